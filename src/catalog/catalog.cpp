@@ -1,53 +1,378 @@
 #include "src/catalog/catalog.h"
 #include "src/utils/logger.h"
 
+#include "src/storage/segment/segment_manager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace catalog;
 
+Type catalog::parse_type(const std::string &declared) {
+    std::string t = declared;
+    std::transform(t.begin(), t.end(), t.begin(), ::toupper);
+    return t == "INT" || t == "INTEGER" ? Type::INT : Type::TEXT;
+}
+
+// Segment of a table or index defined before segments were assigned: a hash
+// of its name (two names could share one)
+static uint32_t legacy_segment(const std::string &name) {
+    return static_cast<uint32_t>(std::hash<std::string>()(name) & 0xFFFFFFFFu);
+}
+
+// Fill in what is derived from the definition
+static void describe(Table &t) {
+    t.positions.clear();
+    for (size_t i = 0; i < t.columns.size(); ++i) {
+        t.columns[i].kind = parse_type(t.columns[i].type);
+        t.positions.emplace(t.columns[i].name, static_cast<int>(i));
+    }
+}
+
+Catalog::Catalog() {
+    snapshot_ = std::make_unique<Snapshot>();
+    current_.store(snapshot_.get(), std::memory_order_release);
+}
+
+Catalog::~Catalog() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void Catalog::claim_locked(const Table &t) {
+    used_segments_.insert(t.id);
+    used_segments_.insert(t.zone_segment_id);
+    for (const Index &i : t.indexes) {
+        used_segments_.insert(i.segment_id);
+        index_names_.insert(i.name);
+    }
+}
+
+uint32_t Catalog::allocate_segment_locked() {
+    // ids from TEMP_SEGMENT_BASE up are scratch segments
+    while (next_segment_ == 0 || next_segment_ >= storage::SegmentManager::TEMP_SEGMENT_BASE ||
+           used_segments_.count(next_segment_)) {
+        next_segment_ = next_segment_ >= storage::SegmentManager::TEMP_SEGMENT_BASE ? 1 : next_segment_ + 1;
+    }
+    used_segments_.insert(next_segment_);
+    return next_segment_++;
+}
+
+void Catalog::publish_locked(std::unique_ptr<Snapshot> s) {
+    current_.store(s.get(), std::memory_order_release);
+    retired_snapshots_.push_back(std::move(snapshot_));
+    snapshot_ = std::move(s);
+    version_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void Catalog::publish_locked(std::unique_ptr<Table> t) {
+    auto next = std::make_unique<Snapshot>(*snapshot_);
+    next->tables[t->name] = t.get();
+    claim_locked(*t);
+    std::unique_ptr<const Table> &slot = defined_[t->name];
+    if (slot) retired_tables_.push_back(std::move(slot));
+    slot = std::move(t);
+    publish_locked(std::move(next));
+}
+
+void Catalog::reclaim() {
+    std::lock_guard<std::mutex> lg(mu_);
+    retired_tables_.clear();
+    retired_snapshots_.clear();
+}
+
 bool Catalog::create_table(const std::string &name, const std::vector<Column> &cols, std::string &err) {
     std::lock_guard<std::mutex> lg(mu_);
-    if (tables_.count(name)) {
+    const Snapshot &cur = *current_.load(std::memory_order_acquire);
+    if (cur.tables.count(name)) {
         err = "table already exists: " + name;
         return false;
     }
-    Table t;
-    t.name = name;
-    t.columns = cols;
-    tables_.emplace(name, std::move(t));
+    auto t = std::make_unique<Table>();
+    t->name = name;
+    t->columns = cols;
+    describe(*t);
+    uint32_t resume = next_segment_;
+    t->id = allocate_segment_locked();
+    t->zone_segment_id = allocate_segment_locked();
+    if (!persist_locked(*t, err)) {
+        used_segments_.erase(t->id);
+        used_segments_.erase(t->zone_segment_id);
+        next_segment_ = resume;
+        return false;
+    }
+    publish_locked(std::move(t));
+    compact_locked();
+    return true;
+}
+
+bool Catalog::create_index(const std::string &table, const Index &idx, std::string &err) {
+    std::lock_guard<std::mutex> lg(mu_);
+    const Snapshot &cur = *current_.load(std::memory_order_acquire);
+    auto it = cur.tables.find(table);
+    if (it == cur.tables.end()) {
+        err = "unknown table: " + table;
+        return false;
+    }
+    if (index_names_.count(idx.name)) {
+        err = "index already exists: " + idx.name;
+        return false;
+    }
+    if (it->second->column_index(idx.column) < 0) {
+        err = "unknown column: " + idx.column;
+        return false;
+    }
+    auto t = std::make_unique<Table>(*it->second);
+    t->indexes.push_back(idx);
+    uint32_t resume = next_segment_;
+    uint32_t seg = t->indexes.back().segment_id = allocate_segment_locked();
+    if (!persist_locked(*t, err)) {
+        used_segments_.erase(seg);
+        next_segment_ = resume;
+        return false;
+    }
+    publish_locked(std::move(t));
+    compact_locked();
     return true;
 }
 
-std::optional<Table> Catalog::get_table(const std::string &name) const {
+bool Catalog::set_stats(const std::string &table, TableStats stats, std::string &err) {
     std::lock_guard<std::mutex> lg(mu_);
-    auto it = tables_.find(name);
-    if (it == tables_.end()) return std::nullopt;
-    return it->second;
+    const Snapshot &cur = *current_.load(std::memory_order_acquire);
+    auto it = cur.tables.find(table);
+    if (it == cur.tables.end()) {
+        err = "unknown table: " + table;
+        return false;
+    }
+    auto t = std::make_unique<Table>(*it->second);
+    t->stats = std::make_shared<const TableStats>(std::move(stats));
+    if (!persist_locked(*t, err)) return false;
+    publish_locked(std::move(t));
+    compact_locked();
+    return true;
+}
+
+const Table *Catalog::get_table(const std::string &name) const {
+    const Snapshot *s = current_.load(std::memory_order_acquire);
+    auto it = s->tables.find(name);
+    return it == s->tables.end() ? nullptr : it->second;
+}
+
+std::vector<const Table *> Catalog::tables() const {
+    const Snapshot *s = current_.load(std::memory_order_acquire);
+    std::vector<const Table *> out;
+    out.reserve(s->tables.size());
+    for (auto const &p : s->tables) out.push_back(p.second);
+    return out;
 }
 
 std::vector<std::string> Catalog::list_tables() const {
     std::lock_guard<std::mutex> lg(mu_);
     std::vector<std::string> out;
-    out.reserve(tables_.size());
-    for (auto const &p : tables_) out.push_back(p.first);
+    out.reserve(snapshot_->tables.size());
+    for (auto const &p : snapshot_->tables) out.push_back(p.first);
     return out;
 }
 
-// Very small, robust line-based persistence.
-// Format (line oriented):
-// TABLE <name>
+//
+// ------------------------- PERSISTENCE -------------------------
+//
+// <dir>/catalog.bin starts with [magic u32][version u32] and is then a log of
+// records, each the whole definition of one table:
+//   [len u32][checksum u32][next segment u32][id u32][zone segment u32][name]
+//   [columns u32] { [name][type] } [indexes u32] { [name][column][method][segment u32] }
+//   [analyzed u8] and, if set, [rows u64][pages u32][columns u32]
+//     { [distinct u64][bounds u32] { [type u8][i32 | string] } }
+// with strings as [len u32][bytes]. len covers the whole record, the checksum
+// (FNV-1a) everything after it. A change appends the table it changed; on
+// load a later record of a name replaces the earlier one, and the first torn
+// record ends the log. Once replaced records outnumber the live ones the
+// file is rewritten (to a temporary file, then renamed over it). Files of
+// version 1 (no statistics) are rewritten on open.
+static constexpr uint32_t CATALOG_MAGIC = 0x54414342;   // "BCAT"
+static constexpr uint32_t CATALOG_VERSION = 2;
+static constexpr size_t FILE_HEADER = 8;
+static constexpr size_t RECORD_HEADER = 8;
+// replaced records tolerated before a rewrite, on top of one per live table
+static constexpr size_t COMPACT_SLACK = 64;
+
+static uint32_t checksum(const char *p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool write_all(int fd, const char *p, size_t n, off_t at) {
+    while (n > 0) {
+        ssize_t w = ::pwrite(fd, p, n, at);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+        at += w;
+    }
+    return true;
+}
+
+static void put_u32(std::string &out, uint32_t v) {
+    out.append(reinterpret_cast<const char *>(&v), 4);
+}
+
+static void put_u64(std::string &out, uint64_t v) {
+    out.append(reinterpret_cast<const char *>(&v), 8);
+}
+
+static void put_str(std::string &out, const std::string &s) {
+    put_u32(out, static_cast<uint32_t>(s.size()));
+    out.append(s);
+}
+
+static void put_stats(std::string &out, const TableStats &st) {
+    put_u64(out, st.rows);
+    put_u32(out, st.pages);
+    put_u32(out, static_cast<uint32_t>(st.columns.size()));
+    for (const ColumnStats &c : st.columns) {
+        put_u64(out, c.distinct);
+        put_u32(out, static_cast<uint32_t>(c.bounds.size()));
+        for (const storage::Value &v : c.bounds) {
+            out.push_back(static_cast<char>(v.type()));
+            if (v.type() == storage::ValueType::INT) put_u32(out, static_cast<uint32_t>(v.as_int()));
+            else put_str(out, v.as_text());
+        }
+    }
+}
+
+static std::string encode_record(const Table &t, uint32_t next_segment) {
+    std::string body;
+    put_u32(body, next_segment);
+    put_u32(body, t.id);
+    put_u32(body, t.zone_segment_id);
+    put_str(body, t.name);
+    put_u32(body, static_cast<uint32_t>(t.columns.size()));
+    for (const Column &c : t.columns) {
+        put_str(body, c.name);
+        put_str(body, c.type);
+    }
+    put_u32(body, static_cast<uint32_t>(t.indexes.size()));
+    for (const Index &i : t.indexes) {
+        put_str(body, i.name);
+        put_str(body, i.column);
+        put_str(body, i.method);
+        put_u32(body, i.segment_id);
+    }
+    body.push_back(t.stats ? 1 : 0);
+    if (t.stats) put_stats(body, *t.stats);
+    std::string rec;
+    put_u32(rec, static_cast<uint32_t>(RECORD_HEADER + body.size()));
+    put_u32(rec, checksum(body.data(), body.size()));
+    return rec + body;
+}
+
+// Reads a record body; every read fails once it would pass the end
+struct RecordReader {
+    const char *p;
+    const char *end;
+
+    bool u8(uint8_t &v) {
+        if (end - p < 1) return false;
+        v = static_cast<uint8_t>(*p++);
+        return true;
+    }
+    bool u32(uint32_t &v) {
+        if (end - p < 4) return false;
+        std::memcpy(&v, p, 4);
+        p += 4;
+        return true;
+    }
+    bool u64(uint64_t &v) {
+        if (end - p < 8) return false;
+        std::memcpy(&v, p, 8);
+        p += 8;
+        return true;
+    }
+    bool str(std::string &s) {
+        uint32_t n;
+        if (!u32(n) || static_cast<size_t>(end - p) < n) return false;
+        s.assign(p, n);
+        p += n;
+        return true;
+    }
+};
+
+static bool decode_stats(RecordReader &r, TableStats &st) {
+    uint32_t ncols;
+    if (!r.u64(st.rows) || !r.u32(st.pages) || !r.u32(ncols)) return false;
+    st.columns.resize(ncols);
+    for (ColumnStats &c : st.columns) {
+        uint32_t nbounds;
+        if (!r.u64(c.distinct) || !r.u32(nbounds)) return false;
+        for (uint32_t i = 0; i < nbounds; ++i) {
+            uint8_t type;
+            uint32_t iv;
+            std::string sv;
+            if (!r.u8(type)) return false;
+            if (type == static_cast<uint8_t>(storage::ValueType::INT)) {
+                if (!r.u32(iv)) return false;
+                c.bounds.emplace_back(static_cast<int32_t>(iv));
+            } else {
+                if (!r.str(sv)) return false;
+                c.bounds.emplace_back(sv);
+            }
+        }
+    }
+    return true;
+}
+
+static bool decode_record(RecordReader r, uint32_t version, Table &t, uint32_t &next_segment) {
+    uint32_t ncols, nidx;
+    if (!r.u32(next_segment) || !r.u32(t.id) || !r.u32(t.zone_segment_id) || !r.str(t.name) || !r.u32(ncols))
+        return false;
+    for (uint32_t i = 0; i < ncols; ++i) {
+        Column c;
+        if (!r.str(c.name) || !r.str(c.type)) return false;
+        t.columns.push_back(std::move(c));
+    }
+    if (!r.u32(nidx)) return false;
+    for (uint32_t i = 0; i < nidx; ++i) {
+        Index idx;
+        if (!r.str(idx.name) || !r.str(idx.column) || !r.str(idx.method) || !r.u32(idx.segment_id)) return false;
+        t.indexes.push_back(std::move(idx));
+    }
+    uint8_t analyzed = 0;
+    if (version >= 2 && !r.u8(analyzed)) return false;
+    if (analyzed) {
+        auto st = std::make_shared<TableStats>();
+        if (!decode_stats(r, *st)) return false;
+        t.stats = std::move(st);
+    }
+    return r.p == r.end;
+}
+
+// The line-based catalog.meta of older versions:
+// NEXT <next segment id>
+// TABLE <name> [<id> <zone map segment>]
 // COL <colname> <type>
+// INDEX <idxname> <colname> <method> [<segment>]
 // END
-bool Catalog::load_from_file(const std::string &path, std::string &err) {
+// Segments missing from TABLE / INDEX lines (catalogs written before they
+// were assigned) are derived from the names as they used to be.
+static bool load_text(const std::string &path, std::vector<std::unique_ptr<Table>> &loaded, uint32_t &next,
+                      std::string &err) {
     std::ifstream ifs(path);
-    if (!ifs) {
-        // non-existent file is not an error here (empty catalog)
-        log(LogLevel::INFO, "catalog file not found: " + path + " (starting fresh)");
-        return true;
-    }
+    if (!ifs) return true;   // none: an empty catalog
 
-    std::unordered_map<std::string, Table> tmp;
     std::string line;
     Table *cur = nullptr;
     while (std::getline(ifs, line)) {
@@ -55,15 +380,22 @@ bool Catalog::load_from_file(const std::string &path, std::string &err) {
         std::istringstream ss(line);
         std::string tok;
         ss >> tok;
-        if (tok == "TABLE") {
+        if (tok == "NEXT") {
+            ss >> next;
+        } else if (tok == "TABLE") {
             std::string tname;
             ss >> tname;
             if (tname.empty()) {
                 err = "malformed catalog: TABLE with empty name";
                 return false;
             }
-            tmp.emplace(tname, Table{tname, {}});
-            cur = &tmp.at(tname);
+            loaded.push_back(std::make_unique<Table>());
+            cur = loaded.back().get();
+            cur->name = tname;
+            if (!(ss >> cur->id >> cur->zone_segment_id)) {
+                cur->id = legacy_segment(tname);
+                cur->zone_segment_id = legacy_segment("zonemap:" + tname);
+            }
         } else if (tok == "COL") {
             if (!cur) {
                 err = "malformed catalog: COL without TABLE";
@@ -76,6 +408,20 @@ bool Catalog::load_from_file(const std::string &path, std::string &err) {
                 return false;
             }
             cur->columns.push_back(Column{cname, ctype});
+        } else if (tok == "INDEX") {
+            if (!cur) {
+                err = "malformed catalog: INDEX without TABLE";
+                return false;
+            }
+            std::string iname, icol, imethod;
+            ss >> iname >> icol >> imethod;
+            if (iname.empty() || icol.empty() || imethod.empty()) {
+                err = "malformed catalog: INDEX line invalid";
+                return false;
+            }
+            Index idx{iname, icol, imethod};
+            if (!(ss >> idx.segment_id)) idx.segment_id = legacy_segment("index:" + iname);
+            cur->indexes.push_back(idx);
         } else if (tok == "END") {
             cur = nullptr;
         } else {
@@ -83,45 +429,150 @@ bool Catalog::load_from_file(const std::string &path, std::string &err) {
             log(LogLevel::WARN, "unknown catalog token: " + tok);
         }
     }
-
-    {
-        std::lock_guard<std::mutex> lg(mu_);
-        tables_.swap(tmp);
-    }
-    log(LogLevel::INFO, "catalog loaded from " + path);
     return true;
 }
 
-bool Catalog::save_to_file(const std::string &path, std::string &err) {
-    // write to temp file then atomic rename
-    std::string tmp = path + ".tmp";
-    std::ofstream ofs(tmp, std::ofstream::trunc);
-    if (!ofs) {
-        err = "failed opening catalog tmp file: " + tmp;
+bool Catalog::open(const std::string &dir, std::string &err) {
+    std::lock_guard<std::mutex> lg(mu_);
+    path_ = dir + "/catalog.bin";
+    std::string legacy = dir + "/catalog.meta";
+    std::vector<std::unique_ptr<Table>> loaded;
+    uint32_t next = 1;
+
+    int fd = ::open(path_.c_str(), O_RDWR);
+    if (fd < 0 && errno != ENOENT) {
+        err = "cannot open " + path_ + ": " + std::strerror(errno);
         return false;
     }
+    if (fd < 0) {
+        if (!load_text(legacy, loaded, next, err)) return false;
+    } else {
+        struct stat st;
+        std::string data;
+        if (::fstat(fd, &st) == 0) {
+            data.resize(static_cast<size_t>(st.st_size));
+            if (::pread(fd, &data[0], data.size(), 0) != static_cast<ssize_t>(data.size())) data.clear();
+        }
+        uint32_t magic = 0, version = 0;
+        if (data.size() >= FILE_HEADER) {
+            std::memcpy(&magic, data.data(), 4);
+            std::memcpy(&version, data.data() + 4, 4);
+        }
+        if (magic != CATALOG_MAGIC || version < 1 || version > CATALOG_VERSION) {
+            ::close(fd);
+            err = "bad catalog header in " + path_;
+            return false;
+        }
 
-    {
-        std::lock_guard<std::mutex> lg(mu_);
-        for (auto const &p : tables_) {
-            ofs << "TABLE " << p.second.name << '\n';
-            for (auto const &c : p.second.columns) {
-                ofs << "COL " << c.name << ' ' << c.type << '\n';
-            }
-            ofs << "END\n";
+        // the catalog ends at the last intact record
+        size_t pos = FILE_HEADER;
+        std::unordered_map<std::string, size_t> named;   // name -> position in `loaded`
+        while (data.size() - pos >= RECORD_HEADER) {
+            uint32_t len, sum;
+            std::memcpy(&len, data.data() + pos, 4);
+            std::memcpy(&sum, data.data() + pos + 4, 4);
+            if (len < RECORD_HEADER || len > data.size() - pos) break;
+            const char *body = data.data() + pos + RECORD_HEADER;
+            size_t body_len = len - RECORD_HEADER;
+            auto t = std::make_unique<Table>();
+            if (checksum(body, body_len) != sum || !decode_record(RecordReader{body, body + body_len}, version, *t, next))
+                break;
+            auto at = named.emplace(t->name, loaded.size());
+            if (at.second) loaded.push_back(std::move(t));
+            else loaded[at.first->second] = std::move(t);
+            records_++;
+            pos += len;
+        }
+        if (pos < data.size() && ::ftruncate(fd, static_cast<off_t>(pos)) != 0) {
+            ::close(fd);
+            err = "cannot truncate " + path_;
+            return false;
+        }
+        if (version == CATALOG_VERSION) {
+            fd_ = fd;
+            end_ = pos;
+        } else {
+            ::close(fd);   // written again below, in the current format
         }
     }
-    ofs.close();
-    if (!ofs) {
-        err = "failed writing catalog tmp file: " + tmp;
+
+    auto snap = std::make_unique<Snapshot>();
+    for (auto &t : loaded) {
+        describe(*t);
+        snap->tables[t->name] = t.get();
+        claim_locked(*t);
+        std::unique_ptr<const Table> &slot = defined_[t->name];
+        if (slot) retired_tables_.push_back(std::move(slot));
+        slot = std::move(t);
+    }
+    next_segment_ = next;
+    publish_locked(std::move(snap));
+
+    if (fd_ < 0) {
+        // first run, or a catalog of an older format to convert
+        if (!rewrite_locked(err)) return false;
+        if (::access(legacy.c_str(), F_OK) == 0) {
+            std::remove(legacy.c_str());
+            log(LogLevel::INFO, "catalog converted from " + legacy);
+        }
+    }
+    log(LogLevel::INFO, "catalog loaded from " + path_ + " (" +
+                            std::to_string(current_.load(std::memory_order_acquire)->tables.size()) + " tables)");
+    return true;
+}
+
+bool Catalog::persist_locked(const Table &t, std::string &err) {
+    if (fd_ < 0) return true;   // not opened: kept in memory only
+    std::string rec = encode_record(t, next_segment_);
+    if (!write_all(fd_, rec.data(), rec.size(), static_cast<off_t>(end_)) || ::fdatasync(fd_) != 0) {
+        err = "failed to save catalog: " + std::string(std::strerror(errno));
+        // a partial record would be cut off at the next start; drop it now
+        if (::ftruncate(fd_, static_cast<off_t>(end_)) != 0)
+            log(LogLevel::WARN, "cannot truncate " + path_ + " after a failed write");
         return false;
     }
+    end_ += rec.size();
+    records_++;
+    return true;
+}
+
+void Catalog::compact_locked() {
+    if (fd_ < 0 || records_ <= 2 * current_.load(std::memory_order_acquire)->tables.size() + COMPACT_SLACK)
+        return;
+    std::string err;
+    if (!rewrite_locked(err)) log(LogLevel::WARN, "catalog compaction failed (appending as before): " + err);
+}
+
+bool Catalog::rewrite_locked(std::string &err) {
+    const Snapshot &cur = *current_.load(std::memory_order_acquire);
+    std::string data;
+    put_u32(data, CATALOG_MAGIC);
+    put_u32(data, CATALOG_VERSION);
+    for (auto const &p : cur.tables) data += encode_record(*p.second, next_segment_);
 
-    // atomic rename
-    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
-        err = "failed to rename catalog tmp file";
+    std::string tmp = path_ + ".tmp";
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        err = "cannot create " + tmp + ": " + std::strerror(errno);
         return false;
     }
-    log(LogLevel::INFO, "catalog saved to " + path);
+    if (!write_all(fd, data.data(), data.size(), 0) || ::fsync(fd) != 0 ||
+        ::rename(tmp.c_str(), path_.c_str()) != 0) {
+        err = "cannot replace " + path_ + ": " + std::strerror(errno);
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    // make the rename itself durable
+    std::string dir = path_.substr(0, path_.find_last_of('/'));
+    int dfd = ::open(dir.c_str(), O_RDONLY);
+    if (dfd >= 0) {
+        ::fsync(dfd);
+        ::close(dfd);
+    }
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = fd;
+    end_ = data.size();
+    records_ = cur.tables.size();
     return true;
 }
@@ -1,39 +1,143 @@
 #pragma once
 
+#include "src/storage/table/tuple.h"
+
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
-#include <optional>
+#include <memory>
+#include <atomic>
+#include <cstdint>
 
 namespace catalog {
 
+// Column types, parsed once from the declared type name
+enum class Type : uint8_t { INT, TEXT };
+// INT / INTEGER (any case) are INT; everything else is stored as TEXT
+Type parse_type(const std::string &declared);
+
 struct Column {
     std::string name;
-    std::string type; // simple textual type for now
+    std::string type;          // as declared
+    Type kind = Type::TEXT;    // parsed (set by the catalog)
+};
+
+struct Index {
+    std::string name;
+    std::string column;
+    std::string method; // only "HASH" for now
+    uint32_t segment_id = 0;
+};
+
+// What ANALYZE found in a table (collected by src/execution/statistics.h)
+struct ColumnStats {
+    uint64_t distinct = 0;                 // estimated number of distinct values
+    // Equi-depth histogram: bounds.front() / back() are the smallest and
+    // largest value, and about as many rows fall between each two neighbours
+    std::vector<storage::Value> bounds;
+};
+
+struct TableStats {
+    uint64_t rows = 0;
+    uint32_t pages = 0;
+    std::vector<ColumnStats> columns;      // in column order
 };
 
+// A table definition as published by the catalog: immutable, with the
+// segments of its data assigned at CREATE TABLE and kept across restarts.
 struct Table {
+    uint32_t id = 0;               // also the segment holding its rows
     std::string name;
     std::vector<Column> columns;
+    std::vector<Index> indexes;
+    uint32_t zone_segment_id = 0;  // zone map pages
+    std::shared_ptr<const TableStats> stats;   // null until the table is analyzed
+
+    // position of a column by name; -1 if there is none
+    int column_index(const std::string &col) const {
+        auto it = positions.find(col);
+        return it == positions.end() ? -1 : it->second;
+    }
+    std::unordered_map<std::string, int> positions;
 };
 
+// Table definitions. Readers go through an immutable snapshot published with
+// one atomic pointer: a lookup takes no lock and copies nothing. A change
+// builds the next snapshot under the catalog mutex (tables it does not touch
+// are shared) and publishes it. The definitions and snapshot it replaced stay
+// alive until reclaim(), which the owner calls when no reader can still hold
+// them (the executor does at a checkpoint, with no statement running), so a
+// `const Table *` stays valid for the statement that looked it up.
+//
+// Once opened on a directory, every change is appended to the catalog file
+// (one record for the one table it touches) and synced before it is published.
 class Catalog {
 public:
-    Catalog() = default;
+    Catalog();
+    ~Catalog();
+    Catalog(const Catalog &) = delete;
+    Catalog &operator=(const Catalog &) = delete;
+
+    // Load <dir>/catalog.bin (created if missing; a catalog.meta of older
+    // versions is converted) and keep appending changes to it
+    bool open(const std::string &dir, std::string &err);
 
-    // thread-safe accessors
     bool create_table(const std::string &name, const std::vector<Column> &cols, std::string &err);
-    std::optional<Table> get_table(const std::string &name) const;
+    bool create_index(const std::string &table, const Index &idx, std::string &err);
+    // replace the statistics of `table` (a change like any other: the
+    // definition it replaces waits for reclaim())
+    bool set_stats(const std::string &table, TableStats stats, std::string &err);
+    // the table as of the latest change (null if there is none)
+    const Table *get_table(const std::string &name) const;
+    std::vector<const Table *> tables() const;
+    // under the catalog mutex: safe outside a statement, while reclaim() runs
     std::vector<std::string> list_tables() const;
 
-    // persistence (simple file API; engine will call with data_dir/catalog.meta)
-    bool load_from_file(const std::string &path, std::string &err);
-    bool save_to_file(const std::string &path, std::string &err);
+    // free the definitions and snapshots replaced so far; nobody may still
+    // use a pointer handed out before the latest change
+    void reclaim();
+
+    // bumped on every schema change; plans bound to an older version are stale
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
 
 private:
+    struct Snapshot {
+        std::unordered_map<std::string, const Table *> tables;
+    };
+
+    std::atomic<const Snapshot *> current_;
+    std::atomic<uint64_t> version_{0};
+
+    // writers: the next segment id to try, what is taken, and what is published
     mutable std::mutex mu_;
-    std::unordered_map<std::string, Table> tables_;
+    uint32_t next_segment_ = 1;
+    std::unordered_set<uint32_t> used_segments_;
+    std::unordered_set<std::string> index_names_;
+    std::unordered_map<std::string, std::unique_ptr<const Table>> defined_;   // the tables of snapshot_
+    std::unique_ptr<const Snapshot> snapshot_;
+    // replaced, kept for readers that may still look at them until reclaim()
+    std::vector<std::unique_ptr<const Table>> retired_tables_;
+    std::vector<std::unique_ptr<const Snapshot>> retired_snapshots_;
+
+    // the catalog file (none until open)
+    std::string path_;
+    int fd_ = -1;
+    uint64_t end_ = 0;        // where the next record goes
+    size_t records_ = 0;      // records in the file, live or replaced
+
+    uint32_t allocate_segment_locked();
+    // record the segments and index names of `t` as taken
+    void claim_locked(const Table &t);
+    // append `t` to the catalog file; false (nothing written) if it failed
+    bool persist_locked(const Table &t, std::string &err);
+    // rewrite the file with one record per table once replaced records dominate it
+    void compact_locked();
+    bool rewrite_locked(std::string &err);
+    // publish `t` (new, or replacing the table of that name); mu_ held
+    void publish_locked(std::unique_ptr<Table> t);
+    void publish_locked(std::unique_ptr<Snapshot> s);
 };
 
 } // namespace catalog
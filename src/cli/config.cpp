@@ -33,6 +33,20 @@ std::optional<Config> Config::loadConfig(const std::string &path, std::string &e
         else if (key == "pid_file") c.pid_file = val;
         else if (key == "daemonize") c.daemonize = (val == "1" || val == "true" || val=="yes");
         else if (key == "ask_mode") c.ask_mode = (val == "1" || val == "true" || val=="yes");
+        else if (key == "vacuum_pages_per_sec") c.vacuum_pages_per_sec = static_cast<uint32_t>(std::stoul(val));
+        else if (key == "checkpoint_wal_bytes") c.checkpoint_wal_bytes = std::stoull(val);
+        else if (key == "recovery_threads") c.recovery_threads = static_cast<unsigned>(std::stoul(val));
+        else if (key == "worker_threads") c.worker_threads = static_cast<unsigned>(std::stoul(val));
+        else if (key == "lock_timeout_ms") c.lock_timeout_ms = static_cast<uint32_t>(std::stoul(val));
+        else if (key == "listen_address") c.listen_address = val;
+        else if (key == "listen_port") c.listen_port = static_cast<uint16_t>(std::stoul(val));
+        else if (key == "socket_path") c.socket_path = val;
+        else if (key == "io_threads") c.io_threads = static_cast<unsigned>(std::stoul(val));
+        else if (key == "max_connections") c.max_connections = static_cast<uint32_t>(std::stoul(val));
+        else if (key == "agg_max_groups") c.agg_max_groups = std::stoull(val);
+        else if (key == "join_max_build_rows") c.join_max_build_rows = std::stoull(val);
+        else if (key == "sort_memory_bytes") c.sort_memory_bytes = std::stoull(val);
+        else if (key == "filter_kernels") c.filter_kernels = val;
         else c.extra[key] = val;
         }
         return c;
@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <cstdint>
 #include <string>
 #include <optional>
 #include <unordered_map>
@@ -11,6 +12,20 @@ std::string data_dir = "./data";
 std::string pid_file = "./boltd.pid";
 bool daemonize = false;
 bool ask_mode = true; // prompt user if true
+uint32_t vacuum_pages_per_sec = 256; // background vacuum I/O budget (0 = off)
+uint64_t checkpoint_wal_bytes = 16u << 20; // checkpoint once the log outgrows this (0 = only at shutdown)
+unsigned recovery_threads = 0; // redo workers at startup (0 = one per core)
+unsigned worker_threads = 0; // threads running queued statements (0 = one per core)
+uint32_t lock_timeout_ms = 5000; // give up a lock wait after this long (0 = wait forever)
+std::string listen_address = "127.0.0.1"; // daemon TCP listener address
+uint16_t listen_port = 5480; // daemon TCP port (0 = no TCP listener)
+std::string socket_path = "./boltd.sock"; // daemon Unix socket (empty = none)
+unsigned io_threads = 2; // daemon threads doing network I/O; statements run on the worker pool
+uint32_t max_connections = 10000; // connections the daemon keeps open at once
+uint64_t agg_max_groups = 0; // groups an aggregation thread holds before it spills (0 = 1M)
+uint64_t join_max_build_rows = 0; // build rows a hash join holds before it partitions to disk (0 = 1M)
+uint64_t sort_memory_bytes = 0; // input a sort buffers before it writes a sorted run (0 = 64 MB)
+std::string filter_kernels = "auto"; // WHERE kernels: auto (best the CPU runs), avx2, sse4.1 or scalar
 std::unordered_map<std::string,std::string> extra;
 
 
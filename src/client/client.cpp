@@ -0,0 +1,261 @@
+// boltc: command-line client of the daemon. Reads statements from stdin, one
+// per line as the REPL does, sends each over TCP or the Unix socket
+// (src/server/protocol.h) and prints its reply. --binary uses the binary
+// protocol (rows arrive as columnar batches and are printed the same way);
+// --pipeline sends every statement before reading the replies.
+#include "src/server/protocol.h"
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void print_usage(const char *prog) {
+    std::cout << "Usage: " << prog << " [--host ADDR] [--port N] [--socket PATH] [--binary] [--pipeline]"
+              << std::endl;
+}
+
+static int connect_tcp(const std::string &host, uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "bad address: " << host << std::endl;
+        return -1;
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "cannot connect to " << host << ":" << port << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+static int connect_unix(const std::string &path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "socket path is too long: " << path << std::endl;
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "cannot connect to " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool write_all(int fd, const std::string &data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool read_all(int fd, char *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = ::recv(fd, buf + done, len - done, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+struct Column {
+    protocol::Type type;
+    std::string name;
+};
+
+// a 'B' frame as "name=value, ..." lines, like the text protocol's rows
+static bool print_batch(protocol::Reader &r, const std::vector<Column> &columns) {
+    uint32_t rows = r.u32();
+    std::vector<std::vector<std::string>> values(columns.size());
+    for (size_t c = 0; c < columns.size() && r.ok; ++c) {
+        values[c].resize(rows);
+        switch (columns[c].type) {
+        case protocol::Type::INT32:
+            for (uint32_t i = 0; i < rows; ++i) values[c][i] = std::to_string(static_cast<int32_t>(r.u32()));
+            break;
+        case protocol::Type::INT64:
+            for (uint32_t i = 0; i < rows; ++i) values[c][i] = std::to_string(static_cast<int64_t>(r.u64()));
+            break;
+        case protocol::Type::FLOAT64:
+            for (uint32_t i = 0; i < rows; ++i) {
+                uint64_t bits = r.u64();
+                double v;
+                std::memcpy(&v, &bits, sizeof(v));
+                char buf[32];
+                std::snprintf(buf, sizeof(buf), "%.15g", v);
+                values[c][i] = buf;
+            }
+            break;
+        case protocol::Type::TEXT: {
+            std::vector<uint32_t> offsets(rows + 1);
+            for (uint32_t &o : offsets) o = r.u32();
+            std::string chars = r.bytes(offsets[rows]);
+            for (uint32_t i = 0; i < rows && r.ok; ++i) {
+                if (offsets[i] > offsets[i + 1] || offsets[i + 1] > chars.size()) return false;
+                values[c][i] = chars.substr(offsets[i], offsets[i + 1] - offsets[i]);
+            }
+            break;
+        }
+        default: return false;
+        }
+    }
+    if (!r.ok) return false;
+    std::string out;
+    for (uint32_t i = 0; i < rows; ++i) {
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (c) out += ", ";
+            out += columns[c].name;
+            out += '=';
+            out += values[c][i];
+        }
+        out += '\n';
+    }
+    std::cout << out;
+    return true;
+}
+
+// print the reply frames of one statement, up to its status line
+static bool print_reply(int fd) {
+    std::vector<Column> columns;
+    for (;;) {
+        char header[4];
+        if (!read_all(fd, header, sizeof(header))) return false;
+        uint32_t len = protocol::get_u32(header);
+        if (len == 0 || len > protocol::MAX_FRAME) return false;
+        std::string frame(len, '\0');
+        if (!read_all(fd, &frame[0], len)) return false;
+        auto kind = static_cast<protocol::Reply>(frame[0]);
+        protocol::Reader r(frame.data() + 1, len - 1);
+        if (kind == protocol::Reply::ROWS) {
+            std::cout.write(frame.data() + 1, static_cast<std::streamsize>(len - 1));
+        } else if (kind == protocol::Reply::COLUMNS) {
+            columns.resize(r.u16());
+            for (Column &c : columns) {
+                c.type = static_cast<protocol::Type>(r.u8());
+                c.name = r.bytes(r.u16());
+            }
+            if (!r.ok) return false;
+        } else if (kind == protocol::Reply::BATCH) {
+            if (!print_batch(r, columns)) return false;
+        } else if (kind == protocol::Reply::DONE) {
+            std::cout.write(frame.data() + 1, static_cast<std::streamsize>(len - 1));
+            std::cout << std::endl;
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+static std::string request(const std::string &sql, bool binary) {
+    std::string out;
+    protocol::put_frame(out, binary ? static_cast<char>(protocol::Request::QUERY) + sql : sql);
+    return out;
+}
+
+int main(int argc, char **argv) {
+    std::string host = "127.0.0.1";
+    uint16_t port = 5480;
+    std::string socket_path;
+    bool binary = false;
+    bool pipeline = false;
+
+    const struct option longopts[] = {
+        {"host", required_argument, nullptr, 'H'},
+        {"port", required_argument, nullptr, 'p'},
+        {"socket", required_argument, nullptr, 's'},
+        {"binary", no_argument, nullptr, 'b'},
+        {"pipeline", no_argument, nullptr, 'P'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "H:p:s:bPh", longopts, nullptr)) != -1) {
+        switch (opt) {
+        case 'H': host = optarg; break;
+        case 'p': port = static_cast<uint16_t>(std::stoul(optarg)); break;
+        case 's': socket_path = optarg; break;
+        case 'b': binary = true; break;
+        case 'P': pipeline = true; break;
+        case 'h': print_usage(argv[0]); return 0;
+        default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    int fd = socket_path.empty() ? connect_tcp(host, port) : connect_unix(socket_path);
+    if (fd < 0) return 1;
+    if (binary && !write_all(fd, std::string(protocol::BINARY_HELLO, sizeof(protocol::BINARY_HELLO)))) {
+        std::cerr << "connection lost" << std::endl;
+        return 1;
+    }
+
+    bool interactive = ::isatty(0) && !pipeline;
+    std::vector<std::string> statements;
+    std::string line;
+    for (;;) {
+        if (interactive) std::cout << "boltc> " << std::flush;
+        if (!std::getline(std::cin, line)) break;
+        auto l = line.find_first_not_of(" \t\r\n");
+        if (l == std::string::npos) continue;
+        auto r = line.find_last_not_of(" \t\r\n");
+        std::string cmd = line.substr(l, r - l + 1);
+        if (cmd == "exit" || cmd == "quit") break;
+        if (pipeline) {
+            statements.push_back(request(cmd, binary));
+            continue;
+        }
+
+        if (!write_all(fd, request(cmd, binary)) || !print_reply(fd)) {
+            std::cerr << "connection lost" << std::endl;
+            ::close(fd);
+            return 1;
+        }
+    }
+
+    if (pipeline) {
+        // send from another thread: the server stops reading a client that
+        // does not read its replies
+        std::thread sender([&] {
+            std::string all;
+            for (const std::string &s : statements) all += s;
+            write_all(fd, all);
+        });
+        bool ok = true;
+        for (size_t i = 0; i < statements.size() && ok; ++i) ok = print_reply(fd);
+        ::shutdown(fd, SHUT_RDWR);
+        sender.join();
+        if (!ok) {
+            std::cerr << "connection lost" << std::endl;
+            ::close(fd);
+            return 1;
+        }
+    }
+    ::close(fd);
+    return 0;
+}
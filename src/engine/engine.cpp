@@ -1,8 +1,9 @@
 #include "src/engine/engine.h"
 #include "src/utils/logger.h"
+#include "src/execution/filter_kernels.h"
+#include "src/storage/wal/recovery.h"
 
 #include <filesystem>
-#include <sstream>
 #include <chrono>
 #include <iostream>
 
@@ -17,6 +18,10 @@ Engine::~Engine() {
 }
 
 bool Engine::init(std::string &err) {
+    if (!set_filter_kernel_level(cfg_.filter_kernels)) {
+        err = "filter_kernels: " + cfg_.filter_kernels + " is not a kernel level this CPU runs";
+        return false;
+    }
     try {
         if (!fs::exists(cfg_.data_dir)) {
             fs::create_directories(cfg_.data_dir);
@@ -28,16 +33,58 @@ bool Engine::init(std::string &err) {
     }
 
     // load catalog
-    std::string catalog_path = cfg_.data_dir + "/catalog.meta";
-    if (!catalog_.load_from_file(catalog_path, err)) {
+    if (!catalog_.open(cfg_.data_dir, err)) {
         return false;
     }
 
     // ✅ init storage + executor
     segmgr_ = std::make_unique<storage::SegmentManager>(cfg_.data_dir);
     buffer_pool_ = std::make_unique<storage::BufferPool>(128, *segmgr_); // 128 frames default
-    executor_ = std::make_unique<Executor>(catalog_, *buffer_pool_);
+    try {
+        wal_ = std::make_unique<storage::Wal>(cfg_.data_dir);
+    } catch (const std::exception &e) {
+        err = std::string("failed to open write-ahead log: ") + e.what();
+        return false;
+    }
+    // redo what the last run logged but did not write before the pool reads any page
+    storage::Recovery recovery(*segmgr_, *wal_);
+    try {
+        storage::Recovery::Stats st = recovery.run(cfg_.recovery_threads);
+        log(LogLevel::INFO, "recovery: " + std::to_string(st.applied) + " of " + std::to_string(st.records) +
+                                " log records replayed on " + std::to_string(st.pages) + " pages by " +
+                                std::to_string(st.threads) + " threads in " +
+                                std::to_string(static_cast<long>(st.seconds * 1000)) + " ms");
+    } catch (const std::exception &e) {
+        err = std::string("recovery failed: ") + e.what();
+        return false;
+    }
+    buffer_pool_->attach_wal(wal_.get());
+    try {
+        txns_ = std::make_unique<storage::TransactionManager>(cfg_.data_dir);
+    } catch (const std::exception &e) {
+        err = std::string("failed to open transaction ids: ") + e.what();
+        return false;
+    }
+    locks_ = std::make_unique<storage::LockManager>(std::chrono::milliseconds(cfg_.lock_timeout_ms));
+    SpillLimits limits;
+    if (cfg_.agg_max_groups) limits.agg_max_groups = cfg_.agg_max_groups;
+    if (cfg_.join_max_build_rows) limits.join_max_build_rows = cfg_.join_max_build_rows;
+    if (cfg_.sort_memory_bytes) limits.sort_memory_bytes = cfg_.sort_memory_bytes;
+    executor_ = std::make_unique<Executor>(catalog_, *buffer_pool_, *txns_, *locks_, limits);
+    // then undo the transactions the crash cut off, and checkpoint
+    try {
+        txns_->recover(recovery.committed());
+        size_t restored = executor_->recover(recovery.undo(), recovery.segments());
+        if (restored > 0) log(LogLevel::INFO, "recovery: " + std::to_string(restored) + " rows put back");
+        if (wal_->end_lsn() != wal_->base_lsn()) executor_->checkpoint();
+    } catch (const std::exception &e) {
+        err = std::string("recovery failed: ") + e.what();
+        return false;
+    }
+    workers_ = std::make_unique<WorkerPool>(cfg_.worker_threads);
+    log(LogLevel::INFO, "worker pool: " + std::to_string(workers_->size()) + " threads");
 
+    log(LogLevel::INFO, std::string("filter kernels: ") + filter_kernel_level());
     log(LogLevel::INFO, "Engine initialized");
     return true;
 }
@@ -57,8 +104,19 @@ void Engine::start_background() {
 void Engine::shutdown() {
     bool was = terminate_.exchange(true);
     if (!was) {
+        // finish the statements already queued; nothing new is taken
+        if (workers_) workers_->stop();
         // notify background thread
         bg_cv_.notify_all();
+        // it may be in the middle of a vacuum step: wait for it before flushing
+        join();
+        // persist whatever is still only in memory; the next start has nothing to redo
+        try {
+            if (executor_) executor_->checkpoint();
+            else if (buffer_pool_) buffer_pool_->flush_all();
+        } catch (const std::exception &e) {
+            log(LogLevel::ERROR, std::string("checkpoint failed: ") + e.what());
+        }
     }
 }
 
@@ -72,19 +130,67 @@ void Engine::join() {
     bg_running_.store(false);
 }
 
-std::string Engine::execute_sql(const std::string &sql) {
+std::shared_ptr<Session> Engine::open_session() {
+    return std::make_shared<Session>();
+}
+
+void Engine::execute_sql(const std::string &sql, ResultSink &sink) {
+    execute_sql(session_, sql, sink);
+}
+
+void Engine::execute_sql(Session &session, const std::string &sql, ResultSink &sink) {
     if (sql.rfind(".tables", 0) == 0) {
-        auto tables = catalog_.list_tables();
-        std::ostringstream ss;
-        for (auto &t : tables) ss << t << '\n';
-        return ss.str();
+        Batch rows;
+        rows.reset({ColumnType::TEXT});
+        for (auto &t : catalog_.list_tables()) {
+            rows.columns[0].push_text(t);
+            rows.size++;
+        }
+        sink.columns({"table"}, {ColumnType::TEXT});
+        if (rows.size > 0) sink.batch(rows);
+        return;
     }
 
     if (!executor_) {
-        return "ERR: executor not initialized";
+        sink.status("ERR: executor not initialized");
+        return;
     }
 
-    return executor_->execute(sql);
+    executor_->execute(session, sql, sink);
+}
+
+void Engine::execute_sql(Session &session, const std::string &sql, const Params &params, ResultSink &sink) {
+    if (!executor_) {
+        sink.status("ERR: executor not initialized");
+        return;
+    }
+    executor_->execute(session, sql, params, sink);
+}
+
+bool Engine::submit(std::shared_ptr<Session> session, std::string sql, ResultSink &sink,
+                    std::function<void()> done) {
+    return run_on_workers([this, session = std::move(session), sql = std::move(sql), &sink] {
+        execute_sql(*session, sql, sink);
+    }, sink, std::move(done));
+}
+
+bool Engine::submit(std::shared_ptr<Session> session, std::string sql, Params params, ResultSink &sink,
+                    std::function<void()> done) {
+    return run_on_workers([this, session = std::move(session), sql = std::move(sql), params = std::move(params),
+                           &sink] { execute_sql(*session, sql, params, sink); },
+                          sink, std::move(done));
+}
+
+bool Engine::run_on_workers(std::function<void()> statement, ResultSink &sink, std::function<void()> done) {
+    if (!workers_) return false;
+    return workers_->submit([statement = std::move(statement), &sink, done = std::move(done)] {
+        try {
+            statement();
+        } catch (const std::exception &e) {
+            sink.status(std::string("ERR: ") + e.what());
+        }
+        if (done) done();
+    });
 }
 
 const catalog::Catalog& Engine::catalog() const {
@@ -92,15 +198,37 @@ const catalog::Catalog& Engine::catalog() const {
 }
 
 void Engine::background_loop() {
-    // Do light periodic maintenance (placeholder). Sleep and wake on shutdown.
+    // Background maintenance: vacuum, paced by a token bucket refilled at
+    // cfg_.vacuum_pages_per_sec so it never takes more I/O than configured,
+    // and a checkpoint whenever the log outgrows cfg_.checkpoint_wal_bytes
+    // (which bounds the redo work of a restart).
     using namespace std::chrono_literals;
+    const double rate = cfg_.vacuum_pages_per_sec;
+    double tokens = 0;
+    auto last = std::chrono::steady_clock::now();
     std::unique_lock<std::mutex> lk(bg_mu_);
     while (!terminate_.load()) {
-        // Example maintenance: every 5s write a heartbeat log (production: checkpoints, GC, metrics)
-        bg_cv_.wait_for(lk, 5s);
+        bg_cv_.wait_for(lk, 100ms);
         if (terminate_.load()) break;
-        log(LogLevel::DEBUG, "Engine background heartbeat");
-        // (more maintenance work could be done here)
+
+        auto now = std::chrono::steady_clock::now();
+        tokens = std::min(rate, tokens + rate * std::chrono::duration<double>(now - last).count());
+        last = now;
+        if (!executor_) continue;
+
+        lk.unlock();
+        try {
+            if (tokens >= 1) tokens -= static_cast<double>(executor_->vacuum(static_cast<size_t>(tokens)));
+        } catch (const std::exception &e) {
+            log(LogLevel::ERROR, std::string("vacuum failed: ") + e.what());
+        }
+        try {
+            if (cfg_.checkpoint_wal_bytes > 0 && wal_->end_lsn() - wal_->base_lsn() >= cfg_.checkpoint_wal_bytes)
+                executor_->checkpoint();
+        } catch (const std::exception &e) {
+            log(LogLevel::ERROR, std::string("checkpoint failed: ") + e.what());
+        }
+        lk.lock();
     }
     log(LogLevel::INFO, "Engine background loop exiting");
 }
@@ -4,7 +4,11 @@
 #include "src/catalog/catalog.h"
 #include "src/storage/segment/segment_manager.h"
 #include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/wal/wal.h"
+#include "src/storage/mvcc/transaction.h"
+#include "src/storage/mvcc/lock_manager.h"
 #include "src/execution/executor.h"
+#include "src/engine/worker_pool.h"
 
 #include <string>
 #include <atomic>
@@ -12,6 +16,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <memory>
+#include <functional>
 
 class Engine {
 public:
@@ -26,12 +31,30 @@ public:
     void shutdown();
     void join();
 
-    std::string execute_sql(const std::string &sql);
+    // A client's session: its prepared statements and open transaction last
+    // from one statement to the next. Sessions run their statements in parallel.
+    std::shared_ptr<Session> open_session();
+
+    // results are streamed into `sink` while the statement runs (on the
+    // calling thread); the first form runs in the engine's own session
+    void execute_sql(const std::string &sql, ResultSink &sink);
+    void execute_sql(Session &session, const std::string &sql, ResultSink &sink);
+    // with the values of its '?' parameters (see Executor::execute)
+    void execute_sql(Session &session, const std::string &sql, const Params &params, ResultSink &sink);
+
+    // Run a statement on the worker pool; `done` follows on the worker once
+    // `sink` has everything. A session submits its next statement after the
+    // last one is done. False (and nothing runs) once the engine shuts down.
+    bool submit(std::shared_ptr<Session> session, std::string sql, ResultSink &sink, std::function<void()> done);
+    bool submit(std::shared_ptr<Session> session, std::string sql, Params params, ResultSink &sink,
+                std::function<void()> done);
 
     const catalog::Catalog& catalog() const;
 
 private:
     void background_loop();
+    // run `statement` on the worker pool, reporting what it throws to `sink`
+    bool run_on_workers(std::function<void()> statement, ResultSink &sink, std::function<void()> done);
 
 private:
     Config cfg_;
@@ -39,8 +62,13 @@ private:
 
     // NEW: storage + executor
     std::unique_ptr<storage::SegmentManager> segmgr_;
+    std::unique_ptr<storage::Wal> wal_;
     std::unique_ptr<storage::BufferPool> buffer_pool_;
+    std::unique_ptr<storage::TransactionManager> txns_;
+    std::unique_ptr<storage::LockManager> locks_;
     std::unique_ptr<Executor> executor_;
+    Session session_;
+    std::unique_ptr<WorkerPool> workers_;
 
     std::atomic<bool> terminate_{false};
     std::atomic<bool> bg_running_{false};
@@ -0,0 +1,53 @@
+#include "src/engine/worker_pool.h"
+#include "src/utils/logger.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+WorkerPool::WorkerPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) threads_.emplace_back(&WorkerPool::run, this);
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+bool WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lg(mu_);
+        if (stopping_) return false;
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lg(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : threads_)
+        if (t.joinable()) t.join();
+}
+
+void WorkerPool::run() {
+    std::unique_lock<std::mutex> lk(mu_);
+    for (;;) {
+        cv_.wait(lk, [&] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) return;
+        std::function<void()> task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lk.unlock();
+        try {
+            task();
+        } catch (const std::exception &e) {
+            log(LogLevel::ERROR, std::string("worker task failed: ") + e.what());
+        }
+        lk.lock();
+    }
+}
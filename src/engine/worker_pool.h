@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running queued tasks in arrival order
+class WorkerPool {
+public:
+    // `threads` of 0 starts one per core
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // false once the pool is stopping (the task is not run)
+    bool submit(std::function<void()> task);
+    // run what is queued, then end the threads
+    void stop();
+    size_t size() const { return threads_.size(); }
+
+private:
+    void run();
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
@@ -0,0 +1,89 @@
+#include "src/execution/agg_table.h"
+
+#include <functional>
+#include <stdexcept>
+
+AggTable::AggTable(size_t naggs) : naggs_(naggs), slots_(1024, Slot{0, EMPTY}) {}
+
+uint64_t AggTable::hash_key(std::string_view key) {
+    uint64_t h = std::hash<std::string_view>()(key);
+    // finalize (splitmix64) so both the low bits (slot) and high bits (spill partition) are well mixed
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+size_t AggTable::find_or_insert(std::string_view key, uint64_t hash) {
+    size_t mask = slots_.size() - 1;
+    for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        Slot &slot = slots_[pos];
+        if (slot.group == EMPTY) {
+            uint32_t g = static_cast<uint32_t>(hashes_.size());
+            slot = Slot{hash, g};
+            arena_.append(key.data(), key.size());
+            key_off_.push_back(arena_.size());
+            hashes_.push_back(hash);
+            states_.resize(states_.size() + naggs_);
+            if (hashes_.size() * 2 > slots_.size()) grow();
+            return g;
+        }
+        if (slot.hash == hash && this->key(slot.group) == key) return slot.group;
+    }
+}
+
+void AggTable::grow() {
+    std::vector<Slot> bigger(slots_.size() * 2, Slot{0, EMPTY});
+    size_t mask = bigger.size() - 1;
+    for (const Slot &s : slots_) {
+        if (s.group == EMPTY) continue;
+        size_t pos = s.hash & mask;
+        while (bigger[pos].group != EMPTY) pos = (pos + 1) & mask;
+        bigger[pos] = s;
+    }
+    slots_.swap(bigger);
+}
+
+void AggTable::clear() {
+    slots_.assign(1024, Slot{0, EMPTY});
+    arena_.clear();
+    key_off_.assign(1, 0);
+    hashes_.clear();
+    states_.clear();
+}
+
+//
+// --------------------------- SPILL -----------------------------
+//
+AggSpill::~AggSpill() {
+    for (std::FILE *f : files_)
+        if (f) std::fclose(f);
+}
+
+void AggSpill::write(const AggTable &table) {
+    for (size_t g = 0; g < table.size(); ++g) {
+        size_t p = partition_of(table.hash(g));
+        if (!files_[p]) {
+            files_[p] = std::tmpfile();
+            if (!files_[p]) throw std::runtime_error("cannot create aggregate spill file");
+        }
+        std::FILE *f = files_[p];
+        std::string_view key = table.key(g);
+        uint32_t len = static_cast<uint32_t>(key.size());
+        std::fwrite(&len, sizeof(len), 1, f);
+        std::fwrite(key.data(), 1, len, f);
+        const AggState *st = table.states(g);
+        for (size_t a = 0; a < naggs_; ++a) {
+            uint32_t slen = static_cast<uint32_t>(st[a].s.size());
+            std::fwrite(&st[a].count, sizeof(st[a].count), 1, f);
+            std::fwrite(&st[a].i, sizeof(st[a].i), 1, f);
+            std::fwrite(&st[a].d, sizeof(st[a].d), 1, f);
+            std::fwrite(&slen, sizeof(slen), 1, f);
+            std::fwrite(st[a].s.data(), 1, slen, f);
+        }
+        if (std::ferror(f)) throw std::runtime_error("aggregate spill write failed");
+    }
+    used_ = used_ || table.size() > 0;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Running state of one aggregate for one group. Which fields are used
+// depends on the function and argument type (see AggregateOp).
+struct AggState {
+    int64_t count = 0;
+    int64_t i = 0;
+    double d = 0;
+    std::string s;
+};
+
+// Open-addressing (linear probing) hash table from encoded group keys to
+// group numbers. Slots hold only the hash and group number, so probing stays
+// within a few cache lines; keys live packed in one arena and the aggregate
+// states in one flat array (group * naggs + agg).
+class AggTable {
+public:
+    explicit AggTable(size_t naggs);
+
+    static uint64_t hash_key(std::string_view key);
+
+    // group number for `key`, inserting a new group with fresh states if needed
+    size_t find_or_insert(std::string_view key, uint64_t hash);
+
+    size_t size() const { return hashes_.size(); }
+    std::string_view key(size_t group) const {
+        return std::string_view(arena_.data() + key_off_[group], key_off_[group + 1] - key_off_[group]);
+    }
+    uint64_t hash(size_t group) const { return hashes_[group]; }
+    AggState *states(size_t group) { return &states_[group * naggs_]; }
+    const AggState *states(size_t group) const { return &states_[group * naggs_]; }
+    size_t naggs() const { return naggs_; }
+
+    void clear();
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    struct Slot {
+        uint64_t hash;
+        uint32_t group;
+    };
+
+    void grow();
+
+    size_t naggs_;
+    std::vector<Slot> slots_;          // power-of-two sized, load factor <= 1/2
+    std::string arena_;
+    std::vector<size_t> key_off_{0};   // size() + 1 entries
+    std::vector<uint64_t> hashes_;
+    std::vector<AggState> states_;
+};
+
+// Hash-partitioned spill files for partial aggregates that outgrow memory.
+// Each partition is a temporary file of (key, states) records; the same key
+// always lands in the same partition, so partitions can be merged one at a time.
+class AggSpill {
+public:
+    static constexpr size_t PARTITIONS = 16;
+
+    explicit AggSpill(size_t naggs) : naggs_(naggs) {}
+    ~AggSpill();
+    AggSpill(const AggSpill &) = delete;
+    AggSpill &operator=(const AggSpill &) = delete;
+
+    static size_t partition_of(uint64_t hash) { return static_cast<size_t>(hash >> 60) % PARTITIONS; }
+
+    // append every group of `table` to its partition file
+    void write(const AggTable &table);
+    bool empty() const { return !used_; }
+
+    // call fn(key, hash, states) for each record of partition p
+    template <typename Fn>
+    void read(size_t p, Fn &&fn) const;
+
+private:
+    size_t naggs_;
+    bool used_ = false;
+    std::FILE *files_[PARTITIONS] = {};
+};
+
+template <typename Fn>
+void AggSpill::read(size_t p, Fn &&fn) const {
+    std::FILE *f = files_[p];
+    if (!f) return;
+    std::rewind(f);
+    std::string key;
+    std::vector<AggState> states(naggs_);
+    uint32_t len;
+    while (std::fread(&len, sizeof(len), 1, f) == 1) {
+        key.resize(len);
+        if (len && std::fread(&key[0], 1, len, f) != len) break;
+        for (auto &s : states) {
+            uint32_t slen = 0;
+            std::fread(&s.count, sizeof(s.count), 1, f);
+            std::fread(&s.i, sizeof(s.i), 1, f);
+            std::fread(&s.d, sizeof(s.d), 1, f);
+            std::fread(&slen, sizeof(slen), 1, f);
+            s.s.resize(slen);
+            if (slen) std::fread(&s.s[0], 1, slen, f);
+        }
+        fn(std::string_view(key), AggTable::hash_key(key), static_cast<const AggState *>(states.data()));
+    }
+    std::fseek(f, 0, SEEK_END); // later writes append
+}
@@ -0,0 +1,84 @@
+#include "src/execution/batch.h"
+
+#include <cstdio>
+
+const char *column_type_name(ColumnType t) {
+    switch (t) {
+    case ColumnType::INT: return "INT";
+    case ColumnType::BIGINT: return "BIGINT";
+    case ColumnType::DOUBLE: return "DOUBLE";
+    case ColumnType::TEXT: return "TEXT";
+    }
+    return "?";
+}
+
+void ColumnVector::append_from(const ColumnVector &src, size_t i) {
+    switch (type) {
+    case ColumnType::INT: i32.push_back(src.i32[i]); break;
+    case ColumnType::BIGINT: i64.push_back(src.i64[i]); break;
+    case ColumnType::DOUBLE: f64.push_back(src.f64[i]); break;
+    case ColumnType::TEXT: push_text(src.text(i)); break;
+    }
+}
+
+std::string ColumnVector::value_string(size_t i) const {
+    switch (type) {
+    case ColumnType::INT: return std::to_string(i32[i]);
+    case ColumnType::BIGINT: return std::to_string(i64[i]);
+    case ColumnType::DOUBLE: {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.15g", f64[i]);
+        return buf;
+    }
+    case ColumnType::TEXT: return std::string(text(i));
+    }
+    return "";
+}
+
+template <typename T>
+static void compact_fixed(std::vector<T> &v, const std::vector<uint8_t> &keep) {
+    size_t w = 0;
+    for (size_t r = 0; r < v.size(); ++r) {
+        v[w] = v[r];
+        w += keep[r] != 0;
+    }
+    v.resize(w);
+}
+
+static void compact_text(ColumnVector &c, const std::vector<uint8_t> &keep) {
+    size_t n = c.offsets.size() - 1;
+    uint32_t out = 0;
+    size_t w = 0;
+    for (size_t r = 0; r < n; ++r) {
+        if (!keep[r]) continue;
+        uint32_t b = c.offsets[r], e = c.offsets[r + 1];
+        if (out != b) std::memmove(&c.chars[out], &c.chars[b], e - b);
+        c.offsets[w] = out; // offsets[w] <= offsets[r], safe to overwrite in place
+        out += e - b;
+        w++;
+    }
+    c.offsets[w] = out;
+    c.offsets.resize(w + 1);
+    c.chars.resize(out);
+}
+
+void Batch::compact(const std::vector<uint8_t> &keep) {
+    size_t kept = 0;
+    for (size_t r = 0; r < size; ++r) kept += keep[r] != 0;
+    if (kept == size) return;
+
+    for (auto &c : columns) {
+        switch (c.type) {
+        case ColumnType::INT: compact_fixed(c.i32, keep); break;
+        case ColumnType::BIGINT: compact_fixed(c.i64, keep); break;
+        case ColumnType::DOUBLE: compact_fixed(c.f64, keep); break;
+        case ColumnType::TEXT: compact_text(c, keep); break;
+        }
+    }
+    size = kept;
+}
+
+void Batch::append_row(const Batch &src, size_t i) {
+    for (size_t c = 0; c < columns.size(); ++c) columns[c].append_from(src.columns[c], i);
+    size++;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Column-oriented batches exchanged between vectorized operators.
+
+constexpr size_t BATCH_SIZE = 2048;
+
+enum class ColumnType : uint8_t {
+    INT,     // int32 (the storage INT)
+    BIGINT,  // int64 (COUNT / SUM results)
+    DOUBLE,  // AVG results
+    TEXT
+};
+
+const char *column_type_name(ColumnType t);
+
+// One column of a batch. Only the storage matching `type` is used; TEXT values
+// are packed into one buffer with an offsets array (offsets.size() == size + 1).
+struct ColumnVector {
+    ColumnType type = ColumnType::INT;
+    std::vector<int32_t> i32;
+    std::vector<int64_t> i64;
+    std::vector<double> f64;
+    std::vector<uint32_t> offsets{0};
+    std::string chars;
+
+    void reset(ColumnType t) {
+        type = t;
+        i32.clear();
+        i64.clear();
+        f64.clear();
+        offsets.assign(1, 0);
+        chars.clear();
+    }
+
+    std::string_view text(size_t i) const {
+        return std::string_view(chars.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    void push_text(std::string_view v) {
+        chars.append(v.data(), v.size());
+        offsets.push_back(static_cast<uint32_t>(chars.size()));
+    }
+
+    // append row `i` of `src` (same type)
+    void append_from(const ColumnVector &src, size_t i);
+    std::string value_string(size_t i) const;
+};
+
+// Compile-time access to the storage of each column type, so kernels can be
+// written once as templates and dispatched with one switch per batch.
+template <ColumnType T> struct ColumnTraits;
+
+template <> struct ColumnTraits<ColumnType::INT> {
+    using value_type = int32_t;
+    static const int32_t *data(const ColumnVector &c) { return c.i32.data(); }
+    static std::vector<int32_t> &vec(ColumnVector &c) { return c.i32; }
+};
+
+template <> struct ColumnTraits<ColumnType::BIGINT> {
+    using value_type = int64_t;
+    static const int64_t *data(const ColumnVector &c) { return c.i64.data(); }
+    static std::vector<int64_t> &vec(ColumnVector &c) { return c.i64; }
+};
+
+template <> struct ColumnTraits<ColumnType::DOUBLE> {
+    using value_type = double;
+    static const double *data(const ColumnVector &c) { return c.f64.data(); }
+    static std::vector<double> &vec(ColumnVector &c) { return c.f64; }
+};
+
+struct Batch {
+    std::vector<ColumnVector> columns;
+    size_t size = 0;
+
+    void reset(const std::vector<ColumnType> &types) {
+        columns.resize(types.size());
+        for (size_t i = 0; i < types.size(); ++i) columns[i].reset(types[i]);
+        size = 0;
+    }
+
+    // keep only rows whose mask byte is non-zero, preserving order
+    void compact(const std::vector<uint8_t> &keep);
+    // append row `i` of `src` (same column types)
+    void append_row(const Batch &src, size_t i);
+};
@@ -1,10 +1,21 @@
 #include "src/execution/executor.h"
+#include "src/execution/expression.h"
+#include "src/execution/operators.h"
+#include "src/execution/statistics.h"
+#include "src/execution/vector_expr.h"
+#include "src/sql/parser.h"
 #include "src/storage/table/tuple.h"     // tuple include
+#include "src/storage/table/table_heap.h"
+#include "src/storage/table/zone_map.h"
 #include "src/utils/logger.h"            // optional logger
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <sstream>
 #include <cctype>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
 
 //
 // ===============================================================
@@ -12,56 +23,410 @@
 // ===============================================================
 //
 
-// Trim whitespace from both ends
-static inline std::string trim(const std::string &s) {
-    auto a = s.find_first_not_of(" \t\r\n");
-    if (a == std::string::npos) return "";
-    auto b = s.find_last_not_of(" \t\r\n");
-    return s.substr(a, b - a + 1);
+// Zone map over every INT column of the table
+static storage::ZoneMap table_zone_map(const catalog::Table &table) {
+    std::vector<size_t> cols;
+    for (size_t i = 0; i < table.columns.size(); ++i)
+        if (table.columns[i].kind == catalog::Type::INT) cols.push_back(i);
+    return storage::ZoneMap(table.zone_segment_id, std::move(cols));
 }
 
-// Split CSV-style strings into values (supports quoted strings)
-static inline std::vector<std::string> split_csv(const std::string &s) {
-    std::vector<std::string> out;
-    std::string cur;
-    bool in_quotes = false;
+static bool is_constant(const sql::Expr &e) {
+    return e.type == sql::ExprType::LITERAL || e.type == sql::ExprType::PARAM;
+}
 
-    for (size_t i = 0; i < s.size(); ++i) {
-        char c = s[i];
-        if (c == '"') {
-            in_quotes = !in_quotes;
-            continue;
+// Recognize `<col> <op> <literal or ?>` (either order) in a bound conjunct
+static bool column_vs_literal(const sql::Expr &c, const Params *params,
+                              int &col, sql::CompareOp &op, storage::Value &val) {
+    if (c.type != sql::ExprType::COMPARE) return false;
+    const sql::Expr &l = *c.args[0];
+    const sql::Expr &r = *c.args[1];
+    op = c.op;
+    if (l.type == sql::ExprType::COLUMN && is_constant(r)) {
+        col = l.column;
+        val = eval_expr(r, {}, params);
+        return true;
+    }
+    if (is_constant(l) && r.type == sql::ExprType::COLUMN) {
+        col = r.column;
+        val = eval_expr(l, {}, params);
+        // literal on the left: mirror the operator
+        switch (op) {
+        case sql::CompareOp::LT: op = sql::CompareOp::GT; break;
+        case sql::CompareOp::LE: op = sql::CompareOp::GE; break;
+        case sql::CompareOp::GT: op = sql::CompareOp::LT; break;
+        case sql::CompareOp::GE: op = sql::CompareOp::LE; break;
+        default: break;
+        }
+        return true;
+    }
+    return false;
+}
+
+
+static bool contains_aggregate(const sql::Expr &e) {
+    if (e.type == sql::ExprType::FUNCTION) return true;
+    for (const auto &a : e.args)
+        if (contains_aggregate(*a)) return true;
+    return false;
+}
+
+// Aggregate calls must be known, take one argument (COUNT also `*`) and not nest
+static bool check_aggregates(const sql::Expr &e, bool inside, std::string &err) {
+    if (e.type == sql::ExprType::FUNCTION) {
+        AggFunc f;
+        if (!agg_func_from_name(e.name, f)) {
+            err = "unknown function " + e.name;
+            return false;
         }
-        if (c == ',' && !in_quotes) {
-            out.push_back(trim(cur));
-            cur.clear();
+        if (inside) {
+            err = "aggregate calls cannot be nested";
+            return false;
+        }
+        if (e.args.size() != 1 || (e.args[0]->type == sql::ExprType::STAR && f != AggFunc::COUNT)) {
+            err = "wrong arguments to " + e.name;
+            return false;
+        }
+        inside = true;
+    } else if (e.type == sql::ExprType::STAR && !inside) {
+        err = "'*' is only allowed as the whole select list or in COUNT(*)";
+        return false;
+    }
+    for (const auto &a : e.args)
+        if (!check_aggregates(*a, inside, err)) return false;
+    return true;
+}
+
+// Rewrite an expression over table rows into one over the aggregate output:
+// group keys become columns [0, nkeys), distinct aggregate calls nkeys + j
+static bool rewrite_for_aggregate(sql::ExprPtr &e, SelectPlan &sp, std::vector<sql::ExprPtr> &agg_calls,
+                                  std::string &err) {
+    auto column_ref = [&](size_t pos) {
+        auto col = std::make_unique<sql::Expr>(sql::ExprType::COLUMN);
+        col->name = sql::expr_to_string(*e);
+        col->column = static_cast<int>(pos);
+        e = std::move(col);
+    };
+
+    for (size_t k = 0; k < sp.group_keys.size(); ++k) {
+        if (sql::same_expr(*e, *sp.group_keys[k])) {
+            column_ref(k);
+            return true;
+        }
+    }
+    if (e->type == sql::ExprType::FUNCTION) {
+        size_t j = 0;
+        while (j < agg_calls.size() && !sql::same_expr(*agg_calls[j], *e)) j++;
+        if (j == agg_calls.size()) {
+            AggSpec spec;
+            agg_func_from_name(e->name, spec.func);
+            if (e->args[0]->type != sql::ExprType::STAR) spec.arg = sql::clone_expr(*e->args[0]);
+            sp.aggs.push_back(std::move(spec));
+            agg_calls.push_back(sql::clone_expr(*e));
+        }
+        column_ref(sp.group_keys.size() + j);
+        return true;
+    }
+    if (e->type == sql::ExprType::COLUMN) {
+        err = "column " + e->name + " must appear in GROUP BY or be used in an aggregate";
+        return false;
+    }
+    for (auto &a : e->args)
+        if (!rewrite_for_aggregate(a, sp, agg_calls, err)) return false;
+    return true;
+}
+
+static void mark_columns(const sql::Expr &e, std::vector<bool> &used) {
+    if (e.type == sql::ExprType::COLUMN && e.column >= 0) used[e.column] = true;
+    for (const auto &a : e.args) mark_columns(*a, used);
+}
+
+static void remap_columns(sql::Expr &e, const std::vector<int> &to) {
+    if (e.type == sql::ExprType::COLUMN && e.column >= 0) e.column = to[e.column];
+    for (auto &a : e.args) remap_columns(*a, to);
+}
+
+// Narrow the scan to the columns the query reads and rebind scan-side
+// expressions to positions within that projection. `ncolumns` is the width of
+// the bound row (both tables for a join).
+static void push_down_projection(size_t ncolumns, SelectPlan &sp) {
+    std::vector<sql::Expr *> scan_side;
+    if (sp.filter) scan_side.push_back(sp.filter.get());
+    if (sp.aggregate) {
+        for (auto &k : sp.group_keys) scan_side.push_back(k.get());
+        for (auto &a : sp.aggs)
+            if (a.arg) scan_side.push_back(a.arg.get());
+    } else {
+        for (auto &e : sp.outputs) scan_side.push_back(e.get());
+        for (auto &k : sp.sort) scan_side.push_back(k.expr.get());
+    }
+
+    // join keys and per-side filters are evaluated on the side scans
+    std::vector<sql::Expr *> left_side, right_side;
+    if (sp.join) {
+        JoinPlan &j = *sp.join;
+        for (auto &k : j.left_keys) left_side.push_back(k.get());
+        for (auto &k : j.right_keys) right_side.push_back(k.get());
+        if (j.left_filter) left_side.push_back(j.left_filter.get());
+        if (j.right_filter) right_side.push_back(j.right_filter.get());
+    }
+
+    std::vector<bool> used(ncolumns, false);
+    for (const auto *side : {&scan_side, &left_side, &right_side})
+        for (const sql::Expr *e : *side) mark_columns(*e, used);
+    std::vector<int> to(ncolumns, -1);
+    for (size_t i = 0; i < used.size(); ++i) {
+        if (!used[i]) continue;
+        to[i] = static_cast<int>(sp.scan_columns.size());
+        sp.scan_columns.push_back(static_cast<int>(i));
+    }
+    for (sql::Expr *e : scan_side) remap_columns(*e, to);
+    if (!sp.join) return;
+
+    // the join output is the left scan row followed by the right one
+    JoinPlan &j = *sp.join;
+    int nleft = static_cast<int>(ncolumns - j.right.columns.size());
+    std::vector<int> right_to(ncolumns, -1);
+    for (int c : sp.scan_columns) {
+        if (c < nleft) {
+            j.left_columns.push_back(c);
         } else {
-            cur.push_back(c);
+            right_to[c] = static_cast<int>(j.right_columns.size());
+            j.right_columns.push_back(c - nleft);
+        }
+    }
+    for (sql::Expr *e : left_side) remap_columns(*e, to);
+    for (sql::Expr *e : right_side) remap_columns(*e, right_to);
+}
+
+// Which join inputs an expression reads: bit 0 = left table, bit 1 = right
+static int join_sides(const sql::Expr &e, int nleft) {
+    int sides = 0;
+    if (e.type == sql::ExprType::COLUMN && e.column >= 0) sides |= e.column < nleft ? 1 : 2;
+    for (const auto &a : e.args) sides |= join_sides(*a, nleft);
+    return sides;
+}
+
+static sql::ExprPtr conjunction(std::vector<sql::ExprPtr> terms) {
+    sql::ExprPtr out;
+    for (auto &t : terms) {
+        if (!out) {
+            out = std::move(t);
+            continue;
         }
+        auto both = std::make_unique<sql::Expr>(sql::ExprType::AND);
+        both->args.push_back(std::move(out));
+        both->args.push_back(std::move(t));
+        out = std::move(both);
     }
-    if (!cur.empty()) out.push_back(trim(cur));
     return out;
 }
 
-// Map a table name to a segment id (simple hash)
-static uint32_t table_to_segment(const std::string &tname) {
-    std::hash<std::string> h;
-    return static_cast<uint32_t>(h(tname) & 0xFFFFFFFFu);
+// Split ON into equi-join keys and move single-table WHERE terms below the
+// join. Expressions are bound to the combined row at this point.
+static bool plan_join(sql::SelectStmt &s, const std::vector<BindTable> &scope, SelectPlan &sp, std::string &err) {
+    JoinPlan &j = *sp.join;
+    sql::JoinClause &jc = s.joins[0];
+    int nleft = scope[1].offset;
+    j.left_outer = jc.left;
+
+    if (!bind_expr(*jc.on, scope, err)) return false;
+    std::vector<const sql::Expr *> terms;
+    collect_conjuncts(jc.on.get(), terms);
+    for (const sql::Expr *t : terms) {
+        int l = t->type == sql::ExprType::COMPARE && t->op == sql::CompareOp::EQ ? join_sides(*t->args[0], nleft) : 0;
+        int r = l ? join_sides(*t->args[1], nleft) : 0;
+        if (contains_aggregate(*t) || !((l == 1 && r == 2) || (l == 2 && r == 1))) {
+            err = "JOIN ... ON supports only equalities between the two tables";
+            return false;
+        }
+        j.left_keys.push_back(sql::clone_expr(*t->args[l == 1 ? 0 : 1]));
+        j.right_keys.push_back(sql::clone_expr(*t->args[l == 1 ? 1 : 0]));
+    }
+
+    if (!sp.filter) return true;
+    std::vector<const sql::Expr *> where;
+    collect_conjuncts(sp.filter.get(), where);
+    std::vector<sql::ExprPtr> left, right, rest;
+    for (const sql::Expr *t : where) {
+        int sides = join_sides(*t, nleft);
+        // for a LEFT JOIN a right-side term must see the defaults of unmatched rows
+        if (sides == 1) left.push_back(sql::clone_expr(*t));
+        else if (sides == 2 && !j.left_outer) right.push_back(sql::clone_expr(*t));
+        else rest.push_back(sql::clone_expr(*t));
+    }
+    j.left_filter = conjunction(std::move(left));
+    j.right_filter = conjunction(std::move(right));
+    sp.filter = conjunction(std::move(rest));
+    return true;
 }
 
-// Read/write the "used bytes" header from page.data
-static uint32_t read_page_used_bytes(const storage::Page &p) {
-    uint32_t used = 0;
-    if (sizeof(p.data) >= sizeof(uint32_t)) {
-        std::memcpy(&used, p.data, sizeof(uint32_t));
+// `scope` holds the FROM table and, for a join, the joined table after it
+static bool plan_select(sql::SelectStmt &s, const std::vector<BindTable> &scope, SelectPlan &sp, std::string &err) {
+    size_t ncolumns = 0;
+    for (const BindTable &t : scope) ncolumns += t.table->columns.size();
+
+    if (s.where) {
+        if (!bind_expr(*s.where, scope, err)) return false;
+        if (contains_aggregate(*s.where)) {
+            err = "aggregates are not allowed in WHERE";
+            return false;
+        }
+        sp.filter = sql::clone_expr(*s.where);
+    }
+    if (sp.join && !plan_join(s, scope, sp, err)) return false;
+
+    // select list, with `*` expanded to the table columns
+    for (const auto &item : s.items) {
+        if (item.expr->type == sql::ExprType::STAR) {
+            for (const BindTable &t : scope) {
+                for (size_t i = 0; i < t.table->columns.size(); ++i) {
+                    auto col = std::make_unique<sql::Expr>(sql::ExprType::COLUMN);
+                    col->name = t.table->columns[i].name;
+                    col->column = t.offset + static_cast<int>(i);
+                    sp.outputs.push_back(std::move(col));
+                    sp.names.push_back(t.table->columns[i].name);
+                }
+            }
+            continue;
+        }
+        if (!check_aggregates(*item.expr, false, err)) return false;
+        sql::ExprPtr e = sql::clone_expr(*item.expr);
+        if (!bind_expr(*e, scope, err)) return false;
+        if (!item.alias.empty()) sp.names.push_back(item.alias);
+        else if (e->type == sql::ExprType::COLUMN) sp.names.push_back(e->name);
+        else sp.names.push_back(sql::expr_to_string(*e));
+        sp.outputs.push_back(std::move(e));
+    }
+
+    // ORDER BY may name a select-list alias or position
+    for (const auto &o : s.order_by) {
+        const sql::Expr &oe = *o.expr;
+        sql::ExprPtr key;
+        if (oe.type == sql::ExprType::COLUMN && oe.table.empty()) {
+            for (size_t i = 0; i < sp.names.size() && !key; ++i)
+                if (sp.names[i] == oe.name) key = sql::clone_expr(*sp.outputs[i]);
+        } else if (oe.type == sql::ExprType::LITERAL && oe.value.type() == storage::ValueType::INT) {
+            int32_t pos = oe.value.as_int();
+            if (pos < 1 || static_cast<size_t>(pos) > sp.outputs.size()) {
+                err = "ORDER BY position " + std::to_string(pos) + " is out of range";
+                return false;
+            }
+            key = sql::clone_expr(*sp.outputs[pos - 1]);
+        }
+        if (!key) {
+            if (!check_aggregates(oe, false, err)) return false;
+            key = sql::clone_expr(oe);
+            if (!bind_expr(*key, scope, err)) return false;
+        }
+        sp.sort.push_back(SortKey{std::move(key), o.desc});
+    }
+
+    sp.aggregate = !s.group_by.empty();
+    for (const auto &e : sp.outputs) sp.aggregate = sp.aggregate || contains_aggregate(*e);
+    for (const auto &k : sp.sort) sp.aggregate = sp.aggregate || contains_aggregate(*k.expr);
+    if (!sp.aggregate) {
+        push_down_projection(ncolumns, sp);
+        return true;
     }
-    return used;
+
+    for (const auto &g : s.group_by) {
+        if (contains_aggregate(*g)) {
+            err = "aggregates are not allowed in GROUP BY";
+            return false;
+        }
+        sql::ExprPtr key = sql::clone_expr(*g);
+        if (!bind_expr(*key, scope, err)) return false;
+        sp.group_keys.push_back(std::move(key));
+    }
+    std::vector<sql::ExprPtr> agg_calls;
+    for (auto &e : sp.outputs)
+        if (!rewrite_for_aggregate(e, sp, agg_calls, err)) return false;
+    for (auto &k : sp.sort)
+        if (!rewrite_for_aggregate(k.expr, sp, agg_calls, err)) return false;
+    push_down_projection(ncolumns, sp);
+    return true;
+}
+
+// `col BETWEEN a AND b` / `col IN (a, ...)` on a zone-mapped INT column
+static bool int_range_of(const sql::Expr &c, const Params *params, const storage::ZoneMap &zones,
+                         storage::ZoneMap::IntRange &r) {
+    if ((c.type != sql::ExprType::BETWEEN && c.type != sql::ExprType::IN) ||
+        c.args[0]->type != sql::ExprType::COLUMN)
+        return false;
+    int slot = zones.slot_of(c.args[0]->column);
+    if (slot < 0) return false;
+    r = storage::ZoneMap::IntRange{static_cast<size_t>(slot), INT32_MAX, INT32_MIN};
+    for (size_t i = 1; i < c.args.size(); ++i) {
+        if (!is_constant(*c.args[i])) return false;
+        storage::Value v = eval_expr(*c.args[i], {}, params);
+        if (v.type() != storage::ValueType::INT) return false;
+        r.lo = std::min<int64_t>(r.lo, v.as_int());
+        r.hi = std::max<int64_t>(r.hi, v.as_int());
+    }
+    if (c.type == sql::ExprType::BETWEEN) {
+        r.lo = eval_expr(*c.args[1], {}, params).as_int();
+        r.hi = eval_expr(*c.args[2], {}, params).as_int();
+    }
+    return true;
 }
 
-static void write_page_used_bytes(storage::Page &p, uint32_t used) {
-    if (sizeof(p.data) >= sizeof(uint32_t)) {
-        std::memcpy(p.data, &used, sizeof(uint32_t));
+// How a single-table scan reads its rows, picked by estimated cost: every
+// page (split over `workers` threads), or a hash index probe for an
+// `<indexed col> = <literal>` conjunct. A table never analyzed has no costs
+// to go by: the first index that applies is used, small table or not.
+struct AccessPath {
+    const catalog::Index *index = nullptr;   // null: sequential scan
+    storage::Value key;                      // to probe `index` with
+    uint32_t workers = 1;
+    double rows = 0;                         // estimated rows read
+    double cost = 0;
+};
+
+// `parallel`: the rows may leave the scan in any order
+static AccessPath access_path(const catalog::Table &table, const std::vector<const sql::Expr *> &conjuncts,
+                              const Params *params, uint32_t pages, bool parallel) {
+    AccessPath path;
+    path.rows = cost::table_rows(table, pages);
+    path.cost = cost::seq_scan(pages, path.rows);
+    if (parallel) path.workers = cost::parallel_workers(path.cost);
+
+    for (const sql::Expr *c : conjuncts) {
+        int col;
+        sql::CompareOp op;
+        storage::Value val;
+        if (!column_vs_literal(*c, params, col, op, val) || op != sql::CompareOp::EQ) continue;
+        for (const auto &idx : table.indexes) {
+            if (idx.column != table.columns[col].name) continue;
+            storage::Value key = coerce_to_column(table.columns[col], val);
+            double matches = table.stats ? std::max(1.0, cost::eq_selectivity(table, col, key) * path.rows) : 1;
+            double c_idx = cost::index_scan(matches, pages);
+            if (c_idx < path.cost || (!table.stats && !path.index)) {
+                path.index = &idx;
+                path.key = std::move(key);
+                path.workers = 1;
+                path.rows = matches;
+                path.cost = c_idx;
+            }
+        }
     }
+    return path;
+}
+
+// `op` as an EXPLAIN plan node over `inputs` (nodes made the same way),
+// unless the query just runs
+static OperatorPtr explained(ExplainMode mode, OperatorPtr op, std::string label, const std::vector<Operator *> &inputs) {
+    if (mode == ExplainMode::NONE) return op;
+    std::vector<std::shared_ptr<const PlanNode>> from;
+    for (Operator *in : inputs) from.push_back(static_cast<const ExplainOp *>(in)->node());
+    return std::make_unique<ExplainOp>(std::move(op), std::move(label), std::move(from), mode == ExplainMode::ANALYZE);
+}
+
+// " (est. rows=.. cost=..)" of an access path
+static std::string estimate(double rows, double cost) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), " (est. rows=%.0f cost=%.1f)", rows, cost);
+    return buf;
 }
 
 //
@@ -70,269 +435,1255 @@ static void write_page_used_bytes(storage::Page &p, uint32_t used) {
 // ===============================================================
 //
 
-Executor::Executor(catalog::Catalog &catalog, storage::BufferPool &bp)
-    : catalog_(catalog), bp_(bp) {}
+// lock owner of vacuum work, which runs outside any transaction
+static constexpr storage::TxnId MAINTENANCE = UINT32_MAX;
 
-std::string Executor::execute(const std::string &sql) {
-    std::string s = trim(sql);
-    if (s.empty()) return "";
+Executor::Executor(catalog::Catalog &catalog, storage::BufferPool &bp, storage::TransactionManager &txns,
+                   storage::LockManager &locks, const SpillLimits &limits)
+    : catalog_(catalog), bp_(bp), limits_(limits), txns_(txns), locks_(locks), vacuum_(bp, free_space_),
+      plan_cache_(256) {}
 
-    // Convert to uppercase for command detection
-    std::string upper(s.size(), '\0');
-    std::transform(s.begin(), s.end(), upper.begin(),
-                   [](unsigned char c){ return std::toupper(c); });
+void Executor::execute(Session &session, const std::string &sql, ResultSink &sink) {
+    run_statement(session, sql, nullptr, sink);
+}
 
-    if (upper.rfind("CREATE TABLE", 0) == 0) return handle_create_table(s);
-    if (upper.rfind("INSERT INTO", 0) == 0) return handle_insert(s);
-    if (upper.rfind("SELECT", 0) == 0)       return handle_select(s);
-    if (upper.rfind("UPDATE", 0) == 0)       return handle_update(s);
-    if (upper.rfind("DELETE", 0) == 0)       return handle_delete(s);
+void Executor::execute(Session &session, const std::string &sql, const Params &params, ResultSink &sink) {
+    run_statement(session, sql, &params, sink);
+}
 
+void Executor::run_statement(Session &session, const std::string &sql, const Params *params, ResultSink &sink) {
+    std::lock_guard<std::mutex> in_order(session.mu_);
+    std::string status;
+    storage::Lsn commit = 0;
+    uint64_t schema = catalog_.version();
+    {
+        std::shared_lock<std::shared_mutex> running = [&] {
+            std::lock_guard<std::mutex> after_checkpoint(checkpoint_mu_);
+            return std::shared_lock<std::shared_mutex>(statement_mu_);
+        }();
+        storage::TxnId xid = txns_.begin();
+        std::vector<storage::RowUndo> undo;
+        storage::Txn txn{xid, txns_.snapshot(xid), &versions_, &undo};
+        session.txn_ = &txn;
+        session.running_ = &running;
+        session.wrote_ = false;
+        session.inserted_.clear();
+        bool failed = true;
+        std::exception_ptr error;
+        try {
+            status = execute_statement(session, sql, params, sink);
+            failed = status.rfind("ERR", 0) == 0;
+            if (session.wrote_ && !failed) commit = log_commit(xid);
+        } catch (...) {
+            failed = true;
+            error = std::current_exception();
+        }
+        // a statement that fails changes nothing
+        if (failed && session.wrote_) {
+            try {
+                rollback(session, txn);
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+        session.txn_ = nullptr;
+        session.running_ = nullptr;
+        txns_.release(txn.snapshot);
+        txns_.end(xid);
+        // a writer waiting for the locks reads the rows as committed (or put back)
+        locks_.release_all(xid);
+        if (error) std::rethrow_exception(error);
+    }
+    // group commit: other statements run while this one waits for the sync
+    if (commit) bp_.wal()->flush(commit);
+    if (catalog_.version() != schema) {
+        // what DDL or ANALYZE replaced goes now if nothing runs, else at the checkpoint
+        std::unique_lock<std::shared_mutex> alone(statement_mu_, std::try_to_lock);
+        if (alone.owns_lock()) catalog_.reclaim();
+    }
+    if (!status.empty()) sink.status(status);
+}
+
+// Log the changed pages and close them with a COMMIT record; returns the LSN
+// that makes the statement durable. Pages other statements changed meanwhile
+// go into the log with them: their own COMMIT follows.
+storage::Lsn Executor::log_commit(storage::TxnId xid) {
+    storage::Wal *wal = bp_.wal();
+    if (!wal) return 0;
+    bp_.log_changes();
+    return wal->append(storage::WalRecord{storage::WalType::COMMIT, 0, 0,
+                                          std::string(reinterpret_cast<const char *>(&xid), sizeof(xid))});
+}
+
+std::string Executor::execute_statement(Session &s, const std::string &sql, const Params *params,
+                                       ResultSink &sink) {
+    if (sql.find_first_not_of(" \t\r\n;") == std::string::npos) return "";
+
+    std::string key = PlanCache::normalize(sql);
+    std::shared_ptr<const Plan> plan = key.empty() ? nullptr : plan_cache_.get(key, catalog_.version());
+
+    std::string err;
+    if (!plan) {
+        sql::Statement stmt;
+        if (!sql::parse(sql, stmt, err)) return "ERR: " + err;
+
+        // DDL and session statements run directly and are never cached (and
+        // take no parameters: with some, they fail to plan below)
+        if (!params || params->empty()) {
+            try {
+                if (auto *t = stmt.as<sql::TransactionStmt>()) return handle_transaction(s, *t);
+                if (s.in_transaction_ && (stmt.as<sql::CreateTableStmt>() || stmt.as<sql::CreateIndexStmt>()))
+                    return "ERR: CREATE cannot run inside a transaction";
+                if (auto *t = stmt.as<sql::AnalyzeStmt>())     return handle_analyze(s, *t);
+                if (auto *t = stmt.as<sql::ExplainStmt>())     return handle_explain(s, *t, sink);
+                if (auto *t = stmt.as<sql::CreateTableStmt>()) return handle_create_table(*t);
+                if (auto *t = stmt.as<sql::CreateIndexStmt>()) return handle_create_index(s, *t);
+                if (auto *t = stmt.as<sql::PrepareStmt>())     return handle_prepare(s, *t);
+                if (auto *t = stmt.as<sql::ExecuteStmt>())     return handle_execute(s, *t, sink);
+                if (auto *t = stmt.as<sql::DeallocateStmt>()) {
+                    return s.prepared_.erase(t->name) ? "OK: deallocated " + t->name
+                                                      : "ERR: unknown prepared statement " + t->name;
+                }
+            } catch (const std::exception &e) {
+                return std::string("ERR: ") + e.what();
+            }
+        }
+
+        plan = build_plan(std::move(stmt), err);
+        if (!plan) return "ERR: " + err;
+        plan_cache_.put(key, plan);
+    }
+
+    if (!params && plan->stmt.param_count > 0) return "ERR: '?' parameters are only allowed in PREPARE";
+    if (params && static_cast<int>(params->size()) != plan->stmt.param_count) {
+        return "ERR: expected " + std::to_string(plan->stmt.param_count) + " parameters, got " +
+               std::to_string(params->size());
+    }
+    if (s.in_transaction_ && !plan->stmt.as<sql::SelectStmt>()) return queue_write(s, plan, params, sql);
+    return run_plan(s, *plan, params, sink);
+}
+
+std::shared_ptr<const Plan> Executor::build_plan(sql::Statement stmt, std::string &err) {
+    auto plan = std::make_shared<Plan>();
+    // read the version first: a concurrent DDL can only make the plan look older
+    plan->catalog_version = catalog_.version();
+
+    std::string tname;
+    if (auto *s = stmt.as<sql::SelectStmt>()) tname = s->from.name;
+    else if (auto *s = stmt.as<sql::InsertStmt>()) tname = s->table;
+    else if (auto *s = stmt.as<sql::UpdateStmt>()) tname = s->table;
+    else if (auto *s = stmt.as<sql::DeleteStmt>()) tname = s->table;
+    else {
+        err = "statement cannot be planned";
+        return nullptr;
+    }
+
+    auto maybe = catalog_.get_table(tname);
+    if (!maybe) {
+        err = "unknown table " + tname;
+        return nullptr;
+    }
+    plan->table = *maybe;
+    const catalog::Table &table = plan->table;
+
+    if (auto *s = stmt.as<sql::SelectStmt>()) {
+        std::vector<BindTable> scope{BindTable{&table, s->from.alias, 0}};
+        if (s->joins.size() > 1) {
+            err = "only one JOIN per SELECT is supported";
+            return nullptr;
+        }
+        if (!s->joins.empty()) {
+            auto right = catalog_.get_table(s->joins[0].table.name);
+            if (!right) {
+                err = "unknown table " + s->joins[0].table.name;
+                return nullptr;
+            }
+            plan->select.join = std::make_unique<JoinPlan>();
+            plan->select.join->right = *right;
+            scope.push_back(BindTable{&plan->select.join->right, s->joins[0].table.alias,
+                                      static_cast<int>(table.columns.size())});
+        }
+        if (!plan_select(*s, scope, plan->select, err)) return nullptr;
+    } else if (auto *s = stmt.as<sql::InsertStmt>()) {
+        // Map VALUES positions to table columns
+        if (s->columns.empty()) {
+            for (size_t i = 0; i < table.columns.size(); ++i) plan->insert_targets.push_back(static_cast<int>(i));
+        } else {
+            // every column exactly once: there are no defaults to fill a gap with
+            std::vector<bool> given(table.columns.size(), false);
+            for (const auto &c : s->columns) {
+                int idx = table.column_index(c);
+                if (idx < 0) {
+                    err = "unknown column " + c;
+                    return nullptr;
+                }
+                if (given[idx]) {
+                    err = "column name given twice: " + c;
+                    return nullptr;
+                }
+                given[idx] = true;
+                plan->insert_targets.push_back(idx);
+            }
+            for (size_t i = 0; i < given.size(); ++i) {
+                if (!given[i]) {
+                    err = "column list must name every column: " + table.columns[i].name + " is missing";
+                    return nullptr;
+                }
+            }
+        }
+        for (const auto &row : s->rows) {
+            if (row.size() != table.columns.size()) {
+                err = "column count mismatch: expected " + std::to_string(table.columns.size());
+                return nullptr;
+            }
+        }
+    } else if (auto *s = stmt.as<sql::UpdateStmt>()) {
+        for (auto &a : s->assignments) {
+            if (table.column_index(a.first) < 0) {
+                err = "unknown column " + a.first;
+                return nullptr;
+            }
+            if (!bind_expr(*a.second, table, "", err)) return nullptr;
+        }
+        if (s->where && !bind_expr(*s->where, table, "", err)) return nullptr;
+    } else if (auto *s = stmt.as<sql::DeleteStmt>()) {
+        if (s->where && !bind_expr(*s->where, table, "", err)) return nullptr;
+    }
+
+    plan->stmt = std::move(stmt);
+    return plan;
+}
+
+std::string Executor::run_plan(Session &s, const Plan &plan, const Params *params, ResultSink &sink) {
+    try {
+        if (auto *t = plan.stmt.as<sql::InsertStmt>()) return handle_insert(s, plan, *t, params);
+        if (auto *t = plan.stmt.as<sql::SelectStmt>()) return handle_select(s, plan, *t, params, sink);
+        if (auto *t = plan.stmt.as<sql::UpdateStmt>()) return handle_update(s, plan, *t, params);
+        if (auto *t = plan.stmt.as<sql::DeleteStmt>()) return handle_delete(s, plan, *t, params);
+    } catch (const std::exception &e) {
+        return std::string("ERR: ") + e.what();
+    }
     return "ERR: unsupported command";
 }
 
+//
+// ------------------------ PREPARE / EXECUTE --------------------
+//
+std::string Executor::handle_prepare(Session &s, const sql::PrepareStmt &stmt) {
+    if (s.prepared_.count(stmt.name)) return "ERR: prepared statement already exists: " + stmt.name;
+
+    Session::Prepared p;
+    p.body = stmt.body;
+    p.key = PlanCache::normalize(stmt.body);
+    std::string err;
+    p.plan = plan_cache_.get(p.key, catalog_.version());
+    if (!p.plan) {
+        sql::Statement body;
+        if (!sql::parse(stmt.body, body, err)) return "ERR: " + err;
+        p.plan = build_plan(std::move(body), err);
+        if (!p.plan) return "ERR: " + err;
+        plan_cache_.put(p.key, p.plan);
+    }
+
+    int nparams = p.plan->stmt.param_count;
+    s.prepared_.emplace(stmt.name, std::move(p));
+    return "OK: prepared " + stmt.name + " (" + std::to_string(nparams) + " parameters)";
+}
+
+std::string Executor::handle_execute(Session &s, const sql::ExecuteStmt &stmt, ResultSink &sink) {
+    Params params;
+    std::string err;
+    std::shared_ptr<const Plan> plan = prepared_plan(s, stmt, params, err); // kept alive even if the cache evicts it
+    if (!plan) return "ERR: " + err;
+    if (s.in_transaction_ && !plan->stmt.as<sql::SelectStmt>())
+        return queue_write(s, plan, &params, s.prepared_.at(stmt.name).body);
+    return run_plan(s, *plan, &params, sink);
+}
+
+std::shared_ptr<const Plan> Executor::prepared_plan(Session &s, const sql::ExecuteStmt &stmt, Params &params,
+                                                    std::string &err) {
+    auto it = s.prepared_.find(stmt.name);
+    if (it == s.prepared_.end()) {
+        err = "unknown prepared statement " + stmt.name;
+        return nullptr;
+    }
+    Session::Prepared &p = it->second;
+
+    // re-plan if DDL happened since PREPARE
+    if (p.plan->catalog_version != catalog_.version()) {
+        p.plan = plan_cache_.get(p.key, catalog_.version());
+        if (!p.plan) {
+            sql::Statement body;
+            if (!sql::parse(p.body, body, err)) return nullptr;
+            std::shared_ptr<const Plan> fresh = build_plan(std::move(body), err);
+            if (!fresh) {
+                s.prepared_.erase(it);
+                return nullptr;
+            }
+            p.plan = fresh;
+            plan_cache_.put(p.key, p.plan);
+        }
+    }
+
+    if (static_cast<int>(stmt.args.size()) != p.plan->stmt.param_count) {
+        err = "expected " + std::to_string(p.plan->stmt.param_count) + " parameters, got " +
+              std::to_string(stmt.args.size());
+        return nullptr;
+    }
+    params.clear();
+    params.reserve(stmt.args.size());
+    for (const auto &a : stmt.args) params.push_back(eval_expr(*a, {}));
+    return p.plan;
+}
+
 //
 // ------------------------- INSERT ------------------------------
 //
-std::string Executor::handle_insert(const std::string &sql) {
-    // Parse SQL: INSERT INTO <table> VALUES (v1, v2, ...)
-    size_t pos_into   = sql.find("INTO");
-    size_t pos_values = sql.find("VALUES", pos_into);
-    if (pos_into == std::string::npos || pos_values == std::string::npos)
-        return "ERR: malformed INSERT";
-
-    std::string tbl = trim(sql.substr(pos_into + 4, pos_values - (pos_into + 4)));
-    // strip optional column list
-    auto paren = tbl.find('(');
-    if (paren != std::string::npos) tbl = trim(tbl.substr(0, paren));
-
-    // Extract values inside parentheses
-    size_t p1 = sql.find('(', pos_values);
-    size_t p2 = sql.rfind(')');
-    if (p1 == std::string::npos || p2 == std::string::npos || p2 <= p1)
-        return "ERR: malformed INSERT values";
-
-    std::string vals = sql.substr(p1 + 1, p2 - p1 - 1);
-    auto pieces = split_csv(vals);
-
-    // Lookup table schema
-    auto maybe = catalog_.get_table(tbl);
-    if (!maybe) return "ERR: unknown table " + tbl;
-    const catalog::Table &table = *maybe;
-
-    if (pieces.size() != table.columns.size()) {
-        return "ERR: column count mismatch: expected " +
-               std::to_string(table.columns.size());
-    }
-
-    // ----------------------------------------------
-    // Build Tuple from parsed values
-    // ----------------------------------------------
-    std::vector<storage::Value> vals_vec;
-    vals_vec.reserve(pieces.size());
-
-    for (size_t i = 0; i < pieces.size(); i++) {
-        std::string v = trim(pieces[i]);
-        if (v.size() >= 2 && v.front() == '"' && v.back() == '"')
-            v = v.substr(1, v.size() - 2);
-
-        const auto &col = table.columns[i];
-        std::string type_upper = col.type;
-        std::transform(type_upper.begin(), type_upper.end(), type_upper.begin(), ::toupper);
-
-        if (type_upper == "INT" || type_upper == "INTEGER")
-            vals_vec.emplace_back(std::stoi(v));
-        else
-            vals_vec.emplace_back(v);
-    }
-
-    storage::Tuple tuple(std::move(vals_vec));
-    auto payload = tuple.serialize();
-
-    // ----------------------------------------------
-    // Write to pages
-    // ----------------------------------------------
-    uint32_t seg = table_to_segment(tbl);
-    uint32_t page_no = 0;
-    bool written = false;
-
-    while (true) {
-        storage::PageId pid{seg, page_no};
+// Rows of the VALUES expressions, in table column order
+static std::vector<storage::Tuple> insert_tuples(const Plan &plan, const sql::InsertStmt &stmt,
+                                                 const Params *params) {
+    const catalog::Table &table = plan.table;
+    const std::vector<int> &targets = plan.insert_targets;
+    std::vector<storage::Tuple> rows;
+    rows.reserve(stmt.rows.size());
+    for (const auto &row : stmt.rows) {
+        std::vector<storage::Value> vals_vec(table.columns.size());
+        static const std::vector<storage::Value> no_row;
+        for (size_t i = 0; i < row.size(); i++) {
+            const auto &col = table.columns[targets[i]];
+            vals_vec[targets[i]] = coerce_to_column(col, eval_expr(*row[i], no_row, params));
+        }
+        rows.emplace_back(std::move(vals_vec));
+    }
+    return rows;
+}
+
+std::string Executor::handle_insert(Session &s, const Plan &plan, const sql::InsertStmt &stmt,
+                                    const Params *params) {
+    return insert_rows(s, plan.table, insert_tuples(plan, stmt, params));
+}
+
+// New rows are nobody else's yet: they take no row locks
+std::string Executor::insert_rows(Session &s, const catalog::Table &planned, const std::vector<storage::Tuple> &rows) {
+    std::string err;
+    if (!lock_table(s, planned, storage::LockMode::IX, err)) return "ERR: " + err;
+    const catalog::Table &table = current_table(planned);
+    storage::TableHeap heap(table.id, &free_space_, s.txn_);
+    storage::ZoneMap zones = table_zone_map(table);
+    size_t inserted = 0;
+
+    for (const storage::Tuple &tuple : rows) {
+        auto payload = tuple.serialize();
+
+        // ----------------------------------------------
+        // Write to pages, then maintain zone map + indexes
+        // ----------------------------------------------
+        storage::RecordId rid;
         try {
-            storage::Frame *frame = bp_.fetch_page(pid, true);
-            uint32_t used = read_page_used_bytes(frame->page);
-
-            uint32_t rec_len = static_cast<uint32_t>(payload.size());
-            uint32_t need = 4 + rec_len;  // record header + tuple data
-            size_t available = sizeof(frame->page.data) - used;
-
-            if (need + 4 <= available) {
-                // Append record
-                uint32_t offset = used + 4;
-                std::memcpy(frame->page.data + offset, &rec_len, 4);
-                std::memcpy(frame->page.data + offset + 4, payload.data(), rec_len);
-
-                used += need;
-                write_page_used_bytes(frame->page, used);
-
-                bp_.unpin_page(frame, true);
-                written = true;
-                break;
-            } else {
-                bp_.unpin_page(frame, false);
-                page_no++;
-                continue;
-            }
-        } catch (const std::out_of_range &) {
-            // Allocate new page if not exist
-            storage::PageId newpid = bp_.allocate_page(seg);
-            storage::Frame *frame  = bp_.fetch_page(newpid, true);
+            rid = heap.Insert(bp_, payload);
+        } catch (const std::exception &e) {
+            return std::string("ERR: failed to write row: ") + e.what();
+        }
+        s.wrote_ = true;
+        s.inserted_.insert(table.id);
+
+        zones.Update(bp_, rid.page_number, tuple.values());
 
-            uint32_t rec_len = static_cast<uint32_t>(payload.size());
-            std::memcpy(frame->page.data + 4, &rec_len, 4);
-            std::memcpy(frame->page.data + 8, payload.data(), rec_len);
+        for (const auto &idx : table.indexes) {
+            int col = table.column_index(idx.column);
+            if (col < 0) continue;
+            open_index(idx).Insert(storage::HashIndex::HashValue(tuple.values()[col]), rid);
+        }
+        inserted++;
+    }
+
+    return "OK: " + std::to_string(inserted) + (inserted == 1 ? " row inserted" : " rows inserted");
+}
 
-            uint32_t used = 4 + rec_len;
-            write_page_used_bytes(frame->page, used);
+//
+// ---------------------- BEGIN / COMMIT / ROLLBACK --------------
+//
+// Queries inside the block read committed data as usual; the block's own
+// writes only exist from COMMIT on. Nothing reaches the heap or the log
+// before COMMIT, so ROLLBACK just forgets the queue.
+std::string Executor::handle_transaction(Session &s, const sql::TransactionStmt &stmt) {
+    switch (stmt.kind) {
+    case sql::TransactionStmt::Kind::BEGIN:
+        if (s.in_transaction_) return "ERR: a transaction is already open";
+        s.in_transaction_ = true;
+        return "OK: transaction started";
+    case sql::TransactionStmt::Kind::COMMIT:
+        if (!s.in_transaction_) return "ERR: no transaction is open";
+        return commit_pending(s);
+    case sql::TransactionStmt::Kind::ROLLBACK:
+        if (!s.in_transaction_) return "ERR: no transaction is open";
+        s.in_transaction_ = false;
+        s.pending_.clear();
+        return "OK: transaction rolled back";
+    }
+    return "ERR: unsupported command";
+}
 
-            bp_.unpin_page(frame, true);
-            written = true;
-            break;
+std::string Executor::queue_write(Session &s, const std::shared_ptr<const Plan> &plan, const Params *params,
+                                  const std::string &sql) {
+    auto &pending = s.pending_;
+    try {
+        if (auto *ins = plan->stmt.as<sql::InsertStmt>()) {
+            std::vector<storage::Tuple> rows = insert_tuples(*plan, *ins, params);
+            size_t n = rows.size();
+            // consecutive inserts into one table are stored in one go at COMMIT
+            if (pending.empty() || pending.back().plan || pending.back().table != plan->table.name) {
+                pending.emplace_back();
+                pending.back().table = plan->table.name;
+            }
+            auto &queued = pending.back().rows;
+            queued.insert(queued.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+            return "OK: " + std::to_string(n) + (n == 1 ? " row queued" : " rows queued");
         }
+    } catch (const std::exception &e) {
+        return std::string("ERR: ") + e.what();
+    }
+    Session::PendingWrite w;
+    w.table = plan->table.name;
+    w.plan = plan;
+    if (params) {
+        w.params = *params;
+        w.has_params = true;
     }
+    w.sql = sql;
+    pending.push_back(std::move(w));
+    return plan->stmt.as<sql::UpdateStmt>() ? "OK: update queued" : "OK: delete queued";
+}
+
+// Number in an "OK: <n> rows ..." status line
+static size_t affected_rows(const std::string &status) {
+    return std::strtoull(status.c_str() + 4, nullptr, 10);
+}
 
-    return written ? "OK: 1 row inserted"
-                   : "ERR: failed to write row";
+// Apply the queued writes in order. They share this statement's transaction,
+// so each sees the ones before it, and commit or abort together: a write that
+// fails stops the commit and the statement's failure undoes the writes before
+// it (run_statement logs the COMMIT record only when all of them succeeded).
+// The tables are locked up front, in one order for every session, so fewer
+// commits fail half way on a lock.
+std::string Executor::commit_pending(Session &s) {
+    std::vector<Session::PendingWrite> writes = std::move(s.pending_);
+    s.pending_.clear();
+    s.in_transaction_ = false;
+
+    // (a table dropped from under a write fails that write below)
+    std::vector<const catalog::Table *> tables;
+    for (const auto &w : writes)
+        if (const catalog::Table *t = catalog_.get_table(w.table)) tables.push_back(t);
+    std::sort(tables.begin(), tables.end(),
+              [](const catalog::Table *a, const catalog::Table *b) { return a->id < b->id; });
+    tables.erase(std::unique(tables.begin(), tables.end(),
+                             [](const catalog::Table *a, const catalog::Table *b) { return a->id == b->id; }),
+                 tables.end());
+    std::string err;
+    for (const catalog::Table *t : tables)
+        if (!lock_table(s, *t, storage::LockMode::IX, err)) return "ERR: commit failed, nothing was applied (" + err + ")";
+
+    size_t inserted = 0, updated = 0, deleted = 0;
+    for (size_t i = 0; i < writes.size(); ++i) {
+        Session::PendingWrite &w = writes[i];
+        std::string status;
+        if (!w.plan) {
+            const catalog::Table *table = catalog_.get_table(w.table);
+            status = table ? insert_rows(s, *table, w.rows) : "ERR: unknown table " + w.table;
+            if (status.rfind("OK", 0) == 0) inserted += affected_rows(status);
+        } else {
+            std::shared_ptr<const Plan> plan = w.plan;
+            std::string err;
+            if (plan->catalog_version != catalog_.version()) {
+                sql::Statement stmt;
+                if (sql::parse(w.sql, stmt, err)) plan = build_plan(std::move(stmt), err);
+                else plan = nullptr;
+            }
+            const Params *params = w.has_params ? &w.params : nullptr;
+            try {
+                if (!plan) status = "ERR: " + err;
+                else if (auto *u = plan->stmt.as<sql::UpdateStmt>()) status = handle_update(s, *plan, *u, params);
+                else if (auto *d = plan->stmt.as<sql::DeleteStmt>()) status = handle_delete(s, *plan, *d, params);
+            } catch (const std::exception &e) {
+                status = std::string("ERR: ") + e.what();
+            }
+            if (status.rfind("OK", 0) == 0) {
+                if (plan->stmt.as<sql::UpdateStmt>()) updated += affected_rows(status);
+                else deleted += affected_rows(status);
+            }
+        }
+        if (status.rfind("OK", 0) != 0)
+            return "ERR: commit stopped at write " + std::to_string(i + 1) + " of " + std::to_string(writes.size()) +
+                   " (" + status.substr(status.rfind("ERR: ", 0) == 0 ? 5 : 0) + "); nothing was applied";
+    }
+    return "OK: committed: " + std::to_string(inserted) + " inserted, " + std::to_string(updated) + " updated, " +
+           std::to_string(deleted) + " deleted";
 }
 
 //
 // ------------------------- SELECT ------------------------------
 //
-std::string Executor::handle_select(const std::string &sql) {
-    // Only supports: SELECT * FROM <table>
-    std::string upper = sql;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-    size_t pos_from = upper.find("FROM");
-    if (pos_from == std::string::npos) return "ERR: malformed SELECT";
-
-    std::string tbl = trim(sql.substr(pos_from + 4));
-    auto wherepos = tbl.find("WHERE");
-    if (wherepos != std::string::npos) tbl = trim(tbl.substr(0, wherepos));
-    if (!tbl.empty() && tbl.back() == ';') tbl.pop_back();
-    tbl = trim(tbl);
-
-    auto maybe = catalog_.get_table(tbl);
-    if (!maybe) return "ERR: unknown table " + tbl;
-    const catalog::Table &table = *maybe;
-
-    uint32_t seg = table_to_segment(tbl);
-    std::ostringstream out;
-    uint32_t page_no = 0;
-
-    // Scan all pages
-    while (true) {
-        storage::PageId pid{seg, page_no};
-        storage::Frame *frame = nullptr;
+std::string Executor::handle_select(Session &s, const Plan &plan, const sql::SelectStmt &stmt, const Params *params,
+                                    ResultSink &sink, ExplainMode mode) {
+    // Pipeline: scan | join -> [filter] -> [aggregate] -> [sort] -> [limit] -> project.
+    // Index and zone-map selection read stmt.where, which is bound to table positions
+    // (single-table queries only).
+    const catalog::Table &table = plan.table;
+    const SelectPlan &sp = plan.select;
+    uint32_t seg = table.id;
 
-        try {
-            frame = bp_.fetch_page(pid, false);
-        } catch (...) {
-            break;
-        }
+    // the snapshot keeps writers apart; IS only keeps out CREATE INDEX and vacuum
+    std::vector<const catalog::Table *> read{&table};
+    if (sp.join) read.push_back(&sp.join->right);
+    std::sort(read.begin(), read.end(),
+              [](const catalog::Table *a, const catalog::Table *b) { return a->id < b->id; });
+    std::string err;
+    for (const catalog::Table *t : read)
+        if (!lock_table(s, *t, storage::LockMode::IS, err)) return "ERR: " + err;
 
-        uint32_t used = read_page_used_bytes(frame->page);
-        uint32_t offset = 4;
+    std::vector<ColumnType> scan_types;
+    if (!sp.join)
+        for (int c : sp.scan_columns) scan_types.push_back(column_type_of(table.columns[c].kind));
 
-        while (offset + 4 <= used + 4) {
-            const char *ptr = frame->page.data + offset;
-            uint32_t rec_len = 0;
-            std::memcpy(&rec_len, ptr, 4);
-            ptr += 4;
+    std::vector<const sql::Expr *> conjuncts;
+    if (!sp.join) collect_conjuncts(stmt.where.get(), conjuncts);
 
-            if (rec_len == 0 || offset + 4 + rec_len > sizeof(frame->page.data))
-                break;
+    // equality on an indexed column: probe the hash index instead of scanning,
+    // if that reads less; aggregation runs one scan slice per thread
+    uint32_t pages = sp.join ? 0 : bp_.page_count(seg);
+    AccessPath path = sp.join ? AccessPath{} : access_path(table, conjuncts, params, pages, sp.aggregate);
 
-            const char *tuple_ptr = ptr;
-            storage::Tuple tup = storage::Tuple::deserialize(tuple_ptr);
+    // each operator becomes a plan node when the query is explained
+    auto node = [&](OperatorPtr op, std::string label, const std::vector<Operator *> &from) {
+        return explained(mode, std::move(op), std::move(label), from);
+    };
+
+    storage::ZoneMap zones = table_zone_map(table);
+    std::vector<storage::ZoneMap::IntRange> ranges;
+    std::vector<OperatorPtr> inputs;
+    bool limit_in_scan = false;
+    if (sp.join) {
+        inputs.push_back(join_input(s, plan, params, mode));
+    } else if (path.index) {
+        auto rids = open_index(*path.index).Lookup(storage::HashIndex::HashValue(path.key));
+        inputs.push_back(node(
+            std::make_unique<IndexScanOp>(bp_, seg, s.txn_, sp.scan_columns, scan_types, std::move(rids)),
+            "Index Scan on " + table.name + " using " + path.index->name + estimate(path.rows, path.cost), {}));
+    } else {
+        // range terms on INT columns let the zone map skip whole pages
+        for (const sql::Expr *c : conjuncts) {
+            storage::ZoneMap::IntRange in_range;
+            if (int_range_of(*c, params, zones, in_range)) {
+                ranges.push_back(in_range);
+                continue;
+            }
+            int col;
+            sql::CompareOp cop;
+            storage::Value val;
+            if (!column_vs_literal(*c, params, col, cop, val)) continue;
+            int slot = zones.slot_of(col);
+            if (slot < 0 || cop == sql::CompareOp::NE || val.type() != storage::ValueType::INT) continue;
+            int64_t v = val.as_int();
+            storage::ZoneMap::IntRange r{static_cast<size_t>(slot), INT32_MIN, INT32_MAX};
+            if (cop == sql::CompareOp::EQ || cop == sql::CompareOp::GE) r.lo = v;
+            if (cop == sql::CompareOp::EQ || cop == sql::CompareOp::LE) r.hi = v;
+            if (cop == sql::CompareOp::GT) r.lo = v + 1;
+            if (cop == sql::CompareOp::LT) r.hi = v - 1;
+            ranges.push_back(r);
+        }
+        std::function<bool(uint32_t)> keep_page;
+        if (!ranges.empty()) keep_page = [&](uint32_t page_no) { return zones.MayMatch(bp_, page_no, ranges); };
 
-            // Print row
-            for (size_t i = 0; i < tup.values().size() && i < table.columns.size(); ++i) {
-                out << table.columns[i].name << "=" << tup.values()[i].to_string();
-                if (i + 1 < tup.values().size()) out << ", ";
+        uint32_t parts = path.workers;
+        for (uint32_t i = 0; i < parts; ++i) {
+            auto scan = std::make_unique<SeqScanOp>(bp_, seg, s.txn_, sp.scan_columns, scan_types, keep_page);
+            std::string label = "Seq Scan on " + table.name;
+            if (parts > 1) {
+                uint32_t first = pages / parts * i, end = i + 1 == parts ? pages : pages / parts * (i + 1);
+                scan->restrict_pages(first, end);
+                label += " pages " + std::to_string(first) + ".." + std::to_string(end);
+            }
+            if (!ranges.empty()) label += ", zone map on " + std::to_string(ranges.size()) + " terms";
+            // rows leave the scan in output order: LIMIT/OFFSET can stop it early
+            if (!sp.aggregate && sp.sort.empty() && (stmt.limit >= 0 || stmt.offset > 0)) {
+                if (!sp.filter) {
+                    scan->set_limit(stmt.limit >= 0 ? stmt.limit : UINT64_MAX, stmt.offset);
+                    limit_in_scan = true;
+                    label += ", stops after LIMIT";
+                } else if (stmt.limit >= 0) {
+                    scan->set_first_batch(static_cast<size_t>(stmt.limit + stmt.offset));
+                }
             }
-            out << "\n";
+            inputs.push_back(node(std::move(scan), label + estimate(path.rows / parts, path.cost / parts), {}));
+        }
+    }
 
-            offset += 4 + rec_len;
+    if (sp.filter) {
+        for (auto &in : inputs) {
+            Operator *from = in.get();
+            in = node(std::make_unique<FilterOp>(std::move(in), *sp.filter, params), "Filter", {from});
         }
+    }
+    OperatorPtr op;
+    if (sp.aggregate) {
+        std::vector<Operator *> from;
+        for (const auto &in : inputs) from.push_back(in.get());
+        std::string label = "Hash Aggregate (" + std::to_string(sp.group_keys.size()) + " keys, " +
+                            std::to_string(sp.aggs.size()) + " aggregates";
+        if (inputs.size() > 1) label += ", " + std::to_string(inputs.size()) + " threads";
+        op = node(std::make_unique<AggregateOp>(std::move(inputs), sp.group_keys, sp.aggs, params,
+                                                limits_.agg_max_groups),
+                  label + ")", from);
+    } else {
+        op = std::move(inputs[0]);
+    }
+    if (!sp.sort.empty()) {
+        // the sort only has to produce the rows LIMIT/OFFSET can return
+        int64_t keep = stmt.limit >= 0 ? stmt.limit + stmt.offset : -1;
+        std::string label = keep >= 0 && keep <= SORT_TOP_N_MAX ? "Top-N Sort (" + std::to_string(keep) + " rows, "
+                                                               : std::string("Sort (");
+        Operator *from = op.get();
+        op = node(std::make_unique<SortOp>(std::move(op), sp.sort, params, bp_.segment_manager(), keep,
+                                            limits_.sort_memory_bytes),
+                  label + std::to_string(sp.sort.size()) + " keys)", {from});
+    }
+    if ((stmt.limit >= 0 || stmt.offset > 0) && !limit_in_scan) {
+        Operator *from = op.get();
+        op = node(std::make_unique<LimitOp>(std::move(op), stmt.limit, stmt.offset),
+                  "Limit " + (stmt.limit >= 0 ? std::to_string(stmt.limit) : std::string("ALL")) + " offset " +
+                      std::to_string(stmt.offset),
+                  {from});
+    }
+    Operator *from = op.get();
+    op = node(std::make_unique<ProjectOp>(std::move(op), sp.outputs, params),
+              "Project (" + std::to_string(sp.outputs.size()) + " columns)", {from});
+
+    if (mode != ExplainMode::NONE) return explain_result(static_cast<ExplainOp &>(*op), mode, sink);
 
-        bp_.unpin_page(frame, false);
-        page_no++;
+    // hand each batch over as soon as it is produced
+    sink.columns(sp.names, op->types());
+    Batch batch;
+    while (op->next(batch)) {
+        if (batch.size > 0 && !sink.batch(batch)) break;
+        if (!sink.ready() && !wait_for_sink(s, sink)) break;
     }
+    return "";
+}
 
-    std::string res = out.str();
-    return res.empty() ? "OK: 0 rows" : res;
+// Wait for a consumer that fell behind. A query that changed nothing lets go
+// of statement_mu_ meanwhile: a checkpoint (and every session behind it) does
+// not wait on a slow client. The query reads the table definitions copied
+// into its plan, not the catalog's, which the checkpoint may free.
+bool Executor::wait_for_sink(Session &s, ResultSink &sink) {
+    if (s.wrote_ || !s.running_) return sink.wait();
+    s.running_->unlock();
+    bool more = sink.wait();
+    std::lock_guard<std::mutex> after_checkpoint(checkpoint_mu_);
+    s.running_->lock();
+    return more;
+}
+
+//
+// -------------------------- EXPLAIN ----------------------------
+//
+// The query is planned as usual (through the plan cache) and its operators
+// are built as plan nodes; EXPLAIN ANALYZE runs them and drops the rows.
+// EXPLAIN EXECUTE shows the plan a prepared SELECT runs with those arguments.
+std::string Executor::handle_explain(Session &s, const sql::ExplainStmt &stmt, ResultSink &sink) {
+    std::string key = PlanCache::normalize(stmt.body);
+    std::shared_ptr<const Plan> plan = key.empty() ? nullptr : plan_cache_.get(key, catalog_.version());
+    std::string err;
+    Params params;
+    bool prepared = false;
+    if (!plan) {
+        sql::Statement body;
+        if (!sql::parse(stmt.body, body, err)) return "ERR: " + err;
+        // EXPLAIN EXECUTE: the plan the prepared statement runs now, with its arguments
+        if (auto *e = body.as<sql::ExecuteStmt>()) {
+            plan = prepared_plan(s, *e, params, err);
+            prepared = true;
+        } else {
+            plan = build_plan(std::move(body), err);
+            if (plan) plan_cache_.put(key, plan);
+        }
+        if (!plan) return "ERR: " + err;
+    }
+    if (!prepared && plan->stmt.param_count > 0) return "ERR: '?' parameters are only allowed in PREPARE";
+    const auto *select = plan->stmt.as<sql::SelectStmt>();
+    if (!select) return "ERR: only SELECT can be explained";
+    return handle_select(s, *plan, *select, prepared ? &params : nullptr, sink,
+                         stmt.analyze ? ExplainMode::ANALYZE : ExplainMode::PLAN);
+}
+
+// The plan under `root` as one text row per node
+std::string Executor::explain_result(ExplainOp &root, ExplainMode mode, ResultSink &sink) {
+    std::string total;
+    if (mode == ExplainMode::ANALYZE) {
+        auto start = std::chrono::steady_clock::now();
+        Batch batch;
+        while (root.next(batch)) {
+        }
+        char ms[32];
+        std::snprintf(ms, sizeof(ms), "%.3f",
+                      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        total = std::string("Execution time: ") + ms + " ms";
+    }
+    std::vector<std::string> lines;
+    root.node()->render(lines, mode == ExplainMode::ANALYZE);
+    if (!total.empty()) lines.push_back(total);
+
+    Batch out;
+    out.columns.resize(1);
+    out.columns[0].reset(ColumnType::TEXT);
+    for (const std::string &line : lines) out.columns[0].push_text(line);
+    out.size = lines.size();
+    sink.columns({"plan"}, {ColumnType::TEXT});
+    sink.batch(out);
+    return "";
 }
 
 //
 // ---------------------- CREATE TABLE ---------------------------
 //
-std::string Executor::handle_create_table(const std::string &sql) {
-    // Parse CREATE TABLE <name> (col type, ...)
-    std::string s = trim(sql);
-    std::string upper(s.size(), '\0');
-    std::transform(s.begin(), s.end(), upper.begin(), ::toupper);
-    if (upper.rfind("CREATE TABLE", 0) != 0) return "ERR: malformed CREATE TABLE";
-
-    auto p1 = s.find('(');
-    auto p2 = s.rfind(')');
-    if (p1 == std::string::npos || p2 == std::string::npos || p2 <= p1)
-        return "ERR: malformed CREATE TABLE";
-
-    std::string name_part = s.substr(strlen("CREATE TABLE"), p1 - strlen("CREATE TABLE"));
-    auto nl = name_part.find_first_not_of(" \t\r\n");
-    auto nr = name_part.find_last_not_of(" \t\r\n");
-    if (nl == std::string::npos) return "ERR: missing table name";
-    std::string tblname = name_part.substr(nl, nr - nl + 1);
-
-    // Parse columns
-    std::string cols_str = s.substr(p1 + 1, p2 - p1 - 1);
-    std::vector<catalog::Column> cols;
-    std::istringstream colss(cols_str);
-    std::string piece;
-    while (std::getline(colss, piece, ',')) {
-        auto cl = piece.find_first_not_of(" \t\r\n");
-        if (cl == std::string::npos) continue;
-        auto cr = piece.find_last_not_of(" \t\r\n");
-        std::string cp = piece.substr(cl, cr - cl + 1);
-
-        std::istringstream ps(cp);
-        std::string cname, ctype;
-        ps >> cname >> ctype;
-        if (cname.empty() || ctype.empty())
-            return "ERR: malformed column: " + cp;
-
-        cols.push_back({cname, ctype});
-    }
-
-    // Create table in catalog
+std::string Executor::handle_create_table(const sql::CreateTableStmt &stmt) {
+    // Create table in catalog (which persists it)
+    std::string err;
+    if (!catalog_.create_table(stmt.name, stmt.columns, err)) return "ERR: " + err;
+    return "OK: table created: " + stmt.name;
+}
+
+//
+// ---------------------- CREATE INDEX ---------------------------
+//
+// The table is locked S meanwhile: writers that started before have finished,
+// and the ones after it see the index in the catalog once they get their lock.
+std::string Executor::handle_create_index(Session &s, const sql::CreateIndexStmt &stmt) {
+    if (stmt.method != "HASH") return "ERR: unsupported index method " + stmt.method;
+
+    catalog::Index idx{stmt.name, stmt.column, stmt.method};
     std::string err;
-    if (!catalog_.create_table(tblname, cols, err)) return "ERR: " + err;
+    const catalog::Table *before = catalog_.get_table(stmt.table);
+    if (!before) return "ERR: unknown table " + stmt.table;
+    if (!lock_table(s, *before, storage::LockMode::S, err)) return "ERR: " + err;
+    if (!catalog_.create_index(stmt.table, idx, err)) return "ERR: " + err;
+    s.wrote_ = true;
 
-    // Persist catalog
-    std::string path = "./data/catalog.meta";
-    if (!catalog_.save_to_file(path, err))
-        return "ERR: failed to save catalog: " + err;
+    // Backfill from existing rows (the catalog gave the index its segment)
+    const catalog::Table *table = catalog_.get_table(stmt.table);
+    size_t rows = fill_index(*table, table->indexes.back());
+    return "OK: index created: " + stmt.name + " (" + std::to_string(rows) + " rows)";
+}
 
-    return "OK: table created: " + tblname;
+// Index every stored row, whichever snapshots see it
+size_t Executor::fill_index(const catalog::Table &table, const catalog::Index &idx) {
+    int col_no = table.column_index(idx.column);
+    storage::HashIndex &hidx = open_index(idx);
+    storage::TableHeap heap(table.id);
+    size_t rows = 0;
+    heap.ForEach(bp_, [&](const storage::RecordId &rid, const char *ptr, uint32_t) {
+        storage::Tuple tup = storage::Tuple::deserialize(ptr);
+        if (col_no >= 0 && static_cast<size_t>(col_no) < tup.values().size()) {
+            hidx.Insert(storage::HashIndex::HashValue(tup.values()[col_no]), rid);
+            rows++;
+        }
+    });
+    return rows;
 }
 
 //
-// ---------------------- NOT IMPLEMENTED ------------------------
+// -------------------------- ANALYZE ----------------------------
 //
-std::string Executor::handle_update(const std::string &) {
-    return "ERR: UPDATE not implemented in this version";
+// Statistics of the rows the statement's snapshot sees. IS keeps out CREATE
+// INDEX and vacuum, like a query; the new statistics make cached plans stale.
+std::string Executor::handle_analyze(Session &s, const sql::AnalyzeStmt &stmt) {
+    const catalog::Table *table = catalog_.get_table(stmt.table);
+    if (!table) return "ERR: unknown table " + stmt.table;
+    std::string err;
+    if (!lock_table(s, *table, storage::LockMode::IS, err)) return "ERR: " + err;
+
+    uint32_t pages = bp_.page_count(table->id);
+    StatsCollector stats(table->columns.size());
+    storage::TableHeap heap(table->id, nullptr, s.txn_);
+    heap.ForEach(bp_, [&](const storage::RecordId &, const char *ptr, uint32_t) {
+        stats.add(storage::Tuple::deserialize(ptr).values());
+    });
+    catalog::TableStats st = stats.finish(pages);
+    uint64_t rows = st.rows;
+    if (!catalog_.set_stats(stmt.table, std::move(st), err)) return "ERR: " + err;
+    return "OK: analyzed " + stmt.table + " (" + std::to_string(rows) + " rows, " + std::to_string(pages) + " pages)";
 }
 
-std::string Executor::handle_delete(const std::string &) {
-    return "ERR: DELETE not implemented in this version";
+// Hash join of the two sides of plan.select.join, each a filtered table scan
+OperatorPtr Executor::join_input(Session &s, const Plan &plan, const Params *params, ExplainMode mode) {
+    const JoinPlan &j = *plan.select.join;
+    auto side = [&](const catalog::Table &t, const std::vector<int> &columns, const sql::ExprPtr &filter) {
+        std::vector<ColumnType> types;
+        for (int c : columns) types.push_back(column_type_of(t.columns[c].kind));
+        OperatorPtr op = explained(mode, std::make_unique<SeqScanOp>(bp_, t.id, s.txn_, columns, types),
+                                   "Seq Scan on " + t.name, {});
+        if (filter) {
+            Operator *from = op.get();
+            op = explained(mode, std::make_unique<FilterOp>(std::move(op), *filter, params), "Filter", {from});
+        }
+        return op;
+    };
+    OperatorPtr left = side(plan.table, j.left_columns, j.left_filter);
+    OperatorPtr right = side(j.right, j.right_columns, j.right_filter);
+
+    // hash the smaller table; a LEFT JOIN has to probe with the left rows
+    bool build_left = !j.left_outer && bp_.page_count(plan.table.id) < bp_.page_count(j.right.id);
+    OperatorPtr &build = build_left ? left : right;
+    OperatorPtr &probe = build_left ? right : left;
+    const auto &build_keys = build_left ? j.left_keys : j.right_keys;
+    const auto &probe_keys = build_left ? j.right_keys : j.left_keys;
+
+    // inner joins drop probe rows without a possible partner right after the scan
+    std::shared_ptr<BloomFilter> bloom;
+    if (!j.left_outer) {
+        bloom = std::make_shared<BloomFilter>();
+        Operator *from = probe.get();
+        probe = explained(mode, std::make_unique<BloomFilterOp>(std::move(probe), probe_keys, bloom, params),
+                          "Bloom Filter", {from});
+    }
+    // EXPLAIN lists the inputs as build, then probe
+    std::vector<Operator *> from{build.get(), probe.get()};
+    std::string label = std::string(j.left_outer ? "Hash Left Join" : "Hash Join") + " (build: " +
+                        (build_left ? plan.table.name : j.right.name) + ")";
+    return explained(mode,
+                     std::make_unique<HashJoinOp>(std::move(build), std::move(probe), build_keys, probe_keys,
+                                                  build_left, j.left_outer, params, bloom,
+                                                  limits_.join_max_build_rows),
+                     label, from);
+}
+
+storage::HashIndex &Executor::open_index(const catalog::Index &idx) {
+    std::lock_guard<std::mutex> lg(indexes_mu_);
+    auto it = indexes_.find(idx.name);
+    if (it != indexes_.end()) return *it->second;
+    auto hidx = std::make_unique<storage::HashIndex>(bp_, idx.segment_id);
+    return *indexes_.emplace(idx.name, std::move(hidx)).first->second;
+}
+
+//
+// ---------------------------- LOCKS ----------------------------
+//
+bool Executor::lock_table(Session &s, const catalog::Table &table, storage::LockMode mode, std::string &err) {
+    return locks_.lock(s.txn_->id, storage::LockTarget::table(table.id), mode, err);
+}
+
+// Lock the rows an UPDATE / DELETE matched, X in row order (or, past
+// ROW_LOCK_LIMIT rows, the whole table SIX), before any of them is written:
+// a statement refused a lock has changed nothing.
+bool Executor::lock_rows(Session &s, const catalog::Table &table, MatchedRows &rows, std::string &err) {
+    uint32_t seg = table.id;
+    if (rows.size() > ROW_LOCK_LIMIT)
+        return locks_.lock(s.txn_->id, storage::LockTarget::table(seg), storage::LockMode::SIX, err);
+    auto pos = [](const storage::RecordId &r) { return std::make_pair(r.page_number, r.offset); };
+    std::sort(rows.begin(), rows.end(), [&](const auto &a, const auto &b) { return pos(a.first) < pos(b.first); });
+    for (const auto &row : rows)
+        if (!locks_.lock(s.txn_->id, storage::LockTarget::of_row(seg, row.first), storage::LockMode::X, err))
+            return false;
+    return true;
+}
+
+// A matched row as it is now that it is locked. It was matched in the
+// statement's snapshot; a transaction that committed since may have deleted
+// it (false) or changed it, and then it is checked against `where` again and
+// `vals` become its current values.
+bool Executor::recheck_row(Session &s, uint32_t segment_id, const storage::RecordId &rid, const sql::Expr *where,
+                           const Params *params, std::vector<storage::Value> &vals) {
+    storage::Tuple now;
+    storage::TxnId xmin;
+    if (!storage::TableHeap(segment_id).GetLatest(bp_, rid, now, xmin)) return false;
+    if (s.txn_->snapshot.sees(xmin)) return true;
+    if (where && !eval_predicate(*where, now.values(), params)) return false;
+    vals = now.values();
+    return true;
+}
+
+// Writers read the table under their table lock, which keeps CREATE INDEX
+// out: the plan may predate an index they have to maintain
+const catalog::Table &Executor::current_table(const catalog::Table &planned) {
+    const catalog::Table *table = catalog_.get_table(planned.name);
+    return table ? *table : planned;
+}
+
+//
+// ------------------------ UPDATE / DELETE ----------------------
+//
+// Rows satisfying `where` (every row if null) with their ids. All of them are
+// collected before anything changes, so an update never meets a row it moved.
+Executor::MatchedRows Executor::matching_rows(Session &s, const catalog::Table &table, const sql::Expr *where,
+                                              const Params *params) {
+    MatchedRows rows;
+    storage::TableHeap heap(table.id, nullptr, s.txn_);
+    auto take = [&](const storage::RecordId &rid, std::vector<storage::Value> vals) {
+        if (!where || eval_predicate(*where, vals, params)) rows.emplace_back(rid, std::move(vals));
+    };
+
+    std::vector<const sql::Expr *> conjuncts;
+    collect_conjuncts(where, conjuncts);
+    AccessPath path = access_path(table, conjuncts, params, bp_.page_count(table.id), false);
+    if (path.index) {
+        // a row is listed once per distinct key among its versions
+        auto rids = open_index(*path.index).Lookup(storage::HashIndex::HashValue(path.key));
+        auto pos = [](const storage::RecordId &r) { return std::make_pair(r.page_number, r.offset); };
+        std::sort(rids.begin(), rids.end(),
+                  [&](const storage::RecordId &a, const storage::RecordId &b) { return pos(a) < pos(b); });
+        rids.erase(std::unique(rids.begin(), rids.end()), rids.end());
+        storage::Tuple tup;
+        for (const storage::RecordId &rid : rids)
+            if (heap.Get(bp_, rid, tup)) take(rid, tup.values());
+        return rows;
+    }
+    heap.ForEach(bp_, [&](const storage::RecordId &rid, const char *ptr, uint32_t) {
+        take(rid, storage::Tuple::deserialize(ptr).values());
+    });
+    return rows;
+}
+
+// Distinct index keys of column `col` over the versions of a row
+static std::vector<uint64_t> index_keys(const std::vector<std::vector<storage::Value>> &versions, int col) {
+    std::vector<uint64_t> keys;
+    for (const auto &vals : versions)
+        keys.push_back(storage::HashIndex::HashValue(static_cast<size_t>(col) < vals.size() ? vals[col]
+                                                                                        : storage::Value()));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+static bool has_key(const std::vector<uint64_t> &keys, uint64_t key) {
+    return std::binary_search(keys.begin(), keys.end(), key);
+}
+
+std::vector<std::vector<storage::Value>> Executor::row_versions(uint32_t segment_id, const storage::RecordId &rid,
+                                                                const std::vector<storage::Value> *current) {
+    std::vector<std::vector<storage::Value>> rows;
+    if (current) rows.push_back(*current);
+    for (const auto &tuple : versions_.tuples(segment_id, rid)) {
+        const char *ptr = tuple.data();
+        rows.push_back(storage::Tuple::deserialize(ptr).values());
+    }
+    return rows;
+}
+
+// An index lists a row under the key of every version still stored: the
+// current one and those kept for older snapshots.
+std::string Executor::handle_update(Session &s, const Plan &plan, const sql::UpdateStmt &stmt,
+                                    const Params *params) {
+    std::string err;
+    if (!lock_table(s, plan.table, storage::LockMode::IX, err)) return "ERR: " + err;
+    const catalog::Table &table = current_table(plan.table);
+    std::vector<std::pair<int, const sql::Expr *>> sets;
+    for (const auto &a : stmt.assignments) sets.emplace_back(table.column_index(a.first), a.second.get());
+
+    uint32_t seg = table.id;
+    storage::TableHeap heap(seg, &free_space_, s.txn_);
+    storage::ZoneMap zones = table_zone_map(table);
+    size_t updated = 0;
+
+    MatchedRows rows = matching_rows(s, table, stmt.where.get(), params);
+    if (!lock_rows(s, table, rows, err)) return "ERR: " + err;
+    for (auto &[rid, old] : rows) {
+        if (!recheck_row(s, seg, rid, stmt.where.get(), params, old)) continue;
+        std::vector<storage::Value> vals = old;
+        vals.resize(table.columns.size());
+        for (const auto &[col, e] : sets) vals[col] = coerce_to_column(table.columns[col], eval_expr(*e, old, params));
+
+        storage::Tuple tuple(std::move(vals));
+        storage::RecordId id = rid, stored_at{};
+        std::vector<std::vector<storage::Value>> before;
+        if (!table.indexes.empty()) before = row_versions(seg, rid, &old);
+        try {
+            if (!heap.Update(bp_, id, tuple.serialize(), stored_at)) continue;
+        } catch (const std::exception &e) {
+            return std::string("ERR: failed to write row: ") + e.what();
+        }
+        s.wrote_ = true;
+
+        // snapshots that do not see the update read the old row where the new one is stored
+        zones.Update(bp_, stored_at.page_number, tuple.values());
+        if (stored_at.page_number != rid.page_number) zones.Update(bp_, stored_at.page_number, old);
+
+        // index entries only change with the keys or the row id
+        if (table.indexes.empty()) {
+            updated++;
+            continue;
+        }
+        std::vector<std::vector<storage::Value>> after = row_versions(seg, id, &tuple.values());
+        for (const auto &idx : table.indexes) {
+            int col = table.column_index(idx.column);
+            if (col < 0) continue;
+            std::vector<uint64_t> from = index_keys(before, col), to = index_keys(after, col);
+            storage::HashIndex &hidx = open_index(idx);
+            for (uint64_t k : from)
+                if (id != rid || !has_key(to, k)) hidx.Remove(k, rid);
+            for (uint64_t k : to)
+                if (id != rid || !has_key(from, k)) hidx.Insert(k, id);
+        }
+        updated++;
+    }
+
+    return "OK: " + std::to_string(updated) + (updated == 1 ? " row updated" : " rows updated");
+}
+
+// A deleted row keeps its index entries until vacuum removes it
+std::string Executor::handle_delete(Session &s, const Plan &plan, const sql::DeleteStmt &stmt,
+                                    const Params *params) {
+    std::string err;
+    if (!lock_table(s, plan.table, storage::LockMode::IX, err)) return "ERR: " + err;
+    const catalog::Table &table = current_table(plan.table);
+    uint32_t seg = table.id;
+    storage::TableHeap heap(seg, &free_space_, s.txn_);
+    storage::TableHeap stored(seg);
+    size_t deleted = 0;
+
+    MatchedRows rows = matching_rows(s, table, stmt.where.get(), params);
+    if (!lock_rows(s, table, rows, err)) return "ERR: " + err;
+    for (auto &[rid, old] : rows) {
+        if (!recheck_row(s, seg, rid, stmt.where.get(), params, old) || !heap.Delete(bp_, rid)) continue;
+        s.wrote_ = true;
+        deleted++;
+        // rows too small to carry a version are tombstoned right away
+        storage::Tuple tup;
+        if (table.indexes.empty() || stored.Get(bp_, rid, tup)) continue;
+        for (const auto &idx : table.indexes) {
+            int col = table.column_index(idx.column);
+            if (col < 0 || static_cast<size_t>(col) >= old.size()) continue;
+            open_index(idx).Remove(storage::HashIndex::HashValue(old[col]), rid);
+        }
+    }
+    if (deleted > 0) {
+        std::lock_guard<std::mutex> lg(deleted_mu_);
+        deleted_.insert(seg);
+    }
+
+    return "OK: " + std::to_string(deleted) + (deleted == 1 ? " row deleted" : " rows deleted");
+}
+
+// Abort the statement's transaction: its inserts are invisible from here on
+// (vacuum removes them), its updates and deletes are put back, newest first,
+// under the row locks it still holds
+void Executor::rollback(Session &s, const storage::Txn &txn) {
+    txns_.abort(txn.id);
+    IndexedTables tables;
+    for (const catalog::Table *t : catalog_.tables())
+        if (!t->indexes.empty()) tables.emplace(t->id, t);
+    for (auto it = txn.undo->rbegin(); it != txn.undo->rend(); ++it) restore_row(tables, txn.id, *it);
+    std::lock_guard<std::mutex> lg(deleted_mu_);
+    deleted_.insert(s.inserted_.begin(), s.inserted_.end());
+}
+
+size_t Executor::recover(const std::vector<std::pair<storage::TxnId, storage::RowUndo>> &undo,
+                         const std::unordered_set<uint32_t> &changed) {
+    IndexedTables tables;
+    for (const catalog::Table *t : catalog_.tables())
+        if (!t->indexes.empty()) tables.emplace(t->id, t);
+    // the log holds a page as of its last write, so a statement the crash cut
+    // short may have left a split with only some of its pages there: the
+    // changed indexes are built again from the heap once its rows are back
+    size_t restored = 0;
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it)
+        if (restore_row(tables, it->first, it->second, &changed)) restored++;
+    for (const auto &t : tables) {
+        for (const catalog::Index &idx : t.second->indexes) {
+            if (!changed.count(idx.segment_id)) continue;
+            {
+                std::lock_guard<std::mutex> lg(indexes_mu_);
+                indexes_.erase(idx.name);
+            }
+            bp_.truncate_segment(idx.segment_id, 0);
+            size_t rows = fill_index(*t.second, idx);
+            log(LogLevel::INFO, "recovery: index " + idx.name + " rebuilt (" + std::to_string(rows) + " rows)");
+        }
+    }
+    return restored;
+}
+
+// Put one row back as it was before `xid` changed it; index entries only the
+// undone version needed go with it (but for the indexes in `rebuilt`)
+bool Executor::restore_row(const IndexedTables &tables, storage::TxnId xid, const storage::RowUndo &undo,
+                           const std::unordered_set<uint32_t> *rebuilt) {
+    uint32_t seg = undo.segment_id;
+    std::vector<char> replaced;
+    if (!storage::TableHeap(seg, &free_space_).Restore(bp_, undo, xid, replaced)) return false;
+    auto t = tables.find(seg);
+    if (t == tables.end()) return true;
+    const char *ptr = replaced.data();
+    std::vector<std::vector<storage::Value>> gone{storage::Tuple::deserialize(ptr).values()};
+    ptr = undo.tuple.data();
+    storage::Tuple back = storage::Tuple::deserialize(ptr);
+    std::vector<std::vector<storage::Value>> left = row_versions(seg, undo.rid, &back.values());
+    for (const auto &idx : t->second->indexes) {
+        int col = t->second->column_index(idx.column);
+        if (col < 0 || (rebuilt && rebuilt->count(idx.segment_id))) continue;
+        std::vector<uint64_t> keep = index_keys(left, col);
+        for (uint64_t k : index_keys(gone, col))
+            if (!has_key(keep, k)) open_index(idx).Remove(k, undo.rid);
+    }
+    return true;
+}
+
+//
+// ---------------------------- VACUUM ---------------------------
+//
+// A step works on a table no statement is using (locked X); a table in use
+// goes to the back of the queue.
+size_t Executor::vacuum(size_t max_pages) {
+    std::shared_lock<std::shared_mutex> running = [&] {
+        std::lock_guard<std::mutex> after_checkpoint(checkpoint_mu_);
+        return std::shared_lock<std::shared_mutex>(statement_mu_);
+    }();
+    storage::TxnId horizon = txns_.horizon();
+    vacuum_.set_horizon(horizon, txns_.aborted());
+    prune_versions(horizon);
+    if (vacuum_queue_.empty()) {
+        std::lock_guard<std::mutex> lg(deleted_mu_);
+        for (const catalog::Table *t : catalog_.tables()) {
+            uint32_t seg = t->id;
+            bool freed = free_space_.take_freed(seg) > 0;
+            bool deleted = deleted_.erase(seg) > 0;
+            if (freed || deleted || vacuumed_.insert(seg).second) vacuum_queue_.push_back(t->name);
+        }
+    }
+
+    size_t spent = 0;
+    storage::Vacuum::Changes changes;
+    for (size_t busy = 0; spent < max_pages && !vacuum_queue_.empty() && busy < vacuum_queue_.size();) {
+        const catalog::Table *table = catalog_.get_table(vacuum_queue_.front());
+        if (!table) {
+            vacuum_queue_.pop_front();
+            continue;
+        }
+        uint32_t seg = table->id;
+        if (!locks_.try_lock(MAINTENANCE, storage::LockTarget::table(seg), storage::LockMode::X)) {
+            vacuum_queue_.push_back(vacuum_queue_.front());
+            vacuum_queue_.pop_front();
+            busy++;
+            continue;
+        }
+        bool done = false;
+        changes.clear();
+        spent += vacuum_.step(seg, max_pages - spent, changes, done);
+        apply_vacuum_changes(*table, changes);
+        locks_.release_all(MAINTENANCE);
+        if (!done) continue;
+
+        const storage::Vacuum::Stats &st = vacuum_.stats();
+        // rows deleted at or after the horizon are removed by a later pass
+        if (st.kept > 0) {
+            std::lock_guard<std::mutex> lg(deleted_mu_);
+            deleted_.insert(seg);
+        }
+        if (st.pruned > 0 || st.compacted > 0 || st.truncated > 0) {
+            double dead = st.used == 0 ? 0.0 : 100.0 * (st.used - st.live) / st.used;
+            log(LogLevel::INFO, "vacuum " + table->name + ": " + std::to_string(st.pages) + " pages, " +
+                                    std::to_string(st.pruned) + " deleted rows removed, " +
+                                    std::to_string(static_cast<int>(dead)) + "% dead, " +
+                                    std::to_string(st.compacted) + " compacted, " +
+                                    std::to_string(st.truncated) + " truncated");
+        }
+        vacuum_queue_.pop_front();
+    }
+    // logged, but not forced: losing a vacuum step in a crash is harmless
+    bp_.log_changes();
+    return spent;
+}
+
+void Executor::checkpoint() {
+    std::lock_guard<std::mutex> first(checkpoint_mu_);
+    std::unique_lock<std::shared_mutex> alone(statement_mu_);
+    // the COMMIT records go with the log: every transaction so far has ended
+    // and its outcome is durable first
+    bp_.flush_all();
+    txns_.settle();
+    bp_.checkpoint();
+    // and no statement holds a table definition replaced since the last one
+    catalog_.reclaim();
+}
+
+// Drop the row versions no snapshot can read any more, and the index entries
+// only they needed. Each row is locked meanwhile, as an update of it would
+// be; a row it cannot lock keeps its entries (lookups check the rows they find).
+void Executor::prune_versions(storage::TxnId horizon) {
+    if (versions_.size() == 0) return;
+    std::vector<storage::VersionStore::Pruned> pruned = versions_.prune(horizon);
+    if (pruned.empty()) return;
+
+    std::unordered_map<uint32_t, const catalog::Table *> tables;
+    for (const catalog::Table *t : catalog_.tables())
+        if (!t->indexes.empty()) tables.emplace(t->id, t);
+
+    // the versions of one row come out together
+    for (size_t i = 0, j = 0; i < pruned.size(); i = j) {
+        uint32_t seg = pruned[i].segment_id;
+        storage::RecordId rid = pruned[i].rid;
+        for (j = i + 1; j < pruned.size() && pruned[j].segment_id == seg && pruned[j].rid == rid;) j++;
+        auto t = tables.find(seg);
+        if (t == tables.end()) continue;
+        std::string err;
+        bool locked = locks_.lock(MAINTENANCE, storage::LockTarget::table(seg), storage::LockMode::IX, err) &&
+                      locks_.lock(MAINTENANCE, storage::LockTarget::of_row(seg, rid), storage::LockMode::X, err);
+        if (!locked) {
+            locks_.release_all(MAINTENANCE);
+            continue;
+        }
+
+        std::vector<std::vector<storage::Value>> gone;
+        for (size_t k = i; k < j; ++k) {
+            const char *ptr = pruned[k].version.tuple.data();
+            gone.push_back(storage::Tuple::deserialize(ptr).values());
+        }
+        storage::Tuple tup;
+        bool stored = storage::TableHeap(seg).Get(bp_, rid, tup);
+        std::vector<std::vector<storage::Value>> left = row_versions(seg, rid, stored ? &tup.values() : nullptr);
+        for (const auto &idx : t->second->indexes) {
+            int col = t->second->column_index(idx.column);
+            if (col < 0) continue;
+            std::vector<uint64_t> keep = index_keys(left, col);
+            for (uint64_t k : index_keys(gone, col))
+                if (!has_key(keep, k)) open_index(idx).Remove(k, rid);
+        }
+        locks_.release_all(MAINTENANCE);
+    }
+}
+
+// Index and zone-map upkeep for one vacuum step: rows removed for good lose
+// their index entries, moved rows (with their kept versions) are repointed in
+// the order they moved
+void Executor::apply_vacuum_changes(const catalog::Table &table, const storage::Vacuum::Changes &changes) {
+    uint32_t seg = table.id;
+    for (const storage::PrunedRow &row : changes.pruned) {
+        if (!table.indexes.empty()) {
+            std::vector<std::vector<storage::Value>> gone = row_versions(seg, row.rid, &row.tuple.values());
+            for (const auto &idx : table.indexes) {
+                int col = table.column_index(idx.column);
+                if (col < 0) continue;
+                for (uint64_t k : index_keys(gone, col)) open_index(idx).Remove(k, row.rid);
+            }
+        }
+        versions_.drop(seg, row.rid);
+    }
+    if (changes.moved.empty()) return;
+
+    storage::TableHeap heap(seg);
+    storage::ZoneMap zones = table_zone_map(table);
+    for (const storage::RecordMove &m : changes.moved) {
+        storage::Tuple tup;
+        if (!heap.Get(bp_, m.to, tup)) continue;
+        std::vector<std::vector<storage::Value>> rows = row_versions(seg, m.from, &tup.values());
+        versions_.rekey(seg, m.from, m.to);
+        for (const auto &vals : rows) zones.Update(bp_, m.to.page_number, vals);
+        for (const auto &idx : table.indexes) {
+            int col = table.column_index(idx.column);
+            if (col < 0) continue;
+            storage::HashIndex &hidx = open_index(idx);
+            for (uint64_t k : index_keys(rows, col)) {
+                hidx.Remove(k, m.from);
+                hidx.Insert(k, m.to);
+            }
+        }
+    }
 }
@@ -1,21 +1,190 @@
 #pragma once
 #include "src/catalog/catalog.h"
 #include "src/storage/buffer/buffer_pool.h"
+#include "src/execution/expression.h"
+#include "src/execution/plan_cache.h"
+#include "src/execution/result_sink.h"
+#include "src/sql/ast.h"
+#include "src/storage/index/hash_index.h"
+#include "src/storage/mvcc/lock_manager.h"
+#include "src/storage/mvcc/transaction.h"
+#include "src/storage/mvcc/version_store.h"
+#include "src/storage/table/free_space_map.h"
+#include "src/storage/table/table_heap.h"
+#include "src/storage/table/vacuum.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// What a client keeps from one statement to the next: its prepared
+// statements and its open BEGIN .. COMMIT block. A session runs one statement
+// at a time; statements of different sessions run side by side.
+class Session {
+private:
+    friend class Executor;
+
+    struct Prepared {
+        std::string body;   // SQL text after PREPARE ... AS
+        std::string key;    // normalized body (plan cache key)
+        std::shared_ptr<const Plan> plan;
+    };
+    // Writes of the open BEGIN .. COMMIT block, in order. INSERT rows are
+    // evaluated when queued; UPDATE/DELETE keep their plan and parameters
+    // (and text, to plan again after DDL) and run at COMMIT.
+    struct PendingWrite {
+        std::string table;
+        std::vector<storage::Tuple> rows;   // INSERT (plan is null)
+        std::shared_ptr<const Plan> plan;   // UPDATE / DELETE
+        Params params;
+        bool has_params = false;
+        std::string sql;
+    };
+
+    std::mutex mu_;
+    std::unordered_map<std::string, Prepared> prepared_;
+    bool in_transaction_ = false;
+    std::vector<PendingWrite> pending_;
+
+    // the running statement's transaction, whether it changed anything and
+    // the tables it inserted into (vacuumed if it aborts)
+    const storage::Txn *txn_ = nullptr;
+    bool wrote_ = false;
+    std::unordered_set<uint32_t> inserted_;
+    std::shared_lock<std::shared_mutex> *running_ = nullptr;   // its hold on statement_mu_
+};
+
+// How much each query operator holds in memory before it spills to
+// temporary files (the defaults are the constants in operators.h)
+struct SpillLimits {
+    size_t agg_max_groups = AGG_MAX_GROUPS;
+    size_t join_max_build_rows = JOIN_MAX_BUILD_ROWS;
+    size_t sort_memory_bytes = SORT_MEMORY_BYTES;
+};
 
 class Executor {
 public:
-    Executor(catalog::Catalog &catalog, storage::BufferPool &bp);
+    Executor(catalog::Catalog &catalog, storage::BufferPool &bp, storage::TransactionManager &txns,
+             storage::LockManager &locks, const SpillLimits &limits = {});
+
+    // Run one statement of `session` as a transaction of its own, reading one
+    // snapshot, and stream its rows or status line into `sink`. A statement
+    // that fails aborts: none of its writes stay. Between BEGIN
+    // and COMMIT, INSERT/UPDATE/DELETE only queue their writes; COMMIT applies
+    // them all as one statement (one transaction id, one log flush), ROLLBACK
+    // drops them. Any number of sessions may call this at once: locks taken
+    // by the statement order its writes against theirs.
+    void execute(Session &session, const std::string &sql, ResultSink &sink);
+    // The same for a statement whose '?' parameters arrive already typed
+    // (binary protocol): planned through the plan cache as any statement, the
+    // values are bound as they are instead of being parsed from SQL text
+    void execute(Session &session, const std::string &sql, const Params &params, ResultSink &sink);
 
-    std::string execute(const std::string &sql);
+    // One slice of background vacuum, touching about `max_pages` pages between
+    // statements; returns the pages touched (0 when no table needs a pass)
+    size_t vacuum(size_t max_pages);
+    // write out every change and empty the log, between statements
+    void checkpoint();
+    // At startup: put back the rows that transactions a crash cut off
+    // updated or deleted (Recovery::undo()), newest first, then rebuild the
+    // indexes in `changed` (the segments the log replayed) from their tables;
+    // returns how many rows were put back
+    size_t recover(const std::vector<std::pair<storage::TxnId, storage::RowUndo>> &undo,
+                   const std::unordered_set<uint32_t> &changed);
 
 private:
     catalog::Catalog &catalog_;
     storage::BufferPool &bp_;
+    SpillLimits limits_;
+
+    // Statements and vacuum steps share this; a checkpoint takes it alone.
+    // A checkpoint waiting for it holds checkpoint_mu_, which keeps
+    // statements that have not started from cutting in.
+    std::shared_mutex statement_mu_;
+    std::mutex checkpoint_mu_;
+
+    // row versions: the versions updates replaced, kept until no snapshot can
+    // read them
+    storage::TransactionManager &txns_;
+    storage::VersionStore versions_;
+
+    // Table and row locks of running statements. UPDATE / DELETE lock the rows
+    // they write, or the whole table past ROW_LOCK_LIMIT rows.
+    storage::LockManager &locks_;
+    static constexpr size_t ROW_LOCK_LIMIT = 4096;
+    bool lock_table(Session &s, const catalog::Table &table, storage::LockMode mode, std::string &err);
+    using MatchedRows = std::vector<std::pair<storage::RecordId, std::vector<storage::Value>>>;
+    bool lock_rows(Session &s, const catalog::Table &table, MatchedRows &rows, std::string &err);
+    bool recheck_row(Session &s, uint32_t segment_id, const storage::RecordId &rid, const sql::Expr *where,
+                     const Params *params, std::vector<storage::Value> &vals);
+    // the table as the catalog has it now
+    const catalog::Table &current_table(const catalog::Table &planned);
+
+    // open hash indexes by index name (opened lazily)
+    std::mutex indexes_mu_;
+    std::unordered_map<std::string, std::unique_ptr<storage::HashIndex>> indexes_;
+    storage::HashIndex &open_index(const catalog::Index &idx);
+
+    // space freed by UPDATE/DELETE, handed to later inserts
+    storage::FreeSpaceMap free_space_;
+
+    // tables waiting for a vacuum pass: each once after startup, then when rows were freed
+    // or deleted (deleted rows are removed once no snapshot sees them)
+    storage::Vacuum vacuum_;
+    std::deque<std::string> vacuum_queue_;
+    std::unordered_set<uint32_t> vacuumed_;
+    std::mutex deleted_mu_;
+    std::unordered_set<uint32_t> deleted_;
+    void prune_versions(storage::TxnId horizon);
+    void apply_vacuum_changes(const catalog::Table &table, const storage::Vacuum::Changes &changes);
+    // every stored version of row `rid`: `current` (if it is still stored) and the kept ones
+    std::vector<std::vector<storage::Value>> row_versions(uint32_t segment_id, const storage::RecordId &rid,
+                                                          const std::vector<storage::Value> *current);
+
+    // parsed + bound statements, shared by plain and prepared execution
+    PlanCache plan_cache_;
+
+    // The handlers return the statement's status line, or "" once a query
+    // has streamed its rows into the sink
+    void run_statement(Session &session, const std::string &sql, const Params *params, ResultSink &sink);
+    std::string execute_statement(Session &s, const std::string &sql, const Params *params, ResultSink &sink);
+    storage::Lsn log_commit(storage::TxnId xid);
+    void rollback(Session &s, const storage::Txn &txn);
+    using IndexedTables = std::unordered_map<uint32_t, const catalog::Table *>;
+    bool restore_row(const IndexedTables &tables, storage::TxnId xid, const storage::RowUndo &undo,
+                     const std::unordered_set<uint32_t> *rebuilt = nullptr);
+    size_t fill_index(const catalog::Table &table, const catalog::Index &idx);
+    std::shared_ptr<const Plan> build_plan(sql::Statement stmt, std::string &err);
+    std::string run_plan(Session &s, const Plan &plan, const Params *params, ResultSink &sink);
+
+    std::string handle_create_table(const sql::CreateTableStmt &stmt);
+    std::string handle_create_index(Session &s, const sql::CreateIndexStmt &stmt);
+    std::string handle_analyze(Session &s, const sql::AnalyzeStmt &stmt);
+    std::string handle_prepare(Session &s, const sql::PrepareStmt &stmt);
+    std::string handle_execute(Session &s, const sql::ExecuteStmt &stmt, ResultSink &sink);
+    // the current plan of a prepared statement (planned again if DDL ran since
+    // PREPARE) with its arguments in `params`; null and `err` if there is none
+    std::shared_ptr<const Plan> prepared_plan(Session &s, const sql::ExecuteStmt &stmt, Params &params,
+                                              std::string &err);
+    std::string handle_transaction(Session &s, const sql::TransactionStmt &stmt);
+    std::string queue_write(Session &s, const std::shared_ptr<const Plan> &plan, const Params *params,
+                            const std::string &sql);
+    std::string commit_pending(Session &s);
+    std::string handle_insert(Session &s, const Plan &plan, const sql::InsertStmt &stmt, const Params *params);
+    std::string insert_rows(Session &s, const catalog::Table &table, const std::vector<storage::Tuple> &rows);
+    std::string handle_select(Session &s, const Plan &plan, const sql::SelectStmt &stmt, const Params *params,
+                              ResultSink &sink, ExplainMode mode = ExplainMode::NONE);
+    bool wait_for_sink(Session &s, ResultSink &sink);
+    std::string handle_explain(Session &s, const sql::ExplainStmt &stmt, ResultSink &sink);
+    std::string explain_result(ExplainOp &root, ExplainMode mode, ResultSink &sink);
+    std::string handle_update(Session &s, const Plan &plan, const sql::UpdateStmt &stmt, const Params *params);
+    std::string handle_delete(Session &s, const Plan &plan, const sql::DeleteStmt &stmt, const Params *params);
+    MatchedRows matching_rows(Session &s, const catalog::Table &table, const sql::Expr *where, const Params *params);
 
-    std::string handle_create_table(const std::string &sql);
-    std::string handle_insert(const std::string &sql);
-    std::string handle_select(const std::string &sql);
-    std::string handle_update(const std::string &sql);
-    std::string handle_delete(const std::string &sql);
+    OperatorPtr join_input(Session &s, const Plan &plan, const Params *params, ExplainMode mode);
 };
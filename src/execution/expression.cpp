@@ -0,0 +1,190 @@
+#include "src/execution/expression.h"
+
+#include <stdexcept>
+
+using sql::Expr;
+using sql::ExprType;
+using storage::Value;
+using storage::ValueType;
+
+int compare_values(const Value &a, const Value &b) {
+    if (a.type() != b.type()) return a.type() == ValueType::INT ? -1 : 1;
+    if (a.type() == ValueType::INT)
+        return a.as_int() < b.as_int() ? -1 : (a.as_int() > b.as_int() ? 1 : 0);
+    return a.as_text().compare(b.as_text());
+}
+
+Value coerce_to_column(const catalog::Column &col, const Value &v) {
+    if (col.kind == catalog::Type::INT) {
+        if (v.type() == ValueType::INT) return v;
+        size_t used = 0;
+        int32_t i = 0;
+        try {
+            i = static_cast<int32_t>(std::stoi(v.as_text(), &used));
+        } catch (const std::exception &) {
+            used = 0;
+        }
+        if (used == 0 || used != v.as_text().size())
+            throw std::runtime_error("invalid INT value for column " + col.name);
+        return Value(i);
+    }
+    return v.type() == ValueType::TEXT ? v : Value(v.to_string());
+}
+
+bool bind_expr(Expr &e, const catalog::Table &table, const std::string &alias, std::string &err) {
+    return bind_expr(e, std::vector<BindTable>{BindTable{&table, alias, 0}}, err);
+}
+
+bool bind_expr(Expr &e, const std::vector<BindTable> &scope, std::string &err) {
+    if (e.type == ExprType::COLUMN) {
+        bool known_table = e.table.empty();
+        e.column = -1;
+        for (const BindTable &t : scope) {
+            if (!e.table.empty() && e.table != t.table->name && e.table != t.alias) continue;
+            known_table = true;
+            for (size_t i = 0; i < t.table->columns.size(); ++i) {
+                if (t.table->columns[i].name != e.name) continue;
+                if (e.column >= 0) {
+                    err = "ambiguous column " + e.name;
+                    return false;
+                }
+                e.column = t.offset + static_cast<int>(i);
+            }
+        }
+        if (!known_table) {
+            err = "unknown table " + e.table;
+            return false;
+        }
+        if (e.column < 0) {
+            err = "unknown column " + e.name;
+            return false;
+        }
+        return true;
+    }
+    for (auto &a : e.args)
+        if (!bind_expr(*a, scope, err)) return false;
+    return true;
+}
+
+bool like_match(std::string_view s, std::string_view p) {
+    // greedy matching with backtracking to the last %
+    size_t si = 0, pi = 0, star = std::string_view::npos, mark = 0;
+    while (si < s.size()) {
+        if (pi < p.size() && (p[pi] == '_' || p[pi] == s[si])) {
+            si++;
+            pi++;
+        } else if (pi < p.size() && p[pi] == '%') {
+            star = pi++;
+            mark = si;
+        } else if (star != std::string_view::npos) {
+            pi = star + 1;
+            si = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (pi < p.size() && p[pi] == '%') pi++;
+    return pi == p.size();
+}
+
+static bool compare_true(sql::CompareOp op, int r) {
+    switch (op) {
+    case sql::CompareOp::EQ: return r == 0;
+    case sql::CompareOp::NE: return r != 0;
+    case sql::CompareOp::LT: return r < 0;
+    case sql::CompareOp::LE: return r <= 0;
+    case sql::CompareOp::GT: return r > 0;
+    case sql::CompareOp::GE: return r >= 0;
+    }
+    return false;
+}
+
+Value eval_expr(const Expr &e, const std::vector<Value> &row, const Params *params) {
+    switch (e.type) {
+    case ExprType::LITERAL: return e.value;
+    case ExprType::COLUMN:
+        if (e.column < 0 || static_cast<size_t>(e.column) >= row.size())
+            throw std::runtime_error("unbound column " + e.name);
+        return row[e.column];
+    case ExprType::COMPARE:
+    case ExprType::AND:
+    case ExprType::OR:
+    case ExprType::NOT:
+    case ExprType::BETWEEN:
+    case ExprType::IN:
+    case ExprType::LIKE:
+        return Value(static_cast<int32_t>(eval_predicate(e, row, params)));
+    case ExprType::ARITH: {
+        Value l = eval_expr(*e.args[0], row, params);
+        Value r = eval_expr(*e.args[1], row, params);
+        if (l.type() != ValueType::INT || r.type() != ValueType::INT)
+            throw std::runtime_error("arithmetic on non-INT value");
+        int64_t a = l.as_int(), b = r.as_int();
+        switch (e.arith) {
+        case sql::ArithOp::ADD: return Value(static_cast<int32_t>(a + b));
+        case sql::ArithOp::SUB: return Value(static_cast<int32_t>(a - b));
+        case sql::ArithOp::MUL: return Value(static_cast<int32_t>(a * b));
+        case sql::ArithOp::DIV:
+            if (b == 0) throw std::runtime_error("division by zero");
+            return Value(static_cast<int32_t>(a / b));
+        }
+        break;
+    }
+    case ExprType::PARAM:
+        if (!params || e.param < 0 || static_cast<size_t>(e.param) >= params->size())
+            throw std::runtime_error("missing value for parameter " + std::to_string(e.param + 1));
+        return (*params)[e.param];
+    case ExprType::STAR: throw std::runtime_error("'*' is not a value");
+    case ExprType::FUNCTION: throw std::runtime_error("function " + e.name + " not allowed here");
+    }
+    throw std::runtime_error("bad expression");
+}
+
+bool eval_predicate(const Expr &e, const std::vector<Value> &row, const Params *params) {
+    switch (e.type) {
+    case ExprType::AND: return eval_predicate(*e.args[0], row, params) && eval_predicate(*e.args[1], row, params);
+    case ExprType::OR: return eval_predicate(*e.args[0], row, params) || eval_predicate(*e.args[1], row, params);
+    case ExprType::NOT: return !eval_predicate(*e.args[0], row, params);
+    case ExprType::COMPARE: {
+        Value l = eval_expr(*e.args[0], row, params);
+        Value r = eval_expr(*e.args[1], row, params);
+        if (l.type() != r.type()) return false;
+        return compare_true(e.op, compare_values(l, r));
+    }
+    case ExprType::BETWEEN: {
+        Value v = eval_expr(*e.args[0], row, params);
+        Value lo = eval_expr(*e.args[1], row, params);
+        Value hi = eval_expr(*e.args[2], row, params);
+        if (v.type() != lo.type() || v.type() != hi.type()) return false;
+        return compare_values(v, lo) >= 0 && compare_values(v, hi) <= 0;
+    }
+    case ExprType::IN: {
+        Value v = eval_expr(*e.args[0], row, params);
+        for (size_t i = 1; i < e.args.size(); ++i) {
+            Value item = eval_expr(*e.args[i], row, params);
+            if (item.type() == v.type() && compare_values(v, item) == 0) return true;
+        }
+        return false;
+    }
+    case ExprType::LIKE: {
+        Value v = eval_expr(*e.args[0], row, params);
+        Value p = eval_expr(*e.args[1], row, params);
+        if (v.type() != ValueType::TEXT || p.type() != ValueType::TEXT) return false;
+        return like_match(v.as_text(), p.as_text());
+    }
+    default: {
+        Value v = eval_expr(e, row, params);
+        return v.type() == ValueType::INT ? v.as_int() != 0 : !v.as_text().empty();
+    }
+    }
+}
+
+void collect_conjuncts(const Expr *e, std::vector<const Expr *> &out) {
+    if (!e) return;
+    if (e->type == ExprType::AND) {
+        collect_conjuncts(e->args[0].get(), out);
+        collect_conjuncts(e->args[1].get(), out);
+    } else {
+        out.push_back(e);
+    }
+}
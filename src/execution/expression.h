@@ -0,0 +1,50 @@
+#pragma once
+
+#include "src/catalog/catalog.h"
+#include "src/sql/ast.h"
+#include "src/storage/table/tuple.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Row-at-a-time expression evaluation over the parser's AST.
+
+// Values for `?` placeholders, by position
+using Params = std::vector<storage::Value>;
+
+// Resolve COLUMN references against `table` (qualifier must be the table name
+// or `alias`). Fills Expr::column; false + err on unknown columns.
+bool bind_expr(sql::Expr &e, const catalog::Table &table, const std::string &alias, std::string &err);
+
+// One table of a multi-table scope; its columns occupy positions
+// [offset, offset + columns) of the combined row
+struct BindTable {
+    const catalog::Table *table;
+    std::string alias;
+    int offset;
+};
+
+// As above over several tables; unqualified names must be unique across them
+bool bind_expr(sql::Expr &e, const std::vector<BindTable> &scope, std::string &err);
+
+// Evaluate a scalar expression; booleans are INT 0/1. Throws std::runtime_error
+// on type errors and division by zero.
+storage::Value eval_expr(const sql::Expr &e, const std::vector<storage::Value> &row,
+                         const Params *params = nullptr);
+
+// WHERE semantics: comparisons between different types are false.
+bool eval_predicate(const sql::Expr &e, const std::vector<storage::Value> &row,
+                    const Params *params = nullptr);
+
+// <0, 0, >0 like strcmp; values of different types order INT before TEXT
+int compare_values(const storage::Value &a, const storage::Value &b);
+
+// SQL LIKE: % matches any run of characters, _ exactly one
+bool like_match(std::string_view s, std::string_view pattern);
+
+// Coerce a value to a column's declared type (INT <-> TEXT); throws on bad INT text
+storage::Value coerce_to_column(const catalog::Column &col, const storage::Value &v);
+
+// Split an AND tree into its conjuncts (pointers into `e`)
+void collect_conjuncts(const sql::Expr *e, std::vector<const sql::Expr *> &out);
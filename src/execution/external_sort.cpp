@@ -0,0 +1,149 @@
+#include "src/execution/external_sort.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace storage;
+
+template <typename U>
+static void append_big_endian(std::string &key, U v) {
+    for (int shift = (sizeof(U) - 1) * 8; shift >= 0; shift -= 8) key.push_back(static_cast<char>(v >> shift));
+}
+
+void append_sort_key(std::string &key, const ColumnVector &c, size_t r, bool desc) {
+    size_t start = key.size();
+    switch (c.type) {
+    case ColumnType::INT: append_big_endian(key, static_cast<uint32_t>(c.i32[r]) ^ 0x80000000u); break;
+    case ColumnType::BIGINT:
+        append_big_endian(key, static_cast<uint64_t>(c.i64[r]) ^ 0x8000000000000000ull);
+        break;
+    case ColumnType::DOUBLE: {
+        uint64_t bits;
+        std::memcpy(&bits, &c.f64[r], sizeof(bits));
+        bits = (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+        append_big_endian(key, bits);
+        break;
+    }
+    case ColumnType::TEXT:
+        for (char ch : c.text(r)) {
+            key.push_back(ch);
+            if (ch == 0) key.push_back(static_cast<char>(0xFF));
+        }
+        key.append(2, '\0');
+        break;
+    }
+    if (desc)
+        for (size_t i = start; i < key.size(); ++i) key[i] = static_cast<char>(~key[i]);
+}
+
+void append_row_bytes(std::string &out, const Batch &src, size_t r) {
+    for (const ColumnVector &c : src.columns) {
+        switch (c.type) {
+        case ColumnType::INT: out.append(reinterpret_cast<const char *>(&c.i32[r]), sizeof(int32_t)); break;
+        case ColumnType::BIGINT: out.append(reinterpret_cast<const char *>(&c.i64[r]), sizeof(int64_t)); break;
+        case ColumnType::DOUBLE: out.append(reinterpret_cast<const char *>(&c.f64[r]), sizeof(double)); break;
+        case ColumnType::TEXT: {
+            std::string_view v = c.text(r);
+            uint32_t len = static_cast<uint32_t>(v.size());
+            out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+            out.append(v.data(), v.size());
+            break;
+        }
+        }
+    }
+}
+
+void read_row_bytes(std::string_view row, Batch &out) {
+    const char *p = row.data();
+    for (ColumnVector &c : out.columns) {
+        switch (c.type) {
+        case ColumnType::INT:
+            c.i32.emplace_back();
+            std::memcpy(&c.i32.back(), p, sizeof(int32_t));
+            p += sizeof(int32_t);
+            break;
+        case ColumnType::BIGINT:
+            c.i64.emplace_back();
+            std::memcpy(&c.i64.back(), p, sizeof(int64_t));
+            p += sizeof(int64_t);
+            break;
+        case ColumnType::DOUBLE:
+            c.f64.emplace_back();
+            std::memcpy(&c.f64.back(), p, sizeof(double));
+            p += sizeof(double);
+            break;
+        case ColumnType::TEXT: {
+            uint32_t len;
+            std::memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            c.push_text(std::string_view(p, len));
+            p += len;
+            break;
+        }
+        }
+    }
+    out.size++;
+}
+
+//
+// ---------------------------- RUNS -----------------------------
+//
+SortRunWriter::SortRunWriter(SegmentManager &sm) : sm_(sm) {
+    run_.segment = sm_.create_temp_segment();
+    page_.reset(PageId{run_.segment, 0}, PageType::SORT_RUN);
+}
+
+void SortRunWriter::put(const char *p, size_t n) {
+    while (n > 0) {
+        if (used_ == PAGE_PAYLOAD_SIZE) {
+            sm_.write_page(page_);
+            page_.reset(PageId{run_.segment, page_.hdr.page_number + 1}, PageType::SORT_RUN);
+            used_ = 0;
+        }
+        size_t take = std::min(n, PAGE_PAYLOAD_SIZE - used_);
+        std::memcpy(page_.data + used_, p, take);
+        used_ += take;
+        p += take;
+        n -= take;
+    }
+}
+
+void SortRunWriter::add(std::string_view key, std::string_view row) {
+    uint32_t lens[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(row.size())};
+    put(reinterpret_cast<const char *>(lens), sizeof(lens));
+    put(key.data(), key.size());
+    put(row.data(), row.size());
+    run_.bytes += sizeof(lens) + key.size() + row.size();
+}
+
+SortRun SortRunWriter::finish() {
+    if (used_ > 0) sm_.write_page(page_);
+    return run_;
+}
+
+SortRunReader::SortRunReader(SegmentManager &sm, const SortRun &run) : sm_(sm), run_(run) {}
+
+void SortRunReader::get(char *p, size_t n) {
+    while (n > 0) {
+        if (pos_ == PAGE_PAYLOAD_SIZE) {
+            page_ = sm_.read_page(PageId{run_.segment, page_no_++});
+            pos_ = 0;
+        }
+        size_t take = std::min(n, PAGE_PAYLOAD_SIZE - pos_);
+        std::memcpy(p, page_.data + pos_, take);
+        pos_ += take;
+        p += take;
+        n -= take;
+    }
+}
+
+bool SortRunReader::next() {
+    if (consumed_ >= run_.bytes) return false;
+    uint32_t lens[2];
+    get(reinterpret_cast<char *>(lens), sizeof(lens));
+    record_.resize(lens[0] + lens[1]);
+    get(&record_[0], record_.size());
+    key_len_ = lens[0];
+    consumed_ += sizeof(lens) + record_.size();
+    return true;
+}
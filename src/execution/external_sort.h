@@ -0,0 +1,66 @@
+#pragma once
+
+#include "src/execution/batch.h"
+#include "src/storage/segment/segment_manager.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Building blocks of SortOp: normalized sort keys, a compact row encoding and
+// sorted runs stored in temporary segments.
+
+// Append the normalized form of row `r` of `c` to `key`. Normalized keys of
+// whole rows compare with memcmp in ORDER BY order: integers are big-endian
+// with the sign bit flipped, doubles use the usual sign-magnitude flip, TEXT
+// escapes 0x00 and ends with 0x00 0x00, and DESC inverts every byte.
+void append_sort_key(std::string &key, const ColumnVector &c, size_t r, bool desc);
+
+// Row `r` of `src` as bytes (layout implied by the column types)
+void append_row_bytes(std::string &out, const Batch &src, size_t r);
+// Append a row encoded by append_row_bytes to `out` (same column types)
+void read_row_bytes(std::string_view row, Batch &out);
+
+// A sorted run: a byte stream of [key len u32][row len u32][key][row] records
+// packed into the payload of consecutive pages of one temporary segment.
+struct SortRun {
+    uint32_t segment = 0;
+    uint64_t bytes = 0;
+};
+
+class SortRunWriter {
+public:
+    explicit SortRunWriter(storage::SegmentManager &sm);
+    void add(std::string_view key, std::string_view row);
+    // write the last page and hand over the run
+    SortRun finish();
+
+private:
+    void put(const char *p, size_t n);
+
+    storage::SegmentManager &sm_;
+    SortRun run_;
+    storage::Page page_;
+    size_t used_ = 0;   // bytes of page_.data filled
+};
+
+class SortRunReader {
+public:
+    SortRunReader(storage::SegmentManager &sm, const SortRun &run);
+    // advance to the next record; false at the end of the run
+    bool next();
+    std::string_view key() const { return std::string_view(record_.data(), key_len_); }
+    std::string_view row() const { return std::string_view(record_.data() + key_len_, record_.size() - key_len_); }
+
+private:
+    void get(char *p, size_t n);
+
+    storage::SegmentManager &sm_;
+    SortRun run_;
+    storage::Page page_;
+    uint32_t page_no_ = 0;
+    size_t pos_ = storage::PAGE_PAYLOAD_SIZE;   // read position in page_.data
+    uint64_t consumed_ = 0;
+    std::string record_;
+    uint32_t key_len_ = 0;
+};
@@ -0,0 +1,255 @@
+#include "src/execution/filter_kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILTER_KERNELS_X86 1
+#endif
+
+// One kernel shape serves every INT predicate. The vector loops compute the
+// predicate below (or its complement, when `invert` is set) 8 or 4 lanes at a time.
+enum Pred : int {
+    PRED_EQ,        // x == a[0]
+    PRED_GT,        // x > a[0]
+    PRED_LT,        // x < a[0]
+    PRED_OUTSIDE,   // x < a[0] || x > a[1]   (BETWEEN is its complement)
+    PRED_IN_SMALL,  // x equals one of a[0..na)
+};
+
+// IN lists up to this size are checked with one vector compare per item
+constexpr size_t IN_VECTOR_MAX = 8;
+
+using I32Kernel = void (*)(const int32_t *v, size_t n, const int32_t *a, size_t na, bool invert, uint8_t *m);
+
+//
+// ------------------------- SCALAR ------------------------------
+//
+template <int P>
+static inline bool pred_one(int32_t x, const int32_t *a, size_t na) {
+    if constexpr (P == PRED_EQ) return x == a[0];
+    if constexpr (P == PRED_GT) return x > a[0];
+    if constexpr (P == PRED_LT) return x < a[0];
+    if constexpr (P == PRED_OUTSIDE) return x < a[0] || x > a[1];
+    if constexpr (P == PRED_IN_SMALL) {
+        bool hit = false;
+        for (size_t j = 0; j < na; ++j) hit |= x == a[j];
+        return hit;
+    }
+    return false;
+}
+
+template <int P>
+static void scalar_kernel(const int32_t *v, size_t n, const int32_t *a, size_t na, bool invert, uint8_t *m) {
+    for (size_t i = 0; i < n; ++i) m[i] = pred_one<P>(v[i], a, na) != invert;
+}
+
+#ifdef FILTER_KERNELS_X86
+//
+// -------------------------- SSE4.1 -----------------------------
+//
+template <int P>
+__attribute__((target("sse4.1"))) static void sse_kernel(const int32_t *v, size_t n, const int32_t *a, size_t na,
+                                                          bool invert, uint8_t *m) {
+    const __m128i a0 = _mm_set1_epi32(a[0]);
+    const __m128i a1 = _mm_set1_epi32(na > 1 ? a[1] : 0);
+    const __m128i flip = invert ? _mm_set1_epi8(-1) : _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i r[4];
+        for (int j = 0; j < 4; ++j) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i + 4 * j));
+            if constexpr (P == PRED_EQ) r[j] = _mm_cmpeq_epi32(x, a0);
+            else if constexpr (P == PRED_GT) r[j] = _mm_cmpgt_epi32(x, a0);
+            else if constexpr (P == PRED_LT) r[j] = _mm_cmplt_epi32(x, a0);
+            else if constexpr (P == PRED_OUTSIDE) r[j] = _mm_or_si128(_mm_cmplt_epi32(x, a0), _mm_cmpgt_epi32(x, a1));
+            else {
+                __m128i hit = _mm_setzero_si128();
+                for (size_t k = 0; k < na; ++k) hit = _mm_or_si128(hit, _mm_cmpeq_epi32(x, _mm_set1_epi32(a[k])));
+                r[j] = hit;
+            }
+        }
+        // 4 x (4 x i32 of 0/-1) -> 16 bytes, order preserved by signed saturation
+        __m128i b = _mm_packs_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3]));
+        b = _mm_and_si128(_mm_xor_si128(b, flip), one);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(m + i), b);
+    }
+    scalar_kernel<P>(v + i, n - i, a, na, invert, m + i);
+}
+
+//
+// --------------------------- AVX2 ------------------------------
+//
+template <int P>
+__attribute__((target("avx2"))) static void avx2_kernel(const int32_t *v, size_t n, const int32_t *a, size_t na,
+                                                         bool invert, uint8_t *m) {
+    const __m256i a0 = _mm256_set1_epi32(a[0]);
+    const __m256i a1 = _mm256_set1_epi32(na > 1 ? a[1] : 0);
+    const __m256i flip = invert ? _mm256_set1_epi8(-1) : _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    // packs work per 128-bit lane; this restores row order of the 32 bytes
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i r[4];
+        for (int j = 0; j < 4; ++j) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i + 8 * j));
+            if constexpr (P == PRED_EQ) r[j] = _mm256_cmpeq_epi32(x, a0);
+            else if constexpr (P == PRED_GT) r[j] = _mm256_cmpgt_epi32(x, a0);
+            else if constexpr (P == PRED_LT) r[j] = _mm256_cmpgt_epi32(a0, x);
+            else if constexpr (P == PRED_OUTSIDE)
+                r[j] = _mm256_or_si256(_mm256_cmpgt_epi32(a0, x), _mm256_cmpgt_epi32(x, a1));
+            else {
+                __m256i hit = _mm256_setzero_si256();
+                for (size_t k = 0; k < na; ++k)
+                    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi32(x, _mm256_set1_epi32(a[k])));
+                r[j] = hit;
+            }
+        }
+        __m256i b = _mm256_packs_epi16(_mm256_packs_epi32(r[0], r[1]), _mm256_packs_epi32(r[2], r[3]));
+        b = _mm256_permutevar8x32_epi32(b, order);
+        b = _mm256_and_si256(_mm256_xor_si256(b, flip), one);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(m + i), b);
+    }
+    scalar_kernel<P>(v + i, n - i, a, na, invert, m + i);
+}
+#endif
+
+//
+// ------------------------- DISPATCH ----------------------------
+//
+namespace {
+
+struct KernelSet {
+    const char *level;
+    I32Kernel k[5];
+};
+
+const KernelSet SCALAR{"scalar",
+                       {scalar_kernel<PRED_EQ>, scalar_kernel<PRED_GT>, scalar_kernel<PRED_LT>,
+                        scalar_kernel<PRED_OUTSIDE>, scalar_kernel<PRED_IN_SMALL>}};
+#ifdef FILTER_KERNELS_X86
+const KernelSet SSE41{"sse4.1",
+                      {sse_kernel<PRED_EQ>, sse_kernel<PRED_GT>, sse_kernel<PRED_LT>, sse_kernel<PRED_OUTSIDE>,
+                       sse_kernel<PRED_IN_SMALL>}};
+const KernelSet AVX2{"avx2",
+                     {avx2_kernel<PRED_EQ>, avx2_kernel<PRED_GT>, avx2_kernel<PRED_LT>, avx2_kernel<PRED_OUTSIDE>,
+                      avx2_kernel<PRED_IN_SMALL>}};
+#endif
+
+// the sets this CPU can run, best first
+const std::vector<const KernelSet *> &usable() {
+    static const std::vector<const KernelSet *> sets = [] {
+        std::vector<const KernelSet *> out;
+#ifdef FILTER_KERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) out.push_back(&AVX2);
+        if (__builtin_cpu_supports("sse4.1")) out.push_back(&SSE41);
+#endif
+        out.push_back(&SCALAR);
+        return out;
+    }();
+    return sets;
+}
+
+std::atomic<const KernelSet *> &active() {
+    static std::atomic<const KernelSet *> set{usable().front()};
+    return set;
+}
+
+const KernelSet &kernels() { return *active().load(std::memory_order_relaxed); }
+
+} // namespace
+
+std::vector<const char *> filter_kernel_levels() {
+    std::vector<const char *> out;
+    for (const KernelSet *k : usable()) out.push_back(k->level);
+    return out;
+}
+
+bool set_filter_kernel_level(std::string_view level) {
+    if (level == "auto") {
+        active().store(usable().front(), std::memory_order_relaxed);
+        return true;
+    }
+    for (const KernelSet *k : usable()) {
+        if (level != k->level) continue;
+        active().store(k, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+const char *filter_kernel_level() { return kernels().level; }
+
+void filter_i32_compare(const int32_t *v, size_t n, sql::CompareOp op, int32_t k, uint8_t *mask) {
+    const I32Kernel *ks = kernels().k;
+    switch (op) {
+    case sql::CompareOp::EQ: ks[PRED_EQ](v, n, &k, 1, false, mask); break;
+    case sql::CompareOp::NE: ks[PRED_EQ](v, n, &k, 1, true, mask); break;
+    case sql::CompareOp::GT: ks[PRED_GT](v, n, &k, 1, false, mask); break;
+    case sql::CompareOp::LE: ks[PRED_GT](v, n, &k, 1, true, mask); break;
+    case sql::CompareOp::LT: ks[PRED_LT](v, n, &k, 1, false, mask); break;
+    case sql::CompareOp::GE: ks[PRED_LT](v, n, &k, 1, true, mask); break;
+    }
+}
+
+void filter_i32_between(const int32_t *v, size_t n, int32_t lo, int32_t hi, uint8_t *mask) {
+    const int32_t bounds[2] = {lo, hi};
+    kernels().k[PRED_OUTSIDE](v, n, bounds, 2, true, mask);
+}
+
+void filter_i32_in(const int32_t *v, size_t n, const int32_t *set, size_t set_size, uint8_t *mask) {
+    if (set_size == 0) {
+        std::fill(mask, mask + n, 0);
+        return;
+    }
+    if (set_size <= IN_VECTOR_MAX) {
+        kernels().k[PRED_IN_SMALL](v, n, set, set_size, false, mask);
+        return;
+    }
+    // long lists: a range check rejects most rows before the binary search
+    int32_t lo = set[0], hi = set[set_size - 1];
+    for (size_t i = 0; i < n; ++i) {
+        int32_t x = v[i];
+        mask[i] = x >= lo && x <= hi && std::binary_search(set, set + set_size, x);
+    }
+}
+
+void filter_text_equals(const uint32_t *offsets, const char *chars, size_t n, std::string_view k, bool negate,
+                        uint8_t *mask) {
+    // length first: most non-matching rows never touch their bytes
+    const uint32_t len = static_cast<uint32_t>(k.size());
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t b = offsets[i];
+        bool eq = offsets[i + 1] - b == len && std::memcmp(chars + b, k.data(), len) == 0;
+        mask[i] = eq != negate;
+    }
+}
+
+void filter_text_prefix(const uint32_t *offsets, const char *chars, size_t n, std::string_view prefix,
+                        uint8_t *mask) {
+    const uint32_t len = static_cast<uint32_t>(prefix.size());
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t b = offsets[i];
+        mask[i] = offsets[i + 1] - b >= len && std::memcmp(chars + b, prefix.data(), len) == 0;
+    }
+}
+
+void mask_and(uint8_t *dst, const uint8_t *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] &= src[i];
+}
+
+void mask_or(uint8_t *dst, const uint8_t *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] |= src[i];
+}
+
+void mask_not(uint8_t *dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] ^= 1;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "src/sql/ast.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Selection kernels for WHERE over column vectors. Every kernel writes one
+// byte per row (1 = selected) into `mask`. INT kernels use AVX2 or SSE4.1,
+// picked once at startup from the CPU's capabilities, with a scalar fallback.
+
+// "avx2", "sse4.1" or "scalar"
+const char *filter_kernel_level();
+// the levels this CPU can run, best first ("scalar" always last)
+std::vector<const char *> filter_kernel_levels();
+// Run the INT kernels of `level` from now on ("auto" = the best one); false
+// if the CPU cannot run it. For tests and the filter_kernels config key:
+// callers switch before running queries, not during.
+bool set_filter_kernel_level(std::string_view level);
+
+void filter_i32_compare(const int32_t *v, size_t n, sql::CompareOp op, int32_t k, uint8_t *mask);
+void filter_i32_between(const int32_t *v, size_t n, int32_t lo, int32_t hi, uint8_t *mask);
+// `set` must be sorted and free of duplicates
+void filter_i32_in(const int32_t *v, size_t n, const int32_t *set, size_t set_size, uint8_t *mask);
+
+// TEXT columns in ColumnVector layout (offsets has n + 1 entries)
+void filter_text_equals(const uint32_t *offsets, const char *chars, size_t n, std::string_view k, bool negate,
+                        uint8_t *mask);
+void filter_text_prefix(const uint32_t *offsets, const char *chars, size_t n, std::string_view prefix,
+                        uint8_t *mask);
+
+void mask_and(uint8_t *dst, const uint8_t *src, size_t n);
+void mask_or(uint8_t *dst, const uint8_t *src, size_t n);
+void mask_not(uint8_t *dst, size_t n);
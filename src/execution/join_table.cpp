@@ -0,0 +1,149 @@
+#include "src/execution/join_table.h"
+
+#include <stdexcept>
+
+JoinTable::JoinTable(std::vector<ColumnType> types) : types_(std::move(types)) { rows_.reset(types_); }
+
+void JoinTable::insert(const Batch &src, size_t row, std::string_view key, uint64_t hash) {
+    rows_.append_row(src, row);
+    arena_.append(key.data(), key.size());
+    key_off_.push_back(arena_.size());
+    hashes_.push_back(hash);
+}
+
+void JoinTable::finish() {
+    size_t buckets = 1024;
+    while (buckets < hashes_.size()) buckets *= 2;
+    heads_.assign(buckets, NONE);
+    next_.assign(hashes_.size(), NONE);
+    size_t mask = buckets - 1;
+    // insert back to front so chains list rows in input order
+    for (size_t r = hashes_.size(); r-- > 0;) {
+        uint32_t &head = heads_[hashes_[r] & mask];
+        next_[r] = head;
+        head = static_cast<uint32_t>(r);
+    }
+}
+
+void JoinTable::clear() {
+    rows_.reset(types_);
+    arena_.clear();
+    key_off_.assign(1, 0);
+    hashes_.clear();
+    heads_.clear();
+    next_.clear();
+}
+
+uint32_t JoinTable::scan_chain(uint32_t row, std::string_view key, uint64_t hash) const {
+    while (row != NONE && (hashes_[row] != hash || this->key(row) != key)) row = next_[row];
+    return row;
+}
+
+uint32_t JoinTable::first_match(std::string_view key, uint64_t hash) const {
+    if (heads_.empty()) return NONE;
+    return scan_chain(heads_[hash & (heads_.size() - 1)], key, hash);
+}
+
+uint32_t JoinTable::next_match(uint32_t row, std::string_view key, uint64_t hash) const {
+    return scan_chain(next_[row], key, hash);
+}
+
+//
+// --------------------------- SPILL -----------------------------
+//
+RowSpill::~RowSpill() {
+    for (std::FILE *f : files_)
+        if (f) std::fclose(f);
+}
+
+void RowSpill::write(const Batch &src, size_t row, std::string_view key, uint64_t hash) {
+    size_t p = partition_of(hash);
+    if (!files_[p]) {
+        files_[p] = std::tmpfile();
+        if (!files_[p]) throw std::runtime_error("cannot create join spill file");
+    }
+    std::FILE *f = files_[p];
+    uint32_t len = static_cast<uint32_t>(key.size());
+    std::fwrite(&len, sizeof(len), 1, f);
+    std::fwrite(key.data(), 1, len, f);
+    for (const ColumnVector &c : src.columns) {
+        switch (c.type) {
+        case ColumnType::INT: std::fwrite(&c.i32[row], sizeof(int32_t), 1, f); break;
+        case ColumnType::BIGINT: std::fwrite(&c.i64[row], sizeof(int64_t), 1, f); break;
+        case ColumnType::DOUBLE: std::fwrite(&c.f64[row], sizeof(double), 1, f); break;
+        case ColumnType::TEXT: {
+            std::string_view v = c.text(row);
+            uint32_t vlen = static_cast<uint32_t>(v.size());
+            std::fwrite(&vlen, sizeof(vlen), 1, f);
+            std::fwrite(v.data(), 1, vlen, f);
+            break;
+        }
+        }
+    }
+    if (std::ferror(f)) throw std::runtime_error("join spill write failed");
+}
+
+bool RowSpill::read(size_t p, Batch &out, std::string &keys, std::vector<size_t> &key_off) {
+    out.reset(types_);
+    keys.clear();
+    key_off.assign(1, 0);
+    std::FILE *f = files_[p];
+    if (!f) return false;
+    if (!reading_[p]) {
+        std::rewind(f);
+        reading_[p] = true;
+    }
+
+    std::string text;
+    uint32_t len;
+    while (out.size < BATCH_SIZE && std::fread(&len, sizeof(len), 1, f) == 1) {
+        size_t at = keys.size();
+        keys.resize(at + len);
+        if (len && std::fread(&keys[at], 1, len, f) != len) break;
+        key_off.push_back(keys.size());
+        for (ColumnVector &c : out.columns) {
+            switch (c.type) {
+            case ColumnType::INT: c.i32.emplace_back(); std::fread(&c.i32.back(), sizeof(int32_t), 1, f); break;
+            case ColumnType::BIGINT: c.i64.emplace_back(); std::fread(&c.i64.back(), sizeof(int64_t), 1, f); break;
+            case ColumnType::DOUBLE: c.f64.emplace_back(); std::fread(&c.f64.back(), sizeof(double), 1, f); break;
+            case ColumnType::TEXT: {
+                uint32_t vlen = 0;
+                std::fread(&vlen, sizeof(vlen), 1, f);
+                text.resize(vlen);
+                if (vlen) std::fread(&text[0], 1, vlen, f);
+                c.push_text(text);
+                break;
+            }
+            }
+        }
+        out.size++;
+    }
+    return out.size > 0;
+}
+
+//
+// ---------------------------- BLOOM ----------------------------
+//
+void BloomFilter::init(size_t n) {
+    size_t bits = 1024;
+    while (bits < n * 10) bits *= 2;
+    bits_.assign(bits / 64, 0);
+    mask_ = bits - 1;
+}
+
+void BloomFilter::add(uint64_t hash) {
+    uint64_t h1 = hash, h2 = (hash >> 32) | 1;
+    for (int i = 0; i < PROBES; ++i) {
+        uint64_t b = (h1 + i * h2) & mask_;
+        bits_[b >> 6] |= uint64_t(1) << (b & 63);
+    }
+}
+
+bool BloomFilter::may_contain(uint64_t hash) const {
+    uint64_t h1 = hash, h2 = (hash >> 32) | 1;
+    for (int i = 0; i < PROBES; ++i) {
+        uint64_t b = (h1 + i * h2) & mask_;
+        if (!(bits_[b >> 6] & (uint64_t(1) << (b & 63)))) return false;
+    }
+    return true;
+}
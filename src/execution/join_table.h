@@ -0,0 +1,91 @@
+#pragma once
+
+#include "src/execution/batch.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Build side of a hash join: rows kept column-wise in one Batch plus their
+// encoded join keys. Rows with the same bucket are chained through `next_`,
+// so duplicate keys cost one index each and the directory is built once,
+// after the last insert, at a size matching the row count.
+class JoinTable {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    explicit JoinTable(std::vector<ColumnType> types);
+
+    void insert(const Batch &src, size_t row, std::string_view key, uint64_t hash);
+    // build the bucket directory; call after the last insert
+    void finish();
+    void clear();
+
+    size_t size() const { return hashes_.size(); }
+    const Batch &rows() const { return rows_; }
+    std::string_view key(uint32_t row) const {
+        return std::string_view(arena_.data() + key_off_[row], key_off_[row + 1] - key_off_[row]);
+    }
+    uint64_t hash(uint32_t row) const { return hashes_[row]; }
+
+    // first / next row whose key equals `key`, NONE when there is none
+    uint32_t first_match(std::string_view key, uint64_t hash) const;
+    uint32_t next_match(uint32_t row, std::string_view key, uint64_t hash) const;
+
+private:
+    uint32_t scan_chain(uint32_t row, std::string_view key, uint64_t hash) const;
+
+    std::vector<ColumnType> types_;
+    Batch rows_;
+    std::string arena_;
+    std::vector<size_t> key_off_{0};   // size() + 1 entries
+    std::vector<uint64_t> hashes_;
+    std::vector<uint32_t> heads_;      // power-of-two bucket directory
+    std::vector<uint32_t> next_;
+};
+
+// Hash-partitioned spill files of (join key, row) records, used by the grace
+// hash join when the build side outgrows memory. Partitioning uses the same
+// hash bits as AggSpill, so matching keys of both inputs share a partition.
+class RowSpill {
+public:
+    static constexpr size_t PARTITIONS = 16;
+
+    explicit RowSpill(std::vector<ColumnType> types) : types_(std::move(types)) {}
+    ~RowSpill();
+    RowSpill(const RowSpill &) = delete;
+    RowSpill &operator=(const RowSpill &) = delete;
+
+    static size_t partition_of(uint64_t hash) { return static_cast<size_t>(hash >> 60) % PARTITIONS; }
+
+    void write(const Batch &src, size_t row, std::string_view key, uint64_t hash);
+
+    // Read the next rows of partition p (at most BATCH_SIZE) into `out`, with
+    // their keys concatenated in `keys` (key_off: size + 1 offsets). Partitions
+    // are read from the start once writing is over; false at the end.
+    bool read(size_t p, Batch &out, std::string &keys, std::vector<size_t> &key_off);
+
+private:
+    std::vector<ColumnType> types_;
+    std::FILE *files_[PARTITIONS] = {};
+    bool reading_[PARTITIONS] = {};
+};
+
+// Bloom filter (double hashing) over join key hashes. Built from
+// the build side of an inner join and checked by the probe-side scan, so rows
+// that cannot match are dropped before they reach the join.
+class BloomFilter {
+public:
+    // size for `n` keys at ~10 bits per key (about 1% false positives)
+    void init(size_t n);
+    void add(uint64_t hash);
+    bool may_contain(uint64_t hash) const;
+    bool ready() const { return !bits_.empty(); }
+
+private:
+    static constexpr int PROBES = 7;
+    std::vector<uint64_t> bits_;
+    uint64_t mask_ = 0;   // bit count - 1
+};
@@ -0,0 +1,1069 @@
+#include "src/execution/operators.h"
+#include "src/execution/vector_expr.h"
+#include "src/storage/page/heap_page.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+using namespace storage;
+
+//
+// ------------------------- SCANS -------------------------------
+//
+static void push_default(ColumnVector &col) {
+    if (col.type == ColumnType::TEXT) col.push_text("");
+    else col.i32.push_back(0);
+}
+
+// Decode the wanted values of one serialized Tuple into the next row of `out`
+// (INT/TEXT columns). Unwanted values are skipped by their encoded length and
+// nothing past the last wanted column is read. Missing values read as 0 / ''.
+static void decode_row(const char *p, const std::vector<int> &columns, Batch &out) {
+    uint16_t n;
+    std::memcpy(&n, p, sizeof(uint16_t));
+    p += sizeof(uint16_t);
+
+    int at = 0; // index of the value `p` points at
+    for (size_t c = 0; c < columns.size(); ++c) {
+        ColumnVector &col = out.columns[c];
+        int want = columns[c];
+        if (want >= n) {
+            push_default(col);
+            continue;
+        }
+        for (; at < want; ++at) {
+            if (static_cast<ValueType>(*p) == ValueType::INT) {
+                p += 1 + sizeof(int32_t);
+            } else {
+                uint16_t len;
+                std::memcpy(&len, p + 1, sizeof(uint16_t));
+                p += 1 + sizeof(uint16_t) + len;
+            }
+        }
+
+        auto type = static_cast<ValueType>(*p++);
+        if (type == ValueType::INT) {
+            int32_t v;
+            std::memcpy(&v, p, sizeof(int32_t));
+            p += sizeof(int32_t);
+            if (col.type == ColumnType::INT) col.i32.push_back(v);
+            else col.push_text(std::to_string(v));
+        } else {
+            uint16_t len;
+            std::memcpy(&len, p, sizeof(uint16_t));
+            p += sizeof(uint16_t);
+            if (col.type == ColumnType::TEXT) col.push_text(std::string_view(p, len));
+            else col.i32.push_back(0);
+            p += len;
+        }
+        at++;
+    }
+    out.size++;
+}
+
+SeqScanOp::SeqScanOp(BufferPool &bp, uint32_t segment_id, const Txn *txn, std::vector<int> columns,
+                     std::vector<ColumnType> types, std::function<bool(uint32_t)> keep_page)
+    : bp_(bp), segment_id_(segment_id), txn_(txn), heap_(segment_id, nullptr, txn), columns_(std::move(columns)),
+      keep_page_(std::move(keep_page)), pages_(bp.page_count(segment_id)) {
+    types_ = std::move(types);
+}
+
+void SeqScanOp::restrict_pages(uint32_t first, uint32_t end) {
+    page_no_ = first;
+    pages_ = std::min(pages_, end);
+}
+
+void SeqScanOp::set_limit(uint64_t limit, uint64_t skip) {
+    limit_ = limit;
+    skip_ = skip;
+}
+
+void SeqScanOp::set_first_batch(size_t rows) { batch_rows_ = std::max<size_t>(1, std::min(rows, BATCH_SIZE)); }
+
+bool SeqScanOp::next(Batch &out) {
+    out.reset(types_);
+    size_t cap = static_cast<size_t>(std::min<uint64_t>(batch_rows_, limit_ - produced_));
+    batch_rows_ = std::min(batch_rows_ * 2, BATCH_SIZE);
+    while (page_no_ < pages_ && out.size < cap) {
+        if (offset_ == 0) {
+            if (keep_page_ && !keep_page_(page_no_)) {
+                page_no_++;
+                continue;
+            }
+            offset_ = HeapPage::FIRST_RECORD;
+        }
+
+        // the page stays pinned only while this batch is being filled
+        Frame *frame = bp_.fetch_page(PageId{segment_id_, page_no_});
+        const Page &page = frame->page;
+        uint32_t end = HeapPage::FIRST_RECORD + HeapPage::used_bytes(page);
+        bool page_done = true;
+        while (offset_ + HeapPage::RECORD_HEADER <= end) {
+            if (out.size + forwarded_.size() == cap) {
+                page_done = false;
+                break;
+            }
+            uint32_t hdr = HeapPage::record_header(page, offset_);
+            uint32_t len = hdr & HeapPage::LEN_MASK;
+            if (len == 0 || offset_ + HeapPage::RECORD_HEADER + len > end) break;
+            // moved rows are read from their home record (see TableHeap::ForEach)
+            if ((hdr & (HeapPage::FORWARD | HeapPage::DELETED)) == HeapPage::FORWARD) {
+                RecordId to;
+                std::memcpy(&to, page.data + offset_ + HeapPage::RECORD_HEADER, sizeof(RecordId));
+                forwarded_.emplace_back(RecordId{page_no_, offset_}, to);
+                offset_ += HeapPage::RECORD_HEADER + len;
+                continue;
+            }
+            const char *tuple = (hdr & HeapPage::MOVED) ? nullptr : HeapPage::tuple_at(page, offset_, hdr);
+            if (tuple && txn_ && (hdr & HeapPage::VERSIONED)) {
+                uint32_t n = 0;
+                tuple = TableHeap::VisibleTuple(*txn_, segment_id_, RecordId{page_no_, offset_}, page, offset_, hdr,
+                                                n, copy_);
+            }
+            if (tuple) {
+                if (skip_ > 0) skip_--;
+                else decode_row(tuple, columns_, out);
+            }
+            offset_ += HeapPage::RECORD_HEADER + len;
+        }
+        bp_.unpin_page(frame, false);
+
+        for (const auto &[id, to] : forwarded_) {
+            if (!heap_.ReadAt(bp_, id, to, copy_)) continue;
+            if (skip_ > 0) skip_--;
+            else decode_row(copy_.data(), columns_, out);
+        }
+        forwarded_.clear();
+
+        if (page_done) {
+            page_no_++;
+            offset_ = 0;
+        }
+    }
+    produced_ += out.size;
+    return out.size > 0;
+}
+
+IndexScanOp::IndexScanOp(BufferPool &bp, uint32_t segment_id, const Txn *txn, std::vector<int> columns,
+                         std::vector<ColumnType> types, std::vector<RecordId> rids)
+    : bp_(bp), heap_(segment_id, nullptr, txn), columns_(std::move(columns)), rids_(std::move(rids)) {
+    types_ = std::move(types);
+    auto key = [](const RecordId &r) { return std::make_pair(r.page_number, r.offset); };
+    std::sort(rids_.begin(), rids_.end(), [&](const RecordId &a, const RecordId &b) { return key(a) < key(b); });
+    rids_.erase(std::unique(rids_.begin(), rids_.end()), rids_.end());
+}
+
+bool IndexScanOp::next(Batch &out) {
+    out.reset(types_);
+    Tuple tup;
+    while (pos_ < rids_.size() && out.size < BATCH_SIZE) {
+        if (!heap_.Get(bp_, rids_[pos_++], tup)) continue;
+        const auto &vals = tup.values();
+        for (size_t c = 0; c < columns_.size(); ++c) {
+            ColumnVector &col = out.columns[c];
+            size_t at = static_cast<size_t>(columns_[c]);
+            if (at >= vals.size()) push_default(col);
+            else if (col.type == ColumnType::TEXT) col.push_text(vals[at].to_string());
+            else col.i32.push_back(vals[at].type() == ValueType::INT ? vals[at].as_int() : 0);
+        }
+        out.size++;
+    }
+    return out.size > 0;
+}
+
+//
+// ---------------------- FILTER / PROJECT -----------------------
+//
+FilterOp::FilterOp(OperatorPtr child, const sql::Expr &pred, const Params *params)
+    : child_(std::move(child)), pred_(pred), params_(params) {
+    types_ = child_->types();
+}
+
+bool FilterOp::next(Batch &out) {
+    while (child_->next(out)) {
+        eval_mask(pred_, out, params_, mask_);
+        out.compact(mask_);
+        if (out.size > 0) return true;
+    }
+    return false;
+}
+
+ProjectOp::ProjectOp(OperatorPtr child, const std::vector<sql::ExprPtr> &exprs, const Params *params)
+    : child_(std::move(child)), exprs_(exprs), params_(params) {
+    for (const auto &e : exprs_) types_.push_back(infer_type(*e, child_->types(), params_));
+}
+
+bool ProjectOp::next(Batch &out) {
+    if (!child_->next(in_)) return false;
+    out.columns.resize(exprs_.size());
+    for (size_t i = 0; i < exprs_.size(); ++i) eval_batch(*exprs_[i], in_, params_, out.columns[i]);
+    out.size = in_.size;
+    return true;
+}
+
+//
+// ------------------------- AGGREGATE ---------------------------
+//
+bool agg_func_from_name(const std::string &name, AggFunc &out) {
+    static const std::pair<const char *, AggFunc> funcs[] = {
+        {"COUNT", AggFunc::COUNT}, {"SUM", AggFunc::SUM}, {"MIN", AggFunc::MIN},
+        {"MAX", AggFunc::MAX},     {"AVG", AggFunc::AVG},
+    };
+    for (const auto &f : funcs) {
+        if (name == f.first) {
+            out = f.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+AggregateOp::AggregateOp(std::vector<OperatorPtr> inputs, const std::vector<sql::ExprPtr> &keys,
+                         const std::vector<AggSpec> &aggs, const Params *params, size_t max_groups)
+    : inputs_(std::move(inputs)), keys_(keys), aggs_(aggs), params_(params), max_groups_(max_groups),
+      result_(aggs.size()) {
+    const auto &in = inputs_.at(0)->types();
+    for (const auto &k : keys_) key_types_.push_back(infer_type(*k, in, params_));
+    types_ = key_types_;
+
+    for (const auto &a : aggs_) {
+        ColumnType arg = a.arg ? infer_type(*a.arg, in, params_) : ColumnType::BIGINT;
+        arg_types_.push_back(arg);
+        switch (a.func) {
+        case AggFunc::COUNT: types_.push_back(ColumnType::BIGINT); break;
+        case AggFunc::SUM:
+        case AggFunc::AVG:
+            if (arg == ColumnType::TEXT) throw std::runtime_error("SUM/AVG of non-INT value");
+            types_.push_back(a.func == AggFunc::AVG ? ColumnType::DOUBLE
+                             : arg == ColumnType::DOUBLE ? ColumnType::DOUBLE : ColumnType::BIGINT);
+            break;
+        case AggFunc::MIN:
+        case AggFunc::MAX: types_.push_back(arg); break;
+        }
+    }
+}
+
+// Group key bytes: fixed-width values raw, TEXT length-prefixed
+static void append_key(std::string &key, const ColumnVector &c, size_t r) {
+    switch (c.type) {
+    case ColumnType::INT: key.append(reinterpret_cast<const char *>(&c.i32[r]), sizeof(int32_t)); break;
+    case ColumnType::BIGINT: key.append(reinterpret_cast<const char *>(&c.i64[r]), sizeof(int64_t)); break;
+    case ColumnType::DOUBLE: key.append(reinterpret_cast<const char *>(&c.f64[r]), sizeof(double)); break;
+    case ColumnType::TEXT: {
+        std::string_view v = c.text(r);
+        uint32_t len = static_cast<uint32_t>(v.size());
+        key.append(reinterpret_cast<const char *>(&len), sizeof(len));
+        key.append(v.data(), v.size());
+        break;
+    }
+    }
+}
+
+// Inverse of append_key for a whole key: one value per key column
+static void decode_key(std::string_view key, Batch &out) {
+    const char *p = key.data();
+    for (auto &c : out.columns) {
+        switch (c.type) {
+        case ColumnType::INT: {
+            int32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            c.i32.push_back(v);
+            p += sizeof(v);
+            break;
+        }
+        case ColumnType::BIGINT: {
+            int64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            c.i64.push_back(v);
+            p += sizeof(v);
+            break;
+        }
+        case ColumnType::DOUBLE: {
+            double v;
+            std::memcpy(&v, p, sizeof(v));
+            c.f64.push_back(v);
+            p += sizeof(v);
+            break;
+        }
+        case ColumnType::TEXT: {
+            uint32_t len;
+            std::memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            c.push_text(std::string_view(p, len));
+            p += len;
+            break;
+        }
+        }
+    }
+}
+
+static void update_state(AggState &s, AggFunc f, const ColumnVector &v, size_t r) {
+    if (f == AggFunc::COUNT) {
+        s.count++;
+        return;
+    }
+    bool first = s.count++ == 0;
+    switch (v.type) {
+    case ColumnType::INT:
+    case ColumnType::BIGINT: {
+        int64_t x = v.type == ColumnType::INT ? v.i32[r] : v.i64[r];
+        if (f == AggFunc::SUM || f == AggFunc::AVG) s.i += x;
+        else if (first || (f == AggFunc::MIN ? x < s.i : x > s.i)) s.i = x;
+        break;
+    }
+    case ColumnType::DOUBLE: {
+        double x = v.f64[r];
+        if (f == AggFunc::SUM || f == AggFunc::AVG) s.d += x;
+        else if (first || (f == AggFunc::MIN ? x < s.d : x > s.d)) s.d = x;
+        break;
+    }
+    case ColumnType::TEXT: {
+        std::string_view x = v.text(r);
+        if (first || (f == AggFunc::MIN ? x < s.s : x > s.s)) s.s.assign(x);
+        break;
+    }
+    }
+}
+
+// Write a fixed-width key column at byte `at` of every row's key (`width` bytes each)
+template <typename T>
+static void key_column(const T *v, size_t n, size_t width, size_t at, char *keys) {
+    for (size_t r = 0; r < n; ++r) std::memcpy(keys + r * width + at, &v[r], sizeof(T));
+}
+
+// update_state for a whole batch with the function and argument type fixed:
+// SUM/AVG and MIN/MAX of INT, BIGINT and DOUBLE each get their own loop
+template <AggFunc F, typename Acc, typename T>
+static void update_loop(AggTable &table, size_t agg, const size_t *groups, const T *x, size_t n, Acc AggState::*acc) {
+    for (size_t r = 0; r < n; ++r) {
+        AggState &s = table.states(groups[r])[agg];
+        Acc v = x[r];
+        if constexpr (F == AggFunc::SUM) {
+            s.*acc += v;
+            s.count++;
+        } else if constexpr (F == AggFunc::MIN) {
+            if (s.count++ == 0 || v < s.*acc) s.*acc = v;
+        } else {
+            if (s.count++ == 0 || v > s.*acc) s.*acc = v;
+        }
+    }
+}
+
+template <typename Acc, typename T>
+static void update_numeric(AggTable &table, size_t agg, AggFunc f, const size_t *groups, const T *x, size_t n,
+                           Acc AggState::*acc) {
+    switch (f) {
+    case AggFunc::SUM:
+    case AggFunc::AVG: update_loop<AggFunc::SUM>(table, agg, groups, x, n, acc); break;
+    case AggFunc::MIN: update_loop<AggFunc::MIN>(table, agg, groups, x, n, acc); break;
+    case AggFunc::MAX: update_loop<AggFunc::MAX>(table, agg, groups, x, n, acc); break;
+    case AggFunc::COUNT: break;
+    }
+}
+
+// Aggregate `agg` of every row of a batch into the state of its group
+static void update_states(AggTable &table, size_t agg, AggFunc f, const ColumnVector &v, const size_t *groups,
+                          size_t n) {
+    if (f == AggFunc::COUNT) {
+        for (size_t r = 0; r < n; ++r) table.states(groups[r])[agg].count++;
+        return;
+    }
+    switch (v.type) {
+    case ColumnType::INT: update_numeric(table, agg, f, groups, v.i32.data(), n, &AggState::i); break;
+    case ColumnType::BIGINT: update_numeric(table, agg, f, groups, v.i64.data(), n, &AggState::i); break;
+    case ColumnType::DOUBLE: update_numeric(table, agg, f, groups, v.f64.data(), n, &AggState::d); break;
+    case ColumnType::TEXT:
+        for (size_t r = 0; r < n; ++r) update_state(table.states(groups[r])[agg], f, v, r);
+        break;
+    }
+}
+
+static void merge_state(AggState &dst, const AggState &src, AggFunc f, ColumnType arg) {
+    if (src.count == 0) return;
+    if (f == AggFunc::MIN || f == AggFunc::MAX) {
+        bool take = dst.count == 0;
+        if (!take) {
+            bool less = arg == ColumnType::TEXT ? src.s < dst.s
+                        : arg == ColumnType::DOUBLE ? src.d < dst.d : src.i < dst.i;
+            bool greater = arg == ColumnType::TEXT ? src.s > dst.s
+                           : arg == ColumnType::DOUBLE ? src.d > dst.d : src.i > dst.i;
+            take = f == AggFunc::MIN ? less : greater;
+        }
+        if (take) {
+            dst.i = src.i;
+            dst.d = src.d;
+            dst.s = src.s;
+        }
+    } else {
+        dst.i += src.i;
+        dst.d += src.d;
+    }
+    dst.count += src.count;
+}
+
+void AggregateOp::merge_into(AggTable &dst, std::string_view key, uint64_t hash, const AggState *src) {
+    AggState *st = dst.states(dst.find_or_insert(key, hash));
+    for (size_t a = 0; a < aggs_.size(); ++a) merge_state(st[a], src[a], aggs_[a].func, arg_types_[a]);
+}
+
+void AggregateOp::aggregate_input(Operator &input, Partial &part) {
+    size_t naggs = aggs_.size();
+    Batch in;
+    std::vector<ColumnVector> key_cols(keys_.size());
+    std::vector<ColumnVector> args(naggs);
+    std::string key;
+    std::vector<size_t> groups;
+
+    while (input.next(in)) {
+        for (size_t k = 0; k < keys_.size(); ++k) eval_batch(*keys_[k], in, params_, key_cols[k]);
+        for (size_t a = 0; a < naggs; ++a)
+            if (aggs_[a].arg) eval_batch(*aggs_[a].arg, in, params_, args[a]);
+
+        // the group of every row; fixed-width keys are built a column at a time
+        groups.resize(in.size);
+        size_t width = 0;
+        for (const auto &kc : key_cols) {
+            if (kc.type == ColumnType::TEXT) {
+                width = SIZE_MAX;
+                break;
+            }
+            width += kc.type == ColumnType::INT ? sizeof(int32_t) : sizeof(int64_t);
+        }
+        if (width == SIZE_MAX) {
+            for (size_t r = 0; r < in.size; ++r) {
+                key.clear();
+                for (const auto &kc : key_cols) append_key(key, kc, r);
+                groups[r] = part.table.find_or_insert(key, AggTable::hash_key(key));
+            }
+        } else if (width == 0) {
+            // no GROUP BY: one group (created by the first row, as for any key)
+            size_t group = in.size ? part.table.find_or_insert({}, AggTable::hash_key({})) : 0;
+            std::fill(groups.begin(), groups.end(), group);
+        } else {
+            key.resize(in.size * width);
+            size_t at = 0;
+            for (const auto &kc : key_cols) {
+                switch (kc.type) {
+                case ColumnType::INT: key_column(kc.i32.data(), in.size, width, at, key.data()); break;
+                case ColumnType::BIGINT: key_column(kc.i64.data(), in.size, width, at, key.data()); break;
+                case ColumnType::DOUBLE: key_column(kc.f64.data(), in.size, width, at, key.data()); break;
+                case ColumnType::TEXT: break;
+                }
+                at += kc.type == ColumnType::INT ? sizeof(int32_t) : sizeof(int64_t);
+            }
+            for (size_t r = 0; r < in.size; ++r) {
+                std::string_view k(key.data() + r * width, width);
+                groups[r] = part.table.find_or_insert(k, AggTable::hash_key(k));
+            }
+        }
+        for (size_t a = 0; a < naggs; ++a)
+            update_states(part.table, a, aggs_[a].func, args[a], groups.data(), in.size);
+
+        if (part.table.size() > max_groups_) {
+            part.spill.write(part.table);
+            part.table.clear();
+        }
+    }
+}
+
+void AggregateOp::consume() {
+    for (size_t i = 0; i < inputs_.size(); ++i) partials_.push_back(std::make_unique<Partial>(aggs_.size()));
+
+    if (inputs_.size() == 1) {
+        aggregate_input(*inputs_[0], *partials_[0]);
+    } else {
+        // thread-local aggregation, one thread per input
+        std::vector<std::thread> workers;
+        std::vector<std::exception_ptr> errors(inputs_.size());
+        for (size_t i = 0; i < inputs_.size(); ++i) {
+            workers.emplace_back([this, i, &errors] {
+                try {
+                    aggregate_input(*inputs_[i], *partials_[i]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for (auto &w : workers) w.join();
+        for (auto &e : errors)
+            if (e) std::rethrow_exception(e);
+    }
+    inputs_.clear();
+
+    for (const auto &p : partials_) spilled_ = spilled_ || !p->spill.empty();
+    if (spilled_) {
+        // everything goes through the partitions so each key is merged exactly once
+        for (auto &p : partials_) {
+            p->spill.write(p->table);
+            p->table.clear();
+        }
+        return;
+    }
+
+    // merge the partial tables into the largest one
+    size_t big = 0;
+    for (size_t i = 1; i < partials_.size(); ++i)
+        if (partials_[i]->table.size() > partials_[big]->table.size()) big = i;
+    std::swap(result_, partials_[big]->table);
+    for (size_t i = 0; i < partials_.size(); ++i) {
+        if (i == big) continue;
+        const AggTable &t = partials_[i]->table;
+        for (size_t g = 0; g < t.size(); ++g) merge_into(result_, t.key(g), t.hash(g), t.states(g));
+    }
+    partials_.clear();
+
+    // an aggregate without GROUP BY always yields one row
+    if (keys_.empty() && result_.size() == 0) result_.find_or_insert("", AggTable::hash_key(""));
+}
+
+// Replace result_ with the merged groups of the next non-empty spill partition
+bool AggregateOp::load_partition() {
+    while (next_partition_ < AggSpill::PARTITIONS) {
+        size_t p = next_partition_++;
+        result_.clear();
+        for (const auto &part : partials_) {
+            part->spill.read(p, [&](std::string_view key, uint64_t hash, const AggState *st) {
+                merge_into(result_, key, hash, st);
+            });
+        }
+        if (result_.size() > 0) return true;
+    }
+    return false;
+}
+
+bool AggregateOp::next(Batch &out) {
+    if (!consumed_) {
+        consume();
+        consumed_ = true;
+        if (spilled_) load_partition();
+    }
+    if (emitted_ == result_.size() && spilled_ && load_partition()) emitted_ = 0;
+
+    out.reset(types_);
+    size_t nkeys = keys_.size();
+    size_t naggs = aggs_.size();
+    size_t end = std::min(result_.size(), emitted_ + BATCH_SIZE);
+
+    Batch key_batch;
+    key_batch.reset(key_types_);
+    for (size_t g = emitted_; g < end; ++g) decode_key(result_.key(g), key_batch);
+    for (size_t k = 0; k < nkeys; ++k) out.columns[k] = std::move(key_batch.columns[k]);
+
+    for (size_t a = 0; a < naggs; ++a) {
+        ColumnVector &col = out.columns[nkeys + a];
+        ColumnType arg = arg_types_[a];
+        for (size_t g = emitted_; g < end; ++g) {
+            const AggState &s = result_.states(g)[a];
+            switch (aggs_[a].func) {
+            case AggFunc::COUNT: col.i64.push_back(s.count); break;
+            case AggFunc::SUM:
+                if (arg == ColumnType::DOUBLE) col.f64.push_back(s.d);
+                else col.i64.push_back(s.i);
+                break;
+            case AggFunc::AVG: {
+                double sum = arg == ColumnType::DOUBLE ? s.d : static_cast<double>(s.i);
+                col.f64.push_back(s.count ? sum / s.count : 0);
+                break;
+            }
+            case AggFunc::MIN:
+            case AggFunc::MAX:
+                switch (arg) {
+                case ColumnType::INT: col.i32.push_back(static_cast<int32_t>(s.i)); break;
+                case ColumnType::BIGINT: col.i64.push_back(s.i); break;
+                case ColumnType::DOUBLE: col.f64.push_back(s.d); break;
+                case ColumnType::TEXT: col.push_text(s.s); break;
+                }
+                break;
+            }
+        }
+    }
+    out.size = end - emitted_;
+    emitted_ = end;
+    return out.size > 0;
+}
+
+//
+// ---------------------------- JOIN -----------------------------
+//
+// Join key bytes: a type tag per value, integers widened to int64 so INT and
+// BIGINT keys compare equal; values of other differing types never match
+static void append_join_key(std::string &key, const ColumnVector &c, size_t r) {
+    switch (c.type) {
+    case ColumnType::INT:
+    case ColumnType::BIGINT: {
+        int64_t v = c.type == ColumnType::INT ? c.i32[r] : c.i64[r];
+        key.push_back('I');
+        key.append(reinterpret_cast<const char *>(&v), sizeof(v));
+        break;
+    }
+    case ColumnType::DOUBLE:
+        key.push_back('D');
+        key.append(reinterpret_cast<const char *>(&c.f64[r]), sizeof(double));
+        break;
+    case ColumnType::TEXT:
+        key.push_back('T');
+        append_key(key, c, r);
+        break;
+    }
+}
+
+// Encoded keys of every row of `in`, concatenated (off: in.size + 1 offsets)
+static void encode_join_keys(const std::vector<sql::ExprPtr> &exprs, const Batch &in, const Params *params,
+                             std::vector<ColumnVector> &cols, std::string &keys, std::vector<size_t> &off) {
+    cols.resize(exprs.size());
+    for (size_t k = 0; k < exprs.size(); ++k) eval_batch(*exprs[k], in, params, cols[k]);
+    keys.clear();
+    off.assign(1, 0);
+    for (size_t r = 0; r < in.size; ++r) {
+        for (const auto &c : cols) append_join_key(keys, c, r);
+        off.push_back(keys.size());
+    }
+}
+
+static void push_default_value(ColumnVector &col) {
+    switch (col.type) {
+    case ColumnType::INT: col.i32.push_back(0); break;
+    case ColumnType::BIGINT: col.i64.push_back(0); break;
+    case ColumnType::DOUBLE: col.f64.push_back(0); break;
+    case ColumnType::TEXT: col.push_text(""); break;
+    }
+}
+
+BloomFilterOp::BloomFilterOp(OperatorPtr child, const std::vector<sql::ExprPtr> &keys,
+                             std::shared_ptr<const BloomFilter> bloom, const Params *params)
+    : child_(std::move(child)), keys_(keys), bloom_(std::move(bloom)), params_(params) {
+    types_ = child_->types();
+}
+
+bool BloomFilterOp::next(Batch &out) {
+    while (child_->next(out)) {
+        if (!bloom_->ready()) return true;
+        key_cols_.resize(keys_.size());
+        for (size_t k = 0; k < keys_.size(); ++k) eval_batch(*keys_[k], out, params_, key_cols_[k]);
+        mask_.assign(out.size, 0);
+        for (size_t r = 0; r < out.size; ++r) {
+            key_.clear();
+            for (const auto &c : key_cols_) append_join_key(key_, c, r);
+            mask_[r] = bloom_->may_contain(AggTable::hash_key(key_));
+        }
+        out.compact(mask_);
+        if (out.size > 0) return true;
+    }
+    return false;
+}
+
+HashJoinOp::HashJoinOp(OperatorPtr build, OperatorPtr probe, const std::vector<sql::ExprPtr> &build_keys,
+                       const std::vector<sql::ExprPtr> &probe_keys, bool build_is_left, bool outer,
+                       const Params *params, std::shared_ptr<BloomFilter> bloom, size_t max_build_rows)
+    : build_(std::move(build)), probe_(std::move(probe)), build_keys_(build_keys), probe_keys_(probe_keys),
+      build_is_left_(build_is_left), outer_(outer), params_(params), bloom_(std::move(bloom)),
+      max_build_rows_(max_build_rows), table_(build_->types()) {
+    const auto &l = build_is_left_ ? build_->types() : probe_->types();
+    const auto &r = build_is_left_ ? probe_->types() : build_->types();
+    types_ = l;
+    types_.insert(types_.end(), r.begin(), r.end());
+}
+
+void HashJoinOp::build() {
+    Batch in;
+    std::vector<ColumnVector> key_cols;
+    std::string keys;
+    std::vector<size_t> off;
+    std::vector<uint64_t> bloom_hashes;
+    while (build_->next(in)) {
+        encode_join_keys(build_keys_, in, params_, key_cols, keys, off);
+        for (size_t r = 0; r < in.size; ++r) {
+            std::string_view key(keys.data() + off[r], off[r + 1] - off[r]);
+            uint64_t hash = AggTable::hash_key(key);
+            if (build_spill_) build_spill_->write(in, r, key, hash);
+            else table_.insert(in, r, key, hash);
+            if (bloom_) bloom_hashes.push_back(hash);
+        }
+        if (!build_spill_ && table_.size() > max_build_rows_) {
+            // out of memory budget: move everything to the partition files
+            build_spill_ = std::make_unique<RowSpill>(build_->types());
+            for (uint32_t r = 0; r < table_.size(); ++r)
+                build_spill_->write(table_.rows(), r, table_.key(r), table_.hash(r));
+            table_.clear();
+        }
+    }
+    build_.reset();
+
+    if (bloom_) {
+        bloom_->init(bloom_hashes.size());
+        for (uint64_t h : bloom_hashes) bloom_->add(h);
+    }
+    if (!build_spill_) {
+        table_.finish();
+        return;
+    }
+
+    // partition the probe side the same way, then join partition by partition
+    probe_spill_ = std::make_unique<RowSpill>(probe_->types());
+    Batch pin;
+    while (probe_->next(pin)) {
+        encode_join_keys(probe_keys_, pin, params_, key_cols, keys, off);
+        for (size_t r = 0; r < pin.size; ++r) {
+            std::string_view key(keys.data() + off[r], off[r + 1] - off[r]);
+            probe_spill_->write(pin, r, key, AggTable::hash_key(key));
+        }
+    }
+    probe_.reset();
+    load_partition();
+}
+
+// Load the build rows of the next partition worth joining into table_
+bool HashJoinOp::load_partition() {
+    Batch rows;
+    std::string keys;
+    std::vector<size_t> off;
+    while (next_partition_ < RowSpill::PARTITIONS) {
+        partition_ = next_partition_++;
+        table_.clear();
+        while (build_spill_->read(partition_, rows, keys, off)) {
+            for (size_t r = 0; r < rows.size; ++r) {
+                std::string_view key(keys.data() + off[r], off[r + 1] - off[r]);
+                table_.insert(rows, r, key, AggTable::hash_key(key));
+            }
+        }
+        table_.finish();
+        if (table_.size() > 0 || outer_) return true;
+    }
+    partition_ = RowSpill::PARTITIONS;
+    return false;
+}
+
+bool HashJoinOp::next_probe_batch() {
+    std::vector<ColumnVector> key_cols;
+    if (!build_spill_) {
+        do {
+            if (!probe_ || !probe_->next(probe_batch_)) {
+                probe_.reset();
+                probe_batch_.size = 0;
+                return false;
+            }
+        } while (probe_batch_.size == 0);
+        encode_join_keys(probe_keys_, probe_batch_, params_, key_cols, probe_keys_buf_, probe_key_off_);
+    } else {
+        for (;;) {
+            if (partition_ == RowSpill::PARTITIONS) return false;
+            if (probe_spill_->read(partition_, probe_batch_, probe_keys_buf_, probe_key_off_)) break;
+            if (!load_partition()) return false;
+        }
+    }
+    probe_hashes_.resize(probe_batch_.size);
+    for (size_t r = 0; r < probe_batch_.size; ++r) {
+        probe_hashes_[r] = AggTable::hash_key(std::string_view(probe_keys_buf_.data() + probe_key_off_[r],
+                                                               probe_key_off_[r + 1] - probe_key_off_[r]));
+    }
+    return true;
+}
+
+// Append one joined row; build_row NONE = no match (defaults)
+void HashJoinOp::emit(Batch &out, size_t probe_row, uint32_t build_row) {
+    size_t nprobe = probe_batch_.columns.size();
+    size_t nbuild = types_.size() - nprobe;
+    size_t probe_at = build_is_left_ ? nbuild : 0;
+    size_t build_at = build_is_left_ ? 0 : nprobe;
+    for (size_t c = 0; c < nprobe; ++c) out.columns[probe_at + c].append_from(probe_batch_.columns[c], probe_row);
+    for (size_t c = 0; c < nbuild; ++c) {
+        if (build_row == JoinTable::NONE) push_default_value(out.columns[build_at + c]);
+        else out.columns[build_at + c].append_from(table_.rows().columns[c], build_row);
+    }
+    out.size++;
+}
+
+bool HashJoinOp::next(Batch &out) {
+    if (!built_) {
+        build();
+        built_ = true;
+    }
+    out.reset(types_);
+    while (out.size < BATCH_SIZE) {
+        if (probe_row_ >= probe_batch_.size) {
+            if (!next_probe_batch()) break;
+            probe_row_ = 0;
+            looked_up_ = false;
+        }
+        std::string_view key(probe_keys_buf_.data() + probe_key_off_[probe_row_],
+                             probe_key_off_[probe_row_ + 1] - probe_key_off_[probe_row_]);
+        uint64_t hash = probe_hashes_[probe_row_];
+        if (!looked_up_) {
+            match_ = table_.first_match(key, hash);
+            looked_up_ = true;
+            matched_ = false;
+        }
+        if (match_ != JoinTable::NONE) {
+            emit(out, probe_row_, match_);
+            matched_ = true;
+            match_ = table_.next_match(match_, key, hash);
+            continue;
+        }
+        if (outer_ && !matched_) emit(out, probe_row_, JoinTable::NONE);
+        probe_row_++;
+        looked_up_ = false;
+    }
+    return out.size > 0;
+}
+
+//
+// ---------------------------- SORT -----------------------------
+//
+SortOp::SortOp(OperatorPtr child, const std::vector<SortKey> &keys, const Params *params,
+               SegmentManager &segments, int64_t limit, size_t max_bytes)
+    : child_(std::move(child)), keys_(keys), params_(params), segments_(segments), limit_(limit),
+      max_bytes_(max_bytes) {
+    types_ = child_->types();
+    top_n_ = limit_ >= 0 && limit_ <= SORT_TOP_N_MAX;
+}
+
+SortOp::~SortOp() {
+    readers_.clear();
+    for (const SortRun &r : runs_) segments_.drop_segment(r.segment);
+}
+
+static size_t batch_bytes(const Batch &b) {
+    size_t n = 0;
+    for (const auto &c : b.columns) {
+        n += c.i32.size() * sizeof(int32_t) + c.i64.size() * sizeof(int64_t) + c.f64.size() * sizeof(double) +
+             c.offsets.size() * sizeof(uint32_t) + c.chars.size();
+    }
+    return n;
+}
+
+// Append one entry per row of `in` (about to become rows_.back()) with its normalized key
+void SortOp::encode_keys(const Batch &in) {
+    key_cols_.resize(keys_.size());
+    for (size_t k = 0; k < keys_.size(); ++k) eval_batch(*keys_[k].expr, in, params_, key_cols_[k]);
+    uint32_t b = static_cast<uint32_t>(rows_.size());
+    for (size_t r = 0; r < in.size; ++r) {
+        size_t off = key_arena_.size();
+        for (size_t k = 0; k < keys_.size(); ++k) append_sort_key(key_arena_, key_cols_[k], r, keys_[k].desc);
+        size_t len = key_arena_.size() - off;
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < 8; ++i)
+            prefix = prefix << 8 | (i < len ? static_cast<uint8_t>(key_arena_[off + i]) : 0);
+        entries_.push_back(Entry{prefix, static_cast<uint32_t>(off), static_cast<uint32_t>(len), b,
+                                 static_cast<uint32_t>(r)});
+    }
+}
+
+void SortOp::sort_entries() {
+    // (key, input position) is a total order, so the unstable sort is stable
+    std::sort(entries_.begin(), entries_.end(), [&](const Entry &x, const Entry &y) {
+        if (x.prefix != y.prefix) return x.prefix < y.prefix;
+        int c = std::string_view(key_arena_.data() + x.key_off, x.key_len)
+                    .compare(std::string_view(key_arena_.data() + y.key_off, y.key_len));
+        if (c != 0) return c < 0;
+        return x.batch != y.batch ? x.batch < y.batch : x.row < y.row;
+    });
+}
+
+// Sort the buffered rows and move them to a new run
+void SortOp::write_run() {
+    sort_entries();
+    SortRunWriter writer(segments_);
+    std::string row;
+    for (const Entry &e : entries_) {
+        row.clear();
+        append_row_bytes(row, rows_[e.batch], e.row);
+        writer.add(std::string_view(key_arena_.data() + e.key_off, e.key_len), row);
+    }
+    runs_.push_back(writer.finish());
+    rows_.clear();
+    key_arena_.clear();
+    entries_.clear();
+    buffered_bytes_ = 0;
+}
+
+// Keep the best `limit_` rows in a max-heap whose root is the worst kept row
+void SortOp::consume_top_n() {
+    auto before = [](const TopRow &a, const TopRow &b) {
+        int c = a.key.compare(b.key);
+        return c != 0 ? c < 0 : a.seq < b.seq;
+    };
+    size_t n = static_cast<size_t>(limit_);
+    if (n == 0) return;
+    uint64_t seq = 0;
+    Batch in;
+    while (child_->next(in)) {
+        key_cols_.resize(keys_.size());
+        for (size_t k = 0; k < keys_.size(); ++k) eval_batch(*keys_[k].expr, in, params_, key_cols_[k]);
+        for (size_t r = 0; r < in.size; ++r, ++seq) {
+            key_.clear();
+            for (size_t k = 0; k < keys_.size(); ++k) append_sort_key(key_, key_cols_[k], r, keys_[k].desc);
+            if (top_.size() == n) {
+                // ties lose against rows seen earlier
+                if (key_.compare(top_.front().key) >= 0) continue;
+                std::pop_heap(top_.begin(), top_.end(), before);
+                top_.pop_back();
+            }
+            TopRow t{key_, std::string(), seq};
+            append_row_bytes(t.row, in, r);
+            top_.push_back(std::move(t));
+            std::push_heap(top_.begin(), top_.end(), before);
+        }
+    }
+    std::sort_heap(top_.begin(), top_.end(), before);
+}
+
+void SortOp::consume() {
+    if (top_n_) {
+        consume_top_n();
+        return;
+    }
+    Batch in;
+    while (child_->next(in)) {
+        if (in.size == 0) continue;
+        size_t keys_before = key_arena_.size();
+        encode_keys(in);
+        buffered_bytes_ += batch_bytes(in) + (key_arena_.size() - keys_before) + in.size * sizeof(Entry);
+        rows_.push_back(std::move(in));
+        in = Batch();
+        if (buffered_bytes_ > max_bytes_) write_run();
+    }
+    if (runs_.empty()) {
+        sort_entries();
+        return;
+    }
+
+    // external sort: the rest becomes the last run, then merge all runs
+    if (!entries_.empty()) write_run();
+    for (const SortRun &r : runs_) {
+        readers_.push_back(std::make_unique<SortRunReader>(segments_, r));
+        if (readers_.back()->next()) heap_.push_back(readers_.size() - 1);
+    }
+    std::make_heap(heap_.begin(), heap_.end(), [&](size_t a, size_t b) { return merge_after(a, b); });
+}
+
+// Merge-heap order: smallest key on top, earlier run first on ties
+bool SortOp::merge_after(size_t a, size_t b) const {
+    int c = readers_[a]->key().compare(readers_[b]->key());
+    return c != 0 ? c > 0 : a > b;
+}
+
+bool SortOp::next(Batch &out) {
+    if (!consumed_) {
+        consume();
+        consumed_ = true;
+    }
+    out.reset(types_);
+    size_t want = BATCH_SIZE;
+    if (limit_ >= 0) want = std::min(want, static_cast<size_t>(limit_) - std::min<size_t>(limit_, emitted_));
+
+    if (top_n_) {
+        for (size_t i = emitted_; i < top_.size() && out.size < want; ++i) read_row_bytes(top_[i].row, out);
+    } else if (!runs_.empty()) {
+        auto after = [&](size_t a, size_t b) { return merge_after(a, b); };
+        while (out.size < want && !heap_.empty()) {
+            std::pop_heap(heap_.begin(), heap_.end(), after);
+            size_t i = heap_.back();
+            read_row_bytes(readers_[i]->row(), out);
+            if (readers_[i]->next()) std::push_heap(heap_.begin(), heap_.end(), after);
+            else heap_.pop_back();
+        }
+    } else {
+        for (size_t i = emitted_; i < entries_.size() && out.size < want; ++i)
+            out.append_row(rows_[entries_[i].batch], entries_[i].row);
+    }
+    emitted_ += out.size;
+    return out.size > 0;
+}
+
+//
+// ---------------------------- LIMIT ----------------------------
+//
+LimitOp::LimitOp(OperatorPtr child, int64_t limit, int64_t offset)
+    : child_(std::move(child)), limit_(limit), offset_(offset) {
+    types_ = child_->types();
+}
+
+bool LimitOp::next(Batch &out) {
+    while (limit_ < 0 || produced_ < limit_) {
+        if (!child_->next(out)) return false;
+        size_t n = out.size;
+        size_t start = 0;
+        if (skipped_ < offset_) {
+            start = static_cast<size_t>(std::min<int64_t>(n, offset_ - skipped_));
+            skipped_ += start;
+        }
+        size_t take = n - start;
+        if (limit_ >= 0) take = static_cast<size_t>(std::min<int64_t>(take, limit_ - produced_));
+        if (take == 0) continue;
+        if (take < n) {
+            mask_.assign(n, 0);
+            std::fill(mask_.begin() + start, mask_.begin() + start + take, 1);
+            out.compact(mask_);
+        }
+        produced_ += take;
+        return true;
+    }
+    return false;
+}
+
+//
+// --------------------------- EXPLAIN ---------------------------
+//
+thread_local PlanNode *ExplainOp::running_ = nullptr;
+
+ExplainOp::ExplainOp(OperatorPtr op, std::string label, std::vector<std::shared_ptr<const PlanNode>> inputs,
+                     bool analyze)
+    : op_(std::move(op)), node_(std::make_shared<PlanNode>()), analyze_(analyze) {
+    types_ = op_->types();
+    node_->label = std::move(label);
+    node_->inputs = std::move(inputs);
+}
+
+bool ExplainOp::next(Batch &out) {
+    if (!analyze_) return op_->next(out);
+
+    // the node this call runs under on this thread gets back what this one does
+    struct Running {
+        PlanNode *outer;
+        explicit Running(PlanNode *self) : outer(running_) { running_ = self; }
+        ~Running() { running_ = outer; }
+    } running(node_.get());
+    IoCounters io_before = thread_io();
+    auto start = std::chrono::steady_clock::now();
+
+    bool more = op_->next(out);
+
+    node_->nanos += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    IoCounters io = thread_io() - io_before;
+    node_->io += io;
+    if (running.outer) running.outer->inputs_io += io;
+    if (more) node_->rows += out.size;
+    return more;
+}
+
+IoCounters PlanNode::total_io() const {
+    IoCounters total = io - inputs_io;
+    for (const auto &in : inputs) total += in->total_io();
+    return total;
+}
+
+void PlanNode::render(std::vector<std::string> &lines, bool analyzed, int depth) const {
+    std::string line = depth == 0 ? label : std::string(static_cast<size_t>(depth - 1) * 4 + 2, ' ') + "-> " + label;
+    if (analyzed) {
+        char time[32];
+        std::snprintf(time, sizeof(time), "%.3f", static_cast<double>(nanos) / 1e6);
+        line += "  (rows";
+        if (!inputs.empty()) {
+            uint64_t in = 0;
+            for (const auto &i : inputs) in += i->rows;
+            line += " in=" + std::to_string(in) + " out";
+        }
+        IoCounters total = total_io();
+        line += "=" + std::to_string(rows) + ", time=" + time + " ms, hits=" + std::to_string(total.hits) +
+                " misses=" + std::to_string(total.misses) + " read=" + std::to_string(total.reads) +
+                " written=" + std::to_string(total.writes) + ")";
+    }
+    lines.push_back(std::move(line));
+    for (const auto &in : inputs) in->render(lines, analyzed, depth + 1);
+}
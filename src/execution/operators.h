@@ -0,0 +1,357 @@
+#pragma once
+
+#include "src/execution/agg_table.h"
+#include "src/execution/batch.h"
+#include "src/execution/expression.h"
+#include "src/execution/external_sort.h"
+#include "src/execution/join_table.h"
+#include "src/sql/ast.h"
+#include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/table/table_heap.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Pull-based vectorized operators. Every call to next() fills `out` with up to
+// BATCH_SIZE rows and returns false once the operator is exhausted.
+
+class Operator {
+public:
+    virtual ~Operator() = default;
+    virtual bool next(Batch &out) = 0;
+    const std::vector<ColumnType> &types() const { return types_; }
+
+protected:
+    std::vector<ColumnType> types_;
+};
+
+using OperatorPtr = std::unique_ptr<Operator>;
+
+// Decode heap pages straight into column vectors. Only the table columns in
+// `columns` (ascending) are decoded; the bytes of the others are skipped.
+// Pages rejected by `keep_page` (zone-map pruning) are never fetched.
+// Dead records and forwards are skipped; moved rows are read where they live.
+// With a transaction, each row is read as its snapshot sees it.
+class SeqScanOp : public Operator {
+public:
+    SeqScanOp(storage::BufferPool &bp, uint32_t segment_id, const storage::Txn *txn, std::vector<int> columns,
+              std::vector<ColumnType> types, std::function<bool(uint32_t)> keep_page = nullptr);
+    bool next(Batch &out) override;
+
+    // scan only pages [first, end) of the segment
+    void restrict_pages(uint32_t first, uint32_t end);
+
+    // LIMIT/OFFSET pushdown: pass over the first `skip` rows without decoding
+    // them, then stop (no further page fetches) after `limit` rows
+    void set_limit(uint64_t limit, uint64_t skip);
+    // Return at most `rows` rows in the first batch, doubling per batch up to
+    // BATCH_SIZE, so a LIMIT above a filter stops the scan close to its last match
+    void set_first_batch(size_t rows);
+
+private:
+    storage::BufferPool &bp_;
+    uint32_t segment_id_;
+    const storage::Txn *txn_;
+    storage::TableHeap heap_;
+    std::vector<int> columns_;
+    std::function<bool(uint32_t)> keep_page_;
+    std::vector<char> copy_;   // older row version being decoded
+    std::vector<std::pair<storage::RecordId, storage::RecordId>> forwarded_;   // of the page: home, moved tuple
+    uint32_t pages_;
+    uint32_t page_no_ = 0;
+    uint32_t offset_ = 0;   // 0 = start of page
+    uint64_t limit_ = UINT64_MAX;
+    uint64_t skip_ = 0;
+    uint64_t produced_ = 0;
+    size_t batch_rows_ = BATCH_SIZE;
+};
+
+// Rows fetched by record id (hash index probes). An index may list a row
+// under several keys of its versions: each id is fetched once.
+class IndexScanOp : public Operator {
+public:
+    IndexScanOp(storage::BufferPool &bp, uint32_t segment_id, const storage::Txn *txn, std::vector<int> columns,
+                std::vector<ColumnType> types, std::vector<storage::RecordId> rids);
+    bool next(Batch &out) override;
+
+private:
+    storage::BufferPool &bp_;
+    storage::TableHeap heap_;
+    std::vector<int> columns_;
+    std::vector<storage::RecordId> rids_;
+    size_t pos_ = 0;
+};
+
+class FilterOp : public Operator {
+public:
+    FilterOp(OperatorPtr child, const sql::Expr &pred, const Params *params);
+    bool next(Batch &out) override;
+
+private:
+    OperatorPtr child_;
+    const sql::Expr &pred_;
+    const Params *params_;
+    std::vector<uint8_t> mask_;
+};
+
+class ProjectOp : public Operator {
+public:
+    ProjectOp(OperatorPtr child, const std::vector<sql::ExprPtr> &exprs, const Params *params);
+    bool next(Batch &out) override;
+
+private:
+    OperatorPtr child_;
+    const std::vector<sql::ExprPtr> &exprs_;
+    const Params *params_;
+    Batch in_;
+};
+
+enum class AggFunc : uint8_t { COUNT, SUM, MIN, MAX, AVG };
+
+struct AggSpec {
+    AggFunc func;
+    sql::ExprPtr arg;   // null for COUNT(*)
+};
+
+bool agg_func_from_name(const std::string &name, AggFunc &out);
+
+// Groups held in memory by one aggregation thread before it spills
+constexpr size_t AGG_MAX_GROUPS = size_t(1) << 20;
+
+// Hash aggregation. Output columns: group keys, then one column per aggregate.
+// COUNT/SUM produce BIGINT (SUM of DOUBLE stays DOUBLE), AVG produces DOUBLE,
+// MIN/MAX keep the argument type.
+//
+// Each input (e.g. a scan over one slice of the table) is aggregated by its
+// own thread into a private AggTable; the partial tables are merged at the
+// end. A thread whose table exceeds `max_groups` spills it to hash-partitioned
+// temporary files, and the result is then produced one partition at a time.
+class AggregateOp : public Operator {
+public:
+    AggregateOp(std::vector<OperatorPtr> inputs, const std::vector<sql::ExprPtr> &keys,
+                const std::vector<AggSpec> &aggs, const Params *params, size_t max_groups = AGG_MAX_GROUPS);
+    bool next(Batch &out) override;
+
+private:
+    struct Partial {
+        Partial(size_t naggs) : table(naggs), spill(naggs) {}
+        AggTable table;
+        AggSpill spill;
+    };
+
+    void consume();
+    void aggregate_input(Operator &input, Partial &part);
+    void merge_into(AggTable &dst, std::string_view key, uint64_t hash, const AggState *src);
+    bool load_partition();
+
+    std::vector<OperatorPtr> inputs_;
+    const std::vector<sql::ExprPtr> &keys_;
+    const std::vector<AggSpec> &aggs_;
+    const Params *params_;
+    size_t max_groups_;
+    std::vector<ColumnType> key_types_;
+    std::vector<ColumnType> arg_types_;
+
+    std::vector<std::unique_ptr<Partial>> partials_;
+    AggTable result_;                   // groups being emitted
+    bool spilled_ = false;
+    size_t next_partition_ = 0;
+    bool consumed_ = false;
+    size_t emitted_ = 0;
+};
+
+// Build-side rows a hash join keeps in memory before it partitions to disk
+constexpr size_t JOIN_MAX_BUILD_ROWS = size_t(1) << 20;
+
+// Drops rows whose join key is certainly absent from `bloom` (filled by the
+// HashJoinOp that consumes this operator, before it first pulls from it)
+class BloomFilterOp : public Operator {
+public:
+    BloomFilterOp(OperatorPtr child, const std::vector<sql::ExprPtr> &keys,
+                  std::shared_ptr<const BloomFilter> bloom, const Params *params);
+    bool next(Batch &out) override;
+
+private:
+    OperatorPtr child_;
+    const std::vector<sql::ExprPtr> &keys_;
+    std::shared_ptr<const BloomFilter> bloom_;
+    const Params *params_;
+    std::vector<ColumnVector> key_cols_;
+    std::string key_;
+    std::vector<uint8_t> mask_;
+};
+
+// Equi-join by hashing. Output columns: the left input's, then the right's.
+// The `build` input is read into a JoinTable, then `probe` is streamed
+// against it. With `outer` (LEFT JOIN, probe = left) a probe row without a
+// match is emitted once with 0 / '' in the build columns (there is no NULL).
+//
+// When the build side exceeds `max_build_rows` both inputs are partitioned
+// to temporary files by key hash and joined one partition at a time (grace
+// hash join). If `bloom` is given it is filled with the build keys before
+// the probe input is first pulled, for a BloomFilterOp below the probe.
+class HashJoinOp : public Operator {
+public:
+    HashJoinOp(OperatorPtr build, OperatorPtr probe, const std::vector<sql::ExprPtr> &build_keys,
+               const std::vector<sql::ExprPtr> &probe_keys, bool build_is_left, bool outer, const Params *params,
+               std::shared_ptr<BloomFilter> bloom = nullptr, size_t max_build_rows = JOIN_MAX_BUILD_ROWS);
+    bool next(Batch &out) override;
+
+private:
+    void build();
+    bool load_partition();
+    bool next_probe_batch();
+    void emit(Batch &out, size_t probe_row, uint32_t build_row);
+
+    OperatorPtr build_;
+    OperatorPtr probe_;
+    const std::vector<sql::ExprPtr> &build_keys_;
+    const std::vector<sql::ExprPtr> &probe_keys_;
+    bool build_is_left_;
+    bool outer_;
+    const Params *params_;
+    std::shared_ptr<BloomFilter> bloom_;
+    size_t max_build_rows_;
+
+    JoinTable table_;
+    std::unique_ptr<RowSpill> build_spill_;   // set once the build side spilled
+    std::unique_ptr<RowSpill> probe_spill_;
+    size_t next_partition_ = 0;
+    size_t partition_ = RowSpill::PARTITIONS; // partition being joined
+    bool built_ = false;
+
+    // current probe batch and the position within it
+    Batch probe_batch_;
+    std::string probe_keys_buf_;
+    std::vector<size_t> probe_key_off_;
+    std::vector<uint64_t> probe_hashes_;
+    size_t probe_row_ = 0;
+    uint32_t match_ = JoinTable::NONE;
+    bool looked_up_ = false;
+    bool matched_ = false;
+};
+
+struct SortKey {
+    sql::ExprPtr expr;
+    bool desc = false;
+};
+
+// Input bytes a sort buffers in memory before it writes a sorted run
+constexpr size_t SORT_MEMORY_BYTES = size_t(64) << 20;
+// Largest LIMIT (plus OFFSET) served by a bounded heap instead of a full sort
+constexpr int64_t SORT_TOP_N_MAX = 65536;
+
+// Emits its input ordered by the keys; ties keep input order. Rows are sorted
+// on normalized (memcmp-ordered) keys. Input beyond `max_bytes` is written
+// as sorted runs to temporary segments and the runs are k-way merged.
+// With `limit` >= 0 at most that many rows are produced, and a small limit
+// keeps only the best `limit` rows in a bounded heap.
+class SortOp : public Operator {
+public:
+    SortOp(OperatorPtr child, const std::vector<SortKey> &keys, const Params *params,
+           storage::SegmentManager &segments, int64_t limit = -1, size_t max_bytes = SORT_MEMORY_BYTES);
+    ~SortOp() override;
+    bool next(Batch &out) override;
+
+private:
+    struct Entry {
+        uint64_t prefix;    // first 8 key bytes, big-endian
+        uint32_t key_off;
+        uint32_t key_len;
+        uint32_t batch;
+        uint32_t row;
+    };
+    struct TopRow {
+        std::string key;
+        std::string row;
+        uint64_t seq;       // input position, breaks ties
+    };
+
+    void consume();
+    void encode_keys(const Batch &in);
+    void sort_entries();
+    void write_run();
+    void consume_top_n();
+    bool merge_after(size_t a, size_t b) const;
+
+    OperatorPtr child_;
+    const std::vector<SortKey> &keys_;
+    const Params *params_;
+    storage::SegmentManager &segments_;
+    int64_t limit_;
+    size_t max_bytes_;
+    bool top_n_;
+
+    std::vector<Batch> rows_;          // buffered input batches
+    std::string key_arena_;
+    std::vector<Entry> entries_;
+    size_t buffered_bytes_ = 0;
+    std::vector<ColumnVector> key_cols_;
+    std::string key_;
+
+    std::vector<SortRun> runs_;
+    std::vector<std::unique_ptr<SortRunReader>> readers_;
+    std::vector<size_t> heap_;         // merge heap of reader indexes
+    std::vector<TopRow> top_;          // top-N result, in order
+
+    bool consumed_ = false;
+    size_t emitted_ = 0;
+};
+
+// Skips `offset` rows, then passes at most `limit` (-1 = all); stops pulling
+// from the child once the limit is reached.
+class LimitOp : public Operator {
+public:
+    LimitOp(OperatorPtr child, int64_t limit, int64_t offset);
+    bool next(Batch &out) override;
+
+private:
+    OperatorPtr child_;
+    int64_t limit_;
+    int64_t offset_;
+    int64_t skipped_ = 0;
+    int64_t produced_ = 0;
+    std::vector<uint8_t> mask_;
+};
+
+// How a query is explained: not at all, its plan, or its plan as it ran
+enum class ExplainMode : uint8_t { NONE, PLAN, ANALYZE };
+
+// What EXPLAIN shows of one operator. Shared with the nodes above it: an
+// operator may free its inputs as soon as it has drained them.
+struct PlanNode {
+    std::string label;
+    std::vector<std::shared_ptr<const PlanNode>> inputs;
+
+    uint64_t rows = 0;
+    uint64_t nanos = 0;
+    storage::IoCounters io;          // during this node's calls, on their thread
+    storage::IoCounters inputs_io;   // the part of io inputs on the same thread did
+
+    // this node and the ones under it, one line each, indented by depth
+    void render(std::vector<std::string> &lines, bool analyzed, int depth = 0) const;
+    storage::IoCounters total_io() const;
+};
+
+// An operator as a node of an EXPLAIN plan. Passes the batches of the
+// operator it wraps through; with `analyze` it also counts its rows, wall
+// time (including its inputs) and page I/O (storage::thread_io). I/O is
+// charged to the innermost node running on the thread, so a node's total is
+// its own plus its inputs', even for inputs run by other threads.
+class ExplainOp : public Operator {
+public:
+    ExplainOp(OperatorPtr op, std::string label, std::vector<std::shared_ptr<const PlanNode>> inputs, bool analyze);
+    bool next(Batch &out) override;
+
+    const std::shared_ptr<PlanNode> &node() const { return node_; }
+
+private:
+    OperatorPtr op_;
+    std::shared_ptr<PlanNode> node_;
+    bool analyze_;
+
+    static thread_local PlanNode *running_;
+};
@@ -0,0 +1,68 @@
+#include "src/execution/plan_cache.h"
+#include "src/sql/lexer.h"
+
+#include <cctype>
+
+std::shared_ptr<const Plan> PlanCache::get(const std::string &key, uint64_t catalog_version) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+        misses_++;
+        return nullptr;
+    }
+    if (it->second->second->catalog_version != catalog_version) {
+        // schema changed since the plan was bound
+        lru_.erase(it->second);
+        map_.erase(it);
+        misses_++;
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    hits_++;
+    return it->second->second;
+}
+
+void PlanCache::put(const std::string &key, std::shared_ptr<const Plan> plan) {
+    if (key.empty() || capacity_ == 0) return;
+    std::lock_guard<std::mutex> lg(mu_);
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+        it->second->second = std::move(plan);
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(key, std::move(plan));
+    map_[key] = lru_.begin();
+    if (map_.size() > capacity_) {
+        map_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+void PlanCache::clear() {
+    std::lock_guard<std::mutex> lg(mu_);
+    lru_.clear();
+    map_.clear();
+}
+
+std::string PlanCache::normalize(std::string_view sql) {
+    sql::Lexer lex(sql);
+    std::string out;
+    out.reserve(sql.size());
+    while (true) {
+        sql::Token t = lex.next();
+        if (t.type == sql::TokenType::END) break;
+        if (t.type == sql::TokenType::ERROR) return "";
+        if (t.type == sql::TokenType::SEMICOLON) continue;
+        if (!out.empty()) out.push_back(' ');
+        if (t.type == sql::TokenType::KEYWORD) {
+            for (char c : t.text) out.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+        } else if (t.type == sql::TokenType::STRING_LIT) {
+            // keep the original quotes so 'a' and "a" stay distinct spellings
+            out.append(t.text.data() - 1, t.text.size() + 2);
+        } else {
+            out.append(t.text);
+        }
+    }
+    return out;
+}
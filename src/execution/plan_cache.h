@@ -0,0 +1,84 @@
+#pragma once
+
+#include "src/catalog/catalog.h"
+#include "src/execution/operators.h"
+#include "src/sql/ast.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Inputs of a two-table hash join. Each side scans only its `*_columns`
+// (table positions, ascending); its keys and filter are bound to that scan row.
+struct JoinPlan {
+    catalog::Table right;                 // schema of the joined table
+    bool left_outer = false;              // LEFT JOIN
+    std::vector<int> left_columns;
+    std::vector<int> right_columns;
+    std::vector<sql::ExprPtr> left_keys;  // ON a.x = b.y: left_keys[i] = right_keys[i]
+    std::vector<sql::ExprPtr> right_keys;
+    sql::ExprPtr left_filter;             // WHERE terms over one side only, applied
+    sql::ExprPtr right_filter;            // before the join (right: inner joins only)
+};
+
+// Operator inputs for a SELECT. The scan produces only `scan_columns` (table
+// positions, ascending); `filter`, `group_keys` and aggregate arguments are
+// bound to that scan row. Without aggregation `outputs` and `sort` are too;
+// with it they are bound to the aggregate output (group keys, then aggs).
+// With a join the "scan row" is the join output: the left scan columns, then
+// the right ones, and `scan_columns` index the combined row (right table
+// positions shifted by the left table's column count).
+struct SelectPlan {
+    std::vector<int> scan_columns;
+    sql::ExprPtr filter;              // WHERE over the scan row
+    bool aggregate = false;
+    std::vector<sql::ExprPtr> group_keys;
+    std::vector<AggSpec> aggs;
+    std::vector<sql::ExprPtr> outputs;
+    std::vector<std::string> names;   // output column labels
+    std::vector<SortKey> sort;
+    std::unique_ptr<JoinPlan> join;   // null for single-table queries
+};
+
+// A parsed statement bound against a snapshot of its table's schema.
+// Plans are immutable once built and shared between executions.
+struct Plan {
+    sql::Statement stmt;
+    catalog::Table table;             // schema the statement was bound against
+    uint64_t catalog_version = 0;     // catalog version at bind time
+    std::vector<int> insert_targets;  // INSERT: VALUES position -> column position
+    SelectPlan select;                // SELECT
+};
+
+// LRU cache of plans keyed by normalized SQL text. An entry built against an
+// older catalog version is treated as a miss and dropped.
+class PlanCache {
+public:
+    explicit PlanCache(size_t capacity) : capacity_(capacity) {}
+
+    std::shared_ptr<const Plan> get(const std::string &key, uint64_t catalog_version);
+    void put(const std::string &key, std::shared_ptr<const Plan> plan);
+    void clear();
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+    // Token-wise normalization: single spaces, upper-case keywords, no trailing ';'.
+    // Returns "" for text the lexer rejects (such statements are never cached).
+    static std::string normalize(std::string_view sql);
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const Plan>>;
+
+    size_t capacity_;
+    std::list<Entry> lru_;   // front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> map_;
+    std::mutex mu_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
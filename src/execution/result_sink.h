@@ -0,0 +1,29 @@
+#pragma once
+
+#include "src/execution/batch.h"
+
+#include <string>
+#include <vector>
+
+// Consumer of statement results, fed incrementally by the executor.
+//
+// A query calls columns() once, then batch() for each batch of rows as the
+// operator pipeline produces it. A consumer that falls behind says so through
+// ready(); the executor then waits in wait() before producing more, so a slow
+// consumer throttles execution instead of rows piling up in memory.
+// Any other outcome (DDL/DML status, errors, including an error after some
+// rows were delivered) arrives as a single status() line "OK: ..." / "ERR: ...".
+class ResultSink {
+public:
+    virtual ~ResultSink() = default;
+
+    virtual void columns(const std::vector<std::string> &names, const std::vector<ColumnType> &types) = 0;
+    // return false to stop the query early
+    virtual bool batch(const Batch &rows) = 0;
+    virtual void status(const std::string &msg) = 0;
+
+    // false while the consumer is behind
+    virtual bool ready() { return true; }
+    // block until it caught up; false to stop the query
+    virtual bool wait() { return true; }
+};
@@ -0,0 +1,120 @@
+#include "src/execution/statistics.h"
+#include "src/execution/expression.h"
+#include "src/storage/index/hash_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// The index hash of a value, finalized again: HyperLogLog reads the top bits
+// and the leading zeros, which FNV-1a (TEXT) leaves poorly mixed
+static uint64_t value_hash(const storage::Value &v) {
+    uint64_t x = storage::HashIndex::HashValue(v);
+    x = (x ^ (x >> 33)) * 0xFF51AFD7ED558CCDull;
+    x = (x ^ (x >> 33)) * 0xC4CEB9FE1A85EC53ull;
+    return x ^ (x >> 33);
+}
+
+void HyperLogLog::add(uint64_t hash) {
+    uint32_t slot = static_cast<uint32_t>(hash >> (64 - P));
+    uint64_t rest = hash << P;
+    uint8_t rank = rest == 0 ? static_cast<uint8_t>(64 - P + 1) : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    if (rank > registers_[slot]) registers_[slot] = rank;
+}
+
+uint64_t HyperLogLog::estimate() const {
+    const double m = static_cast<double>(registers_.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers_) {
+        sum += std::ldexp(1.0, -static_cast<int>(r));
+        if (r == 0) zeros++;
+    }
+    double e = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    // few values: count the empty registers instead (linear counting)
+    if (e <= 2.5 * m && zeros > 0) e = m * std::log(m / static_cast<double>(zeros));
+    return static_cast<uint64_t>(e + 0.5);
+}
+
+StatsCollector::StatsCollector(size_t columns) : distinct_(columns), rng_(0x5EED) {}
+
+void StatsCollector::add(const std::vector<storage::Value> &row) {
+    rows_++;
+    for (size_t c = 0; c < distinct_.size() && c < row.size(); ++c) distinct_[c].add(value_hash(row[c]));
+    if (sample_.size() < SAMPLE_ROWS) {
+        sample_.push_back(row);
+    } else {
+        uint64_t at = rng_() % rows_;
+        if (at < SAMPLE_ROWS) sample_[at] = row;
+    }
+}
+
+catalog::TableStats StatsCollector::finish(uint32_t pages) {
+    catalog::TableStats st;
+    st.rows = rows_;
+    st.pages = pages;
+    st.columns.resize(distinct_.size());
+    for (size_t c = 0; c < distinct_.size(); ++c) {
+        std::vector<storage::Value> vals;
+        vals.reserve(sample_.size());
+        for (const auto &row : sample_)
+            if (c < row.size()) vals.push_back(row[c]);
+        std::sort(vals.begin(), vals.end(),
+                  [](const storage::Value &a, const storage::Value &b) { return compare_values(a, b) < 0; });
+
+        catalog::ColumnStats &cs = st.columns[c];
+        if (sample_.size() == rows_) {
+            // every row is in the sample: count exactly
+            for (size_t i = 0; i < vals.size(); ++i)
+                if (i == 0 || compare_values(vals[i - 1], vals[i]) != 0) cs.distinct++;
+        } else {
+            cs.distinct = std::min<uint64_t>(distinct_[c].estimate(), rows_);
+        }
+        if (vals.empty()) continue;
+        size_t buckets = std::min(HISTOGRAM_BUCKETS, vals.size() - 1);
+        if (buckets == 0) {
+            cs.bounds.push_back(vals[0]);
+            continue;
+        }
+        for (size_t b = 0; b <= buckets; ++b) cs.bounds.push_back(vals[b * (vals.size() - 1) / buckets]);
+    }
+    return st;
+}
+
+double cost::table_rows(const catalog::Table &table, uint32_t pages) {
+    if (table.stats && table.stats->pages > 0)
+        return static_cast<double>(table.stats->rows) * pages / table.stats->pages;
+    if (table.stats && pages == 0) return 0;
+    return pages * DEFAULT_ROWS_PER_PAGE;
+}
+
+double cost::eq_selectivity(const catalog::Table &table, int col, const storage::Value &v) {
+    if (!table.stats || col < 0 || static_cast<size_t>(col) >= table.stats->columns.size()) return 0;
+    const catalog::ColumnStats &cs = table.stats->columns[col];
+    double distinct = std::max<double>(1, static_cast<double>(cs.distinct));
+    if (cs.bounds.size() < 2) return 1 / distinct;
+    if (compare_values(v, cs.bounds.front()) < 0 || compare_values(v, cs.bounds.back()) > 0) return 0;
+    // a value that fills buckets of its own is as frequent as they are large
+    size_t equal = 0;
+    for (const storage::Value &b : cs.bounds)
+        if (compare_values(v, b) == 0) equal++;
+    double buckets = static_cast<double>(cs.bounds.size() - 1);
+    if (equal >= 2) return (equal - 1) / buckets;
+    return 1 / distinct;
+}
+
+double cost::seq_scan(uint32_t pages, double rows) {
+    return pages * SEQ_PAGE + rows * CPU_ROW;
+}
+
+double cost::index_scan(double matches, uint32_t pages) {
+    // the bucket page, then one page per match (at most every page once)
+    return RANDOM_PAGE + std::min(matches, static_cast<double>(pages)) * RANDOM_PAGE + matches * CPU_ROW;
+}
+
+uint32_t cost::parallel_workers(double scan_cost) {
+    uint32_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    double useful = std::floor(scan_cost / WORK_PER_WORKER);
+    return static_cast<uint32_t>(std::max(1.0, std::min({useful, static_cast<double>(cpus),
+                                                         static_cast<double>(MAX_WORKERS)})));
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "src/catalog/catalog.h"
+#include "src/storage/table/tuple.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// HyperLogLog distinct-value sketch: 2^P one-byte registers, about 1.6%
+// standard error at P = 12. Fed 64-bit hashes of the values.
+class HyperLogLog {
+public:
+    static constexpr uint32_t P = 12;
+
+    HyperLogLog() : registers_(1u << P, 0) {}
+    void add(uint64_t hash);
+    uint64_t estimate() const;
+
+private:
+    std::vector<uint8_t> registers_;
+};
+
+// Statistics of one table, built from a single pass over its rows: the exact
+// row count, a HyperLogLog per column, and a uniform sample of the rows
+// (reservoir) that each column's equi-depth histogram is cut from
+class StatsCollector {
+public:
+    static constexpr size_t SAMPLE_ROWS = 30000;
+    static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+    explicit StatsCollector(size_t columns);
+    void add(const std::vector<storage::Value> &row);
+    catalog::TableStats finish(uint32_t pages);
+
+private:
+    uint64_t rows_ = 0;
+    std::vector<HyperLogLog> distinct_;
+    std::vector<std::vector<storage::Value>> sample_;
+    std::mt19937_64 rng_;
+};
+
+//
+// ------------------------- COST MODEL --------------------------
+//
+// Costs are in units of one sequential page read. A table that was never
+// analyzed is assumed to hold DEFAULT_ROWS_PER_PAGE rows per page, and an
+// equality on an indexed column to match a single row; access_path() also
+// takes an index for it whatever the costs, as before statistics existed.
+namespace cost {
+
+constexpr double SEQ_PAGE = 1.0;
+constexpr double RANDOM_PAGE = 4.0;
+constexpr double CPU_ROW = 0.01;
+constexpr double DEFAULT_ROWS_PER_PAGE = 50;
+// work below which another scan thread costs more than it saves
+constexpr double WORK_PER_WORKER = 150;
+constexpr uint32_t MAX_WORKERS = 8;
+
+// rows in `table` now that it has `pages` pages (analyzed counts scaled to the current size)
+double table_rows(const catalog::Table &table, uint32_t pages);
+// fraction of rows whose column `col` equals `v` (0 for a table never analyzed)
+double eq_selectivity(const catalog::Table &table, int col, const storage::Value &v);
+
+double seq_scan(uint32_t pages, double rows);
+// probing a hash index for `matches` rows of a table of `pages` pages
+double index_scan(double matches, uint32_t pages);
+// threads worth starting for a scan of this cost, capped by the CPU count
+uint32_t parallel_workers(double scan_cost);
+
+} // namespace cost
@@ -0,0 +1,442 @@
+#include "src/execution/vector_expr.h"
+#include "src/execution/filter_kernels.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+using sql::CompareOp;
+using sql::Expr;
+using sql::ExprType;
+
+ColumnType column_type_of(catalog::Type kind) {
+    return kind == catalog::Type::INT ? ColumnType::INT : ColumnType::TEXT;
+}
+
+static bool is_numeric(ColumnType t) { return t != ColumnType::TEXT; }
+
+static ColumnType promote(ColumnType a, ColumnType b) {
+    if (a == ColumnType::DOUBLE || b == ColumnType::DOUBLE) return ColumnType::DOUBLE;
+    if (a == ColumnType::BIGINT || b == ColumnType::BIGINT) return ColumnType::BIGINT;
+    return ColumnType::INT;
+}
+
+static const storage::Value &constant_value(const Expr &e, const Params *params) {
+    if (e.type == ExprType::LITERAL) return e.value;
+    if (!params || e.param < 0 || static_cast<size_t>(e.param) >= params->size())
+        throw std::runtime_error("missing value for parameter " + std::to_string(e.param + 1));
+    return (*params)[e.param];
+}
+
+static bool is_constant(const Expr &e) {
+    return e.type == ExprType::LITERAL || e.type == ExprType::PARAM;
+}
+
+ColumnType infer_type(const Expr &e, const std::vector<ColumnType> &input, const Params *params) {
+    switch (e.type) {
+    case ExprType::COLUMN:
+        if (e.column < 0 || static_cast<size_t>(e.column) >= input.size())
+            throw std::runtime_error("unbound column " + e.name);
+        return input[e.column];
+    case ExprType::LITERAL:
+    case ExprType::PARAM:
+        return constant_value(e, params).type() == storage::ValueType::INT ? ColumnType::INT : ColumnType::TEXT;
+    case ExprType::COMPARE:
+    case ExprType::AND:
+    case ExprType::OR:
+    case ExprType::NOT:
+    case ExprType::BETWEEN:
+    case ExprType::IN:
+    case ExprType::LIKE:
+        return ColumnType::INT;
+    case ExprType::ARITH: {
+        ColumnType l = infer_type(*e.args[0], input, params);
+        ColumnType r = infer_type(*e.args[1], input, params);
+        if (!is_numeric(l) || !is_numeric(r)) throw std::runtime_error("arithmetic on non-INT value");
+        return promote(l, r);
+    }
+    case ExprType::FUNCTION: throw std::runtime_error("aggregate " + e.name + " not allowed here");
+    case ExprType::STAR: throw std::runtime_error("'*' is not a value");
+    }
+    throw std::runtime_error("bad expression");
+}
+
+//
+// ------------------------- KERNELS ------------------------------
+//
+template <typename T, typename Cmp>
+static void cmp_const_loop(const T *a, T k, size_t n, uint8_t *m, Cmp cmp) {
+    for (size_t i = 0; i < n; ++i) m[i] = cmp(a[i], k);
+}
+
+template <typename T, typename Cmp>
+static void cmp_cols_loop(const T *a, const T *b, size_t n, uint8_t *m, Cmp cmp) {
+    for (size_t i = 0; i < n; ++i) m[i] = cmp(a[i], b[i]);
+}
+
+// one switch on the operator, then a monomorphic loop
+template <typename T>
+static void cmp_const(const T *a, T k, size_t n, CompareOp op, uint8_t *m) {
+    switch (op) {
+    case CompareOp::EQ: cmp_const_loop(a, k, n, m, std::equal_to<T>()); break;
+    case CompareOp::NE: cmp_const_loop(a, k, n, m, std::not_equal_to<T>()); break;
+    case CompareOp::LT: cmp_const_loop(a, k, n, m, std::less<T>()); break;
+    case CompareOp::LE: cmp_const_loop(a, k, n, m, std::less_equal<T>()); break;
+    case CompareOp::GT: cmp_const_loop(a, k, n, m, std::greater<T>()); break;
+    case CompareOp::GE: cmp_const_loop(a, k, n, m, std::greater_equal<T>()); break;
+    }
+}
+
+template <typename T>
+static void cmp_cols(const T *a, const T *b, size_t n, CompareOp op, uint8_t *m) {
+    switch (op) {
+    case CompareOp::EQ: cmp_cols_loop(a, b, n, m, std::equal_to<T>()); break;
+    case CompareOp::NE: cmp_cols_loop(a, b, n, m, std::not_equal_to<T>()); break;
+    case CompareOp::LT: cmp_cols_loop(a, b, n, m, std::less<T>()); break;
+    case CompareOp::LE: cmp_cols_loop(a, b, n, m, std::less_equal<T>()); break;
+    case CompareOp::GT: cmp_cols_loop(a, b, n, m, std::greater<T>()); break;
+    case CompareOp::GE: cmp_cols_loop(a, b, n, m, std::greater_equal<T>()); break;
+    }
+}
+
+static bool cmp_result(int r, CompareOp op) {
+    switch (op) {
+    case CompareOp::EQ: return r == 0;
+    case CompareOp::NE: return r != 0;
+    case CompareOp::LT: return r < 0;
+    case CompareOp::LE: return r <= 0;
+    case CompareOp::GT: return r > 0;
+    case CompareOp::GE: return r >= 0;
+    }
+    return false;
+}
+
+static CompareOp mirror(CompareOp op) {
+    switch (op) {
+    case CompareOp::LT: return CompareOp::GT;
+    case CompareOp::LE: return CompareOp::GE;
+    case CompareOp::GT: return CompareOp::LT;
+    case CompareOp::GE: return CompareOp::LE;
+    default: return op;
+    }
+}
+
+// Copy/convert a numeric column into the storage of `target`
+static void to_numeric(const ColumnVector &src, size_t n, ColumnType target, ColumnVector &dst) {
+    dst.reset(target);
+    auto convert = [&](auto &out) {
+        out.resize(n);
+        switch (src.type) {
+        case ColumnType::INT: for (size_t i = 0; i < n; ++i) out[i] = src.i32[i]; break;
+        case ColumnType::BIGINT: for (size_t i = 0; i < n; ++i) out[i] = src.i64[i]; break;
+        case ColumnType::DOUBLE: for (size_t i = 0; i < n; ++i) out[i] = src.f64[i]; break;
+        case ColumnType::TEXT: throw std::runtime_error("arithmetic on non-INT value");
+        }
+    };
+    switch (target) {
+    case ColumnType::INT: convert(dst.i32); break;
+    case ColumnType::BIGINT: convert(dst.i64); break;
+    case ColumnType::DOUBLE: convert(dst.f64); break;
+    case ColumnType::TEXT: throw std::runtime_error("bad numeric conversion");
+    }
+}
+
+// Input column for COLUMN refs (no copy), otherwise evaluated into `scratch`
+static const ColumnVector &operand(const Expr &e, const Batch &in, const Params *params, ColumnVector &scratch) {
+    if (e.type == ExprType::COLUMN) return in.columns.at(e.column);
+    eval_batch(e, in, params, scratch);
+    return scratch;
+}
+
+static void compare_with_const(const ColumnVector &col, const storage::Value &k, size_t n,
+                               CompareOp op, uint8_t *m) {
+    bool k_int = k.type() == storage::ValueType::INT;
+    switch (col.type) {
+    case ColumnType::INT:
+        if (k_int) return filter_i32_compare(col.i32.data(), n, op, k.as_int(), m);
+        break;
+    case ColumnType::BIGINT:
+        if (k_int) return cmp_const<int64_t>(col.i64.data(), k.as_int(), n, op, m);
+        break;
+    case ColumnType::DOUBLE:
+        if (k_int) return cmp_const<double>(col.f64.data(), k.as_int(), n, op, m);
+        break;
+    case ColumnType::TEXT:
+        if (!k_int) {
+            const std::string &kt = k.as_text();
+            if (op == CompareOp::EQ || op == CompareOp::NE)
+                return filter_text_equals(col.offsets.data(), col.chars.data(), n, kt, op == CompareOp::NE, m);
+            for (size_t i = 0; i < n; ++i) m[i] = cmp_result(col.text(i).compare(kt), op);
+            return;
+        }
+        break;
+    }
+    std::fill(m, m + n, 0); // different types never compare true
+}
+
+static void compare_columns(const ColumnVector &a, const ColumnVector &b, size_t n, CompareOp op, uint8_t *m) {
+    if (a.type == ColumnType::TEXT || b.type == ColumnType::TEXT) {
+        if (a.type != b.type) {
+            std::fill(m, m + n, 0);
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) m[i] = cmp_result(a.text(i).compare(b.text(i)), op);
+        return;
+    }
+    if (a.type == b.type) {
+        switch (a.type) {
+        case ColumnType::INT: return cmp_cols(a.i32.data(), b.i32.data(), n, op, m);
+        case ColumnType::BIGINT: return cmp_cols(a.i64.data(), b.i64.data(), n, op, m);
+        case ColumnType::DOUBLE: return cmp_cols(a.f64.data(), b.f64.data(), n, op, m);
+        default: break;
+        }
+    }
+    ColumnType t = promote(a.type, b.type);
+    ColumnVector ca, cb;
+    to_numeric(a, n, t, ca);
+    to_numeric(b, n, t, cb);
+    compare_columns(ca, cb, n, op, m);
+}
+
+template <typename T>
+static void arith_loop(const T *a, const T *b, size_t n, sql::ArithOp op, T *out) {
+    switch (op) {
+    case sql::ArithOp::ADD: for (size_t i = 0; i < n; ++i) out[i] = a[i] + b[i]; break;
+    case sql::ArithOp::SUB: for (size_t i = 0; i < n; ++i) out[i] = a[i] - b[i]; break;
+    case sql::ArithOp::MUL: for (size_t i = 0; i < n; ++i) out[i] = a[i] * b[i]; break;
+    case sql::ArithOp::DIV:
+        for (size_t i = 0; i < n; ++i) {
+            if (b[i] == 0) throw std::runtime_error("division by zero");
+            out[i] = a[i] / b[i];
+        }
+        break;
+    }
+}
+
+// INT arithmetic is done in 64 bits and truncated, like the row evaluator
+static void arith_int32(const int32_t *a, const int32_t *b, size_t n, sql::ArithOp op, int32_t *out) {
+    for (size_t i = 0; i < n; ++i) {
+        int64_t x = a[i], y = b[i], r = 0;
+        switch (op) {
+        case sql::ArithOp::ADD: r = x + y; break;
+        case sql::ArithOp::SUB: r = x - y; break;
+        case sql::ArithOp::MUL: r = x * y; break;
+        case sql::ArithOp::DIV:
+            if (y == 0) throw std::runtime_error("division by zero");
+            r = x / y;
+            break;
+        }
+        out[i] = static_cast<int32_t>(r);
+    }
+}
+
+static void broadcast(const storage::Value &v, size_t n, ColumnVector &out) {
+    if (v.type() == storage::ValueType::INT) {
+        out.reset(ColumnType::INT);
+        out.i32.assign(n, v.as_int());
+    } else {
+        out.reset(ColumnType::TEXT);
+        const std::string &s = v.as_text();
+        out.chars.reserve(s.size() * n);
+        for (size_t i = 0; i < n; ++i) out.push_text(s);
+    }
+}
+
+static void compare_operands(const Expr &l, const Expr &r, CompareOp op, const Batch &in, const Params *params,
+                             uint8_t *m) {
+    size_t n = in.size;
+    ColumnVector scratch_l, scratch_r;
+    if (is_constant(l) && is_constant(r)) {
+        const storage::Value &a = constant_value(l, params);
+        const storage::Value &b = constant_value(r, params);
+        bool v = a.type() == b.type() && cmp_result(compare_values(a, b), op);
+        std::fill(m, m + n, v);
+    } else if (is_constant(r)) {
+        compare_with_const(operand(l, in, params, scratch_l), constant_value(r, params), n, op, m);
+    } else if (is_constant(l)) {
+        compare_with_const(operand(r, in, params, scratch_r), constant_value(l, params), n, mirror(op), m);
+    } else {
+        compare_columns(operand(l, in, params, scratch_l), operand(r, in, params, scratch_r), n, op, m);
+    }
+}
+
+static bool all_int_constants(const Expr &e, size_t from, const Params *params) {
+    for (size_t i = from; i < e.args.size(); ++i) {
+        if (!is_constant(*e.args[i]) || constant_value(*e.args[i], params).type() != storage::ValueType::INT)
+            return false;
+    }
+    return true;
+}
+
+static void eval_between(const Expr &e, const Batch &in, const Params *params, std::vector<uint8_t> &mask) {
+    size_t n = in.size;
+    ColumnVector scratch;
+    if (all_int_constants(e, 1, params)) {
+        const ColumnVector &v = operand(*e.args[0], in, params, scratch);
+        if (v.type == ColumnType::INT) {
+            filter_i32_between(v.i32.data(), n, constant_value(*e.args[1], params).as_int(),
+                               constant_value(*e.args[2], params).as_int(), mask.data());
+            return;
+        }
+    }
+    std::vector<uint8_t> hi(n);
+    compare_operands(*e.args[0], *e.args[1], CompareOp::GE, in, params, mask.data());
+    compare_operands(*e.args[0], *e.args[2], CompareOp::LE, in, params, hi.data());
+    mask_and(mask.data(), hi.data(), n);
+}
+
+static void eval_in(const Expr &e, const Batch &in, const Params *params, std::vector<uint8_t> &mask) {
+    size_t n = in.size;
+    ColumnVector scratch;
+    if (all_int_constants(e, 1, params)) {
+        const ColumnVector &v = operand(*e.args[0], in, params, scratch);
+        if (v.type == ColumnType::INT) {
+            std::vector<int32_t> set;
+            for (size_t i = 1; i < e.args.size(); ++i) set.push_back(constant_value(*e.args[i], params).as_int());
+            std::sort(set.begin(), set.end());
+            set.erase(std::unique(set.begin(), set.end()), set.end());
+            filter_i32_in(v.i32.data(), n, set.data(), set.size(), mask.data());
+            return;
+        }
+    }
+    std::vector<uint8_t> item(n);
+    std::fill(mask.begin(), mask.end(), 0);
+    for (size_t i = 1; i < e.args.size(); ++i) {
+        compare_operands(*e.args[0], *e.args[i], CompareOp::EQ, in, params, item.data());
+        mask_or(mask.data(), item.data(), n);
+    }
+}
+
+static bool has_wildcards(std::string_view s) { return s.find_first_of("%_") != std::string_view::npos; }
+
+static void eval_like(const Expr &e, const Batch &in, const Params *params, std::vector<uint8_t> &mask) {
+    size_t n = in.size;
+    ColumnVector scratch_v, scratch_p;
+    const ColumnVector &v = operand(*e.args[0], in, params, scratch_v);
+    if (v.type != ColumnType::TEXT) {
+        std::fill(mask.begin(), mask.end(), 0);
+        return;
+    }
+
+    if (!is_constant(*e.args[1])) {
+        const ColumnVector &p = operand(*e.args[1], in, params, scratch_p);
+        for (size_t i = 0; i < n; ++i) mask[i] = p.type == ColumnType::TEXT && like_match(v.text(i), p.text(i));
+        return;
+    }
+    const storage::Value &pv = constant_value(*e.args[1], params);
+    if (pv.type() != storage::ValueType::TEXT) {
+        std::fill(mask.begin(), mask.end(), 0);
+        return;
+    }
+    const std::string pattern = pv.as_text();
+    std::string_view body(pattern);
+
+    // 'abc' and 'abc%' (the common cases) skip the general matcher
+    if (!has_wildcards(body)) {
+        filter_text_equals(v.offsets.data(), v.chars.data(), n, body, false, mask.data());
+        return;
+    }
+    if (body.back() == '%' && !has_wildcards(body.substr(0, body.size() - 1))) {
+        filter_text_prefix(v.offsets.data(), v.chars.data(), n, body.substr(0, body.size() - 1), mask.data());
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) mask[i] = like_match(v.text(i), body);
+}
+
+//
+// ------------------------- EVALUATION ---------------------------
+//
+void eval_mask(const Expr &e, const Batch &in, const Params *params, std::vector<uint8_t> &mask) {
+    size_t n = in.size;
+    mask.resize(n);
+
+    switch (e.type) {
+    case ExprType::AND:
+    case ExprType::OR: {
+        std::vector<uint8_t> rhs;
+        eval_mask(*e.args[0], in, params, mask);
+        eval_mask(*e.args[1], in, params, rhs);
+        if (e.type == ExprType::AND) mask_and(mask.data(), rhs.data(), n);
+        else mask_or(mask.data(), rhs.data(), n);
+        return;
+    }
+    case ExprType::NOT:
+        eval_mask(*e.args[0], in, params, mask);
+        mask_not(mask.data(), n);
+        return;
+    case ExprType::COMPARE:
+        compare_operands(*e.args[0], *e.args[1], e.op, in, params, mask.data());
+        return;
+    case ExprType::BETWEEN: eval_between(e, in, params, mask); return;
+    case ExprType::IN: eval_in(e, in, params, mask); return;
+    case ExprType::LIKE: eval_like(e, in, params, mask); return;
+    default: {
+        ColumnVector v;
+        eval_batch(e, in, params, v);
+        for (size_t i = 0; i < n; ++i) {
+            switch (v.type) {
+            case ColumnType::INT: mask[i] = v.i32[i] != 0; break;
+            case ColumnType::BIGINT: mask[i] = v.i64[i] != 0; break;
+            case ColumnType::DOUBLE: mask[i] = v.f64[i] != 0; break;
+            case ColumnType::TEXT: mask[i] = !v.text(i).empty(); break;
+            }
+        }
+        return;
+    }
+    }
+}
+
+void eval_batch(const Expr &e, const Batch &in, const Params *params, ColumnVector &out) {
+    size_t n = in.size;
+    switch (e.type) {
+    case ExprType::COLUMN:
+        out = in.columns.at(e.column);
+        return;
+    case ExprType::LITERAL:
+    case ExprType::PARAM:
+        broadcast(constant_value(e, params), n, out);
+        return;
+    case ExprType::COMPARE:
+    case ExprType::AND:
+    case ExprType::OR:
+    case ExprType::NOT:
+    case ExprType::BETWEEN:
+    case ExprType::IN:
+    case ExprType::LIKE: {
+        std::vector<uint8_t> mask;
+        eval_mask(e, in, params, mask);
+        out.reset(ColumnType::INT);
+        out.i32.assign(mask.begin(), mask.end());
+        return;
+    }
+    case ExprType::ARITH: {
+        ColumnVector sa, sb, ca, cb;
+        const ColumnVector &a = operand(*e.args[0], in, params, sa);
+        const ColumnVector &b = operand(*e.args[1], in, params, sb);
+        if (!is_numeric(a.type) || !is_numeric(b.type)) throw std::runtime_error("arithmetic on non-INT value");
+        ColumnType t = promote(a.type, b.type);
+        const ColumnVector *pa = &a, *pb = &b;
+        if (a.type != t) { to_numeric(a, n, t, ca); pa = &ca; }
+        if (b.type != t) { to_numeric(b, n, t, cb); pb = &cb; }
+        out.reset(t);
+        switch (t) {
+        case ColumnType::INT:
+            out.i32.resize(n);
+            arith_int32(pa->i32.data(), pb->i32.data(), n, e.arith, out.i32.data());
+            break;
+        case ColumnType::BIGINT:
+            out.i64.resize(n);
+            arith_loop(pa->i64.data(), pb->i64.data(), n, e.arith, out.i64.data());
+            break;
+        case ColumnType::DOUBLE:
+            out.f64.resize(n);
+            arith_loop(pa->f64.data(), pb->f64.data(), n, e.arith, out.f64.data());
+            break;
+        case ColumnType::TEXT: break;
+        }
+        return;
+    }
+    case ExprType::FUNCTION: throw std::runtime_error("aggregate " + e.name + " not allowed here");
+    case ExprType::STAR: throw std::runtime_error("'*' is not a value");
+    }
+}
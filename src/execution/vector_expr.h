@@ -0,0 +1,21 @@
+#pragma once
+
+#include "src/execution/batch.h"
+#include "src/execution/expression.h"
+#include "src/sql/ast.h"
+
+#include <vector>
+
+// Batch-at-a-time evaluation of bound expressions. Type dispatch happens once
+// per batch; the per-row loops are templates over the column storage type.
+
+// Result type of `e` over input columns of the given types (params resolve ?)
+ColumnType infer_type(const sql::Expr &e, const std::vector<ColumnType> &input, const Params *params);
+
+// Evaluate `e` for every row of `in` into `out` (reset to the result type)
+void eval_batch(const sql::Expr &e, const Batch &in, const Params *params, ColumnVector &out);
+
+// WHERE semantics over a batch: mask[i] = 1 if row i qualifies
+void eval_mask(const sql::Expr &e, const Batch &in, const Params *params, std::vector<uint8_t> &mask);
+
+ColumnType column_type_of(catalog::Type kind);
@@ -1,20 +1,20 @@
 #include "src/main/daemon_launcher.h"
 #include "src/engine/engine.h"
+#include "src/server/server.h"
 #include "src/utils/logger.h"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <csignal>
 #include <iostream>
 #include <mutex>
-#include <thread>
 
 // ---------------- Context ----------------
 struct DaemonContext {
     std::atomic<bool> terminate{false};
     std::mutex mtx;
     std::condition_variable cv;
-    bool finished = false;
 };
 
 static DaemonContext g_daemon_ctx;
@@ -27,32 +27,14 @@ static void signal_handler(int sig) {
     }
 }
 
-// ---------------- Server Worker ----------------
-static void server_worker(Engine &engine) {
-    log(LogLevel::INFO, "Daemon server thread started");
-
-    // Stub loop — later will delegate to src/server/Server
-    while (!g_daemon_ctx.terminate.load(std::memory_order_relaxed)) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        log(LogLevel::DEBUG, "Daemon heartbeat: engine alive");
-    }
-
-    {
-        std::unique_lock<std::mutex> lk(g_daemon_ctx.mtx);
-        g_daemon_ctx.finished = true;
-    }
-    g_daemon_ctx.cv.notify_all();
-
-    log(LogLevel::INFO, "Daemon server thread exiting");
-}
-
 // ---------------- Lifecycle Entry ----------------
 int start_daemon(Config &cfg) {
     log(LogLevel::INFO, "Starting daemon mode");
 
-    // Register signals
+    // Register signals; a client hanging up is seen by send(), not as a signal
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
+    std::signal(SIGPIPE, SIG_IGN);
 
     // Initialize engine
     Engine engine(cfg);
@@ -61,24 +43,24 @@ int start_daemon(Config &cfg) {
         log(LogLevel::ERROR, "Failed to initialize engine: " + err);
         return 1;
     }
+    engine.start_background();
 
-    // Launch server thread
-    std::thread srv_thread(server_worker, std::ref(engine));
-
-    // Wait until termination or finished
+    // Serve clients (src/server/server.h) until told to stop
+    Server server(engine, cfg);
+    if (!server.start(err)) {
+        log(LogLevel::ERROR, "Failed to start server: " + err);
+        engine.shutdown();
+        return 1;
+    }
     {
+        // a notify from the signal handler can be missed: look at the flag now and then
         std::unique_lock<std::mutex> lk(g_daemon_ctx.mtx);
-        g_daemon_ctx.cv.wait(lk, [] {
-            return g_daemon_ctx.finished || g_daemon_ctx.terminate.load(std::memory_order_relaxed);
-        });
-    }
-
-    // Join worker thread
-    if (srv_thread.joinable()) {
-        srv_thread.join();
+        while (!g_daemon_ctx.terminate.load(std::memory_order_relaxed))
+            g_daemon_ctx.cv.wait_for(lk, std::chrono::milliseconds(200));
     }
 
-    // Shutdown engine
+    // no new statements, then let the running ones finish before the final checkpoint
+    server.stop();
     engine.shutdown();
 
     log(LogLevel::INFO, "Daemon mode shutdown complete");
@@ -14,6 +14,46 @@ static std::atomic<bool> g_terminate{false};
 static std::mutex g_mtx;
 static std::condition_variable g_cv;
 
+// Prints results as they arrive: one "name=value, ..." line per row
+class TextSink : public ResultSink {
+public:
+    void columns(const std::vector<std::string> &names, const std::vector<ColumnType> &) override {
+        names_ = names;
+        rows_ = 0;
+    }
+
+    bool batch(const Batch &rows) override {
+        std::string out;
+        for (size_t r = 0; r < rows.size; ++r) {
+            for (size_t c = 0; c < rows.columns.size(); ++c) {
+                if (c) out += ", ";
+                out += names_[c];
+                out += '=';
+                out += rows.columns[c].value_string(r);
+            }
+            out += '\n';
+        }
+        std::cout << out << std::flush;
+        rows_ += rows.size;
+        return true;
+    }
+
+    void status(const std::string &msg) override {
+        std::cout << msg << std::endl;
+        names_.clear(); // the status line ends the statement
+    }
+
+    // end of a statement that announced columns
+    void finish() {
+        if (!names_.empty() && rows_ == 0) std::cout << "OK: 0 rows" << std::endl;
+        names_.clear();
+    }
+
+private:
+    std::vector<std::string> names_;
+    size_t rows_ = 0;
+};
+
 // signal handler sets atomic flag and notifies
 static void signal_handler(int sig) {
     if (sig == SIGINT || sig == SIGTERM) {
@@ -42,6 +82,7 @@ int start_repl(Config &cfg) {
     std::atomic<bool> repl_done{false};
     std::thread repl_thread([&]{
         log(LogLevel::INFO, "REPL thread started");
+        TextSink sink;
         std::string line;
         while (!g_terminate.load(std::memory_order_relaxed)) {
             std::cout << "boltd> " << std::flush;
@@ -66,9 +107,9 @@ int start_repl(Config &cfg) {
                 continue;
             }
 
-            // dispatch to engine
-            std::string out = engine.execute_sql(cmd);
-            if (!out.empty()) std::cout << out << std::endl;
+            // dispatch to engine; rows are printed while the query runs
+            engine.execute_sql(cmd, sink);
+            sink.finish();
         }
         repl_done.store(true);
         g_cv.notify_all();
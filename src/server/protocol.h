@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Wire format of the daemon (shared by the server and boltc).
+//
+// Every message is a frame: a 4-byte little-endian length, then that many
+// bytes. A request frame holds one SQL statement. Its reply is a run of frames
+// whose first byte says what they carry:
+//   'D'  rows, as text: one "name=value, ..." line per row (any number of these)
+//   'Z'  the end of the statement: its status line, "OK: ..." or "ERR: ..."
+// Requests may be sent before the replies to earlier ones arrive; a
+// connection runs its statements one at a time, in order.
+//
+// Binary protocol: a client that opens the connection with BINARY_HELLO
+// (read as a length it is over MAX_FRAME, so no text client sends it) uses
+// it from then on. Integers are little-endian. Requests start with a byte:
+//   'Q'  [SQL text]
+//   'P'  [u32 length][SQL text][u16 parameters][u32 sets], then each set's
+//        values: [u8 Type][INT32: i32 | INT64: i64 | TEXT: u32 length, bytes].
+//        Each set runs as a statement of its own, in order, with its own
+//        reply: many executions of one statement in one frame (up to 4096;
+//        a frame with more is refused).
+// Replies, typed and columnar instead of 'D' lines:
+//   'C'  [u16 columns] then per column [u8 Type][u16 length][name]
+//   'B'  [u32 rows] then the columns in order: INT32 i32 x rows, INT64 i64 x
+//        rows, FLOAT64 f64 x rows, TEXT u32 x (rows + 1) offsets followed by
+//        the characters (offsets[rows] bytes)
+//   'Z'  as above
+namespace protocol {
+
+constexpr uint32_t MAX_FRAME = 16u << 20;
+constexpr char BINARY_HELLO[4] = {'B', 'L', 'T', 1};
+
+enum class Reply : uint8_t { ROWS = 'D', DONE = 'Z', COLUMNS = 'C', BATCH = 'B' };
+enum class Request : uint8_t { QUERY = 'Q', EXECUTE = 'P' };
+enum class Type : uint8_t { INT32 = 1, INT64 = 2, FLOAT64 = 3, TEXT = 4 };
+
+inline void put_u16(std::string &out, uint16_t v) {
+    char b[2] = {static_cast<char>(v), static_cast<char>(v >> 8)};
+    out.append(b, 2);
+}
+
+inline void put_u32(std::string &out, uint32_t v) {
+    char b[4] = {static_cast<char>(v), static_cast<char>(v >> 8), static_cast<char>(v >> 16),
+                 static_cast<char>(v >> 24)};
+    out.append(b, 4);
+}
+
+inline void put_u64(std::string &out, uint64_t v) {
+    put_u32(out, static_cast<uint32_t>(v));
+    put_u32(out, static_cast<uint32_t>(v >> 32));
+}
+
+inline uint32_t get_u32(const char *p) {
+    const auto *b = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<uint32_t>(b[0]) | static_cast<uint32_t>(b[1]) << 8 | static_cast<uint32_t>(b[2]) << 16 |
+           static_cast<uint32_t>(b[3]) << 24;
+}
+
+// Append `n` fixed-width values as their little-endian bytes
+template <typename T> inline void put_array(std::string &out, const T *values, size_t n) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    out.append(reinterpret_cast<const char *>(values), n * sizeof(T));
+#else
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &values[i], sizeof(T));
+        for (size_t b = 0; b < sizeof(T); ++b) out += static_cast<char>(bits >> (8 * b));
+    }
+#endif
+}
+
+inline void put_frame(std::string &out, const std::string &body) {
+    put_u32(out, static_cast<uint32_t>(body.size()));
+    out += body;
+}
+
+inline void put_reply(std::string &out, Reply kind, const std::string &payload) {
+    put_u32(out, static_cast<uint32_t>(payload.size() + 1));
+    out += static_cast<char>(kind);
+    out += payload;
+}
+
+// Length of the frame starting at `data` (header included) if all of it is
+// there, 0 if more bytes are needed
+inline size_t complete_frame(const char *data, size_t size) {
+    if (size < 4) return 0;
+    size_t len = get_u32(data);
+    return size - 4 >= len ? len + 4 : 0;
+}
+
+// Bounds-checked decoding of a frame body: a read past the end yields zeros
+// and clears `ok`
+struct Reader {
+    const char *p;
+    size_t left;
+    bool ok = true;
+
+    Reader(const char *data, size_t size) : p(data), left(size) {}
+
+    bool take(void *dst, size_t n) {
+        if (!ok || n > left) {
+            ok = false;
+            std::memset(dst, 0, n);
+            return false;
+        }
+        std::memcpy(dst, p, n);
+        p += n;
+        left -= n;
+        return true;
+    }
+    uint8_t u8() {
+        uint8_t v;
+        take(&v, 1);
+        return v;
+    }
+    uint16_t u16() {
+        unsigned char b[2];
+        take(b, 2);
+        return static_cast<uint16_t>(b[0] | b[1] << 8);
+    }
+    uint32_t u32() {
+        char b[4];
+        take(b, 4);
+        return get_u32(b);
+    }
+    uint64_t u64() {
+        uint64_t lo = u32();
+        return lo | static_cast<uint64_t>(u32()) << 32;
+    }
+    std::string bytes(size_t n) {
+        if (!ok || n > left) {
+            ok = false;
+            return std::string();
+        }
+        std::string s(p, n);
+        p += n;
+        left -= n;
+        return s;
+    }
+};
+
+} // namespace protocol
@@ -0,0 +1,706 @@
+#include "src/server/server.h"
+#include "src/server/protocol.h"
+#include "src/utils/logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// reply bytes a statement may have waiting for the socket before it is paused
+static constexpr size_t MAX_UNSENT = 1u << 20;
+// requests read ahead of the running one before the connection stops being read
+static constexpr size_t MAX_PIPELINE = 256;
+// parameter sets one 'P' frame may carry
+static constexpr uint32_t MAX_SETS = 4096;
+// smallest encoding of a parameter: its type byte and an INT32
+static constexpr size_t MIN_PARAM_BYTES = 5;
+static constexpr size_t READ_CHUNK = 64 * 1024;
+// connections taken per wakeup of a listener, so one thread does not take them all
+static constexpr int ACCEPT_BATCH = 64;
+
+//
+// ------------------------- CONNECTION --------------------------
+//
+// One statement to run, as read off the wire
+struct Request {
+    std::string sql;
+    bool bound = false;      // binary 'P': run `statement` with `params`
+    std::shared_ptr<const std::string> statement;   // shared by the frame's parameter sets
+    Params params;
+    std::string error;       // a request that could not be read: this is its reply
+};
+
+static protocol::Type wire_type(ColumnType t) {
+    switch (t) {
+    case ColumnType::INT: return protocol::Type::INT32;
+    case ColumnType::BIGINT: return protocol::Type::INT64;
+    case ColumnType::DOUBLE: return protocol::Type::FLOAT64;
+    case ColumnType::TEXT: return protocol::Type::TEXT;
+    }
+    return protocol::Type::TEXT;
+}
+
+// 'C' payload
+static void encode_columns(std::string &out, const std::vector<std::string> &names,
+                           const std::vector<ColumnType> &types) {
+    protocol::put_u16(out, static_cast<uint16_t>(names.size()));
+    for (size_t c = 0; c < names.size(); ++c) {
+        out += static_cast<char>(wire_type(types[c]));
+        protocol::put_u16(out, static_cast<uint16_t>(names[c].size()));
+        out += names[c];
+    }
+}
+
+// 'B' payload: the batch's column storage nearly as it is in memory
+static void encode_batch(std::string &out, const Batch &b) {
+    protocol::put_u32(out, static_cast<uint32_t>(b.size));
+    for (const ColumnVector &col : b.columns) {
+        switch (col.type) {
+        case ColumnType::INT: protocol::put_array(out, col.i32.data(), b.size); break;
+        case ColumnType::BIGINT: protocol::put_array(out, col.i64.data(), b.size); break;
+        case ColumnType::DOUBLE: protocol::put_array(out, col.f64.data(), b.size); break;
+        case ColumnType::TEXT: {
+            uint32_t base = col.offsets[0];
+            if (base == 0) {
+                protocol::put_array(out, col.offsets.data(), b.size + 1);
+            } else {
+                for (size_t r = 0; r <= b.size; ++r) protocol::put_u32(out, col.offsets[r] - base);
+            }
+            out.append(col.chars.data() + base, col.offsets[b.size] - base);
+            break;
+        }
+        }
+    }
+}
+
+// The statements of a binary request frame (one per parameter set of 'P')
+static void decode_request(const char *body, size_t len, std::deque<Request> &requests) {
+    protocol::Reader r(body, len);
+    auto kind = static_cast<protocol::Request>(r.u8());
+    if (r.ok && kind == protocol::Request::QUERY) {
+        Request q;
+        q.sql = r.bytes(r.left);
+        requests.push_back(std::move(q));
+        return;
+    }
+    if (!r.ok || kind != protocol::Request::EXECUTE) {
+        requests.push_back(Request{"", false, nullptr, {}, "ERR: unknown request type"});
+        return;
+    }
+    auto sql = std::make_shared<const std::string>(r.bytes(r.u32()));
+    uint16_t count = r.u16();
+    uint32_t sets = r.u32();
+    // the counts are the client's word: hold them against the bytes that are there
+    std::string error;
+    if (!r.ok || static_cast<uint64_t>(sets) * count * MIN_PARAM_BYTES > r.left)
+        error = "ERR: malformed request";
+    else if (sets > MAX_SETS)
+        error = "ERR: more than " + std::to_string(MAX_SETS) + " parameter sets in one request";
+    if (!error.empty()) {
+        requests.push_back(Request{"", false, nullptr, {}, error});
+        return;
+    }
+    std::deque<Request> runs;
+    for (uint32_t s = 0; s < sets && r.ok && error.empty(); ++s) {
+        Request q;
+        q.statement = sql;
+        q.bound = true;
+        q.params.reserve(count);
+        for (uint16_t i = 0; i < count && r.ok; ++i) {
+            switch (static_cast<protocol::Type>(r.u8())) {
+            case protocol::Type::INT32: q.params.emplace_back(static_cast<int32_t>(r.u32())); break;
+            case protocol::Type::INT64: {
+                auto v = static_cast<int64_t>(r.u64());
+                if (v < INT32_MIN || v > INT32_MAX)
+                    error = "ERR: parameter " + std::to_string(i + 1) + " is out of INT range";
+                q.params.emplace_back(static_cast<int32_t>(v));
+                break;
+            }
+            case protocol::Type::TEXT: q.params.emplace_back(r.bytes(r.u32())); break;
+            default: error = "ERR: parameter " + std::to_string(i + 1) + " has an unsupported type"; break;
+            }
+        }
+        runs.push_back(std::move(q));
+    }
+    if (!r.ok || r.left != 0) error = "ERR: malformed request";
+    if (sets == 0 && error.empty()) error = "ERR: no parameter sets";
+    if (!error.empty()) {
+        requests.push_back(Request{"", false, nullptr, {}, error});
+        return;
+    }
+    for (auto &q : runs) requests.push_back(std::move(q));
+}
+
+// One client. The I/O thread owning it reads its requests and writes its
+// replies; while one of its statements runs, the worker is the result sink
+// and queues reply frames in `outbox` for the I/O thread to pick up. Queuing
+// never blocks; a query that got ahead of the socket by MAX_UNSENT bytes is
+// paused by the executor (ready()/wait()), once it let go of what other
+// statements need.
+struct Server::Connection : ResultSink, std::enable_shared_from_this<Connection> {
+    int fd = -1;
+    IoThread *io = nullptr;
+    std::shared_ptr<Session> session;
+    bool binary = false;               // speaks the binary protocol (set before its first request)
+
+    // I/O thread only
+    bool greeted = false;              // the first bytes were looked at for BINARY_HELLO
+    std::string in;                    // bytes of requests not complete yet
+    std::deque<Request> requests;      // read, waiting for the running one
+    bool running = false;              // a statement is on the worker pool
+    bool closing = false;              // no more requests: close once they are answered
+    std::string error;                 // last reply before closing (a bad request)
+    std::string out;                   // being written
+    size_t out_pos = 0;
+    uint32_t events = 0;               // registered with epoll
+
+    // shared with the worker running the statement
+    std::mutex mu;
+    std::condition_variable drained;
+    std::string outbox;
+    size_t unsent = 0;                 // bytes of outbox and out not written yet
+    bool done = false;                 // outbox ends with the statement's last frame
+    bool dead = false;                 // the socket is closed: replies go nowhere
+    std::atomic<bool> notified{false};
+
+    // the running statement, as its worker sees it
+    std::vector<std::string> names;
+    uint64_t rows = 0;
+    std::string status_line;
+    std::string scratch;               // the reply frame being encoded
+
+    void columns(const std::vector<std::string> &n, const std::vector<ColumnType> &types) override {
+        names = n;
+        if (!binary) return;
+        scratch.clear();
+        encode_columns(scratch, n, types);
+        send(protocol::Reply::COLUMNS, scratch, false);
+    }
+
+    bool batch(const Batch &b) override {
+        rows += b.size;
+        if (binary) {
+            scratch.clear();
+            encode_batch(scratch, b);
+            return send(protocol::Reply::BATCH, scratch, false);
+        }
+        std::string &text = scratch;
+        text.clear();
+        for (size_t r = 0; r < b.size; ++r) {
+            for (size_t c = 0; c < b.columns.size(); ++c) {
+                if (c) text += ", ";
+                text += names[c];
+                text += '=';
+                text += b.columns[c].value_string(r);
+            }
+            text += '\n';
+        }
+        return send(protocol::Reply::ROWS, text, false);
+    }
+
+    void status(const std::string &msg) override { status_line = msg; }
+
+    bool ready() override {
+        std::lock_guard<std::mutex> lg(mu);
+        return dead || unsent <= MAX_UNSENT;
+    }
+
+    bool wait() override {
+        std::unique_lock<std::mutex> lk(mu);
+        drained.wait(lk, [&] { return dead || unsent <= MAX_UNSENT; });
+        return !dead;
+    }
+
+    // the statement is over: its status ends the reply
+    void finish() {
+        std::string msg = status_line.empty() ? "OK: " + std::to_string(rows) + (rows == 1 ? " row" : " rows")
+                                               : status_line;
+        names.clear();
+        rows = 0;
+        status_line.clear();
+        send(protocol::Reply::DONE, msg, true);
+    }
+
+    // false once nobody reads the replies (the statement can stop)
+    bool send(protocol::Reply kind, const std::string &payload, bool last);
+};
+
+//
+// -------------------------- I/O THREAD -------------------------
+//
+// An epoll set over the listeners (shared by every I/O thread, each woken
+// alone through EPOLLEXCLUSIVE), the connections it accepted, and an eventfd
+// workers ring when replies are waiting.
+struct Server::IoThread {
+    int epfd = -1;
+    int wake_fd = -1;
+    int spare_fd = -1;   // given up to accept (and drop) a connection when out of descriptors
+    std::thread thread;
+    std::unordered_map<int, std::shared_ptr<Connection>> conns;
+
+    std::mutex mu;
+    std::vector<std::shared_ptr<Connection>> ready;   // connections with replies to pick up
+
+    void notify(std::shared_ptr<Connection> c) {
+        {
+            std::lock_guard<std::mutex> lg(mu);
+            ready.push_back(std::move(c));
+        }
+        uint64_t one = 1;
+        ssize_t n = ::write(wake_fd, &one, sizeof(one));
+        (void)n;   // a full counter still wakes the thread
+    }
+};
+
+bool Server::Connection::send(protocol::Reply kind, const std::string &payload, bool last) {
+    std::unique_lock<std::mutex> lk(mu);
+    if (dead) return false;
+    size_t before = outbox.size();
+    protocol::put_reply(outbox, kind, payload);
+    unsent += outbox.size() - before;
+    if (last) done = true;
+    lk.unlock();
+    if (!notified.exchange(true)) io->notify(shared_from_this());
+    return true;
+}
+
+static std::string errno_text(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+//
+// ---------------------------- SERVER ---------------------------
+//
+Server::Server(Engine &engine, const Config &cfg) : engine_(engine), cfg_(cfg) {}
+
+Server::~Server() {
+    stop();
+    for (auto &io : io_) {
+        if (io->epfd >= 0) ::close(io->epfd);
+        if (io->wake_fd >= 0) ::close(io->wake_fd);
+        if (io->spare_fd >= 0) ::close(io->spare_fd);
+    }
+}
+
+bool Server::start(std::string &err) {
+    if (cfg_.listen_port == 0 && cfg_.socket_path.empty()) {
+        err = "no listener configured (listen_port and socket_path are both off)";
+        return false;
+    }
+    // idle connections are cheap here, but each is a descriptor
+    struct rlimit lim;
+    if (::getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &lim);
+    }
+    if (cfg_.listen_port != 0 && !listen_tcp(err)) return false;
+    if (!cfg_.socket_path.empty() && !listen_unix(err)) return false;
+
+    unsigned threads = std::max(1u, cfg_.io_threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        auto io = std::make_unique<IoThread>();
+        io->epfd = ::epoll_create1(EPOLL_CLOEXEC);
+        io->wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        io->spare_fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (io->epfd < 0 || io->wake_fd < 0) {
+            err = errno_text("cannot create I/O thread");
+            io_.push_back(std::move(io));
+            return false;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = io->wake_fd;
+        ::epoll_ctl(io->epfd, EPOLL_CTL_ADD, io->wake_fd, &ev);
+        for (int l : listeners_) {
+            ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+            ev.data.fd = l;
+            if (::epoll_ctl(io->epfd, EPOLL_CTL_ADD, l, &ev) != 0) {
+                err = errno_text("cannot watch listener");
+                io_.push_back(std::move(io));
+                return false;
+            }
+        }
+        io_.push_back(std::move(io));
+    }
+    for (auto &io : io_) io->thread = std::thread(&Server::run, this, std::ref(*io));
+    log(LogLevel::INFO, "server: " + std::to_string(io_.size()) + " I/O threads, up to " +
+                            std::to_string(cfg_.max_connections) + " connections");
+    return true;
+}
+
+bool Server::listen_tcp(std::string &err) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        err = errno_text("cannot create TCP socket");
+        return false;
+    }
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg_.listen_port);
+    std::string where = cfg_.listen_address + ":" + std::to_string(cfg_.listen_port);
+    if (::inet_pton(AF_INET, cfg_.listen_address.c_str(), &addr.sin_addr) != 1) {
+        ::close(fd);
+        err = "bad listen_address: " + cfg_.listen_address;
+        return false;
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        err = errno_text("cannot listen on " + where);
+        ::close(fd);
+        return false;
+    }
+    listeners_.push_back(fd);
+    log(LogLevel::INFO, "listening on " + where);
+    return true;
+}
+
+bool Server::listen_unix(std::string &err) {
+    sockaddr_un addr{};
+    if (cfg_.socket_path.size() >= sizeof(addr.sun_path)) {
+        err = "socket_path is too long: " + cfg_.socket_path;
+        return false;
+    }
+    // a socket left by a previous run is replaced; any other file is not
+    struct stat st;
+    if (::lstat(cfg_.socket_path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            err = "socket_path exists and is not a socket: " + cfg_.socket_path;
+            return false;
+        }
+        ::unlink(cfg_.socket_path.c_str());
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        err = errno_text("cannot create Unix socket");
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, cfg_.socket_path.c_str(), cfg_.socket_path.size() + 1);
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        err = errno_text("cannot listen on " + cfg_.socket_path);
+        ::close(fd);
+        return false;
+    }
+    listeners_.push_back(fd);
+    log(LogLevel::INFO, "listening on " + cfg_.socket_path);
+    return true;
+}
+
+void Server::stop() {
+    if (stopping_.exchange(true)) return;
+    for (auto &io : io_) {
+        uint64_t one = 1;
+        if (io->wake_fd >= 0) {
+            ssize_t n = ::write(io->wake_fd, &one, sizeof(one));
+            (void)n;
+        }
+    }
+    for (auto &io : io_)
+        if (io->thread.joinable()) io->thread.join();
+    for (int l : listeners_) ::close(l);
+    listeners_.clear();
+    if (!cfg_.socket_path.empty()) ::unlink(cfg_.socket_path.c_str());
+    log(LogLevel::INFO, "server stopped");
+}
+
+void Server::run(IoThread &io) {
+    std::vector<epoll_event> events(256);
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        int n = ::epoll_wait(io.epfd, events.data(), static_cast<int>(events.size()), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log(LogLevel::ERROR, errno_text("epoll_wait failed"));
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t what = events[i].events;
+            if (fd == io.wake_fd) {
+                uint64_t count;
+                ssize_t r = ::read(io.wake_fd, &count, sizeof(count));
+                (void)r;
+                std::vector<std::shared_ptr<Connection>> ready;
+                {
+                    std::lock_guard<std::mutex> lg(io.mu);
+                    ready.swap(io.ready);
+                }
+                for (auto &c : ready) on_replies(io, c);
+                continue;
+            }
+            if (std::find(listeners_.begin(), listeners_.end(), fd) != listeners_.end()) {
+                accept_from(io, fd);
+                continue;
+            }
+            auto it = io.conns.find(fd);
+            if (it == io.conns.end()) continue;
+            std::shared_ptr<Connection> c = it->second;
+            if (what & (EPOLLHUP | EPOLLERR)) {
+                // gone both ways: nothing more can be delivered
+                close_connection(io, c);
+                continue;
+            }
+            if (what & EPOLLIN) on_readable(io, c);
+            if (c->fd >= 0 && (what & EPOLLOUT)) flush(io, c);
+        }
+    }
+
+    std::vector<std::shared_ptr<Connection>> open;
+    for (auto &entry : io.conns) open.push_back(entry.second);
+    for (auto &c : open) close_connection(io, c);
+}
+
+void Server::accept_from(IoThread &io, int listener) {
+    for (int i = 0; i < ACCEPT_BATCH; ++i) {
+        int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if ((errno == EMFILE || errno == ENFILE) && io.spare_fd >= 0) {
+                // out of descriptors: take the connection off the queue and
+                // drop it rather than being woken for it forever
+                ::close(io.spare_fd);
+                int dropped = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+                if (dropped >= 0) ::close(dropped);
+                io.spare_fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+                log(LogLevel::WARN, "connection refused: out of file descriptors");
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) log(LogLevel::WARN, errno_text("accept failed"));
+            return;
+        }
+        if (connections_.load(std::memory_order_relaxed) >= cfg_.max_connections) {
+            ::close(fd);
+            log(LogLevel::WARN, "connection refused: max_connections reached");
+            continue;
+        }
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));   // fails harmlessly on Unix sockets
+
+        auto c = std::make_shared<Connection>();
+        c->fd = fd;
+        c->io = &io;
+        c->session = engine_.open_session();
+        c->events = EPOLLIN;
+        epoll_event ev{};
+        ev.events = c->events;
+        ev.data.fd = fd;
+        if (::epoll_ctl(io.epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            log(LogLevel::WARN, errno_text("cannot watch connection"));
+            ::close(fd);
+            continue;
+        }
+        io.conns[fd] = std::move(c);
+        connections_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Server::on_readable(IoThread &io, const std::shared_ptr<Connection> &c) {
+    size_t had = c->in.size();
+    c->in.resize(had + READ_CHUNK);
+    ssize_t n = ::recv(c->fd, &c->in[had], READ_CHUNK, 0);
+    c->in.resize(had + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+        close_connection(io, c);
+        return;
+    }
+    if (n == 0) {
+        // the client is done sending: answer what it sent, then close
+        c->closing = true;
+    }
+    parse_requests(c);
+    dispatch(c);
+    flush(io, c);
+}
+
+// Turn the complete frames of `in` into requests, until MAX_PIPELINE are
+// waiting; the rest stay in `in` (and the socket unread) until they are taken
+void Server::parse_requests(const std::shared_ptr<Connection> &c) {
+    size_t pos = 0;
+    if (!c->greeted && c->in.size() >= sizeof(protocol::BINARY_HELLO)) {
+        c->greeted = true;
+        if (std::memcmp(c->in.data(), protocol::BINARY_HELLO, sizeof(protocol::BINARY_HELLO)) == 0) {
+            c->binary = true;
+            pos = sizeof(protocol::BINARY_HELLO);
+        }
+    }
+    while (c->requests.size() < MAX_PIPELINE) {
+        size_t len = protocol::complete_frame(c->in.data() + pos, c->in.size() - pos);
+        if (len == 0) break;
+        if (c->binary) {
+            decode_request(c->in.data() + pos + 4, len - 4, c->requests);
+        } else {
+            Request q;
+            q.sql.assign(c->in, pos + 4, len - 4);
+            c->requests.push_back(std::move(q));
+        }
+        pos += len;
+    }
+    if (c->requests.size() < MAX_PIPELINE && c->in.size() - pos >= 4 &&
+        protocol::get_u32(c->in.data() + pos) > protocol::MAX_FRAME) {
+        c->error = "ERR: request of " + std::to_string(protocol::get_u32(c->in.data() + pos)) +
+                   " bytes is over the limit of " + std::to_string(protocol::MAX_FRAME);
+        c->closing = true;
+        pos = c->in.size();
+    }
+    c->in.erase(0, pos);
+}
+
+void Server::dispatch(const std::shared_ptr<Connection> &c) {
+    while (!c->running && !c->requests.empty()) {
+        Request q = std::move(c->requests.front());
+        c->requests.pop_front();
+        if (!q.error.empty()) {
+            // answered here, in its turn
+            reply_now(c, protocol::Reply::DONE, q.error);
+            continue;
+        }
+        c->running = true;
+        bool queued = q.bound ? engine_.submit(c->session, *q.statement, std::move(q.params), *c,
+                                               [c] { c->finish(); })
+                              : engine_.submit(c->session, std::move(q.sql), *c, [c] { c->finish(); });
+        if (!queued) {
+            c->running = false;
+            c->requests.clear();
+            c->in.clear();
+            c->error = "ERR: server is shutting down";
+            c->closing = true;
+        }
+    }
+}
+
+void Server::reply_now(const std::shared_ptr<Connection> &c, protocol::Reply kind, const std::string &payload) {
+    size_t before = c->out.size();
+    protocol::put_reply(c->out, kind, payload);
+    std::lock_guard<std::mutex> lg(c->mu);
+    c->unsent += c->out.size() - before;
+}
+
+void Server::on_replies(IoThread &io, const std::shared_ptr<Connection> &c) {
+    c->notified.store(false);
+    if (c->fd < 0) return;
+    bool finished;
+    {
+        std::lock_guard<std::mutex> lg(c->mu);
+        c->out.erase(0, c->out_pos);
+        c->out_pos = 0;
+        c->out += c->outbox;
+        c->outbox.clear();
+        finished = c->done;
+        c->done = false;
+    }
+    if (finished) {
+        c->running = false;
+        parse_requests(c);
+        dispatch(c);
+    }
+    flush(io, c);
+}
+
+void Server::flush(IoThread &io, const std::shared_ptr<Connection> &c) {
+    for (;;) {
+        size_t written = 0;
+        while (c->out_pos < c->out.size()) {
+            ssize_t n = ::send(c->fd, c->out.data() + c->out_pos, c->out.size() - c->out_pos, MSG_NOSIGNAL);
+            if (n > 0) {
+                c->out_pos += static_cast<size_t>(n);
+                written += static_cast<size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                close_connection(io, c);
+                return;
+            }
+        }
+        if (c->out_pos == c->out.size()) {
+            c->out.clear();
+            c->out_pos = 0;
+        }
+        if (written > 0) {
+            {
+                std::lock_guard<std::mutex> lg(c->mu);
+                c->unsent -= written;
+            }
+            c->drained.notify_all();
+        }
+
+        if (!c->closing || c->running || !c->requests.empty()) break;
+        if (!c->error.empty()) {
+            // the bad request's reply goes out last
+            reply_now(c, protocol::Reply::DONE, c->error);
+            c->error.clear();
+            continue;
+        }
+        if (c->out.empty()) {
+            close_connection(io, c);
+            return;
+        }
+        break;
+    }
+    update_events(io, c);
+}
+
+void Server::update_events(IoThread &io, const std::shared_ptr<Connection> &c) {
+    uint32_t want = 0;
+    if (!c->closing && c->requests.size() < MAX_PIPELINE) want |= EPOLLIN;
+    if (c->out_pos < c->out.size()) want |= EPOLLOUT;
+    if (want == c->events) return;
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.fd = c->fd;
+    ::epoll_ctl(io.epfd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = want;
+}
+
+void Server::close_connection(IoThread &io, const std::shared_ptr<Connection> &c) {
+    if (c->fd < 0) return;
+    ::epoll_ctl(io.epfd, EPOLL_CTL_DEL, c->fd, nullptr);
+    ::close(c->fd);
+    io.conns.erase(c->fd);
+    c->fd = -1;
+    connections_.fetch_sub(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lg(c->mu);
+        c->dead = true;
+        c->outbox.clear();
+    }
+    c->drained.notify_all();
+}
+
+#else // !__linux__
+
+// The server is built on epoll; elsewhere the daemon starts without listeners
+struct Server::Connection {};
+struct Server::IoThread {};
+
+Server::Server(Engine &engine, const Config &cfg) : engine_(engine), cfg_(cfg) {}
+Server::~Server() = default;
+
+bool Server::start(std::string &err) {
+    err = "the network server needs epoll (Linux)";
+    return false;
+}
+
+void Server::stop() {}
+
+#endif
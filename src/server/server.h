@@ -0,0 +1,61 @@
+#pragma once
+
+#include "src/cli/config.h"
+#include "src/engine/engine.h"
+#include "src/server/protocol.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Network front end of the daemon: TCP and Unix-socket listeners served by a
+// few I/O threads (cfg.io_threads), each with its own epoll set. An I/O
+// thread accepts connections, reads request frames (src/server/protocol.h)
+// and hands each statement to the engine's worker pool; the worker streams
+// the reply back to that thread, which writes it out. Sockets are
+// non-blocking and idle connections only cost their buffers. Clients speak
+// the text or the binary protocol (pipelined, typed parameters and columnar
+// results), chosen by how they open the connection.
+class Server {
+public:
+    Server(Engine &engine, const Config &cfg);
+    ~Server();
+
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+    // bind the listeners and start the I/O threads
+    bool start(std::string &err);
+    // close every connection and end the I/O threads; statements still on the
+    // worker pool finish with nobody to read their replies
+    void stop();
+
+    size_t connections() const { return connections_.load(std::memory_order_relaxed); }
+
+private:
+    struct Connection;
+    struct IoThread;
+
+    bool listen_tcp(std::string &err);
+    bool listen_unix(std::string &err);
+    void run(IoThread &io);
+    void accept_from(IoThread &io, int listener);
+    void on_readable(IoThread &io, const std::shared_ptr<Connection> &c);
+    void on_replies(IoThread &io, const std::shared_ptr<Connection> &c);
+    void parse_requests(const std::shared_ptr<Connection> &c);
+    void dispatch(const std::shared_ptr<Connection> &c);
+    // queue a reply the I/O thread makes itself (not from a statement)
+    void reply_now(const std::shared_ptr<Connection> &c, protocol::Reply kind, const std::string &payload);
+    void flush(IoThread &io, const std::shared_ptr<Connection> &c);
+    void update_events(IoThread &io, const std::shared_ptr<Connection> &c);
+    void close_connection(IoThread &io, const std::shared_ptr<Connection> &c);
+
+    Engine &engine_;
+    Config cfg_;
+    std::vector<int> listeners_;
+    std::vector<std::unique_ptr<IoThread>> io_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<size_t> connections_{0};
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "src/catalog/catalog.h"
+#include "src/storage/table/tuple.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace sql {
+
+// ---------------------------------------------------------
+// Expressions
+// ---------------------------------------------------------
+enum class ExprType : uint8_t {
+    COLUMN,    // [table.]name
+    LITERAL,   // value
+    PARAM,     // ? (param = position)
+    STAR,      // * in a select list or COUNT(*)
+    COMPARE,   // args[0] <op> args[1]
+    ARITH,     // args[0] <arith> args[1]
+    AND,
+    OR,
+    NOT,
+    FUNCTION,  // name(args...)
+    BETWEEN,   // args[0] BETWEEN args[1] AND args[2]
+    IN,        // args[0] IN (args[1], ...)
+    LIKE       // args[0] LIKE args[1]  (% and _ wildcards)
+};
+
+enum class CompareOp : uint8_t { EQ, NE, LT, LE, GT, GE };
+enum class ArithOp : uint8_t { ADD, SUB, MUL, DIV };
+
+struct Expr;
+using ExprPtr = std::unique_ptr<Expr>;
+
+struct Expr {
+    ExprType type = ExprType::LITERAL;
+    CompareOp op = CompareOp::EQ;
+    ArithOp arith = ArithOp::ADD;
+    std::string table;      // COLUMN qualifier, may be empty
+    std::string name;       // COLUMN name / FUNCTION name (upper-case)
+    storage::Value value;   // LITERAL
+    int param = -1;         // PARAM position (0-based)
+    int column = -1;        // COLUMN position in the row, filled in by binding
+    std::vector<ExprPtr> args;
+
+    explicit Expr(ExprType t) : type(t) {}
+};
+
+const char *compare_op_text(CompareOp op);
+std::string expr_to_string(const Expr &e);
+ExprPtr clone_expr(const Expr &e);
+// structural equality (bound column positions, not qualifiers, for COLUMN)
+bool same_expr(const Expr &a, const Expr &b);
+
+// ---------------------------------------------------------
+// Statements
+// ---------------------------------------------------------
+struct TableRef {
+    std::string name;
+    std::string alias;
+};
+
+// [INNER | LEFT [OUTER]] JOIN table [[AS] alias] ON expr
+struct JoinClause {
+    TableRef table;
+    bool left = false;
+    ExprPtr on;
+};
+
+struct SelectItem {
+    ExprPtr expr;
+    std::string alias;
+};
+
+struct OrderItem {
+    ExprPtr expr;
+    bool desc = false;
+};
+
+struct SelectStmt {
+    std::vector<SelectItem> items;   // `*` is a single STAR item
+    TableRef from;
+    std::vector<JoinClause> joins;
+    ExprPtr where;
+    std::vector<ExprPtr> group_by;
+    std::vector<OrderItem> order_by;
+    int64_t limit = -1;              // -1 = no limit
+    int64_t offset = 0;
+};
+
+struct InsertStmt {
+    std::string table;
+    std::vector<std::string> columns;          // empty = all, in table order
+    std::vector<std::vector<ExprPtr>> rows;
+};
+
+struct UpdateStmt {
+    std::string table;
+    std::vector<std::pair<std::string, ExprPtr>> assignments;
+    ExprPtr where;
+};
+
+struct DeleteStmt {
+    std::string table;
+    ExprPtr where;
+};
+
+struct CreateTableStmt {
+    std::string name;
+    std::vector<catalog::Column> columns;
+};
+
+struct CreateIndexStmt {
+    std::string name;
+    std::string table;
+    std::string column;
+    std::string method = "HASH";
+};
+
+// PREPARE name AS <statement>; the body is kept as text and planned through the plan cache
+struct PrepareStmt {
+    std::string name;
+    std::string body;
+};
+
+struct ExecuteStmt {
+    std::string name;
+    std::vector<ExprPtr> args;
+};
+
+struct DeallocateStmt {
+    std::string name;
+};
+
+// BEGIN / COMMIT / ROLLBACK [TRANSACTION | WORK]
+struct TransactionStmt {
+    enum class Kind { BEGIN, COMMIT, ROLLBACK };
+    Kind kind = Kind::BEGIN;
+};
+
+// ANALYZE table: collect the statistics the planner costs access paths with
+struct AnalyzeStmt {
+    std::string table;
+};
+
+// EXPLAIN [ANALYZE] <query or EXECUTE>; the query is kept as text and planned on its own
+struct ExplainStmt {
+    bool analyze = false;   // run it and report what each plan node did
+    std::string body;
+};
+
+struct Statement {
+    std::variant<SelectStmt, InsertStmt, UpdateStmt, DeleteStmt, CreateTableStmt, CreateIndexStmt,
+                 PrepareStmt, ExecuteStmt, DeallocateStmt, TransactionStmt, AnalyzeStmt, ExplainStmt> node;
+    int param_count = 0;
+
+    template <typename T> T *as() { return std::get_if<T>(&node); }
+    template <typename T> const T *as() const { return std::get_if<T>(&node); }
+};
+
+} // namespace sql
@@ -0,0 +1,181 @@
+#include "src/sql/lexer.h"
+
+#include <cctype>
+#include <limits>
+
+using namespace sql;
+
+namespace {
+
+struct KeywordEntry {
+    std::string_view text;
+    Keyword kw;
+};
+
+constexpr KeywordEntry KEYWORDS[] = {
+    {"SELECT", Keyword::SELECT}, {"FROM", Keyword::FROM},     {"WHERE", Keyword::WHERE},
+    {"AND", Keyword::AND},       {"OR", Keyword::OR},         {"NOT", Keyword::NOT},
+    {"ORDER", Keyword::ORDER},   {"GROUP", Keyword::GROUP},   {"BY", Keyword::BY},
+    {"ASC", Keyword::ASC},       {"DESC", Keyword::DESC},     {"LIMIT", Keyword::LIMIT},
+    {"OFFSET", Keyword::OFFSET}, {"INSERT", Keyword::INSERT}, {"INTO", Keyword::INTO},
+    {"VALUES", Keyword::VALUES}, {"UPDATE", Keyword::UPDATE}, {"SET", Keyword::SET},
+    {"DELETE", Keyword::DELETE}, {"CREATE", Keyword::CREATE}, {"TABLE", Keyword::TABLE},
+    {"INDEX", Keyword::INDEX},   {"ON", Keyword::ON},         {"USING", Keyword::USING},
+    {"AS", Keyword::AS},         {"PREPARE", Keyword::PREPARE}, {"EXECUTE", Keyword::EXECUTE},
+    {"DEALLOCATE", Keyword::DEALLOCATE}, {"BETWEEN", Keyword::BETWEEN}, {"IN", Keyword::IN},
+    {"LIKE", Keyword::LIKE},         {"JOIN", Keyword::JOIN},     {"INNER", Keyword::INNER},
+    {"LEFT", Keyword::LEFT},         {"OUTER", Keyword::OUTER},   {"BEGIN", Keyword::BEGIN},
+    {"COMMIT", Keyword::COMMIT},     {"ROLLBACK", Keyword::ROLLBACK}, {"ANALYZE", Keyword::ANALYZE},
+    {"EXPLAIN", Keyword::EXPLAIN},
+};
+
+inline bool is_ident_start(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+inline bool is_ident_char(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+} // namespace
+
+bool sql::equals_ci(std::string_view a, std::string_view upper) {
+    if (a.size() != upper.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != upper[i]) return false;
+    }
+    return true;
+}
+
+const char *Lexer::type_name(TokenType t) {
+    switch (t) {
+    case TokenType::END: return "end of input";
+    case TokenType::ERROR: return "invalid token";
+    case TokenType::IDENT: return "identifier";
+    case TokenType::KEYWORD: return "keyword";
+    case TokenType::INT_LIT: return "integer";
+    case TokenType::STRING_LIT: return "string";
+    case TokenType::PARAM: return "'?'";
+    case TokenType::COMMA: return "','";
+    case TokenType::DOT: return "'.'";
+    case TokenType::LPAREN: return "'('";
+    case TokenType::RPAREN: return "')'";
+    case TokenType::SEMICOLON: return "';'";
+    case TokenType::STAR: return "'*'";
+    case TokenType::PLUS: return "'+'";
+    case TokenType::MINUS: return "'-'";
+    case TokenType::SLASH: return "'/'";
+    case TokenType::EQ: return "'='";
+    case TokenType::NE: return "'!='";
+    case TokenType::LT: return "'<'";
+    case TokenType::LE: return "'<='";
+    case TokenType::GT: return "'>'";
+    case TokenType::GE: return "'>='";
+    }
+    return "token";
+}
+
+void Lexer::skip_space_and_comments() {
+    while (pos_ < src_.size()) {
+        char c = src_[pos_];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pos_++;
+        } else if (c == '-' && pos_ + 1 < src_.size() && src_[pos_ + 1] == '-') {
+            // -- line comment
+            while (pos_ < src_.size() && src_[pos_] != '\n') pos_++;
+        } else {
+            break;
+        }
+    }
+}
+
+Token Lexer::make(TokenType t, size_t start, size_t len) {
+    Token tok;
+    tok.type = t;
+    tok.text = src_.substr(start, len);
+    tok.pos = start;
+    pos_ = start + len;
+    return tok;
+}
+
+Token Lexer::lex_word(size_t start) {
+    size_t end = start + 1;
+    while (end < src_.size() && is_ident_char(src_[end])) end++;
+    Token tok = make(TokenType::IDENT, start, end - start);
+    for (const auto &k : KEYWORDS) {
+        if (equals_ci(tok.text, k.text)) {
+            tok.type = TokenType::KEYWORD;
+            tok.kw = k.kw;
+            break;
+        }
+    }
+    return tok;
+}
+
+Token Lexer::lex_number(size_t start) {
+    size_t end = start;
+    int64_t v = 0;
+    bool overflow = false;
+    while (end < src_.size() && std::isdigit(static_cast<unsigned char>(src_[end]))) {
+        int d = src_[end] - '0';
+        if (v > (std::numeric_limits<int64_t>::max() - d) / 10) overflow = true;
+        else v = v * 10 + d;
+        end++;
+    }
+    if (end < src_.size() && is_ident_start(src_[end])) {
+        return make(TokenType::ERROR, start, end - start + 1);
+    }
+    Token tok = make(overflow ? TokenType::ERROR : TokenType::INT_LIT, start, end - start);
+    tok.int_val = v;
+    return tok;
+}
+
+Token Lexer::lex_string(size_t start, char quote) {
+    size_t end = start + 1;
+    while (end < src_.size()) {
+        if (src_[end] == quote) {
+            // doubled quote is an escaped quote
+            if (end + 1 < src_.size() && src_[end + 1] == quote) {
+                end += 2;
+                continue;
+            }
+            Token tok = make(TokenType::STRING_LIT, start + 1, end - start - 1);
+            pos_ = end + 1;
+            return tok;
+        }
+        end++;
+    }
+    return make(TokenType::ERROR, start, src_.size() - start); // unterminated
+}
+
+Token Lexer::next() {
+    skip_space_and_comments();
+    if (pos_ >= src_.size()) return make(TokenType::END, src_.size(), 0);
+
+    size_t start = pos_;
+    char c = src_[pos_];
+    char n = pos_ + 1 < src_.size() ? src_[pos_ + 1] : '\0';
+
+    if (is_ident_start(c)) return lex_word(start);
+    if (std::isdigit(static_cast<unsigned char>(c))) return lex_number(start);
+
+    switch (c) {
+    case '\'': case '"': return lex_string(start, c);
+    case '?': return make(TokenType::PARAM, start, 1);
+    case ',': return make(TokenType::COMMA, start, 1);
+    case '.': return make(TokenType::DOT, start, 1);
+    case '(': return make(TokenType::LPAREN, start, 1);
+    case ')': return make(TokenType::RPAREN, start, 1);
+    case ';': return make(TokenType::SEMICOLON, start, 1);
+    case '*': return make(TokenType::STAR, start, 1);
+    case '+': return make(TokenType::PLUS, start, 1);
+    case '-': return make(TokenType::MINUS, start, 1);
+    case '/': return make(TokenType::SLASH, start, 1);
+    case '=': return make(TokenType::EQ, start, n == '=' ? 2 : 1);
+    case '!': if (n == '=') return make(TokenType::NE, start, 2); break;
+    case '<':
+        if (n == '=') return make(TokenType::LE, start, 2);
+        if (n == '>') return make(TokenType::NE, start, 2);
+        return make(TokenType::LT, start, 1);
+    case '>':
+        if (n == '=') return make(TokenType::GE, start, 2);
+        return make(TokenType::GT, start, 1);
+    default: break;
+    }
+    return make(TokenType::ERROR, start, 1);
+}
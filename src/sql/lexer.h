@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sql {
+
+enum class TokenType : uint8_t {
+    END,
+    ERROR,
+    IDENT,
+    KEYWORD,
+    INT_LIT,
+    STRING_LIT,  // text excludes the quotes; may still contain doubled quotes
+    PARAM,       // ?
+    COMMA,
+    DOT,
+    LPAREN,
+    RPAREN,
+    SEMICOLON,
+    STAR,
+    PLUS,
+    MINUS,
+    SLASH,
+    EQ,
+    NE,          // != or <>
+    LT,
+    LE,
+    GT,
+    GE
+};
+
+enum class Keyword : uint8_t {
+    NONE,
+    SELECT, FROM, WHERE, AND, OR, NOT, ORDER, GROUP, BY, ASC, DESC, LIMIT, OFFSET,
+    INSERT, INTO, VALUES, UPDATE, SET, DELETE, CREATE, TABLE, INDEX, ON, USING, AS,
+    PREPARE, EXECUTE, DEALLOCATE, BETWEEN, IN, LIKE, JOIN, INNER, LEFT, OUTER,
+    BEGIN, COMMIT, ROLLBACK, ANALYZE, EXPLAIN
+};
+
+struct Token {
+    TokenType type = TokenType::END;
+    Keyword kw = Keyword::NONE;
+    std::string_view text;  // view into the source; never copied by the lexer
+    size_t pos = 0;         // byte offset in the source, for error messages
+    int64_t int_val = 0;
+};
+
+// Hand-written, single-pass tokenizer. Tokens are produced on demand and
+// reference the source text, which must outlive them.
+class Lexer {
+public:
+    explicit Lexer(std::string_view src) : src_(src) {}
+
+    Token next();
+
+    // Unconsumed source from byte offset `pos` (e.g. the body of PREPARE ... AS)
+    std::string_view rest(size_t pos) const { return src_.substr(pos); }
+
+    static const char *type_name(TokenType t);
+
+private:
+    std::string_view src_;
+    size_t pos_ = 0;
+
+    void skip_space_and_comments();
+    Token make(TokenType t, size_t start, size_t len);
+    Token lex_word(size_t start);
+    Token lex_number(size_t start);
+    Token lex_string(size_t start, char quote);
+};
+
+// Case-insensitive compare of a token text against an upper-case keyword
+bool equals_ci(std::string_view a, std::string_view upper);
+
+} // namespace sql
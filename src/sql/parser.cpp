@@ -0,0 +1,700 @@
+#include "src/sql/parser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+using namespace sql;
+
+// ---------------------------------------------------------
+// AST helpers
+// ---------------------------------------------------------
+const char *sql::compare_op_text(CompareOp op) {
+    switch (op) {
+    case CompareOp::EQ: return "=";
+    case CompareOp::NE: return "!=";
+    case CompareOp::LT: return "<";
+    case CompareOp::LE: return "<=";
+    case CompareOp::GT: return ">";
+    case CompareOp::GE: return ">=";
+    }
+    return "?";
+}
+
+std::string sql::expr_to_string(const Expr &e) {
+    switch (e.type) {
+    case ExprType::COLUMN: return e.table.empty() ? e.name : e.table + "." + e.name;
+    case ExprType::LITERAL:
+        return e.value.type() == storage::ValueType::INT ? e.value.to_string() : "'" + e.value.to_string() + "'";
+    case ExprType::PARAM: return "?";
+    case ExprType::STAR: return "*";
+    case ExprType::COMPARE:
+        return expr_to_string(*e.args[0]) + " " + compare_op_text(e.op) + " " + expr_to_string(*e.args[1]);
+    case ExprType::ARITH: {
+        static const char ops[] = {'+', '-', '*', '/'};
+        return "(" + expr_to_string(*e.args[0]) + " " + ops[static_cast<int>(e.arith)] + " " +
+               expr_to_string(*e.args[1]) + ")";
+    }
+    case ExprType::AND: return "(" + expr_to_string(*e.args[0]) + " AND " + expr_to_string(*e.args[1]) + ")";
+    case ExprType::OR: return "(" + expr_to_string(*e.args[0]) + " OR " + expr_to_string(*e.args[1]) + ")";
+    case ExprType::NOT: return "NOT " + expr_to_string(*e.args[0]);
+    case ExprType::BETWEEN:
+        return expr_to_string(*e.args[0]) + " BETWEEN " + expr_to_string(*e.args[1]) + " AND " +
+               expr_to_string(*e.args[2]);
+    case ExprType::IN: {
+        std::string s = expr_to_string(*e.args[0]) + " IN (";
+        for (size_t i = 1; i < e.args.size(); ++i) s += (i > 1 ? ", " : "") + expr_to_string(*e.args[i]);
+        return s + ")";
+    }
+    case ExprType::LIKE: return expr_to_string(*e.args[0]) + " LIKE " + expr_to_string(*e.args[1]);
+    case ExprType::FUNCTION: {
+        std::string s = e.name + "(";
+        for (size_t i = 0; i < e.args.size(); ++i) s += (i ? ", " : "") + expr_to_string(*e.args[i]);
+        return s + ")";
+    }
+    }
+    return "";
+}
+
+ExprPtr sql::clone_expr(const Expr &e) {
+    auto c = std::make_unique<Expr>(e.type);
+    c->op = e.op;
+    c->arith = e.arith;
+    c->table = e.table;
+    c->name = e.name;
+    c->value = e.value;
+    c->param = e.param;
+    c->column = e.column;
+    for (const auto &a : e.args) c->args.push_back(clone_expr(*a));
+    return c;
+}
+
+bool sql::same_expr(const Expr &a, const Expr &b) {
+    if (a.type != b.type || a.args.size() != b.args.size()) return false;
+    switch (a.type) {
+    case ExprType::COLUMN:
+        if (a.column >= 0 || b.column >= 0) return a.column == b.column;
+        return a.name == b.name && a.table == b.table;
+    case ExprType::LITERAL:
+        if (a.value.type() != b.value.type() || a.value.to_string() != b.value.to_string()) return false;
+        break;
+    case ExprType::PARAM: return a.param == b.param;
+    case ExprType::COMPARE: if (a.op != b.op) return false; break;
+    case ExprType::ARITH: if (a.arith != b.arith) return false; break;
+    case ExprType::FUNCTION: if (a.name != b.name) return false; break;
+    default: break;
+    }
+    for (size_t i = 0; i < a.args.size(); ++i)
+        if (!same_expr(*a.args[i], *b.args[i])) return false;
+    return true;
+}
+
+static ExprPtr make_binary(ExprType t, ExprPtr l, ExprPtr r) {
+    auto e = std::make_unique<Expr>(t);
+    e->args.push_back(std::move(l));
+    e->args.push_back(std::move(r));
+    return e;
+}
+
+static std::string unescape(std::string_view text, char quote) {
+    std::string s;
+    s.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        s.push_back(text[i]);
+        if (text[i] == quote && i + 1 < text.size() && text[i + 1] == quote) i++;
+    }
+    return s;
+}
+
+static std::string upper(std::string_view v) {
+    std::string s(v);
+    std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+    return s;
+}
+
+// ---------------------------------------------------------
+// Token helpers
+// ---------------------------------------------------------
+Parser::Parser(std::string_view sql) : lexer_(sql) { advance(); }
+
+bool Parser::fail(const std::string &msg) {
+    if (err_.empty()) {
+        std::string near = cur_.type == TokenType::END ? "end of input" : "'" + std::string(cur_.text) + "'";
+        err_ = msg + " near " + near + " at position " + std::to_string(cur_.pos);
+    }
+    return false;
+}
+
+bool Parser::accept(TokenType t) {
+    if (cur_.type != t) return false;
+    advance();
+    return true;
+}
+
+bool Parser::accept(Keyword k) {
+    if (cur_.type != TokenType::KEYWORD || cur_.kw != k) return false;
+    advance();
+    return true;
+}
+
+bool Parser::expect(TokenType t) {
+    if (accept(t)) return true;
+    return fail(std::string("expected ") + Lexer::type_name(t));
+}
+
+bool Parser::expect(Keyword k, const char *what) {
+    if (accept(k)) return true;
+    return fail(std::string("expected ") + what);
+}
+
+bool Parser::identifier(std::string &out) {
+    if (cur_.type != TokenType::IDENT) return fail("expected identifier");
+    out.assign(cur_.text);
+    advance();
+    return true;
+}
+
+bool Parser::integer(int64_t &out) {
+    if (cur_.type != TokenType::INT_LIT) return fail("expected integer");
+    out = cur_.int_val;
+    advance();
+    return true;
+}
+
+// ---------------------------------------------------------
+// Statements
+// ---------------------------------------------------------
+bool Parser::parse(Statement &out, std::string &err) {
+    bool ok = false;
+    if (cur_.type != TokenType::KEYWORD) {
+        ok = fail("expected a statement");
+    } else {
+        switch (cur_.kw) {
+        case Keyword::SELECT: ok = parse_select(out); break;
+        case Keyword::INSERT: ok = parse_insert(out); break;
+        case Keyword::UPDATE: ok = parse_update(out); break;
+        case Keyword::DELETE: ok = parse_delete(out); break;
+        case Keyword::CREATE: ok = parse_create(out); break;
+        case Keyword::PREPARE: ok = parse_prepare(out); break;
+        case Keyword::EXPLAIN: ok = parse_explain(out); break;
+        case Keyword::EXECUTE: ok = parse_execute(out); break;
+        case Keyword::DEALLOCATE: {
+            advance();
+            DeallocateStmt s;
+            ok = identifier(s.name);
+            out.node = std::move(s);
+            break;
+        }
+        case Keyword::ANALYZE: {
+            advance();
+            AnalyzeStmt s;
+            ok = identifier(s.table);
+            out.node = std::move(s);
+            break;
+        }
+        case Keyword::BEGIN:
+        case Keyword::COMMIT:
+        case Keyword::ROLLBACK: {
+            TransactionStmt s;
+            s.kind = cur_.kw == Keyword::BEGIN    ? TransactionStmt::Kind::BEGIN
+                     : cur_.kw == Keyword::COMMIT ? TransactionStmt::Kind::COMMIT
+                                                  : TransactionStmt::Kind::ROLLBACK;
+            advance();
+            if (cur_.type == TokenType::IDENT && (equals_ci(cur_.text, "TRANSACTION") || equals_ci(cur_.text, "WORK")))
+                advance();
+            out.node = s;
+            ok = true;
+            break;
+        }
+        default: ok = fail("unsupported statement"); break;
+        }
+    }
+    if (ok) {
+        accept(TokenType::SEMICOLON);
+        if (cur_.type != TokenType::END) ok = fail("unexpected trailing input");
+    }
+    if (!ok) {
+        err = err_;
+        return false;
+    }
+    out.param_count = params_;
+    return true;
+}
+
+bool Parser::table_ref(TableRef &out) {
+    if (!identifier(out.name)) return false;
+    if (accept(Keyword::AS)) return identifier(out.alias);
+    if (cur_.type == TokenType::IDENT) {
+        out.alias.assign(cur_.text);
+        advance();
+    }
+    return true;
+}
+
+bool Parser::parse_select(Statement &out) {
+    advance(); // SELECT
+    SelectStmt s;
+
+    do {
+        SelectItem item;
+        if (cur_.type == TokenType::STAR) {
+            advance();
+            item.expr = std::make_unique<Expr>(ExprType::STAR);
+        } else {
+            item.expr = parse_expr();
+            if (!item.expr) return false;
+            if (accept(Keyword::AS)) {
+                if (!identifier(item.alias)) return false;
+            } else if (cur_.type == TokenType::IDENT) {
+                item.alias.assign(cur_.text);
+                advance();
+            }
+        }
+        s.items.push_back(std::move(item));
+    } while (accept(TokenType::COMMA));
+
+    if (!expect(Keyword::FROM, "FROM")) return false;
+    if (!table_ref(s.from)) return false;
+
+    for (;;) {
+        JoinClause j;
+        if (accept(Keyword::LEFT)) {
+            j.left = true;
+            accept(Keyword::OUTER);
+            if (!expect(Keyword::JOIN, "JOIN")) return false;
+        } else if (accept(Keyword::INNER)) {
+            if (!expect(Keyword::JOIN, "JOIN")) return false;
+        } else if (!accept(Keyword::JOIN)) {
+            break;
+        }
+        if (!table_ref(j.table)) return false;
+        if (!expect(Keyword::ON, "ON")) return false;
+        j.on = parse_expr();
+        if (!j.on) return false;
+        s.joins.push_back(std::move(j));
+    }
+
+    if (accept(Keyword::WHERE)) {
+        s.where = parse_expr();
+        if (!s.where) return false;
+    }
+
+    if (accept(Keyword::GROUP)) {
+        if (!expect(Keyword::BY, "BY")) return false;
+        do {
+            ExprPtr e = parse_expr();
+            if (!e) return false;
+            s.group_by.push_back(std::move(e));
+        } while (accept(TokenType::COMMA));
+    }
+
+    if (accept(Keyword::ORDER)) {
+        if (!expect(Keyword::BY, "BY")) return false;
+        do {
+            OrderItem item;
+            item.expr = parse_expr();
+            if (!item.expr) return false;
+            if (accept(Keyword::DESC)) item.desc = true;
+            else accept(Keyword::ASC);
+            s.order_by.push_back(std::move(item));
+        } while (accept(TokenType::COMMA));
+    }
+
+    if (accept(Keyword::LIMIT)) {
+        if (!integer(s.limit)) return false;
+        if (accept(Keyword::OFFSET) && !integer(s.offset)) return false;
+    }
+
+    out.node = std::move(s);
+    return true;
+}
+
+bool Parser::parse_insert(Statement &out) {
+    advance(); // INSERT
+    InsertStmt s;
+    if (!expect(Keyword::INTO, "INTO")) return false;
+    if (!identifier(s.table)) return false;
+
+    if (accept(TokenType::LPAREN)) {
+        do {
+            std::string col;
+            if (!identifier(col)) return false;
+            s.columns.push_back(std::move(col));
+        } while (accept(TokenType::COMMA));
+        if (!expect(TokenType::RPAREN)) return false;
+    }
+
+    if (!expect(Keyword::VALUES, "VALUES")) return false;
+    do {
+        if (!expect(TokenType::LPAREN)) return false;
+        std::vector<ExprPtr> row;
+        do {
+            ExprPtr e = parse_expr();
+            if (!e) return false;
+            row.push_back(std::move(e));
+        } while (accept(TokenType::COMMA));
+        if (!expect(TokenType::RPAREN)) return false;
+        s.rows.push_back(std::move(row));
+    } while (accept(TokenType::COMMA));
+
+    out.node = std::move(s);
+    return true;
+}
+
+bool Parser::parse_update(Statement &out) {
+    advance(); // UPDATE
+    UpdateStmt s;
+    if (!identifier(s.table)) return false;
+    if (!expect(Keyword::SET, "SET")) return false;
+    do {
+        std::string col;
+        if (!identifier(col)) return false;
+        if (!expect(TokenType::EQ)) return false;
+        ExprPtr e = parse_expr();
+        if (!e) return false;
+        s.assignments.emplace_back(std::move(col), std::move(e));
+    } while (accept(TokenType::COMMA));
+
+    if (accept(Keyword::WHERE)) {
+        s.where = parse_expr();
+        if (!s.where) return false;
+    }
+    out.node = std::move(s);
+    return true;
+}
+
+bool Parser::parse_delete(Statement &out) {
+    advance(); // DELETE
+    DeleteStmt s;
+    if (!expect(Keyword::FROM, "FROM")) return false;
+    if (!identifier(s.table)) return false;
+    if (accept(Keyword::WHERE)) {
+        s.where = parse_expr();
+        if (!s.where) return false;
+    }
+    out.node = std::move(s);
+    return true;
+}
+
+bool Parser::parse_create(Statement &out) {
+    advance(); // CREATE
+    if (accept(Keyword::TABLE)) {
+        CreateTableStmt s;
+        if (!identifier(s.name)) return false;
+        if (!expect(TokenType::LPAREN)) return false;
+        do {
+            catalog::Column col;
+            if (!identifier(col.name)) return false;
+            // the type is a plain word (INT, TEXT, ...); keep the spelling used
+            if (cur_.type != TokenType::IDENT) return fail("expected column type");
+            col.type.assign(cur_.text);
+            advance();
+            s.columns.push_back(std::move(col));
+        } while (accept(TokenType::COMMA));
+        if (!expect(TokenType::RPAREN)) return false;
+        out.node = std::move(s);
+        return true;
+    }
+
+    if (accept(Keyword::INDEX)) {
+        CreateIndexStmt s;
+        if (!identifier(s.name)) return false;
+        if (!expect(Keyword::ON, "ON")) return false;
+        if (!identifier(s.table)) return false;
+        if (!expect(TokenType::LPAREN)) return false;
+        if (!identifier(s.column)) return false;
+        if (!expect(TokenType::RPAREN)) return false;
+        if (accept(Keyword::USING)) {
+            if (cur_.type != TokenType::IDENT) return fail("expected index method");
+            s.method = upper(cur_.text);
+            advance();
+        }
+        out.node = std::move(s);
+        return true;
+    }
+
+    return fail("expected TABLE or INDEX");
+}
+
+bool Parser::parse_prepare(Statement &out) {
+    advance(); // PREPARE
+    PrepareStmt s;
+    if (!identifier(s.name)) return false;
+    if (!expect(Keyword::AS, "AS")) return false;
+    if (cur_.type == TokenType::END) return fail("expected statement");
+
+    // the body is planned separately; validate it by parsing it on its own
+    std::string_view body = lexer_.rest(cur_.pos);
+    Statement inner;
+    std::string inner_err;
+    if (!Parser(body).parse(inner, inner_err)) {
+        err_ = inner_err;
+        return false;
+    }
+    if (inner.as<PrepareStmt>() || inner.as<ExecuteStmt>() || inner.as<DeallocateStmt>() ||
+        inner.as<TransactionStmt>())
+        return fail("cannot PREPARE a PREPARE/EXECUTE/DEALLOCATE or a transaction statement");
+    s.body.assign(body);
+
+    while (cur_.type != TokenType::END) advance();
+    out.node = std::move(s);
+    return true;
+}
+
+bool Parser::parse_explain(Statement &out) {
+    advance(); // EXPLAIN
+    ExplainStmt s;
+    s.analyze = accept(Keyword::ANALYZE);
+    if (cur_.type == TokenType::END) return fail("expected statement");
+
+    std::string_view body = lexer_.rest(cur_.pos);
+    Statement inner;
+    std::string inner_err;
+    if (!Parser(body).parse(inner, inner_err)) {
+        err_ = inner_err;
+        return false;
+    }
+    if (!inner.as<SelectStmt>() && !inner.as<ExecuteStmt>()) return fail("only SELECT can be explained");
+    s.body.assign(body);
+
+    while (cur_.type != TokenType::END) advance();
+    out.node = std::move(s);
+    return true;
+}
+
+bool Parser::parse_execute(Statement &out) {
+    advance(); // EXECUTE
+    ExecuteStmt s;
+    if (!identifier(s.name)) return false;
+    if (accept(TokenType::LPAREN)) {
+        if (cur_.type != TokenType::RPAREN) {
+            do {
+                ExprPtr e = parse_expr();
+                if (!e) return false;
+                s.args.push_back(std::move(e));
+            } while (accept(TokenType::COMMA));
+        }
+        if (!expect(TokenType::RPAREN)) return false;
+    }
+    out.node = std::move(s);
+    return true;
+}
+
+// ---------------------------------------------------------
+// Expressions
+// ---------------------------------------------------------
+ExprPtr Parser::parse_expr() {
+    ExprPtr l = parse_and();
+    while (l && accept(Keyword::OR)) {
+        ExprPtr r = parse_and();
+        if (!r) return nullptr;
+        l = make_binary(ExprType::OR, std::move(l), std::move(r));
+    }
+    return l;
+}
+
+ExprPtr Parser::parse_and() {
+    ExprPtr l = parse_not();
+    while (l && accept(Keyword::AND)) {
+        ExprPtr r = parse_not();
+        if (!r) return nullptr;
+        l = make_binary(ExprType::AND, std::move(l), std::move(r));
+    }
+    return l;
+}
+
+ExprPtr Parser::parse_not() {
+    if (accept(Keyword::NOT)) {
+        ExprPtr inner = parse_not();
+        if (!inner) return nullptr;
+        auto e = std::make_unique<Expr>(ExprType::NOT);
+        e->args.push_back(std::move(inner));
+        return e;
+    }
+    return parse_comparison();
+}
+
+ExprPtr Parser::parse_comparison() {
+    ExprPtr l = parse_additive();
+    if (!l) return nullptr;
+
+    // [NOT] BETWEEN / IN / LIKE
+    bool negate = accept(Keyword::NOT);
+    ExprPtr e;
+    if (accept(Keyword::BETWEEN)) {
+        e = std::make_unique<Expr>(ExprType::BETWEEN);
+        e->args.push_back(std::move(l));
+        ExprPtr lo = parse_additive();
+        if (!lo || !expect(Keyword::AND, "AND")) return nullptr;
+        ExprPtr hi = parse_additive();
+        if (!hi) return nullptr;
+        e->args.push_back(std::move(lo));
+        e->args.push_back(std::move(hi));
+    } else if (accept(Keyword::IN)) {
+        e = std::make_unique<Expr>(ExprType::IN);
+        e->args.push_back(std::move(l));
+        if (!expect(TokenType::LPAREN)) return nullptr;
+        do {
+            ExprPtr item = parse_expr();
+            if (!item) return nullptr;
+            e->args.push_back(std::move(item));
+        } while (accept(TokenType::COMMA));
+        if (!expect(TokenType::RPAREN)) return nullptr;
+    } else if (accept(Keyword::LIKE)) {
+        ExprPtr pattern = parse_additive();
+        if (!pattern) return nullptr;
+        e = make_binary(ExprType::LIKE, std::move(l), std::move(pattern));
+    } else if (negate) {
+        fail("expected BETWEEN, IN or LIKE after NOT");
+        return nullptr;
+    }
+    if (e) {
+        if (!negate) return e;
+        auto n = std::make_unique<Expr>(ExprType::NOT);
+        n->args.push_back(std::move(e));
+        return n;
+    }
+
+    CompareOp op;
+    switch (cur_.type) {
+    case TokenType::EQ: op = CompareOp::EQ; break;
+    case TokenType::NE: op = CompareOp::NE; break;
+    case TokenType::LT: op = CompareOp::LT; break;
+    case TokenType::LE: op = CompareOp::LE; break;
+    case TokenType::GT: op = CompareOp::GT; break;
+    case TokenType::GE: op = CompareOp::GE; break;
+    default: return l;
+    }
+    advance();
+    ExprPtr r = parse_additive();
+    if (!r) return nullptr;
+    e = make_binary(ExprType::COMPARE, std::move(l), std::move(r));
+    e->op = op;
+    return e;
+}
+
+ExprPtr Parser::parse_additive() {
+    ExprPtr l = parse_multiplicative();
+    while (l && (cur_.type == TokenType::PLUS || cur_.type == TokenType::MINUS)) {
+        ArithOp op = cur_.type == TokenType::PLUS ? ArithOp::ADD : ArithOp::SUB;
+        advance();
+        ExprPtr r = parse_multiplicative();
+        if (!r) return nullptr;
+        l = make_binary(ExprType::ARITH, std::move(l), std::move(r));
+        l->arith = op;
+    }
+    return l;
+}
+
+ExprPtr Parser::parse_multiplicative() {
+    ExprPtr l = parse_unary();
+    while (l && (cur_.type == TokenType::STAR || cur_.type == TokenType::SLASH)) {
+        ArithOp op = cur_.type == TokenType::STAR ? ArithOp::MUL : ArithOp::DIV;
+        advance();
+        ExprPtr r = parse_unary();
+        if (!r) return nullptr;
+        l = make_binary(ExprType::ARITH, std::move(l), std::move(r));
+        l->arith = op;
+    }
+    return l;
+}
+
+ExprPtr Parser::parse_unary() {
+    if (cur_.type == TokenType::MINUS) {
+        advance();
+        // fold -<int literal> so INT_MIN stays representable
+        if (cur_.type == TokenType::INT_LIT) {
+            int64_t v = -cur_.int_val;
+            if (v < std::numeric_limits<int32_t>::min()) {
+                fail("integer out of range");
+                return nullptr;
+            }
+            advance();
+            auto e = std::make_unique<Expr>(ExprType::LITERAL);
+            e->value = storage::Value(static_cast<int32_t>(v));
+            return e;
+        }
+        ExprPtr inner = parse_unary();
+        if (!inner) return nullptr;
+        auto zero = std::make_unique<Expr>(ExprType::LITERAL);
+        zero->value = storage::Value(int32_t{0});
+        ExprPtr e = make_binary(ExprType::ARITH, std::move(zero), std::move(inner));
+        e->arith = ArithOp::SUB;
+        return e;
+    }
+    return parse_primary();
+}
+
+ExprPtr Parser::parse_primary() {
+    switch (cur_.type) {
+    case TokenType::INT_LIT: {
+        if (cur_.int_val > std::numeric_limits<int32_t>::max()) {
+            fail("integer out of range");
+            return nullptr;
+        }
+        auto e = std::make_unique<Expr>(ExprType::LITERAL);
+        e->value = storage::Value(static_cast<int32_t>(cur_.int_val));
+        advance();
+        return e;
+    }
+    case TokenType::STRING_LIT: {
+        auto e = std::make_unique<Expr>(ExprType::LITERAL);
+        char quote = cur_.pos > 0 ? cur_.text.data()[-1] : '\'';
+        e->value = storage::Value(unescape(cur_.text, quote));
+        advance();
+        return e;
+    }
+    case TokenType::PARAM: {
+        auto e = std::make_unique<Expr>(ExprType::PARAM);
+        e->param = params_++;
+        advance();
+        return e;
+    }
+    case TokenType::STAR: {
+        advance();
+        return std::make_unique<Expr>(ExprType::STAR);
+    }
+    case TokenType::LPAREN: {
+        advance();
+        ExprPtr e = parse_expr();
+        if (!e || !expect(TokenType::RPAREN)) return nullptr;
+        return e;
+    }
+    case TokenType::IDENT: {
+        std::string_view first = cur_.text;
+        advance();
+        if (accept(TokenType::LPAREN)) {
+            auto e = std::make_unique<Expr>(ExprType::FUNCTION);
+            e->name = upper(first);
+            if (cur_.type != TokenType::RPAREN) {
+                do {
+                    ExprPtr a = parse_expr();
+                    if (!a) return nullptr;
+                    e->args.push_back(std::move(a));
+                } while (accept(TokenType::COMMA));
+            }
+            if (!expect(TokenType::RPAREN)) return nullptr;
+            return e;
+        }
+        auto e = std::make_unique<Expr>(ExprType::COLUMN);
+        if (accept(TokenType::DOT)) {
+            e->table.assign(first);
+            if (!identifier(e->name)) return nullptr;
+        } else {
+            e->name.assign(first);
+        }
+        return e;
+    }
+    case TokenType::ERROR:
+        fail("invalid token");
+        return nullptr;
+    default:
+        fail("expected expression");
+        return nullptr;
+    }
+}
+
+bool sql::parse(std::string_view sql, Statement &out, std::string &err) {
+    Parser p(sql);
+    return p.parse(out, err);
+}
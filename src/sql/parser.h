@@ -0,0 +1,74 @@
+#pragma once
+
+#include "src/sql/ast.h"
+#include "src/sql/lexer.h"
+
+#include <string>
+#include <string_view>
+
+namespace sql {
+
+// Recursive-descent parser over the on-demand Lexer (one token of lookahead).
+//
+// Grammar (keywords case-insensitive, trailing ';' optional):
+//   SELECT items FROM table [[AS] alias]
+//          [[INNER | LEFT [OUTER]] JOIN table [[AS] alias] ON expr]...
+//          [WHERE expr] [GROUP BY expr, ...]
+//          [ORDER BY expr [ASC|DESC], ...] [LIMIT n [OFFSET n]]
+//   INSERT INTO table [(col, ...)] VALUES (expr, ...) [, (expr, ...)]...
+//   UPDATE table SET col = expr, ... [WHERE expr]
+//   DELETE FROM table [WHERE expr]
+//   CREATE TABLE name (col type, ...)
+//   CREATE INDEX name ON table (col) [USING HASH]
+//   PREPARE name AS <statement>      (statement may contain ? parameters)
+//   EXECUTE name [(expr, ...)]
+//   DEALLOCATE name
+//
+// Expressions: OR < AND < NOT < comparison < + - < * / < unary - < primary.
+// Comparisons also include [NOT] BETWEEN a AND b, [NOT] IN (a, ...) and
+// [NOT] LIKE pattern.
+// Strings may use '...' or "..." (the latter is kept for older scripts).
+class Parser {
+public:
+    explicit Parser(std::string_view sql);
+
+    bool parse(Statement &out, std::string &err);
+
+private:
+    Lexer lexer_;
+    Token cur_;
+    std::string err_;
+    int params_ = 0;
+
+    void advance() { cur_ = lexer_.next(); }
+    bool fail(const std::string &msg);
+    bool accept(TokenType t);
+    bool accept(Keyword k);
+    bool expect(TokenType t);
+    bool expect(Keyword k, const char *what);
+    bool identifier(std::string &out);
+    bool integer(int64_t &out);
+    bool table_ref(TableRef &out);
+
+    bool parse_select(Statement &out);
+    bool parse_insert(Statement &out);
+    bool parse_update(Statement &out);
+    bool parse_delete(Statement &out);
+    bool parse_create(Statement &out);
+    bool parse_prepare(Statement &out);
+    bool parse_explain(Statement &out);
+    bool parse_execute(Statement &out);
+
+    ExprPtr parse_expr();
+    ExprPtr parse_and();
+    ExprPtr parse_not();
+    ExprPtr parse_comparison();
+    ExprPtr parse_additive();
+    ExprPtr parse_multiplicative();
+    ExprPtr parse_unary();
+    ExprPtr parse_primary();
+};
+
+bool parse(std::string_view sql, Statement &out, std::string &err);
+
+} // namespace sql
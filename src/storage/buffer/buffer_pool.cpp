@@ -2,9 +2,47 @@
 #include "src/storage/buffer/buffer_pool.h"
 #include <stdexcept>
 #include <cassert>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 using namespace storage;
 
+// Identical stretches shorter than this do not end a delta run (a run costs 4 bytes)
+static constexpr size_t DELTA_GAP = 8;
+
+// Redo payload turning `before` into `after`: runs of [offset u16][len u16][bytes]
+static std::string page_delta(const Page &before, const Page &after) {
+    const char *a = reinterpret_cast<const char *>(&before);
+    const char *b = reinterpret_cast<const char *>(&after);
+    std::string out;
+    size_t i = 0;
+    while (i < PAGE_SIZE) {
+        if (i + 8 <= PAGE_SIZE && std::memcmp(a + i, b + i, 8) == 0) {
+            i += 8;
+            continue;
+        }
+        if (a[i] == b[i]) {
+            i++;
+            continue;
+        }
+        size_t end = i + 1;
+        for (size_t j = end, same = 0; j < PAGE_SIZE && same < DELTA_GAP; ++j) {
+            if (a[j] == b[j]) {
+                same++;
+            } else {
+                same = 0;
+                end = j + 1;
+            }
+        }
+        uint16_t run[2] = {static_cast<uint16_t>(i), static_cast<uint16_t>(end - i)};
+        out.append(reinterpret_cast<const char *>(run), sizeof(run));
+        out.append(b + i, end - i);
+        i = end;
+    }
+    return out;
+}
+
 uint64_t BufferPool::page_key(const PageId &pid) {
     return (static_cast<uint64_t>(pid.segment_id) << 32) | pid.page_number;
 }
@@ -22,55 +60,119 @@ void BufferPool::touch_locked(const PageId &pid) {
     lru_pos_[key] = lru_list_.begin();
 }
 
-void BufferPool::evict_if_needed_locked() {
-    if (table_.size() < pool_size_) return;
-
-    // find victim from LRU tail
-    for (auto it = lru_list_.rbegin(); it != lru_list_.rend(); ++it) {
-        uint64_t key = *it;
-        auto f_it = table_.find(key);
-        if (f_it == table_.end()) continue; // should not happen, but guard
-        Frame &f = f_it->second;
-        if (f.pin_count == 0) {
-            // flush and remove
-            if (f.dirty) {
-                // flush outside lock? we flush while holding lock for simplicity here.
-                sm_.write_page(f.page);
-                f.dirty = false;
-            }
-            // remove from structures
-            auto lit = lru_pos_.find(key);
-            if (lit != lru_pos_.end()) {
-                lru_list_.erase(lit->second);
-                lru_pos_.erase(lit);
+bool BufferPool::evict_if_needed(std::unique_lock<std::mutex> &lk) {
+    while (table_.size() >= pool_size_) {
+        // find victim from LRU tail
+        auto victim = table_.end();
+        for (auto it = lru_list_.rbegin(); it != lru_list_.rend(); ++it) {
+            auto f_it = table_.find(*it);
+            if (f_it == table_.end()) continue; // should not happen, but guard
+            const Frame &f = f_it->second;
+            if (f.pin_count == 0 && !f.loading && !f.evicting) {
+                victim = f_it;
+                break;
             }
-            table_.erase(f_it);
-            return;
         }
+        if (victim == table_.end()) {
+            if (evicting_ == 0) throw std::runtime_error("BufferPool full: no evictable page");
+            // a page on its way out leaves room
+            loaded_cv_.wait(lk);
+            continue;
+        }
+
+        uint64_t key = victim->first;
+        Frame &f = victim->second;
+        auto lit = lru_pos_.find(key);
+        if (lit != lru_pos_.end()) {
+            lru_list_.erase(lit->second);
+            lru_pos_.erase(lit);
+        }
+        if (!f.dirty) {
+            before_.erase(key);
+            unlogged_.erase(key);
+            table_.erase(victim);
+            return false;
+        }
+
+        // the log force and the write go on without the pool: the frame
+        // stays, as a placeholder pin() waits on, until the page is on disk
+        if (wal_) log_page_locked(key, f);
+        before_.erase(key);
+        unlogged_.erase(key);
+        f.evicting = true;
+        evicting_++;
+        lk.unlock();
+        try {
+            if (wal_) wal_->flush(f.page.lsn());
+            sm_.write_page(f.page);
+        } catch (...) {
+            lk.lock();
+            f.evicting = false;
+            evicting_--;
+            lru_list_.push_back(key);
+            lru_pos_[key] = std::prev(lru_list_.end());
+            loaded_cv_.notify_all();
+            throw;
+        }
+        lk.lock();
+        table_.erase(key);
+        evicting_--;
+        loaded_cv_.notify_all();
+        return true;
     }
-    throw std::runtime_error("BufferPool full: no evictable page");
+    return false;
 }
 
 Frame* BufferPool::fetch_page(const PageId &pid, bool for_write) {
+    Frame *f = pin(pid);
+    latch(f, for_write);
+    return f;
+}
+
+void BufferPool::latch(Frame *f, bool for_write) {
+    if (!for_write) {
+        f->latch->lock_shared();
+        return;
+    }
+    f->latch->lock();
+    f->exclusive = true;
+    // copied once the writer before us has left the page
+    std::lock_guard<std::mutex> lg(mu_);
+    capture_locked(page_key(f->page.id()), *f);
+}
+
+Frame* BufferPool::pin(const PageId &pid) {
     uint64_t key = page_key(pid);
 
     {   // scope lock for metadata
-        std::lock_guard<std::mutex> lg(mu_);
-        auto it = table_.find(key);
-        if (it != table_.end()) {
-            // found in cache
-            it->second.pin_count++;
-            touch_locked(pid);
-            return &it->second;
+        std::unique_lock<std::mutex> lk(mu_);
+        for (;;) {
+            auto it = table_.find(key);
+            // another thread is reading or writing out this page: wait, then
+            // look again (the placeholder is dropped if the page turned out
+            // not to exist, the victim once it is on disk)
+            if (it != table_.end() && (it->second.loading || it->second.evicting)) {
+                loaded_cv_.wait(lk);
+                continue;
+            }
+            if (it != table_.end()) {
+                // found in cache
+                thread_io().hits++;
+                it->second.pin_count++;
+                touch_locked(pid);
+                return &it->second;
+            }
+            // ensure space for insertion; if that let go of the pool, the page
+            // may have come in meanwhile
+            if (!evict_if_needed(lk)) break;
         }
-
-        // ensure space for insertion
-        evict_if_needed_locked();
+        thread_io().misses++;
 
         // create placeholder Frame in map so pointer remains stable while we unlock
         Frame placeholder;
         placeholder.dirty = false;
         placeholder.pin_count = 1;
+        placeholder.loading = true;
         // page will be filled below after reading from disk
         table_.emplace(key, std::move(placeholder));
         // record LRU position
@@ -80,13 +182,20 @@ Frame* BufferPool::fetch_page(const PageId &pid, bool for_write) {
 
     // Now load page content from disk (do this outside lock to avoid blocking others).
     Page p;
-    bool loaded = true;
     try {
         p = sm_.read_page(pid);
     } catch (const std::out_of_range &) {
-        // page missing => new blank page
-        p.reset(pid, PageType::TABLE_HEAP);
-        loaded = false;
+        // page missing => drop the placeholder and let the caller decide
+        // (scans stop here, writers go through fetch_or_allocate_page)
+        std::lock_guard<std::mutex> lg(mu_);
+        auto lit = lru_pos_.find(key);
+        if (lit != lru_pos_.end()) {
+            lru_list_.erase(lit->second);
+            lru_pos_.erase(lit);
+        }
+        table_.erase(key);
+        loaded_cv_.notify_all();
+        throw;
     }
 
     // assign loaded page into map entry
@@ -95,21 +204,27 @@ Frame* BufferPool::fetch_page(const PageId &pid, bool for_write) {
         auto it = table_.find(key);
         assert(it != table_.end());
         it->second.page = std::move(p);
-        it->second.dirty = !loaded; // if newly allocated in memory, mark dirty so it'll be written
+        it->second.dirty = false;
         it->second.pin_count = 1;   // ensure pin_count is 1
+        it->second.loading = false;
+        loaded_cv_.notify_all();
         return &it->second;
     }
 }
 
 Frame* BufferPool::fetch_or_allocate_page(const PageId &pid, bool for_write) {
     // The semantic: if page exists, return; otherwise allocate a fresh page at that page_number
-    // We'll try fetch_page first — if it gives a blank page (created in memory) we accept it.
-    try {
-        return fetch_page(pid, for_write);
-    } catch (...) {
-        // fallback: allocate at requested segment (this shouldn't normally happen with current fetch_page)
-        std::lock_guard<std::mutex> lg(mu_);
-        evict_if_needed_locked();
+    Frame *frame = nullptr;
+    while (!frame) {
+        try {
+            return fetch_page(pid, for_write);
+        } catch (const std::out_of_range &) {
+        }
+
+        // page is not on disk yet: allocate it at the end of the segment,
+        // unless another thread did so meanwhile (then fetch that one)
+        std::unique_lock<std::mutex> lk(mu_);
+        if (sm_.page_count(pid.segment_id) > pid.page_number || evict_if_needed(lk)) continue;
         PageId newpid = sm_.allocate_page(pid.segment_id);
         if (newpid.page_number != pid.page_number) {
             throw std::runtime_error("fetch_or_allocate_page: allocation mismatch");
@@ -119,42 +234,184 @@ Frame* BufferPool::fetch_or_allocate_page(const PageId &pid, bool for_write) {
         f.page.reset(newpid, PageType::TABLE_HEAP);
         f.dirty = true;
         f.pin_count = 1;
+        if (wal_) {
+            uint16_t type = f.page.hdr.type;
+            f.page.set_lsn(wal_->append(WalRecord{WalType::PAGE_INIT, newpid.segment_id, newpid.page_number,
+                                                  std::string(reinterpret_cast<const char *>(&type), sizeof(type))}));
+            imaged_.insert(key);
+        }
         table_[key] = std::move(f);
+        capture_locked(key, table_[key]);
         lru_list_.push_front(key);
         lru_pos_[key] = lru_list_.begin();
-        return &table_[key];
+        frame = &table_[key];
     }
+    latch(frame, for_write);
+    return frame;
 }
 
 void BufferPool::unpin_page(Frame *frame, bool is_dirty) {
-    std::lock_guard<std::mutex> lg(mu_);
     if (!frame) return;
+    // the pin keeps the frame in place until the latch is released
+    if (frame->exclusive) {
+        frame->exclusive = false;
+        frame->latch->unlock();
+    } else {
+        frame->latch->unlock_shared();
+    }
+    std::lock_guard<std::mutex> lg(mu_);
     if (is_dirty) frame->dirty = true;
+    if (is_dirty && wal_) {
+        uint64_t key = page_key(frame->page.id());
+        if (!before_.count(key)) unlogged_.insert(key);
+    }
     frame->pin_count = std::max(0, frame->pin_count - 1);
 }
 
 void BufferPool::flush_page(Frame *frame) {
     if (!frame) return;
     std::lock_guard<std::mutex> lg(mu_);
-    if (frame->dirty) {
-        sm_.write_page(frame->page);
-        frame->dirty = false;
+    if (frame->dirty) write_frame_locked(page_key(frame->page.id()), *frame);
+}
+
+void BufferPool::flush_all() {
+    std::unique_lock<std::mutex> lk(mu_);
+    // a page being evicted is written already, but maybe not before the sync
+    loaded_cv_.wait(lk, [&] { return evicting_ == 0; });
+    if (wal_) {
+        // one log force for all pages instead of one per page
+        std::vector<uint64_t> keys;
+        for (const auto &kv : before_) keys.push_back(kv.first);
+        keys.insert(keys.end(), unlogged_.begin(), unlogged_.end());
+        for (uint64_t key : keys) log_page_locked(key, table_.at(key));
+        wal_->flush(wal_->end_lsn());
+    }
+    for (auto &kv : table_) {
+        if (kv.second.dirty) write_frame_locked(kv.first, kv.second);
     }
 }
 
-PageId BufferPool::allocate_page(uint32_t segment_id) {
-    // allocate a new page on disk (sm_ will append) then insert into bufferpool
-    PageId pid = sm_.allocate_page(segment_id);
+void BufferPool::checkpoint() {
+    flush_all();
+    sm_.sync();
+    if (!wal_) return;
+    wal_->reset();
+    std::lock_guard<std::mutex> lg(mu_);
+    imaged_.clear();
+}
 
+void BufferPool::truncate_segment(uint32_t segment_id, uint32_t pages) {
+    std::unique_lock<std::mutex> lk(mu_);
+    // no eviction may write past the new end after it
+    loaded_cv_.wait(lk, [&] { return evicting_ == 0; });
+    for (auto it = table_.begin(); it != table_.end();) {
+        if (static_cast<uint32_t>(it->first >> 32) != segment_id || static_cast<uint32_t>(it->first) < pages) {
+            ++it;
+            continue;
+        }
+        if (it->second.pin_count > 0) throw std::runtime_error("truncate_segment: page is pinned");
+        auto lit = lru_pos_.find(it->first);
+        if (lit != lru_pos_.end()) {
+            lru_list_.erase(lit->second);
+            lru_pos_.erase(lit);
+        }
+        before_.erase(it->first);
+        unlogged_.erase(it->first);
+        it = table_.erase(it);
+    }
+    for (auto it = imaged_.begin(); it != imaged_.end();) {
+        bool cut = static_cast<uint32_t>(*it >> 32) == segment_id && static_cast<uint32_t>(*it) >= pages;
+        it = cut ? imaged_.erase(it) : std::next(it);
+    }
+    // the file shrinks right away, so its record must be durable first
+    if (wal_) wal_->flush(wal_->append(WalRecord{WalType::TRUNCATE, segment_id, pages, {}}));
+    sm_.truncate(segment_id, pages);
+}
+
+Lsn BufferPool::log_changes() {
+    if (!wal_) return 0;
+    // pin the changed pages, then diff each under a shared latch: another
+    // session may be half way through writing it
+    std::vector<std::pair<uint64_t, Frame *>> pages;
+    {
+        std::lock_guard<std::mutex> lg(mu_);
+        for (const auto &kv : before_) pages.emplace_back(kv.first, &table_.at(kv.first));
+        for (uint64_t key : unlogged_) pages.emplace_back(key, &table_.at(key));
+        for (auto &p : pages) p.second->pin_count++;
+    }
+    Lsn last = 0;
+    for (auto &[key, f] : pages) {
+        f->latch->lock_shared();
+        {
+            std::lock_guard<std::mutex> lg(mu_);
+            last = std::max(last, log_page_locked(key, *f));
+        }
+        f->latch->unlock_shared();
+    }
     std::lock_guard<std::mutex> lg(mu_);
-    evict_if_needed_locked();
+    for (auto &p : pages) p.second->pin_count--;
+    return last;
+}
+
+void BufferPool::capture_locked(uint64_t key, const Frame &f) {
+    if (wal_ && !before_.count(key) && !unlogged_.count(key)) before_.emplace(key, std::make_unique<Page>(f.page));
+}
+
+Lsn BufferPool::log_page_locked(uint64_t key, Frame &f) {
+    WalRecord rec;
+    rec.segment_id = f.page.hdr.segment_id;
+    rec.page_number = f.page.hdr.page_number;
+    auto it = before_.find(key);
+    bool copied = it != before_.end();
+    if (copied) {
+        rec.type = WalType::PAGE_DELTA;
+        rec.payload = page_delta(*it->second, f.page);
+        before_.erase(it);
+        if (rec.payload.empty()) return 0;
+    } else if (!unlogged_.erase(key)) {
+        return 0;
+    }
+    // the first record of a page since the checkpoint is the whole page:
+    // redo rebuilds it from there even if a crash tore its last write
+    if (imaged_.insert(key).second || !copied) {
+        rec.type = WalType::PAGE_IMAGE;
+        rec.payload.assign(reinterpret_cast<const char *>(&f.page), sizeof(Page));
+    }
+    Lsn lsn = wal_->append(rec);
+    f.page.set_lsn(lsn);
+    return lsn;
+}
+
+void BufferPool::write_frame_locked(uint64_t key, Frame &f) {
+    if (wal_) {
+        log_page_locked(key, f);
+        wal_->flush(f.page.lsn());
+    }
+    sm_.write_page(f.page);
+    f.dirty = false;
+}
+
+PageId BufferPool::allocate_page(uint32_t segment_id) {
+    // allocate a new page on disk (sm_ will append) then insert into bufferpool;
+    // under the lock, so nobody reads the blank page from disk in between
+    std::unique_lock<std::mutex> lk(mu_);
+    while (evict_if_needed(lk)) {
+    }
+    PageId pid = sm_.allocate_page(segment_id);
 
     uint64_t key = page_key(pid);
     Frame f;
     f.page.reset(pid, PageType::TABLE_HEAP);
     f.dirty = true;   // newly allocated, must be persisted (sm_.allocate_page already created on disk, but we mark dirty in memory)
-    f.pin_count = 1;
+    f.pin_count = 0;  // cached but not pinned: callers fetch_page() the returned id
+    if (wal_) {
+        uint16_t type = f.page.hdr.type;
+        f.page.set_lsn(wal_->append(WalRecord{WalType::PAGE_INIT, pid.segment_id, pid.page_number,
+                                              std::string(reinterpret_cast<const char *>(&type), sizeof(type))}));
+        imaged_.insert(key);
+    }
     table_[key] = std::move(f);
+    capture_locked(key, table_[key]);
     lru_list_.push_front(key);
     lru_pos_[key] = lru_list_.begin();
     return pid;
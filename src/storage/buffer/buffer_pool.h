@@ -1,9 +1,14 @@
 #pragma once
 #include "src/storage/page/page.h"
 #include "src/storage/segment/segment_manager.h"
+#include "src/storage/wal/wal.h"
 #include <list>
+#include <memory>
+#include <unordered_set>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
 
 namespace storage {
 
@@ -11,17 +16,50 @@ namespace storage {
         Page page;
         bool dirty;
         int pin_count;
+        bool loading = false;   // placeholder whose page is still being read
+        bool evicting = false;  // victim whose page is still being written out
+        // Page latch, held while the page is pinned: shared by readers,
+        // exclusive for the one writer. Taken after the pin, outside the
+        // pool's mutex, so a thread waiting for it holds up nobody else.
+        std::unique_ptr<std::shared_mutex> latch = std::make_unique<std::shared_mutex>();
+        bool exclusive = false;   // latch held by a writer
     };
 
     class BufferPool {
     public:
+        // appends a blank page to the segment and caches it (unpinned)
         PageId allocate_page(uint32_t segment_id);
         
         BufferPool(size_t pool_size, SegmentManager &sm);
+        // Pin and latch a page: shared, or exclusive `for_write`; unpin_page
+        // releases both. Latches are not recursive: a thread must not fetch
+        // a page it holds. Throws std::out_of_range if the page does not
+        // exist on disk.
         Frame* fetch_page(const PageId &pid, bool for_write = false);
         Frame* fetch_or_allocate_page(const PageId &pid, bool for_write = false);
         void unpin_page(Frame *frame, bool is_dirty);
         void flush_page(Frame *frame);
+        void flush_all();
+        // cut a segment down to `pages` pages; cached pages beyond are dropped
+        // (they must be unpinned)
+        void truncate_segment(uint32_t segment_id, uint32_t pages);
+        uint32_t page_count(uint32_t segment_id) { return sm_.page_count(segment_id); }
+        SegmentManager &segment_manager() { return sm_; }
+
+        // Write-ahead logging. Once a log is attached, a page fetched for write
+        // is copied as it was; log_changes() turns each such page into a redo
+        // record (the changed byte ranges) and stamps the record's LSN on it.
+        // A dirty page reaches disk only after the log is durable up to its LSN.
+        // Full-page writes: a page's first record after a checkpoint is the
+        // whole page (PAGE_IMAGE), so a write the crash tore is redone from it.
+        void attach_wal(Wal *wal) { wal_ = wal; }
+        Wal *wal() const { return wal_; }
+        // log every change since the last call; returns the last LSN (0 = none).
+        // Each page is logged under its latch: the caller must hold none.
+        Lsn log_changes();
+        // Write every dirty page, sync the segment files and empty the log.
+        // Callers keep writers out meanwhile.
+        void checkpoint();
 
     private:
         size_t pool_size_;
@@ -33,8 +71,22 @@ namespace storage {
         std::unordered_map<uint64_t, std::list<uint64_t>::iterator> lru_pos_;
 
         std::mutex mu_;
+        std::condition_variable loaded_cv_;   // signalled when a placeholder is filled or dropped
+        size_t evicting_ = 0;                 // frames being written out with mu_ released
+
+        Wal *wal_ = nullptr;
+        std::unordered_map<uint64_t, std::unique_ptr<Page>> before_;   // page as of its last log record
+        std::unordered_set<uint64_t> unlogged_;   // dirtied without a copy: logged as a full image
+        std::unordered_set<uint64_t> imaged_;     // logged whole (or PAGE_INIT) since the checkpoint
 
-        void evict_if_needed_locked(); // expects mu_ held
+        Frame *pin(const PageId &pid);    // fetch_page without the latch
+        void latch(Frame *f, bool for_write);
+        // make room for one more frame; `lk` holds mu_. A dirty victim is
+        // written with mu_ released: true if it was, and the caller looks again
+        bool evict_if_needed(std::unique_lock<std::mutex> &lk);
+        void capture_locked(uint64_t key, const Frame &f);
+        Lsn log_page_locked(uint64_t key, Frame &f);
+        void write_frame_locked(uint64_t key, Frame &f);   // WAL rule, then write
         static uint64_t page_key(const PageId &pid);
         void touch_locked(const PageId &pid); // move to front; expects mu_ held
     };
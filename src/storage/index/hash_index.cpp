@@ -0,0 +1,283 @@
+#include "src/storage/index/hash_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace storage;
+
+// Meta page layout (Page::data): [magic u32][global_depth u32][dir page count u32][dir pages u32...]
+static constexpr uint32_t META_HEADER = 3 * sizeof(uint32_t);
+
+HashIndex::HashIndex(BufferPool &bp, uint32_t segment_id)
+    : bp_(bp), segment_id_(segment_id) {
+    if (bp_.page_count(segment_id_) == 0) {
+        init_empty();
+    } else {
+        load_meta();
+    }
+}
+
+uint64_t HashIndex::HashValue(const Value &v) {
+    if (v.type() == ValueType::INT) {
+        // splitmix64 finalizer: spreads sequential ids over the low bits
+        uint64_t x = static_cast<uint64_t>(static_cast<int64_t>(v.as_int()));
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+    // FNV-1a, stable across runs and platforms (std::hash is not)
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (unsigned char c : v.as_text()) {
+        h ^= c;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+//
+// ------------------------- META / DIRECTORY ---------------------
+//
+void HashIndex::init_empty() {
+    PageId meta = bp_.allocate_page(segment_id_);
+    if (meta.page_number != 0) throw std::runtime_error("hash index: meta page must be page 0");
+
+    PageId dir = bp_.allocate_page(segment_id_);
+    dir_pages_.assign(1, dir.page_number);
+    global_depth_ = 0;
+
+    uint32_t bucket = new_bucket(0);
+    dir_set(0, bucket);
+    store_meta();
+}
+
+void HashIndex::load_meta() {
+    Frame *f = bp_.fetch_page(PageId{segment_id_, 0});
+    uint32_t hdr[3];
+    std::memcpy(hdr, f->page.data, META_HEADER);
+    if (hdr[0] != META_MAGIC) {
+        bp_.unpin_page(f, false);
+        throw std::runtime_error("hash index: bad meta page in segment " + std::to_string(segment_id_));
+    }
+    global_depth_ = hdr[1];
+    dir_pages_.resize(hdr[2]);
+    std::memcpy(dir_pages_.data(), f->page.data + META_HEADER, hdr[2] * sizeof(uint32_t));
+    bp_.unpin_page(f, false);
+}
+
+void HashIndex::store_meta() {
+    Frame *f = bp_.fetch_page(PageId{segment_id_, 0}, true);
+    f->page.hdr.type = static_cast<uint16_t>(PageType::INDEX_INTERNAL);
+    uint32_t hdr[3] = {META_MAGIC, global_depth_, static_cast<uint32_t>(dir_pages_.size())};
+    std::memcpy(f->page.data, hdr, META_HEADER);
+    std::memcpy(f->page.data + META_HEADER, dir_pages_.data(), dir_pages_.size() * sizeof(uint32_t));
+    bp_.unpin_page(f, true);
+}
+
+uint32_t HashIndex::dir_get(uint32_t slot) {
+    Frame *f = bp_.fetch_page(PageId{segment_id_, dir_pages_[slot / DIR_SLOTS_PER_PAGE]});
+    uint32_t bucket = 0;
+    std::memcpy(&bucket, f->page.data + (slot % DIR_SLOTS_PER_PAGE) * sizeof(uint32_t), sizeof(uint32_t));
+    bp_.unpin_page(f, false);
+    return bucket;
+}
+
+void HashIndex::dir_set(uint32_t slot, uint32_t bucket_page) {
+    Frame *f = bp_.fetch_page(PageId{segment_id_, dir_pages_[slot / DIR_SLOTS_PER_PAGE]}, true);
+    f->page.hdr.type = static_cast<uint16_t>(PageType::INDEX_INTERNAL);
+    std::memcpy(f->page.data + (slot % DIR_SLOTS_PER_PAGE) * sizeof(uint32_t), &bucket_page, sizeof(uint32_t));
+    bp_.unpin_page(f, true);
+}
+
+void HashIndex::double_directory() {
+    uint32_t old_size = 1u << global_depth_;
+    uint32_t new_size = old_size << 1;
+    uint32_t pages_needed = (new_size + DIR_SLOTS_PER_PAGE - 1) / DIR_SLOTS_PER_PAGE;
+    while (dir_pages_.size() < pages_needed) {
+        dir_pages_.push_back(bp_.allocate_page(segment_id_).page_number);
+    }
+    // the new upper half mirrors the lower half until buckets split
+    for (uint32_t i = 0; i < old_size; ++i) {
+        dir_set(old_size + i, dir_get(i));
+    }
+    global_depth_++;
+    store_meta();
+}
+
+//
+// ------------------------- BUCKETS -------------------------------
+//
+uint32_t HashIndex::new_bucket(uint32_t local_depth) {
+    PageId pid = bp_.allocate_page(segment_id_);
+    Frame *f = bp_.fetch_page(pid, true);
+    f->page.hdr.type = static_cast<uint16_t>(PageType::INDEX_LEAF);
+    BucketHeader bh{local_depth, 0, 0, 0};
+    std::memcpy(f->page.data, &bh, sizeof(bh));
+    bp_.unpin_page(f, true);
+    return pid.page_number;
+}
+
+std::vector<HashIndex::Entry> HashIndex::chain_entries(uint32_t bucket_page) {
+    std::vector<Entry> out;
+    for (uint32_t page = bucket_page; page != 0;) {
+        Frame *f = bp_.fetch_page(PageId{segment_id_, page});
+        BucketHeader bh;
+        std::memcpy(&bh, f->page.data, sizeof(bh));
+        size_t had = out.size();
+        out.resize(had + bh.count);
+        std::memcpy(out.data() + had, f->page.data + sizeof(bh), bh.count * sizeof(Entry));
+        bp_.unpin_page(f, false);
+        page = bh.overflow;
+    }
+    return out;
+}
+
+void HashIndex::fill_chain(uint32_t bucket_page, uint32_t local_depth, const std::vector<Entry> &entries) {
+    // pages left over stay linked, empty, for the bucket to grow into
+    size_t done = 0;
+    for (uint32_t page = bucket_page; page != 0;) {
+        Frame *f = bp_.fetch_page(PageId{segment_id_, page}, true);
+        BucketHeader bh;
+        std::memcpy(&bh, f->page.data, sizeof(bh));
+        bh.local_depth = local_depth;
+        bh.count = static_cast<uint32_t>(std::min<size_t>(BUCKET_CAPACITY, entries.size() - done));
+        std::memcpy(f->page.data + sizeof(bh), entries.data() + done, bh.count * sizeof(Entry));
+        done += bh.count;
+        if (done < entries.size() && bh.overflow == 0) bh.overflow = new_bucket(local_depth);
+        std::memcpy(f->page.data, &bh, sizeof(bh));
+        bp_.unpin_page(f, true);
+        page = bh.overflow;
+    }
+}
+
+void HashIndex::split_bucket(uint32_t slot, uint32_t bucket_page, const std::vector<Entry> &entries) {
+    Frame *f = bp_.fetch_page(PageId{segment_id_, bucket_page});
+    BucketHeader bh;
+    std::memcpy(&bh, f->page.data, sizeof(bh));
+    bp_.unpin_page(f, false);
+    uint32_t ld = bh.local_depth;
+
+    // keep entries whose bit `ld` is 0, move the rest to the sibling
+    std::vector<Entry> keep, move;
+    for (const Entry &e : entries) ((e.hash >> ld) & 1u ? move : keep).push_back(e);
+    uint32_t sibling = new_bucket(ld + 1);
+    fill_chain(bucket_page, ld + 1, keep);
+    fill_chain(sibling, ld + 1, move);
+
+    // repoint the directory slots that share the old low `ld` bits and have bit `ld` set
+    uint32_t base = slot & ((1u << ld) - 1);
+    for (uint32_t i = base; i < (1u << global_depth_); i += (1u << ld)) {
+        if ((i >> ld) & 1u) dir_set(i, sibling);
+    }
+}
+
+void HashIndex::append_overflow(uint32_t bucket_page, const Entry &e) {
+    // the first page with room, else a new page at the end of the chain
+    uint32_t page = bucket_page;
+    while (true) {
+        Frame *f = bp_.fetch_page(PageId{segment_id_, page}, true);
+        BucketHeader bh;
+        std::memcpy(&bh, f->page.data, sizeof(bh));
+        if (bh.count < BUCKET_CAPACITY) {
+            std::memcpy(f->page.data + sizeof(bh) + bh.count++ * sizeof(Entry), &e, sizeof(Entry));
+            std::memcpy(f->page.data, &bh, sizeof(bh));
+            bp_.unpin_page(f, true);
+            return;
+        }
+        if (bh.overflow == 0) {
+            bh.overflow = new_bucket(bh.local_depth);
+            std::memcpy(f->page.data, &bh, sizeof(bh));
+            bp_.unpin_page(f, true);
+        } else {
+            bp_.unpin_page(f, false);
+        }
+        page = bh.overflow;
+    }
+}
+
+//
+// ------------------------- PUBLIC API ----------------------------
+//
+void HashIndex::Insert(uint64_t key_hash, const RecordId &rid) {
+    std::lock_guard<std::mutex> lg(mu_);
+    Entry e{key_hash, rid.page_number, rid.offset};
+
+    while (true) {
+        uint32_t slot = static_cast<uint32_t>(key_hash & ((1ull << global_depth_) - 1));
+        uint32_t bucket = dir_get(slot);
+
+        Frame *f = bp_.fetch_page(PageId{segment_id_, bucket}, true);
+        BucketHeader bh;
+        std::memcpy(&bh, f->page.data, sizeof(bh));
+        if (bh.count < BUCKET_CAPACITY) {
+            std::memcpy(f->page.data + sizeof(bh) + bh.count++ * sizeof(Entry), &e, sizeof(Entry));
+            std::memcpy(f->page.data, &bh, sizeof(bh));
+            bp_.unpin_page(f, true);
+            return;
+        }
+        bp_.unpin_page(f, false);
+
+        // a split that leaves every entry on one side only doubles the
+        // directory: chain instead (duplicate keys end up here)
+        std::vector<Entry> entries = chain_entries(bucket);
+        entries.push_back(e);
+        size_t moving = 0;
+        for (const Entry &x : entries) moving += (x.hash >> bh.local_depth) & 1u;
+        if (moving == 0 || moving == entries.size() ||
+            (bh.local_depth == global_depth_ && global_depth_ == MAX_GLOBAL_DEPTH)) {
+            append_overflow(bucket, e);
+            return;
+        }
+        entries.pop_back();
+        if (bh.local_depth == global_depth_) double_directory();
+        split_bucket(slot, bucket, entries);
+    }
+}
+
+bool HashIndex::Remove(uint64_t key_hash, const RecordId &rid) {
+    std::lock_guard<std::mutex> lg(mu_);
+
+    // buckets do not shrink: the last entry of the page fills the gap
+    uint32_t slot = static_cast<uint32_t>(key_hash & ((1ull << global_depth_) - 1));
+    uint32_t page = dir_get(slot);
+    while (page != 0) {
+        Frame *f = bp_.fetch_page(PageId{segment_id_, page}, true);
+        BucketHeader bh;
+        std::memcpy(&bh, f->page.data, sizeof(bh));
+        char *entries = f->page.data + sizeof(bh);
+        for (uint32_t i = 0; i < bh.count; ++i) {
+            Entry e;
+            std::memcpy(&e, entries + i * sizeof(Entry), sizeof(Entry));
+            if (e.hash != key_hash || e.page_number != rid.page_number || e.offset != rid.offset) continue;
+            bh.count--;
+            std::memmove(entries + i * sizeof(Entry), entries + bh.count * sizeof(Entry), sizeof(Entry));
+            std::memcpy(f->page.data, &bh, sizeof(bh));
+            bp_.unpin_page(f, true);
+            return true;
+        }
+        bp_.unpin_page(f, false);
+        page = bh.overflow;
+    }
+    return false;
+}
+
+std::vector<RecordId> HashIndex::Lookup(uint64_t key_hash) {
+    std::lock_guard<std::mutex> lg(mu_);
+    std::vector<RecordId> out;
+
+    uint32_t slot = static_cast<uint32_t>(key_hash & ((1ull << global_depth_) - 1));
+    uint32_t page = dir_get(slot);
+    while (page != 0) {
+        Frame *f = bp_.fetch_page(PageId{segment_id_, page});
+        BucketHeader bh;
+        std::memcpy(&bh, f->page.data, sizeof(bh));
+        for (uint32_t i = 0; i < bh.count; ++i) {
+            Entry e;
+            std::memcpy(&e, f->page.data + sizeof(bh) + i * sizeof(Entry), sizeof(Entry));
+            if (e.hash == key_hash) out.push_back(RecordId{e.page_number, e.offset});
+        }
+        bp_.unpin_page(f, false);
+        page = bh.overflow;
+    }
+    return out;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/table/table_heap.h"
+#include "src/storage/table/tuple.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace storage {
+
+// Extendible hash index stored in its own segment, mapping 64-bit key hashes
+// to record ids. Page layout:
+//   page 0           meta: global depth + list of directory pages
+//   directory pages  u32 bucket page numbers, DIR_SLOTS_PER_PAGE per page
+//   bucket pages     local depth, entry count, overflow link, entries
+//
+// A lookup reads one directory page and one bucket page. A full bucket is split
+// in two (doubling the directory if needed); other buckets are never rehashed.
+// A bucket the split would not divide (one key repeated, say) grows a chain of
+// overflow pages instead, and a later split divides the whole chain.
+// Keys are stored as hashes only, so callers must re-check the row they fetch.
+class HashIndex {
+public:
+    HashIndex(BufferPool &bp, uint32_t segment_id);
+
+    void Insert(uint64_t key_hash, const RecordId &rid);
+    // drop one (key_hash, rid) entry; false if there was none
+    bool Remove(uint64_t key_hash, const RecordId &rid);
+    std::vector<RecordId> Lookup(uint64_t key_hash);
+
+    static uint64_t HashValue(const Value &v);
+
+    uint32_t global_depth() const { return global_depth_; }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        uint32_t page_number;
+        uint32_t offset;
+    };
+
+    struct BucketHeader {
+        uint32_t local_depth;
+        uint32_t count;
+        uint32_t overflow; // 0 = none (page 0 is always the meta page)
+        uint32_t reserved;
+    };
+
+    static constexpr uint32_t META_MAGIC = 0x48494458; // "HIDX"
+    static constexpr uint32_t MAX_GLOBAL_DEPTH = 19;
+    static constexpr uint32_t DIR_SLOTS_PER_PAGE = PAGE_PAYLOAD_SIZE / sizeof(uint32_t);
+    static constexpr uint32_t BUCKET_CAPACITY =
+        (PAGE_PAYLOAD_SIZE - sizeof(BucketHeader)) / sizeof(Entry);
+
+    BufferPool &bp_;
+    uint32_t segment_id_;
+    std::mutex mu_;
+
+    // cached copy of the meta page
+    uint32_t global_depth_ = 0;
+    std::vector<uint32_t> dir_pages_;
+
+    void init_empty();
+    void load_meta();
+    void store_meta();
+
+    uint32_t dir_get(uint32_t slot);
+    void dir_set(uint32_t slot, uint32_t bucket_page);
+    void double_directory();
+
+    uint32_t new_bucket(uint32_t local_depth);
+    // every entry of the bucket starting at `bucket_page`, overflow pages included
+    std::vector<Entry> chain_entries(uint32_t bucket_page);
+    // rewrite the chain starting at `bucket_page` to hold `entries`, adding pages as needed
+    void fill_chain(uint32_t bucket_page, uint32_t local_depth, const std::vector<Entry> &entries);
+    void split_bucket(uint32_t slot, uint32_t bucket_page, const std::vector<Entry> &entries);
+    void append_overflow(uint32_t bucket_page, const Entry &e);
+};
+
+} // namespace storage
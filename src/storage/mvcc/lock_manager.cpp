@@ -0,0 +1,161 @@
+#include "src/storage/mvcc/lock_manager.h"
+
+#include <unordered_set>
+
+using namespace storage;
+
+static constexpr size_t MODES = 5;
+
+// whether two owners may hold a target in these modes at once
+static const bool COMPATIBLE[MODES][MODES] = {
+    //            IS     IX     S      SIX    X
+    /* IS  */ {true,  true,  true,  true,  false},
+    /* IX  */ {true,  true,  false, false, false},
+    /* S   */ {true,  false, true,  false, false},
+    /* SIX */ {true,  false, false, false, false},
+    /* X   */ {false, false, false, false, false},
+};
+
+// the weakest mode covering both
+static const LockMode COMBINED[MODES][MODES] = {
+    {LockMode::IS, LockMode::IX, LockMode::S, LockMode::SIX, LockMode::X},
+    {LockMode::IX, LockMode::IX, LockMode::SIX, LockMode::SIX, LockMode::X},
+    {LockMode::S, LockMode::SIX, LockMode::S, LockMode::SIX, LockMode::X},
+    {LockMode::SIX, LockMode::SIX, LockMode::SIX, LockMode::SIX, LockMode::X},
+    {LockMode::X, LockMode::X, LockMode::X, LockMode::X, LockMode::X},
+};
+
+static bool compatible(LockMode a, LockMode b) {
+    return COMPATIBLE[static_cast<size_t>(a)][static_cast<size_t>(b)];
+}
+
+void LockManager::blockers(const Queue &q, std::list<Request>::const_iterator r, std::vector<TxnId> &out) {
+    bool ahead = true;
+    for (auto it = q.requests.begin(); it != q.requests.end(); ++it) {
+        if (it == r) {
+            ahead = false;
+            continue;
+        }
+        if (it->owner == r->owner) continue;
+        if (it->granted ? !compatible(r->want, it->mode)
+                        : ahead && !r->granted && !compatible(r->want, it->want))
+            out.push_back(it->owner);
+    }
+}
+
+bool LockManager::grantable(const Queue &q, std::list<Request>::const_iterator r) {
+    std::vector<TxnId> in_the_way;
+    blockers(q, r, in_the_way);
+    return in_the_way.empty();
+}
+
+bool LockManager::deadlocked(TxnId owner) {
+    std::vector<TxnId> next;
+    std::unordered_set<TxnId> seen;
+    auto follow = [&](TxnId t) {
+        auto w = waiting_.find(t);
+        if (w == waiting_.end()) return;   // running: its locks are released eventually
+        const Queue &q = queues_.at(w->second);
+        for (auto it = q.requests.begin(); it != q.requests.end(); ++it)
+            if (it->owner == t) blockers(q, it, next);
+    };
+    follow(owner);
+    while (!next.empty()) {
+        TxnId t = next.back();
+        next.pop_back();
+        if (t == owner) return true;
+        if (seen.insert(t).second) follow(t);
+    }
+    return false;
+}
+
+std::list<LockManager::Request>::iterator LockManager::enqueue(Queue &q, TxnId owner, LockMode mode, bool &held) {
+    for (auto it = q.requests.begin(); it != q.requests.end(); ++it) {
+        if (it->owner != owner) continue;
+        LockMode want = COMBINED[static_cast<size_t>(it->mode)][static_cast<size_t>(mode)];
+        held = want == it->mode;
+        it->want = want;
+        return it;
+    }
+    held = false;
+    return q.requests.insert(q.requests.end(), Request{owner, mode, mode, false});
+}
+
+void LockManager::grant(std::list<Request>::iterator r, const LockTarget &target) {
+    if (!r->granted) held_[r->owner].push_back(target);
+    r->granted = true;
+    r->mode = r->want;
+}
+
+void LockManager::withdraw(const LockTarget &target, std::list<Request>::iterator r) {
+    auto q = queues_.find(target);
+    if (r->granted) r->want = r->mode;
+    else q->second.requests.erase(r);
+    if (q->second.requests.empty()) queues_.erase(q);
+    else q->second.cv.notify_all();   // requests behind it may go now
+}
+
+bool LockManager::lock(TxnId owner, const LockTarget &target, LockMode mode, std::string &err) {
+    std::unique_lock<std::mutex> lk(mu_);
+    Queue &q = queues_[target];
+    bool held = false;
+    auto r = enqueue(q, owner, mode, held);
+    if (held) return true;
+
+    if (!grantable(q, r)) {
+        waiting_[owner] = target;
+        if (deadlocked(owner)) {
+            waiting_.erase(owner);
+            withdraw(target, r);
+            err = "deadlock detected";
+            return false;
+        }
+        auto deadline = std::chrono::steady_clock::now() + timeout_;
+        while (!grantable(q, r)) {
+            if (timeout_.count() == 0) {
+                q.cv.wait(lk);
+            } else if (q.cv.wait_until(lk, deadline) == std::cv_status::timeout && !grantable(q, r)) {
+                waiting_.erase(owner);
+                withdraw(target, r);
+                err = "lock wait timed out after " + std::to_string(timeout_.count()) + " ms";
+                return false;
+            }
+        }
+        waiting_.erase(owner);
+    }
+    grant(r, target);
+    return true;
+}
+
+bool LockManager::try_lock(TxnId owner, const LockTarget &target, LockMode mode) {
+    std::lock_guard<std::mutex> lg(mu_);
+    Queue &q = queues_[target];
+    bool held = false;
+    auto r = enqueue(q, owner, mode, held);
+    if (held) return true;
+    if (!grantable(q, r)) {
+        withdraw(target, r);
+        return false;
+    }
+    grant(r, target);
+    return true;
+}
+
+void LockManager::release_all(TxnId owner) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto h = held_.find(owner);
+    if (h == held_.end()) return;
+    for (const LockTarget &target : h->second) {
+        auto q = queues_.find(target);
+        if (q == queues_.end()) continue;
+        auto &requests = q->second.requests;
+        for (auto it = requests.begin(); it != requests.end(); ++it) {
+            if (it->owner != owner) continue;
+            requests.erase(it);
+            break;
+        }
+        if (requests.empty()) queues_.erase(q);
+        else q->second.cv.notify_all();
+    }
+    held_.erase(h);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "src/storage/mvcc/transaction.h"
+#include "src/storage/table/table_heap.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace storage {
+
+// Lock modes. Statements lock a table IS / IX to read / write some of its
+// rows (and then lock those rows S / X), S / X to read / write all of it, and
+// SIX to write any of its rows while other writers stay out.
+enum class LockMode : uint8_t { IS, IX, S, SIX, X };
+
+// A whole table, or one row of it
+struct LockTarget {
+    static constexpr uint64_t TABLE = UINT64_MAX;
+
+    uint32_t segment_id = 0;
+    uint64_t row = TABLE;
+
+    static LockTarget table(uint32_t segment_id) { return LockTarget{segment_id, TABLE}; }
+    static LockTarget of_row(uint32_t segment_id, const RecordId &rid) {
+        return LockTarget{segment_id, (static_cast<uint64_t>(rid.page_number) << 32) | rid.offset};
+    }
+    bool operator==(const LockTarget &o) const { return segment_id == o.segment_id && row == o.row; }
+};
+
+// Table and row locks, held by a transaction until it ends (two-phase).
+// Snapshots keep readers and writers of a row apart; locks order the writers
+// of a row and keep CREATE INDEX and vacuum out of tables in use.
+//
+// Requests are granted in arrival order (raising a held lock goes first). A
+// request that has to wait follows the waits-for edges from the holders in
+// its way: if they lead back to its own transaction, the wait would never
+// end and the request is refused instead. Waits are also cut off after a
+// timeout, which bounds waits the graph cannot see.
+class LockManager {
+public:
+    // a `timeout` of 0 waits for as long as it takes
+    explicit LockManager(std::chrono::milliseconds timeout) : timeout_(timeout) {}
+
+    // Take `target` in `mode` for `owner` (a lock it already holds is raised
+    // to cover both modes), waiting for conflicting holders. False, with the
+    // reason in `err`, on a deadlock or a timeout; the locks held stay held.
+    bool lock(TxnId owner, const LockTarget &target, LockMode mode, std::string &err);
+    // same, but false right away instead of waiting
+    bool try_lock(TxnId owner, const LockTarget &target, LockMode mode);
+    // release every lock of `owner`
+    void release_all(TxnId owner);
+
+private:
+    struct Request {
+        TxnId owner;
+        LockMode mode;   // held (if granted)
+        LockMode want;   // waited for: `mode`, or a stronger one to raise a held lock to
+        bool granted;
+    };
+    // an owner's requests of a target share one entry, kept in arrival order
+    struct Queue {
+        std::list<Request> requests;
+        std::condition_variable cv;
+    };
+    struct TargetHash {
+        size_t operator()(const LockTarget &t) const {
+            return std::hash<uint64_t>()(t.row * 0x9e3779b97f4a7c15ull ^ t.segment_id);
+        }
+    };
+
+    std::chrono::milliseconds timeout_;
+    std::mutex mu_;
+    std::unordered_map<LockTarget, Queue, TargetHash> queues_;
+    std::unordered_map<TxnId, std::vector<LockTarget>> held_;
+    std::unordered_map<TxnId, LockTarget> waiting_;   // what each blocked owner waits for
+
+    // Owners in the way of request `r`: holders of a conflicting mode and,
+    // unless `r` raises a held lock, earlier requests of a conflicting mode
+    static void blockers(const Queue &q, std::list<Request>::const_iterator r, std::vector<TxnId> &out);
+    static bool grantable(const Queue &q, std::list<Request>::const_iterator r);
+    // does waiting close a cycle of owners waiting for each other
+    bool deadlocked(TxnId owner);
+    std::list<Request>::iterator enqueue(Queue &q, TxnId owner, LockMode mode, bool &held);
+    void grant(std::list<Request>::iterator r, const LockTarget &target);
+    // withdraw a request that will not be granted (a raised lock keeps its old mode)
+    void withdraw(const LockTarget &target, std::list<Request>::iterator r);
+};
+
+} // namespace storage
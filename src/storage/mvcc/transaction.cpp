@@ -0,0 +1,165 @@
+#include "src/storage/mvcc/transaction.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace storage;
+
+void AbortedIds::add(TxnId first, TxnId end) {
+    auto it = ranges.insert(std::lower_bound(ranges.begin(), ranges.end(), std::make_pair(first, first)),
+                            std::make_pair(first, end));
+    // join the range before it and the ones it reaches
+    if (it != ranges.begin() && std::prev(it)->second >= first) {
+        --it;
+        it->second = std::max(it->second, end);
+        ranges.erase(it + 1);
+    }
+    while (it + 1 != ranges.end() && (it + 1)->first <= it->second) {
+        it->second = std::max(it->second, (it + 1)->second);
+        ranges.erase(it + 1);
+    }
+}
+
+TransactionManager::TransactionManager(const std::string &dir) {
+    std::string path = dir + "/xid.meta";
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+    TxnId stored = 0;
+    ssize_t r = ::pread(fd_, &stored, sizeof(stored), 0);
+    if (r < 0) throw std::runtime_error("cannot read " + path + ": " + std::strerror(errno));
+    if (r == static_cast<ssize_t>(sizeof(stored)) && stored > 0) next_ = stored;
+    reserved_ = next_;
+
+    path = dir + "/xid.status";
+    status_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (status_fd_ < 0 || ::fstat(status_fd_, &st) != 0)
+        throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+    std::vector<char> buf(static_cast<size_t>(st.st_size));
+    if (::pread(status_fd_, buf.data(), buf.size(), 0) != static_cast<ssize_t>(buf.size()))
+        throw std::runtime_error("cannot read " + path + ": " + std::strerror(errno));
+    if (buf.size() < sizeof(TxnId)) {
+        // new file: the ids of earlier runs all ended before aborts were recorded
+        write_settled_locked(next_);
+        status_end_ = sizeof(TxnId);
+        return;
+    }
+    std::memcpy(&settled_, buf.data(), sizeof(TxnId));
+    auto aborted = std::make_shared<AbortedIds>();
+    // a range torn by a crash is left out (its id is above `settled` anyway)
+    size_t n = (buf.size() - sizeof(TxnId)) / (2 * sizeof(TxnId));
+    for (size_t i = 0; i < n; ++i) {
+        TxnId range[2];
+        std::memcpy(range, buf.data() + sizeof(TxnId) + i * sizeof(range), sizeof(range));
+        aborted->add(range[0], range[1]);
+    }
+    status_end_ = sizeof(TxnId) + n * 2 * sizeof(TxnId);
+    if (!aborted->ranges.empty()) aborted_ = std::move(aborted);
+}
+
+TransactionManager::~TransactionManager() {
+    if (fd_ >= 0) ::close(fd_);
+    if (status_fd_ >= 0) ::close(status_fd_);
+}
+
+void TransactionManager::write_settled_locked(TxnId settled) {
+    if (::pwrite(status_fd_, &settled, sizeof(settled), 0) != static_cast<ssize_t>(sizeof(settled)) ||
+        ::fdatasync(status_fd_) != 0)
+        throw std::runtime_error(std::string("cannot record finished transactions: ") + std::strerror(errno));
+    settled_ = settled;
+}
+
+void TransactionManager::add_aborted_locked(TxnId first, TxnId end) {
+    TxnId range[2] = {first, end};
+    if (::pwrite(status_fd_, range, sizeof(range), static_cast<off_t>(status_end_)) !=
+        static_cast<ssize_t>(sizeof(range)))
+        throw std::runtime_error(std::string("cannot record an aborted transaction: ") + std::strerror(errno));
+    status_end_ += sizeof(range);
+    // snapshots hold on to the set they were taken with
+    auto next = aborted_ ? std::make_shared<AbortedIds>(*aborted_) : std::make_shared<AbortedIds>();
+    next->add(first, end);
+    aborted_ = std::move(next);
+}
+
+void TransactionManager::reserve_locked() {
+    TxnId upto = next_ + RESERVE;
+    if (::pwrite(fd_, &upto, sizeof(upto), 0) != static_cast<ssize_t>(sizeof(upto)) || ::fdatasync(fd_) != 0)
+        throw std::runtime_error(std::string("cannot reserve transaction ids: ") + std::strerror(errno));
+    reserved_ = upto;
+}
+
+TxnId TransactionManager::begin() {
+    std::lock_guard<std::mutex> lg(mu_);
+    if (next_ >= reserved_) reserve_locked();
+    TxnId id = next_++;
+    active_.insert(id);
+    return id;
+}
+
+void TransactionManager::abort(TxnId id) {
+    std::lock_guard<std::mutex> lg(mu_);
+    add_aborted_locked(id, id + 1);
+}
+
+void TransactionManager::end(TxnId id) {
+    std::lock_guard<std::mutex> lg(mu_);
+    active_.erase(id);
+}
+
+void TransactionManager::settle() {
+    std::lock_guard<std::mutex> lg(mu_);
+    // the ranges appended since the last call become durable with it
+    write_settled_locked(next_);
+}
+
+void TransactionManager::recover(const std::unordered_set<TxnId> &committed) {
+    std::lock_guard<std::mutex> lg(mu_);
+    if (settled_ >= next_) return;
+    std::vector<TxnId> kept;
+    for (TxnId id : committed)
+        if (id >= settled_ && id < next_) kept.push_back(id);
+    std::sort(kept.begin(), kept.end());
+    // the gaps between the committed ids (unused ids of the reserve included)
+    TxnId from = settled_;
+    for (TxnId id : kept) {
+        if (id > from) add_aborted_locked(from, id);
+        from = id + 1;
+    }
+    if (from < next_) add_aborted_locked(from, next_);
+    write_settled_locked(next_);
+}
+
+std::shared_ptr<const AbortedIds> TransactionManager::aborted() {
+    std::lock_guard<std::mutex> lg(mu_);
+    return aborted_;
+}
+
+Snapshot TransactionManager::snapshot(TxnId self) {
+    std::lock_guard<std::mutex> lg(mu_);
+    Snapshot s;
+    s.self = self;
+    s.xmax = next_;
+    s.xmin = active_.empty() ? next_ : *active_.begin();
+    s.active.assign(active_.begin(), active_.end());
+    s.aborted = aborted_;
+    snapshots_.insert(s.xmin);
+    return s;
+}
+
+void TransactionManager::release(const Snapshot &s) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto it = snapshots_.find(s.xmin);
+    if (it != snapshots_.end()) snapshots_.erase(it);
+}
+
+TxnId TransactionManager::horizon() {
+    std::lock_guard<std::mutex> lg(mu_);
+    TxnId h = next_;
+    if (!active_.empty()) h = std::min(h, *active_.begin());
+    if (!snapshots_.empty()) h = std::min(h, *snapshots_.begin());
+    return h;
+}
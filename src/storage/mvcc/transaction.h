@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace storage {
+
+class VersionStore;
+struct RowUndo;
+
+// Transaction ids grow with every transaction and are never reused. 0 is the
+// writer of rows stored before row versions existed: always committed.
+using TxnId = uint32_t;
+
+// Ids of aborted transactions, as sorted and disjoint ranges [first, second)
+struct AbortedIds {
+    std::vector<std::pair<TxnId, TxnId>> ranges;
+
+    bool contains(TxnId id) const {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), std::make_pair(id, UINT32_MAX));
+        return it != ranges.begin() && id < std::prev(it)->second;
+    }
+    void add(TxnId first, TxnId end);
+};
+
+// Which transactions' changes a statement sees: those committed when the
+// snapshot was taken, plus its own transaction's.
+struct Snapshot {
+    TxnId self = 0;
+    TxnId xmin = 0;              // every id below had finished
+    TxnId xmax = 0;              // no id from here on had started
+    std::vector<TxnId> active;   // in progress in between (sorted)
+    std::shared_ptr<const AbortedIds> aborted;   // finished without committing (null: none)
+
+    bool sees(TxnId id) const {
+        if (id == 0 || id == self) return true;
+        if (id >= xmax) return false;
+        if (id >= xmin && std::binary_search(active.begin(), active.end(), id)) return false;
+        return !aborted || !aborted->contains(id);
+    }
+};
+
+// The transaction a statement runs in and the snapshot it reads with. Its
+// updates and deletes leave in `undo` how to put the rows back if it aborts.
+struct Txn {
+    TxnId id = 0;
+    Snapshot snapshot;
+    VersionStore *versions = nullptr;
+    std::vector<RowUndo> *undo = nullptr;
+};
+
+// Hands out transaction ids and snapshots and tracks which are in use. Ids
+// are reserved on disk (<dir>/xid.meta) RESERVE at a time, so ids of earlier
+// runs stay below those of this run.
+//
+// A transaction commits unless it aborts. <dir>/xid.status records the
+// aborted ones: [settled u32], then [first u32][end u32] ranges of aborted
+// ids. Every id below `settled` has ended, as committed unless a range holds
+// it; ids from there up to this run's were cut off by a crash and are
+// settled by recovery. Rows the aborted ids wrote stay invisible, so their
+// ranges are kept for good.
+class TransactionManager {
+public:
+    static constexpr TxnId RESERVE = 1u << 16;
+
+    // throws std::runtime_error if xid.meta or xid.status cannot be read or written
+    explicit TransactionManager(const std::string &dir);
+    ~TransactionManager();
+    TransactionManager(const TransactionManager &) = delete;
+    TransactionManager &operator=(const TransactionManager &) = delete;
+
+    TxnId begin();
+    // The changes of `id` never become visible. Called while it still runs,
+    // before its rows are put back; recorded on disk by the next settle()
+    // (a crash before that aborts it anyway: it has no COMMIT record).
+    void abort(TxnId id);
+    // `id` has finished: committed, unless it aborted
+    void end(TxnId id);
+    // Every id handed out so far has ended and the COMMIT records of the
+    // committed ones are durable: record that before a checkpoint empties
+    // the log. Callers keep statements out meanwhile.
+    void settle();
+    // At startup, after the redo pass: the ids a crash cut off that have no
+    // COMMIT record in the log aborted. Settles them.
+    void recover(const std::unordered_set<TxnId> &committed);
+    std::shared_ptr<const AbortedIds> aborted();
+
+    // A snapshot keeps the versions it may read alive until it is released
+    Snapshot snapshot(TxnId self);
+    void release(const Snapshot &s);
+
+    // Every running and future snapshot sees the changes of ids below the
+    // horizon, so the versions they replaced and the rows they deleted can go
+    TxnId horizon();
+
+private:
+    int fd_ = -1;
+    int status_fd_ = -1;
+    uint64_t status_end_ = 0;          // where the next aborted range goes
+    std::mutex mu_;
+    TxnId next_ = 1;
+    TxnId reserved_ = 1;               // ids below are recorded as used on disk
+    TxnId settled_ = 1;
+    std::set<TxnId> active_;
+    std::multiset<TxnId> snapshots_;   // xmin of every registered snapshot
+    std::shared_ptr<const AbortedIds> aborted_;
+
+    void reserve_locked();
+    void write_settled_locked(TxnId settled);
+    void add_aborted_locked(TxnId first, TxnId end);
+};
+
+} // namespace storage
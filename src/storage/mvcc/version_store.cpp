@@ -0,0 +1,81 @@
+#include "src/storage/mvcc/version_store.h"
+
+using namespace storage;
+
+void VersionStore::push(uint32_t segment_id, const RecordId &rid, Version v) {
+    std::lock_guard<std::mutex> lg(mu_);
+    rows_[segment_id][row_key(rid)].push_back(std::move(v));
+    count_++;
+}
+
+bool VersionStore::find(uint32_t segment_id, const RecordId &rid, const Snapshot &s, std::vector<char> &tuple) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto seg = rows_.find(segment_id);
+    if (seg == rows_.end()) return false;
+    auto row = seg->second.find(row_key(rid));
+    if (row == seg->second.end()) return false;
+    for (auto it = row->second.rbegin(); it != row->second.rend(); ++it) {
+        if (!s.sees(it->xmin)) continue;
+        tuple = it->tuple;
+        return true;
+    }
+    return false;
+}
+
+std::vector<std::vector<char>> VersionStore::tuples(uint32_t segment_id, const RecordId &rid) {
+    std::vector<std::vector<char>> out;
+    std::lock_guard<std::mutex> lg(mu_);
+    auto seg = rows_.find(segment_id);
+    if (seg == rows_.end()) return out;
+    auto row = seg->second.find(row_key(rid));
+    if (row == seg->second.end()) return out;
+    for (const Version &v : row->second) out.push_back(v.tuple);
+    return out;
+}
+
+void VersionStore::rekey(uint32_t segment_id, const RecordId &from, const RecordId &to) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto seg = rows_.find(segment_id);
+    if (seg == rows_.end()) return;
+    auto row = seg->second.find(row_key(from));
+    if (row == seg->second.end()) return;
+    std::vector<Version> versions = std::move(row->second);
+    seg->second.erase(row);
+    seg->second[row_key(to)] = std::move(versions);
+}
+
+void VersionStore::drop(uint32_t segment_id, const RecordId &rid) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto seg = rows_.find(segment_id);
+    if (seg == rows_.end()) return;
+    auto row = seg->second.find(row_key(rid));
+    if (row == seg->second.end()) return;
+    count_ -= row->second.size();
+    seg->second.erase(row);
+}
+
+std::vector<VersionStore::Pruned> VersionStore::prune(TxnId horizon) {
+    std::vector<Pruned> pruned;
+    std::lock_guard<std::mutex> lg(mu_);
+    for (auto seg = rows_.begin(); seg != rows_.end();) {
+        auto &rows = seg->second;
+        for (auto row = rows.begin(); row != rows.end();) {
+            // versions are replaced in order: the prunable ones are a prefix
+            std::vector<Version> &versions = row->second;
+            size_t n = 0;
+            while (n < versions.size() && versions[n].xmax < horizon) n++;
+            RecordId rid{static_cast<uint32_t>(row->first >> 32), static_cast<uint32_t>(row->first)};
+            for (size_t i = 0; i < n; ++i) pruned.push_back(Pruned{seg->first, rid, std::move(versions[i])});
+            versions.erase(versions.begin(), versions.begin() + static_cast<std::ptrdiff_t>(n));
+            row = versions.empty() ? rows.erase(row) : std::next(row);
+        }
+        seg = rows.empty() ? rows_.erase(seg) : std::next(seg);
+    }
+    count_ -= pruned.size();
+    return pruned;
+}
+
+size_t VersionStore::size() {
+    std::lock_guard<std::mutex> lg(mu_);
+    return count_;
+}
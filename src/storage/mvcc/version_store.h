@@ -0,0 +1,54 @@
+#pragma once
+
+#include "src/storage/mvcc/transaction.h"
+#include "src/storage/table/table_heap.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace storage {
+
+// Older versions of updated rows. An update overwrites the row in the heap
+// and keeps the tuple it replaced here, so a snapshot that does not see the
+// update still finds the row as it was. Kept in memory only: after a restart
+// no snapshot is older than the heap.
+class VersionStore {
+public:
+    struct Version {
+        TxnId xmin;   // wrote this version
+        TxnId xmax;   // replaced it
+        std::vector<char> tuple;
+    };
+
+    // the heap version of the row was replaced by v.xmax
+    void push(uint32_t segment_id, const RecordId &rid, Version v);
+    // tuple of the newest kept version `s` sees; false when it sees none
+    bool find(uint32_t segment_id, const RecordId &rid, const Snapshot &s, std::vector<char> &tuple);
+    // tuples of every kept version of the row, oldest first
+    std::vector<std::vector<char>> tuples(uint32_t segment_id, const RecordId &rid);
+
+    // vacuum moved the row / deleted it for good
+    void rekey(uint32_t segment_id, const RecordId &from, const RecordId &to);
+    void drop(uint32_t segment_id, const RecordId &rid);
+
+    struct Pruned {
+        uint32_t segment_id;
+        RecordId rid;
+        Version version;
+    };
+    // Take out the versions replaced below `horizon`: no snapshot can see them
+    std::vector<Pruned> prune(TxnId horizon);
+    size_t size();
+
+private:
+    static uint64_t row_key(const RecordId &rid) { return (static_cast<uint64_t>(rid.page_number) << 32) | rid.offset; }
+
+    std::mutex mu_;
+    // segment -> row -> versions, oldest first
+    std::unordered_map<uint32_t, std::unordered_map<uint64_t, std::vector<Version>>> rows_;
+    size_t count_ = 0;
+};
+
+} // namespace storage
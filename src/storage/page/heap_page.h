@@ -1,33 +1,84 @@
 #pragma once
 
-#include <vector>
-#include "src/storage/table/tuple.h"
+#include <cstdint>
+#include <cstring>
+#include "src/storage/page/page.h"
 
 namespace storage {
 
+// Heap page layout (inside Page::data):
+//   [0..4)            used bytes (u32), counted from offset 4
+//   [4..4+used)       records, each [len u32][body]
+//
+// The top bits of a record's len are flags, the rest is the body capacity:
+//   none      body = serialized Tuple (may be followed by unused bytes)
+//   DELETED   tombstone; the space can be reused by an insert
+//   FORWARD   body = RecordId of the row's new location (row outgrew its slot)
+//   MOVED     body = [home RecordId][serialized Tuple]; the row's id is still
+//             the home record, which holds a FORWARD to here
+//   VERSIONED the tuple is preceded by its row version [xmin u32][xmax u32]:
+//             the transaction that wrote it and the one that deleted it (0 =
+//             none). Rows written before versions existed have none and are
+//             visible to every snapshot.
+// Bodies are at least MIN_BODY bytes so any record can become a FORWARD.
 struct HeapPage {
-    // existing fields...
-    uint16_t num_records;
-    char payload[PAGE_PAYLOAD_SIZE - sizeof(uint16_t)];
-
-    std::vector<std::vector<Value>> get_all_records() const {
-        std::vector<std::vector<Value>> records;
-        const char *ptr = payload;
-        for (int i = 0; i < num_records; i++) {
-            uint16_t len;
-            std::memcpy(&len, ptr, sizeof(uint16_t));
-            ptr += sizeof(uint16_t);
-
-            std::vector<Value> row;
-            // Assuming each tuple serialized as [len][bytes...]
-            // You’ll need to deserialize based on your Value format:
-            Value v(std::string(ptr, len));
-            row.push_back(v);
-
-            ptr += len;
-            records.push_back(row);
-        }
-        return records;
+    static constexpr uint32_t RECORD_HEADER = 4;
+    static constexpr uint32_t FIRST_RECORD = 4;
+    static constexpr uint32_t MIN_BODY = 8;   // a RecordId
+
+    static constexpr uint32_t DELETED = 1u << 31;
+    static constexpr uint32_t FORWARD = 1u << 30;
+    static constexpr uint32_t MOVED = 1u << 29;
+    static constexpr uint32_t VERSIONED = 1u << 28;
+    static constexpr uint32_t LEN_MASK = VERSIONED - 1;
+    static constexpr uint32_t VERSION_SIZE = 8;
+
+    static uint32_t used_bytes(const Page &p) {
+        uint32_t used = 0;
+        std::memcpy(&used, p.data, sizeof(uint32_t));
+        return used;
+    }
+
+    static void set_used_bytes(Page &p, uint32_t used) {
+        std::memcpy(p.data, &used, sizeof(uint32_t));
+    }
+
+    static uint32_t free_bytes(const Page &p) {
+        return static_cast<uint32_t>(sizeof(p.data)) - FIRST_RECORD - used_bytes(p);
+    }
+
+    static uint32_t record_header(const Page &p, uint32_t offset) {
+        uint32_t hdr = 0;
+        std::memcpy(&hdr, p.data + offset, sizeof(uint32_t));
+        return hdr;
+    }
+
+    static void set_record_header(Page &p, uint32_t offset, uint32_t hdr) {
+        std::memcpy(p.data + offset, &hdr, sizeof(uint32_t));
+    }
+
+    // body capacity of the record at `offset` (flags stripped)
+    static uint32_t record_len(const Page &p, uint32_t offset) { return record_header(p, offset) & LEN_MASK; }
+    static uint32_t record_flags(const Page &p, uint32_t offset) { return record_header(p, offset) & ~LEN_MASK; }
+
+    // offset in Page::data of the row version of a VERSIONED record
+    static uint32_t version_offset(uint32_t offset, uint32_t hdr) {
+        return offset + RECORD_HEADER + ((hdr & MOVED) ? MIN_BODY : 0);
+    }
+
+    // row version of the record with header `hdr` ({0, 0} when it has none)
+    static void version_at(const Page &p, uint32_t offset, uint32_t hdr, uint32_t &xmin, uint32_t &xmax) {
+        xmin = xmax = 0;
+        if (!(hdr & VERSIONED) || (hdr & (DELETED | FORWARD))) return;
+        const char *v = p.data + version_offset(offset, hdr);
+        std::memcpy(&xmin, v, sizeof(uint32_t));
+        std::memcpy(&xmax, v + sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    // tuple bytes of the record with header `hdr`, nullptr for tombstones and forwards
+    static const char *tuple_at(const Page &p, uint32_t offset, uint32_t hdr) {
+        if (hdr & (DELETED | FORWARD)) return nullptr;
+        return p.data + version_offset(offset, hdr) + ((hdr & VERSIONED) ? VERSION_SIZE : 0);
     }
 };
 
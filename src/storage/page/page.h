@@ -15,8 +15,8 @@ struct PageHeader {
     uint32_t segment_id;   // 4 bytes
     uint32_t page_number;  // 4 bytes
     uint16_t type;         // 2 bytes
-    uint32_t lsn;          // 4 bytes
-    uint8_t reserved[2];   // pad manually to reach 16
+    uint32_t lsn;          // 4 bytes: low bits of the page LSN
+    uint16_t lsn_hi;       // 2 bytes: high bits (LSNs are 48-bit)
 };
 #pragma pack(pop)
 
@@ -26,7 +26,8 @@ enum class PageType : uint16_t {
     INVALID = 0,
     TABLE_HEAP = 1,
     INDEX_INTERNAL = 2,
-    INDEX_LEAF = 3
+    INDEX_LEAF = 3,
+    SORT_RUN = 4
 };
 
 struct PageId {
@@ -49,12 +50,19 @@ struct Page {
         hdr.page_number = pid.page_number;
         hdr.type = static_cast<uint16_t>(t);
         hdr.lsn = 0;
-        hdr.reserved[0] = hdr.reserved[1] = 0;
+        hdr.lsn_hi = 0;
         std::memset(data, 0, sizeof(data));
     }
 
     PageId id() const { return PageId{hdr.segment_id, hdr.page_number}; }
     PageType type() const { return static_cast<PageType>(hdr.type); }
+
+    // LSN of the last logged change to this page (0 = never logged)
+    uint64_t lsn() const { return hdr.lsn | (static_cast<uint64_t>(hdr.lsn_hi) << 32); }
+    void set_lsn(uint64_t lsn) {
+        hdr.lsn = static_cast<uint32_t>(lsn);
+        hdr.lsn_hi = static_cast<uint16_t>(lsn >> 32);
+    }
 };
 
 static_assert(sizeof(Page) == PAGE_SIZE, "Page size mismatch with PAGE_SIZE");
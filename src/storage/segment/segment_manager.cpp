@@ -10,6 +10,16 @@ using namespace storage;
 
 SegmentManager::SegmentManager(const std::string &base_dir) : base_dir_(base_dir) {
     std::filesystem::create_directories(base_dir_);
+    // scratch segments of a previous run are garbage
+    for (const auto &entry : std::filesystem::directory_iterator(base_dir_)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("tmp_", 0) == 0) std::filesystem::remove(entry.path());
+    }
+}
+
+std::string SegmentManager::segment_path(uint32_t segment_id) const {
+    const char *prefix = segment_id >= TEMP_SEGMENT_BASE ? "/tmp_" : "/seg_";
+    return base_dir_ + prefix + std::to_string(segment_id) + ".dat";
 }
 
 SegmentManager::~SegmentManager() {
@@ -22,7 +32,7 @@ std::fstream &SegmentManager::get_segment(uint32_t segment_id) {
     auto it = segments_.find(segment_id);
     if (it != segments_.end()) return it->second;
 
-    std::string path = base_dir_ + "/seg_" + std::to_string(segment_id) + ".dat";
+    std::string path = segment_path(segment_id);
 
     // open in read/write mode; create if missing
     std::fstream fs;
@@ -45,6 +55,7 @@ std::fstream &SegmentManager::get_segment(uint32_t segment_id) {
 }
 
 Page SegmentManager::read_page(const PageId &pid) {
+    thread_io().reads++;
     std::lock_guard<std::mutex> lg(mu_);
     std::fstream &fs = get_segment(pid.segment_id);
 
@@ -59,6 +70,7 @@ Page SegmentManager::read_page(const PageId &pid) {
 }
 
 void SegmentManager::write_page(const Page &page) {
+    thread_io().writes++;
     std::lock_guard<std::mutex> lg(mu_);
     std::fstream &fs = get_segment(page.hdr.segment_id);
 
@@ -66,20 +78,6 @@ void SegmentManager::write_page(const Page &page) {
     fs.seekp(static_cast<std::streamoff>(page.hdr.page_number) * static_cast<std::streamoff>(PAGE_SIZE), std::ios::beg);
     fs.write(reinterpret_cast<const char*>(&page), sizeof(Page));
     fs.flush();
-
-    // Ensure OS-level flush for durability (configurable in production)
-    int fd = fileno((FILE*)nullptr);
-    // We need to get fd for fs; use platform-specific access:
-#if defined(_MSC_VER)
-    // On Windows, obtaining handle from fstream is non-portable using _get_osfhandle; skip fsync by default
-#else
-    // POSIX: try to retrieve file descriptor from underlying FILE* if possible
-    // Unfortunately std::fstream doesn't expose file descriptor portably; use rdbuf()->fd() on glibc? Not standard.
-    // We can obtain via fileno on FILE* if we convert; a more robust solution is to open files with open()/fdopen() and keep fd.
-    std::fstream::pos_type cur = fs.tellp(); // just to use fs and avoid unused warning
-    // best-effort fsync — if we have direct access to the descriptor in your platform, call fsync.
-    // For a portable production system, migrate to low-level file descriptors and call fsync(fd).
-#endif
 }
 
 PageId SegmentManager::allocate_page(uint32_t segment_id) {
@@ -104,3 +102,92 @@ PageId SegmentManager::allocate_page(uint32_t segment_id) {
 void SegmentManager::free_page(const PageId &pid) {
     // optional: mark page as free; for now, no-op
 }
+
+uint32_t SegmentManager::page_count(uint32_t segment_id) {
+    std::lock_guard<std::mutex> lg(mu_);
+    std::fstream &fs = get_segment(segment_id);
+
+    fs.clear();
+    fs.seekg(0, std::ios::end);
+    return static_cast<uint32_t>(fs.tellg() / PAGE_SIZE);
+}
+
+void SegmentManager::truncate(uint32_t segment_id, uint32_t pages) {
+    std::lock_guard<std::mutex> lg(mu_);
+    std::fstream &fs = get_segment(segment_id);
+    fs.flush();
+    std::error_code ec;
+    std::filesystem::resize_file(segment_path(segment_id),
+                                 static_cast<std::uintmax_t>(pages) * PAGE_SIZE, ec);
+    if (ec) throw std::runtime_error("Failed to truncate segment " + segment_path(segment_id) + ": " + ec.message());
+}
+
+void SegmentManager::extend(uint32_t segment_id, uint32_t pages) {
+    std::lock_guard<std::mutex> lg(mu_);
+    std::fstream &fs = get_segment(segment_id);
+    fs.flush();
+    std::string path = segment_path(segment_id);
+    std::error_code ec;
+    std::uintmax_t want = static_cast<std::uintmax_t>(pages) * PAGE_SIZE;
+    if (std::filesystem::file_size(path, ec) < want && !ec) std::filesystem::resize_file(path, want, ec);
+    if (ec) throw std::runtime_error("Failed to extend segment " + path + ": " + ec.message());
+}
+
+void SegmentManager::read_pages(uint32_t segment_id, uint32_t first, uint32_t count, Page *out) {
+    thread_io().reads += count;
+    std::lock_guard<std::mutex> lg(mu_);
+    std::fstream &fs = get_segment(segment_id);
+    fs.clear();
+    fs.seekg(static_cast<std::streamoff>(first) * static_cast<std::streamoff>(PAGE_SIZE), std::ios::beg);
+    if (!fs.read(reinterpret_cast<char *>(out), static_cast<std::streamsize>(count) * PAGE_SIZE)) {
+        throw std::out_of_range("Page not found");
+    }
+}
+
+void SegmentManager::write_pages(const Page *pages, uint32_t count) {
+    if (count == 0) return;
+    thread_io().writes += count;
+    std::lock_guard<std::mutex> lg(mu_);
+    std::fstream &fs = get_segment(pages[0].hdr.segment_id);
+    fs.clear();
+    fs.seekp(static_cast<std::streamoff>(pages[0].hdr.page_number) * static_cast<std::streamoff>(PAGE_SIZE),
+             std::ios::beg);
+    fs.write(reinterpret_cast<const char *>(pages), static_cast<std::streamsize>(count) * PAGE_SIZE);
+    fs.flush();
+    if (!fs) throw std::runtime_error("Failed to write segment " + segment_path(pages[0].hdr.segment_id));
+}
+
+void SegmentManager::sync() {
+    std::lock_guard<std::mutex> lg(mu_);
+    for (auto &kv : segments_) {
+        if (kv.first >= TEMP_SEGMENT_BASE) continue;
+        kv.second.flush();
+        // fstream hides its descriptor; any descriptor of the file syncs it
+        std::string path = segment_path(kv.first);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        bool ok = fd >= 0 && ::fsync(fd) == 0;
+        if (fd >= 0) ::close(fd);
+        if (!ok) throw std::runtime_error("Failed to sync segment " + path);
+    }
+}
+
+uint32_t SegmentManager::create_temp_segment() {
+    std::lock_guard<std::mutex> lg(mu_);
+    uint32_t id = next_temp_++;
+    if (next_temp_ == 0) next_temp_ = TEMP_SEGMENT_BASE; // wrapped
+    // truncate whatever an earlier owner of this id left behind
+    std::ofstream(segment_path(id), std::ios::out | std::ios::binary | std::ios::trunc);
+    get_segment(id);
+    return id;
+}
+
+void SegmentManager::drop_segment(uint32_t segment_id) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto it = segments_.find(segment_id);
+    if (it != segments_.end()) {
+        it->second.close();
+        segments_.erase(it);
+    }
+    std::error_code ec;
+    std::filesystem::remove(segment_path(segment_id), ec);
+}
@@ -7,6 +7,33 @@
 
 namespace storage {
 
+// Page I/O of the calling thread: buffer pool hits and misses, and pages read
+// from / written to segment files (pool misses, evictions, scratch runs).
+// Plain thread-local counters, always kept; EXPLAIN ANALYZE charges the
+// differences to plan nodes.
+struct IoCounters {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+
+    IoCounters &operator+=(const IoCounters &o) {
+        hits += o.hits;
+        misses += o.misses;
+        reads += o.reads;
+        writes += o.writes;
+        return *this;
+    }
+    IoCounters operator-(const IoCounters &o) const {
+        return IoCounters{hits - o.hits, misses - o.misses, reads - o.reads, writes - o.writes};
+    }
+};
+
+inline IoCounters &thread_io() {
+    static thread_local IoCounters io;
+    return io;
+}
+
 class SegmentManager {
 public:
     explicit SegmentManager(const std::string &base_dir);
@@ -16,13 +43,34 @@ public:
     void write_page(const Page &page);
     PageId allocate_page(uint32_t segment_id);
     void free_page(const PageId &pid);
+    uint32_t page_count(uint32_t segment_id);
+    // cut the segment file down to its first `pages` pages
+    void truncate(uint32_t segment_id, uint32_t pages);
+    // grow the segment file to at least `pages` pages (new pages are zeroed)
+    void extend(uint32_t segment_id, uint32_t pages);
+
+    // Runs of consecutive pages moved with one read / write each; the
+    // pages of a write must be consecutive pages of one segment
+    void read_pages(uint32_t segment_id, uint32_t first, uint32_t count, Page *out);
+    void write_pages(const Page *pages, uint32_t count);
+    // make everything written to the (non-scratch) segment files durable
+    void sync();
+
+    // Scratch segments (e.g. sort runs) use ids from TEMP_SEGMENT_BASE up and
+    // files named tmp_<id>.dat. They are never cached by the buffer pool,
+    // are deleted by drop_segment, and leftovers are removed on startup.
+    static constexpr uint32_t TEMP_SEGMENT_BASE = 0xFFF00000u;
+    uint32_t create_temp_segment();
+    void drop_segment(uint32_t segment_id);
 
 private:
     std::string base_dir_;
     std::unordered_map<uint32_t, std::fstream> segments_;
     std::mutex mu_;
+    uint32_t next_temp_ = TEMP_SEGMENT_BASE;
 
     std::fstream &get_segment(uint32_t segment_id);
+    std::string segment_path(uint32_t segment_id) const;
 };
 
 } // namespace storage
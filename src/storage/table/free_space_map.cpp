@@ -0,0 +1,56 @@
+#include "src/storage/table/free_space_map.h"
+
+#include <algorithm>
+
+using namespace storage;
+
+void FreeSpaceMap::add(uint32_t segment_id, uint32_t page_no, uint32_t body) {
+    std::lock_guard<std::mutex> lg(mu_);
+    uint32_t &hole = pages_[segment_id][page_no];
+    hole = std::max(hole, body);
+    freed_[segment_id] += body;
+}
+
+void FreeSpaceMap::set(uint32_t segment_id, uint32_t page_no, uint32_t body) {
+    std::lock_guard<std::mutex> lg(mu_);
+    if (body > 0) {
+        pages_[segment_id][page_no] = body;
+        return;
+    }
+    auto it = pages_.find(segment_id);
+    if (it != pages_.end()) it->second.erase(page_no);
+}
+
+bool FreeSpaceMap::find(uint32_t segment_id, uint32_t body, uint32_t &page_no) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto it = pages_.find(segment_id);
+    if (it == pages_.end()) return false;
+    for (const auto &[page, hole] : it->second) {
+        if (hole >= body) {
+            page_no = page;
+            return true;
+        }
+    }
+    return false;
+}
+
+void FreeSpaceMap::truncate(uint32_t segment_id, uint32_t pages) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto it = pages_.find(segment_id);
+    if (it != pages_.end()) it->second.erase(it->second.lower_bound(pages), it->second.end());
+}
+
+void FreeSpaceMap::drop(uint32_t segment_id) {
+    std::lock_guard<std::mutex> lg(mu_);
+    pages_.erase(segment_id);
+    freed_.erase(segment_id);
+}
+
+uint64_t FreeSpaceMap::take_freed(uint32_t segment_id) {
+    std::lock_guard<std::mutex> lg(mu_);
+    auto it = freed_.find(segment_id);
+    if (it == freed_.end()) return 0;
+    uint64_t bytes = it->second;
+    freed_.erase(it);
+    return bytes;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace storage {
+
+// In-memory record of reusable space in table heaps: for each page with dead
+// records, an upper bound on the largest record body that fits into one of its
+// holes or its unused end. Deletes and updates report the slots they free,
+// vacuum reports what it finds; inserts ask for a page before appending to the
+// tail, and correct the bound after looking at the page.
+// Not persisted: space freed by an earlier run is found again by vacuum.
+class FreeSpaceMap {
+public:
+    // a hole able to hold a `body` byte record body appeared on the page
+    void add(uint32_t segment_id, uint32_t page_no, uint32_t body);
+    // largest hole actually left on the page (0 = none)
+    void set(uint32_t segment_id, uint32_t page_no, uint32_t body);
+    // a page that may hold a `body` byte record, lowest page first
+    bool find(uint32_t segment_id, uint32_t body, uint32_t &page_no);
+    // forget pages >= `pages` (segment truncated)
+    void truncate(uint32_t segment_id, uint32_t pages);
+    void drop(uint32_t segment_id);
+
+    // bytes reported through add() since the last call (vacuum's trigger)
+    uint64_t take_freed(uint32_t segment_id);
+
+private:
+    std::mutex mu_;
+    std::unordered_map<uint32_t, std::map<uint32_t, uint32_t>> pages_;   // segment -> page -> hole bound
+    std::unordered_map<uint32_t, uint64_t> freed_;
+};
+
+} // namespace storage
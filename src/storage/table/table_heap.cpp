@@ -2,34 +2,641 @@
 #include "src/storage/buffer/buffer_pool.h"
 #include "src/storage/page/heap_page.h"
 #include "src/storage/table/tuple.h"
+#include "src/storage/mvcc/version_store.h"
+
+#include <algorithm>
 
 using namespace storage;
 
 std::vector<std::vector<Value>> TableHeap::Scan(BufferPool &bp) {
     std::vector<std::vector<Value>> results;
 
-    uint32_t segment_id = segment_id_;
-    uint32_t page_no = 0;
+    ForEach(bp, [&](const RecordId &, const char *ptr, uint32_t) {
+        results.push_back(Tuple::deserialize(ptr).values());
+    });
+
+    return results;
+}
+
+// Bounds-check the record at `offset`; its header goes to `hdr`
+static bool record_at(const Page &page, uint32_t offset, uint32_t &hdr) {
+    uint32_t end = HeapPage::FIRST_RECORD + HeapPage::used_bytes(page);
+    if (offset < HeapPage::FIRST_RECORD || offset + HeapPage::RECORD_HEADER > end) return false;
+    hdr = HeapPage::record_header(page, offset);
+    uint32_t len = hdr & HeapPage::LEN_MASK;
+    return len != 0 && offset + HeapPage::RECORD_HEADER + len <= end;
+}
+
+// Write header + body; the rest of the slot is zeroed
+static void write_record(Page &page, uint32_t offset, uint32_t hdr, const char *body, size_t n) {
+    char *dst = page.data + offset + HeapPage::RECORD_HEADER;
+    HeapPage::set_record_header(page, offset, hdr);
+    std::memcpy(dst, body, n);
+    std::memset(dst + n, 0, (hdr & HeapPage::LEN_MASK) - n);
+}
+
+// Bytes of the record's body that compaction keeps
+static uint32_t exact_body(const Page &page, uint32_t offset, uint32_t hdr) {
+    uint32_t len = hdr & HeapPage::LEN_MASK;
+    if (hdr & HeapPage::FORWARD) return HeapPage::MIN_BODY;
+    const char *tuple = HeapPage::tuple_at(page, offset, hdr);
+    uint32_t body = static_cast<uint32_t>(tuple - (page.data + offset + HeapPage::RECORD_HEADER)) +
+                    Tuple::serialized_size(tuple);
+    return std::min(len, std::max(body, HeapPage::MIN_BODY));
+}
+
+// Largest body the free end of the page can take
+static uint32_t free_end(const Page &page) {
+    uint32_t free = HeapPage::free_bytes(page);
+    return free >= HeapPage::RECORD_HEADER + HeapPage::MIN_BODY ? free - HeapPage::RECORD_HEADER : 0;
+}
 
+// Claim the first tombstone on the page with room for `body` bytes, merging
+// runs of adjacent tombstones on the way and splitting off the unused end of
+// a large hole; failing that, the free end of the page. Returns its offset
+// (0 = none, header left without flags) and the largest hole left in `largest`.
+static uint32_t take_hole(Page &page, uint32_t body, uint32_t &largest) {
+    uint32_t end = HeapPage::FIRST_RECORD + HeapPage::used_bytes(page);
+    uint32_t offset = HeapPage::FIRST_RECORD;
+    uint32_t found = 0;
+    largest = 0;
+    uint32_t hdr;
+    while (record_at(page, offset, hdr)) {
+        uint32_t len = hdr & HeapPage::LEN_MASK;
+        if (hdr & HeapPage::DELETED) {
+            uint32_t next = offset + HeapPage::RECORD_HEADER + len;
+            uint32_t nhdr;
+            while (next < end && record_at(page, next, nhdr) && (nhdr & HeapPage::DELETED)) {
+                uint32_t nlen = HeapPage::RECORD_HEADER + (nhdr & HeapPage::LEN_MASK);
+                len += nlen;
+                next += nlen;
+            }
+            if (!found && len >= body) {
+                found = offset;
+                if (len - body >= HeapPage::RECORD_HEADER + HeapPage::MIN_BODY) {
+                    HeapPage::set_record_header(page, offset + HeapPage::RECORD_HEADER + body,
+                                                HeapPage::DELETED | (len - body - HeapPage::RECORD_HEADER));
+                    len = body;   // the split-off hole is visited next
+                }
+                HeapPage::set_record_header(page, offset, len);
+            } else {
+                HeapPage::set_record_header(page, offset, HeapPage::DELETED | len);
+                largest = std::max(largest, len);
+            }
+        }
+        offset += HeapPage::RECORD_HEADER + len;
+    }
+    if (!found && free_end(page) >= body) {
+        found = end;
+        HeapPage::set_record_header(page, end, body);
+        HeapPage::set_used_bytes(page, end + HeapPage::RECORD_HEADER + body - HeapPage::FIRST_RECORD);
+    }
+    largest = std::max(largest, free_end(page));
+    return found;
+}
+
+// Row version + tuple, the body of a VERSIONED record
+static std::vector<char> versioned_body(TxnId xmin, TxnId xmax, const char *tuple, size_t n) {
+    std::vector<char> body(HeapPage::VERSION_SIZE + n);
+    std::memcpy(body.data(), &xmin, sizeof(xmin));
+    std::memcpy(body.data() + sizeof(xmin), &xmax, sizeof(xmax));
+    std::memcpy(body.data() + HeapPage::VERSION_SIZE, tuple, n);
+    return body;
+}
+
+RecordId TableHeap::Insert(BufferPool &bp, const std::vector<char> &payload) {
+    if (!txn_) return Place(bp, payload, 0);
+    return Place(bp, versioned_body(txn_->id, 0, payload.data(), payload.size()), HeapPage::VERSIONED);
+}
+
+RecordId TableHeap::Place(BufferPool &bp, const std::vector<char> &body, uint32_t flags) {
+    RecordId rid;
+    if (Reuse(bp, body, flags, UINT32_MAX, rid)) return rid;
+
+    // otherwise append to the tail page
+    uint32_t rec_len = std::max(static_cast<uint32_t>(body.size()), HeapPage::MIN_BODY);
+    uint32_t need = HeapPage::RECORD_HEADER + rec_len;
+    uint32_t pages = bp.page_count(segment_id_);
+    PageId pid{segment_id_, pages == 0 ? 0 : pages - 1};
+
+    Frame *frame = bp.fetch_or_allocate_page(pid, true);
+    while (HeapPage::free_bytes(frame->page) < need) {
+        // full: the page after it, added unless another inserter got there first
+        bp.unpin_page(frame, false);
+        pid.page_number++;
+        frame = bp.fetch_or_allocate_page(pid, true);
+    }
+
+    uint32_t used = HeapPage::used_bytes(frame->page);
+    uint32_t offset = HeapPage::FIRST_RECORD + used;
+    write_record(frame->page, offset, flags | rec_len, body.data(), body.size());
+    HeapPage::set_used_bytes(frame->page, used + need);
+
+    bp.unpin_page(frame, true);
+    return RecordId{pid.page_number, offset};
+}
+
+bool TableHeap::Reuse(BufferPool &bp, const std::vector<char> &body, uint32_t flags, uint32_t below,
+                      RecordId &rid) {
+    uint32_t rec_len = std::max(static_cast<uint32_t>(body.size()), HeapPage::MIN_BODY);
+    if (HeapPage::RECORD_HEADER + rec_len + HeapPage::FIRST_RECORD > PAGE_PAYLOAD_SIZE) {
+        throw std::length_error("tuple too large for a page");
+    }
+
+    // every miss lowers the page's bound, so this ends
+    uint32_t hole_page;
+    while (fsm_ && fsm_->find(segment_id_, rec_len, hole_page) && hole_page < below) {
+        Frame *frame = nullptr;
+        try {
+            frame = bp.fetch_page(PageId{segment_id_, hole_page}, true);
+        } catch (const std::out_of_range &) {
+            fsm_->set(segment_id_, hole_page, 0);
+            continue;
+        }
+        uint32_t largest = 0;
+        uint32_t offset = take_hole(frame->page, rec_len, largest);
+        fsm_->set(segment_id_, hole_page, largest);
+        if (offset != 0) {
+            uint32_t slot = HeapPage::record_len(frame->page, offset);
+            write_record(frame->page, offset, flags | slot, body.data(), body.size());
+        }
+        bp.unpin_page(frame, true);
+        if (offset != 0) {
+            rid = RecordId{hole_page, offset};
+            return true;
+        }
+    }
+    return false;
+}
+
+void TableHeap::Kill(Page &page, uint32_t page_no, uint32_t offset) {
+    uint32_t len = HeapPage::record_len(page, offset);
+    HeapPage::set_record_header(page, offset, HeapPage::DELETED | len);
+    if (fsm_) fsm_->add(segment_id_, page_no, len);
+}
+
+bool TableHeap::Get(BufferPool &bp, const RecordId &rid, Tuple &out) {
+    std::vector<char> tuple;
+    if (!Read(bp, rid, tuple)) return false;
+    const char *ptr = tuple.data();
+    out = Tuple::deserialize(ptr);
+    return true;
+}
+
+bool TableHeap::GetLatest(BufferPool &bp, const RecordId &rid, Tuple &out, TxnId &xmin) {
+    RecordId at;
+    uint32_t hdr, xmax;
+    std::vector<char> tuple;
+    if (!Locate(bp, rid, at, hdr, xmin, xmax, tuple) || xmax != 0) return false;
+    const char *ptr = tuple.data();
+    out = Tuple::deserialize(ptr);
+    return true;
+}
+
+bool TableHeap::ReadAt(BufferPool &bp, const RecordId &rid, const RecordId &start, std::vector<char> &tuple) {
+    // Readers lock no rows, so an update may move the row between the two
+    // pages. A MOVED tuple names its home: a stale pointer shows, and the
+    // FORWARD is read again. Updates repoint the FORWARD before they drop
+    // the old tuple, so only a pointer that did not change is dangling.
+    RecordId at = start;
+    RecordId stale{UINT32_MAX, UINT32_MAX};   // a target found not to hold the row
     while (true) {
-        PageId pid{segment_id, page_no};
+        Frame *frame = nullptr;
+        try {
+            frame = bp.fetch_page(PageId{segment_id_, at.page_number});
+        } catch (const std::out_of_range &) {
+            return false;
+        }
+
+        const Page &page = frame->page;
+        uint32_t hdr = 0;
+        bool live = record_at(page, at.offset, hdr) && !(hdr & HeapPage::DELETED);
+        if (at == rid) {
+            // a MOVED record here is another row's tuple in this row's old slot
+            live = live && !(hdr & HeapPage::MOVED);
+            if (live && (hdr & HeapPage::FORWARD)) {
+                std::memcpy(&at, page.data + at.offset + HeapPage::RECORD_HEADER, sizeof(RecordId));
+                bp.unpin_page(frame, false);
+                if (at == stale) return false;
+                continue;
+            }
+        } else {
+            RecordId home{};
+            if (live && (hdr & HeapPage::MOVED))
+                std::memcpy(&home, page.data + at.offset + HeapPage::RECORD_HEADER, sizeof(RecordId));
+            if (!live || !(hdr & HeapPage::MOVED) || home != rid) {
+                bp.unpin_page(frame, false);
+                stale = at;
+                at = rid;
+                continue;
+            }
+        }
+
+        const char *ptr = live ? HeapPage::tuple_at(page, at.offset, hdr) : nullptr;
+        std::vector<char> copy;
+        if (ptr && txn_ && (hdr & HeapPage::VERSIONED)) {
+            uint32_t len = 0;
+            ptr = VisibleTuple(*txn_, segment_id_, rid, page, at.offset, hdr, len, copy);
+        }
+        if (ptr) tuple.assign(ptr, ptr + Tuple::serialized_size(ptr));
+        bp.unpin_page(frame, false);
+        return ptr != nullptr;
+    }
+}
+
+const char *TableHeap::VisibleTuple(const Txn &txn, uint32_t segment_id, const RecordId &id, const Page &page,
+                                    uint32_t offset, uint32_t hdr, uint32_t &len, std::vector<char> &copy) {
+    uint32_t xmin, xmax;
+    HeapPage::version_at(page, offset, hdr, xmin, xmax);
+    const Snapshot &s = txn.snapshot;
+    if (s.sees(xmin)) return xmax != 0 && s.sees(xmax) ? nullptr : HeapPage::tuple_at(page, offset, hdr);
+    // written after the snapshot: an older version, if the row existed then
+    if (!txn.versions || !txn.versions->find(segment_id, id, s, copy)) return nullptr;
+    len = static_cast<uint32_t>(copy.size());
+    return copy.data();
+}
 
+bool TableHeap::Locate(BufferPool &bp, const RecordId &rid, RecordId &at, uint32_t &hdr, uint32_t &xmin,
+                       uint32_t &xmax, std::vector<char> &tuple) {
+    at = rid;
+    for (int hop = 0; hop < 2; ++hop) {
+        Frame *frame = nullptr;
         try {
-            Frame* frame = bp.fetch_page(pid);
+            frame = bp.fetch_page(PageId{segment_id_, at.page_number});
+        } catch (const std::out_of_range &) {
+            return false;
+        }
+        const Page &page = frame->page;
+        bool ok = record_at(page, at.offset, hdr) && !(hdr & HeapPage::DELETED) &&
+                  (hop == 1 || !(hdr & HeapPage::MOVED));
+        if (ok && (hdr & HeapPage::FORWARD)) {
+            std::memcpy(&at, page.data + at.offset + HeapPage::RECORD_HEADER, sizeof(RecordId));
+            bp.unpin_page(frame, false);
+            continue;
+        }
+        if (ok) {
+            HeapPage::version_at(page, at.offset, hdr, xmin, xmax);
+            const char *ptr = HeapPage::tuple_at(page, at.offset, hdr);
+            tuple.assign(ptr, ptr + Tuple::serialized_size(ptr));
+        }
+        bp.unpin_page(frame, false);
+        return ok;
+    }
+    return false;
+}
+
+bool TableHeap::Delete(BufferPool &bp, const RecordId &rid) {
+    if (!txn_) return Erase(bp, rid);
+    RecordId at;
+    uint32_t hdr, xmin, xmax;
+    std::vector<char> tuple;
+    if (!Locate(bp, rid, at, hdr, xmin, xmax, tuple) || xmax != 0) return false;
+    if (!(hdr & HeapPage::VERSIONED)) {
+        // stored without a version: store it again with one, unless that
+        // would give the row a new id (records too small for a FORWARD)
+        if (at == rid && (hdr & HeapPage::LEN_MASK) < sizeof(RecordId)) return Erase(bp, rid);
+        Remember(bp, rid, xmin, tuple);
+        RecordId id = rid, stored_at;
+        return Rewrite(bp, id, versioned_body(xmin, txn_->id, tuple.data(), tuple.size()), HeapPage::VERSIONED,
+                       stored_at);
+    }
+    // a row this transaction wrote is gone with its insert, or put back by its update's undo
+    if (xmin != txn_->id) Remember(bp, rid, xmin, tuple);
+    Frame *frame = bp.fetch_page(PageId{segment_id_, at.page_number}, true);
+    std::memcpy(frame->page.data + HeapPage::version_offset(at.offset, hdr) + sizeof(TxnId), &txn_->id,
+                sizeof(TxnId));
+    bp.unpin_page(frame, true);
+    return true;
+}
+
+WalRecord RowUndo::log_record(TxnId xid) const {
+    WalRecord rec{WalType::UNDO, segment_id, rid.page_number, {}};
+    uint32_t head[3] = {rid.offset, xid, xmin};
+    rec.payload.assign(reinterpret_cast<const char *>(head), sizeof(head));
+    rec.payload.append(tuple.data(), tuple.size());
+    return rec;
+}
+
+bool RowUndo::from_log(const WalRecord &rec, TxnId &xid, RowUndo &out) {
+    uint32_t head[3];
+    if (rec.type != WalType::UNDO || rec.payload.size() < sizeof(head)) return false;
+    std::memcpy(head, rec.payload.data(), sizeof(head));
+    out.segment_id = rec.segment_id;
+    out.rid = RecordId{rec.page_number, head[0]};
+    xid = head[1];
+    out.xmin = head[2];
+    out.tuple.assign(rec.payload.begin() + sizeof(head), rec.payload.end());
+    return true;
+}
+
+void TableHeap::Remember(BufferPool &bp, const RecordId &rid, TxnId xmin, const std::vector<char> &tuple) {
+    RowUndo undo{segment_id_, rid, xmin, tuple};
+    // the change is logged after this, when its page is: a crash can leave
+    // the change on disk, but not without the record
+    if (Wal *wal = bp.wal()) wal->append(undo.log_record(txn_->id));
+    if (txn_->undo) txn_->undo->push_back(std::move(undo));
+}
+
+bool TableHeap::Restore(BufferPool &bp, const RowUndo &undo, TxnId xid, std::vector<char> &replaced) {
+    RecordId at;
+    uint32_t hdr, xmin, xmax;
+    if (!Locate(bp, undo.rid, at, hdr, xmin, xmax, replaced) || (xmin != xid && xmax != xid)) return false;
+    RecordId id = undo.rid, stored_at;
+    return Rewrite(bp, id, versioned_body(undo.xmin, 0, undo.tuple.data(), undo.tuple.size()), HeapPage::VERSIONED,
+                   stored_at);
+}
+
+bool TableHeap::Erase(BufferPool &bp, const RecordId &rid) {
+    Frame *frame = nullptr;
+    try {
+        frame = bp.fetch_page(PageId{segment_id_, rid.page_number}, true);
+    } catch (const std::out_of_range &) {
+        return false;
+    }
+
+    uint32_t hdr = 0;
+    if (!record_at(frame->page, rid.offset, hdr) || (hdr & (HeapPage::DELETED | HeapPage::MOVED))) {
+        bp.unpin_page(frame, false);
+        return false;
+    }
+    RecordId moved{};
+    bool forwarded = hdr & HeapPage::FORWARD;
+    if (forwarded) std::memcpy(&moved, frame->page.data + rid.offset + HeapPage::RECORD_HEADER, sizeof(moved));
+    Kill(frame->page, rid.page_number, rid.offset);
+    bp.unpin_page(frame, true);
+
+    if (forwarded) {
+        Frame *mf = bp.fetch_page(PageId{segment_id_, moved.page_number}, true);
+        Kill(mf->page, moved.page_number, moved.offset);
+        bp.unpin_page(mf, true);
+    }
+    return true;
+}
 
-            HeapPage* hp = reinterpret_cast<HeapPage*>(frame->page.data);
+bool TableHeap::Update(BufferPool &bp, RecordId &rid, const std::vector<char> &payload, RecordId &stored_at) {
+    if (!txn_) return Rewrite(bp, rid, payload, 0, stored_at);
+    RecordId at;
+    uint32_t hdr, xmin, xmax;
+    std::vector<char> old;
+    if (!Locate(bp, rid, at, hdr, xmin, xmax, old) || xmax != 0) return false;
+    // the version replaced is still visible to snapshots that do not see this
+    // transaction (its own earlier versions are visible to nobody else)
+    if (xmin != txn_->id) {
+        Remember(bp, rid, xmin, old);
+        if (txn_->versions) txn_->versions->push(segment_id_, rid, {xmin, txn_->id, std::move(old)});
+    }
+    RecordId home = rid;
+    bool ok = Rewrite(bp, rid, versioned_body(txn_->id, 0, payload.data(), payload.size()), HeapPage::VERSIONED,
+                      stored_at);
+    if (ok && rid != home && txn_->versions) txn_->versions->rekey(segment_id_, home, rid);
+    return ok;
+}
+
+bool TableHeap::Rewrite(BufferPool &bp, RecordId &rid, const std::vector<char> &payload, uint32_t flags,
+                        RecordId &stored_at) {
+    if (HeapPage::RECORD_HEADER + sizeof(RecordId) + payload.size() + HeapPage::FIRST_RECORD > PAGE_PAYLOAD_SIZE) {
+        throw std::length_error("tuple too large for a page");
+    }
+
+    Frame *frame = nullptr;
+    try {
+        frame = bp.fetch_page(PageId{segment_id_, rid.page_number}, true);
+    } catch (const std::out_of_range &) {
+        return false;
+    }
+    uint32_t hdr = 0;
+    if (!record_at(frame->page, rid.offset, hdr) || (hdr & (HeapPage::DELETED | HeapPage::MOVED))) {
+        bp.unpin_page(frame, false);
+        return false;
+    }
+    uint32_t len = hdr & HeapPage::LEN_MASK;
+    RecordId moved{};
+    bool forwarded = hdr & HeapPage::FORWARD;
+
+    if (!forwarded) {
+        bool fits = payload.size() <= len;
+        if (fits) write_record(frame->page, rid.offset, flags | len, payload.data(), payload.size());
+        bp.unpin_page(frame, fits);
+        if (fits) {
+            stored_at = rid;
+            return true;
+        }
+    } else {
+        std::memcpy(&moved, frame->page.data + rid.offset + HeapPage::RECORD_HEADER, sizeof(moved));
+        bp.unpin_page(frame, false);
+
+        // rewrite the moved tuple where it is, or move it again
+        Frame *mf = bp.fetch_page(PageId{segment_id_, moved.page_number}, true);
+        uint32_t mlen = HeapPage::record_len(mf->page, moved.offset);
+        bool fits = sizeof(RecordId) + payload.size() <= mlen;
+        if (fits) {
+            std::vector<char> body(sizeof(RecordId));
+            std::memcpy(body.data(), &rid, sizeof(RecordId));
+            body.insert(body.end(), payload.begin(), payload.end());
+            write_record(mf->page, moved.offset, HeapPage::MOVED | flags | mlen, body.data(), body.size());
+        }
+        bp.unpin_page(mf, fits);
+        if (fits) {
+            stored_at = moved;
+            return true;
+        }
+    }
+
+    if (len < sizeof(RecordId)) {
+        // no room for a FORWARD: the row is reinserted under a new id
+        frame = bp.fetch_page(PageId{segment_id_, rid.page_number}, true);
+        Kill(frame->page, rid.page_number, rid.offset);
+        bp.unpin_page(frame, true);
+        rid = stored_at = Place(bp, payload, flags);
+        return true;
+    }
 
-            // Use your helper function
-            auto records = hp->get_all_records();
-            results.insert(results.end(), records.begin(), records.end());
+    std::vector<char> body(sizeof(RecordId));
+    std::memcpy(body.data(), &rid, sizeof(RecordId));
+    body.insert(body.end(), payload.begin(), payload.end());
+    stored_at = Place(bp, body, HeapPage::MOVED | flags);
 
+    frame = bp.fetch_page(PageId{segment_id_, rid.page_number}, true);
+    write_record(frame->page, rid.offset, HeapPage::FORWARD | len, reinterpret_cast<const char *>(&stored_at),
+                 sizeof(RecordId));
+    bp.unpin_page(frame, true);
+
+    // the old tuple goes once the FORWARD no longer points at it: readers
+    // follow it without holding the row
+    if (forwarded) {
+        Frame *mf = bp.fetch_page(PageId{segment_id_, moved.page_number}, true);
+        Kill(mf->page, moved.page_number, moved.offset);
+        bp.unpin_page(mf, true);
+    }
+    return true;
+}
+
+//
+// ---------------------------- VACUUM ---------------------------
+//
+PageUsage TableHeap::Usage(BufferPool &bp, uint32_t page_no) {
+    PageUsage u;
+    Frame *frame = bp.fetch_page(PageId{segment_id_, page_no});
+    const Page &page = frame->page;
+    u.used = HeapPage::used_bytes(page);
+    uint32_t offset = HeapPage::FIRST_RECORD;
+    uint32_t hdr;
+    while (record_at(page, offset, hdr)) {
+        uint32_t len = hdr & HeapPage::LEN_MASK;
+        if (hdr & HeapPage::DELETED) u.largest_free = std::max(u.largest_free, len);
+        else u.live += HeapPage::RECORD_HEADER + exact_body(page, offset, hdr);
+        offset += HeapPage::RECORD_HEADER + len;
+    }
+    u.largest_free = std::max(u.largest_free, free_end(page));
+    bp.unpin_page(frame, false);
+    return u;
+}
+
+void TableHeap::CompactPage(BufferPool &bp, uint32_t page_no, std::vector<RecordMove> &moved) {
+    struct Slot {
+        uint32_t from, to, hdr, body;
+    };
+    std::vector<Slot> slots;
+    // records on other pages pointing here, with the new value of their pointer
+    std::vector<std::pair<RecordId, RecordId>> fixups;
+
+    Frame *frame = bp.fetch_page(PageId{segment_id_, page_no}, true);
+    Page &page = frame->page;
+    uint32_t offset = HeapPage::FIRST_RECORD, to = HeapPage::FIRST_RECORD;
+    uint32_t hdr;
+    while (record_at(page, offset, hdr)) {
+        if (!(hdr & HeapPage::DELETED)) {
+            uint32_t body = exact_body(page, offset, hdr);
+            slots.push_back(Slot{offset, to, hdr, body});
+            to += HeapPage::RECORD_HEADER + body;
+        }
+        offset += HeapPage::RECORD_HEADER + (hdr & HeapPage::LEN_MASK);
+    }
+    auto remap = [&](RecordId &rid) {
+        if (rid.page_number != page_no) return;
+        auto it = std::lower_bound(slots.begin(), slots.end(), rid.offset,
+                                   [](const Slot &s, uint32_t off) { return s.from < off; });
+        if (it != slots.end() && it->from == rid.offset) rid.offset = it->to;
+    };
+
+    char image[sizeof(page.data)] = {};
+    for (const Slot &s : slots) {
+        uint32_t h = (s.hdr & ~HeapPage::LEN_MASK) | s.body;
+        char *body = image + s.to + HeapPage::RECORD_HEADER;
+        std::memcpy(image + s.to, &h, sizeof(h));
+        std::memcpy(body, page.data + s.from + HeapPage::RECORD_HEADER, s.body);
+        if (s.hdr & (HeapPage::FORWARD | HeapPage::MOVED)) {
+            // a FORWARD and its MOVED tuple point at each other
+            RecordId partner;
+            std::memcpy(&partner, body, sizeof(partner));
+            remap(partner);
+            std::memcpy(body, &partner, sizeof(partner));
+            if (partner.page_number != page_no && s.from != s.to)
+                fixups.emplace_back(partner, RecordId{page_no, s.to});
+        }
+        if (!(s.hdr & HeapPage::MOVED) && s.from != s.to)
+            moved.push_back(RecordMove{RecordId{page_no, s.from}, RecordId{page_no, s.to}});
+    }
+    std::memcpy(page.data, image, sizeof(image));
+    HeapPage::set_used_bytes(page, to - HeapPage::FIRST_RECORD);
+    uint32_t largest = free_end(page);
+    bp.unpin_page(frame, true);
+    if (fsm_) fsm_->set(segment_id_, page_no, largest);
+
+    for (const auto &[partner, ptr] : fixups) {
+        Frame *f = bp.fetch_page(PageId{segment_id_, partner.page_number}, true);
+        std::memcpy(f->page.data + partner.offset + HeapPage::RECORD_HEADER, &ptr, sizeof(ptr));
+        bp.unpin_page(f, true);
+    }
+}
+
+bool TableHeap::EvacuatePage(BufferPool &bp, uint32_t page_no, std::vector<RecordMove> &moved) {
+    PageId pid{segment_id_, page_no};
+    uint32_t offset = HeapPage::FIRST_RECORD;
+    while (true) {
+        // re-read for every record: moving one can rewrite its partner on this page
+        Frame *frame = bp.fetch_page(pid, true);
+        const Page &page = frame->page;
+        uint32_t hdr = 0;
+        while (record_at(page, offset, hdr) && (hdr & HeapPage::DELETED))
+            offset += HeapPage::RECORD_HEADER + (hdr & HeapPage::LEN_MASK);
+        if (!record_at(page, offset, hdr)) {
             bp.unpin_page(frame, false);
-        } catch (const std::out_of_range&) {
-            break; // no more pages
+            return true;
+        }
+
+        const char *start = page.data + offset + HeapPage::RECORD_HEADER;
+        uint32_t flags = hdr & (HeapPage::MOVED | HeapPage::VERSIONED);
+        RecordId partner{};
+        std::vector<char> body;
+        if (hdr & (HeapPage::FORWARD | HeapPage::MOVED)) std::memcpy(&partner, start, sizeof(partner));
+        if (hdr & HeapPage::FORWARD) {
+            // the moved tuple comes home: its version and tuple, without the
+            // back pointer (latches are not recursive: it may be on this page)
+            bool same_page = partner.page_number == page_no;
+            Frame *mf = same_page ? frame : bp.fetch_page(PageId{segment_id_, partner.page_number});
+            uint32_t mhdr = HeapPage::record_header(mf->page, partner.offset);
+            const char *tuple = HeapPage::tuple_at(mf->page, partner.offset, mhdr);
+            const char *from = mf->page.data + HeapPage::version_offset(partner.offset, mhdr);
+            body.assign(from, tuple + Tuple::serialized_size(tuple));
+            flags = mhdr & HeapPage::VERSIONED;
+            if (!same_page) bp.unpin_page(mf, false);
+        } else {
+            body.assign(start, start + exact_body(page, offset, hdr));
         }
+        bp.unpin_page(frame, false);
+
+        RecordId to;
+        if (!Reuse(bp, body, flags, page_no, to)) return false;
 
-        page_no++;
+        RecordId here{page_no, offset};
+        frame = bp.fetch_page(pid, true);
+        Kill(frame->page, page_no, offset);
+        offset += HeapPage::RECORD_HEADER + HeapPage::record_len(frame->page, offset);
+        bp.unpin_page(frame, true);
+
+        if (hdr & (HeapPage::FORWARD | HeapPage::MOVED)) {
+            Frame *pf = bp.fetch_page(PageId{segment_id_, partner.page_number}, true);
+            if (hdr & HeapPage::FORWARD) Kill(pf->page, partner.page_number, partner.offset);
+            else std::memcpy(pf->page.data + partner.offset + HeapPage::RECORD_HEADER, &to, sizeof(to));
+            bp.unpin_page(pf, true);
+        }
+        if (!(hdr & HeapPage::MOVED)) moved.push_back(RecordMove{here, to});
     }
+}
 
-    return results;
+void TableHeap::Truncate(BufferPool &bp, uint32_t pages) {
+    bp.truncate_segment(segment_id_, pages);
+    if (fsm_) fsm_->truncate(segment_id_, pages);
+}
+
+uint32_t TableHeap::PruneDeleted(BufferPool &bp, uint32_t page_no, TxnId horizon, const AbortedIds *aborted,
+                                 std::vector<PrunedRow> &pruned) {
+    // the row version lives with the tuple: a moved row is found on the page
+    // holding its MOVED record, under its home id
+    auto ended = [&](TxnId id) { return id != 0 && id < horizon; };
+    auto aborted_id = [&](TxnId id) { return aborted && aborted->contains(id); };
+    std::vector<RecordId> gone;
+    uint32_t kept = 0;
+    Frame *frame = bp.fetch_page(PageId{segment_id_, page_no});
+    const Page &page = frame->page;
+    uint32_t offset = HeapPage::FIRST_RECORD;
+    uint32_t hdr;
+    while (record_at(page, offset, hdr)) {
+        uint32_t xmin, xmax;
+        HeapPage::version_at(page, offset, hdr, xmin, xmax);
+        if (xmax != 0 && xmax >= horizon) kept++;
+        if ((ended(xmax) && !aborted_id(xmax)) || (ended(xmin) && aborted_id(xmin))) {
+            RecordId id{page_no, offset};
+            if (hdr & HeapPage::MOVED) std::memcpy(&id, page.data + offset + HeapPage::RECORD_HEADER, sizeof(id));
+            const char *tuple = HeapPage::tuple_at(page, offset, hdr);
+            gone.push_back(id);
+            pruned.push_back(PrunedRow{id, Tuple::deserialize(tuple)});
+        }
+        offset += HeapPage::RECORD_HEADER + (hdr & HeapPage::LEN_MASK);
+    }
+    bp.unpin_page(frame, false);
+
+    for (const RecordId &id : gone) Erase(bp, id);
+    return kept;
 }
@@ -1,21 +1,205 @@
 #pragma once
 
+#include <utility>
 #include <vector>
 #include "src/storage/page/page.h"
+#include "src/storage/page/heap_page.h"
 #include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/table/free_space_map.h"
+#include "src/storage/mvcc/transaction.h"
 #include "src/storage/table/tuple.h"  // Including all Value/Tuple types
 
 namespace storage {
 
+// Location of a record: page within the table segment + byte offset of the
+// record header inside Page::data.
+struct RecordId {
+    uint32_t page_number;
+    uint32_t offset;
+
+    bool operator==(const RecordId &o) const { return page_number == o.page_number && offset == o.offset; }
+    bool operator!=(const RecordId &o) const { return !(*this == o); }
+};
+
+// A row whose id changed because vacuum moved its record
+struct RecordMove {
+    RecordId from;
+    RecordId to;
+};
+
+// A deleted row vacuum removed for good, as it was last stored
+struct PrunedRow {
+    RecordId rid;
+    Tuple tuple;
+};
+
+// A row as it was before a transaction updated or deleted it, to put it back
+// if that transaction aborts
+struct RowUndo {
+    uint32_t segment_id;
+    RecordId rid;
+    TxnId xmin;
+    std::vector<char> tuple;
+
+    // as an UNDO log record of transaction `xid`, and back
+    WalRecord log_record(TxnId xid) const;
+    static bool from_log(const WalRecord &rec, TxnId &xid, RowUndo &out);
+};
+
+// Space accounting of one heap page, in bytes of Page::data
+struct PageUsage {
+    uint32_t used = 0;           // record area in use
+    uint32_t live = 0;           // what compaction keeps: headers + exact bodies
+    uint32_t largest_free = 0;   // largest body a tombstone or the free end can take
+
+    double dead_ratio() const { return used == 0 ? 0.0 : 1.0 - static_cast<double>(live) / used; }
+};
+
+// A row keeps its RecordId until vacuum moves it: an update that outgrows the slot moves
+// the tuple and leaves a FORWARD in the original record (see HeapPage).
+// With a FreeSpaceMap, space freed by deletes and moves is reused by inserts.
+//
+// With a transaction, rows are versioned: inserts and updates stamp the row
+// with the transaction id, an update hands the version it replaces to the
+// VersionStore, a delete only stamps the deleter (vacuum removes the row once
+// no snapshot can see it any more), and reads return the version the
+// snapshot sees. Updates and deletes also note the version they replace in
+// the transaction's undo list and in the log (recovery puts the rows of
+// transactions a crash cut off back from there). Without one, every stored
+// row is read as it is.
 class TableHeap {
 public:
-    explicit TableHeap(uint32_t segment_id) : segment_id_(segment_id) {}
+    explicit TableHeap(uint32_t segment_id, FreeSpaceMap *fsm = nullptr, const Txn *txn = nullptr)
+        : segment_id_(segment_id), fsm_(fsm), txn_(txn) {}
 
     // Read all rows from this table
     std::vector<std::vector<Value>> Scan(BufferPool &bp);
 
+    // Store a serialized tuple in a free hole or at the end of the last page
+    // (or a fresh one) and return its id
+    RecordId Insert(BufferPool &bp, const std::vector<char> &payload);
+
+    // Fetch one row by id; false if rid does not point at a live row
+    bool Get(BufferPool &bp, const RecordId &rid, Tuple &out);
+    // Same, as the serialized tuple
+    bool Read(BufferPool &bp, const RecordId &rid, std::vector<char> &tuple) { return ReadAt(bp, rid, rid, tuple); }
+    // Same, starting at `at`, where the row's FORWARD pointed
+    bool ReadAt(BufferPool &bp, const RecordId &rid, const RecordId &at, std::vector<char> &tuple);
+    // The stored version of row `rid` whatever the snapshot, with the id that
+    // wrote it; false if the row is gone or deleted. For a writer holding the
+    // row, to see what committed since its snapshot.
+    bool GetLatest(BufferPool &bp, const RecordId &rid, Tuple &out, TxnId &xmin);
+
+    // Replace the tuple of row `rid`; false if it is not a live row. Writes in
+    // place when the tuple fits the slot, else moves it. `stored_at` receives
+    // the page/offset now holding the tuple. Rows stored before forwarding
+    // existed may be too small for a FORWARD; those get a new id in `rid`.
+    bool Update(BufferPool &bp, RecordId &rid, const std::vector<char> &payload, RecordId &stored_at);
+
+    // Delete row `rid`; false if it is not a live row. Without a transaction
+    // the record (and its moved tuple) becomes a tombstone right away.
+    bool Delete(BufferPool &bp, const RecordId &rid);
+
+    // Put row `undo.rid` back as it was before transaction `xid` updated or
+    // deleted it, unless that was undone already; the tuple it replaces goes
+    // to `replaced`. False if nothing was put back.
+    bool Restore(BufferPool &bp, const RowUndo &undo, TxnId xid, std::vector<char> &replaced);
+
+    // Visit every live row in page order: fn(const RecordId &, const char *tuple, uint32_t len).
+    // A moved row is visited after the other rows of its home page (under
+    // the home id), so a row an update moves meanwhile is still visited once.
+    template <typename Fn>
+    void ForEach(BufferPool &bp, Fn &&fn) {
+        ForEach(bp, std::forward<Fn>(fn), [](uint32_t) { return true; });
+    }
+
+    // Same, but pages for which keep_page(page_no) is false are not fetched at all
+    template <typename Fn, typename PageFilter>
+    void ForEach(BufferPool &bp, Fn &&fn, PageFilter &&keep_page) {
+        std::vector<char> copy;
+        std::vector<std::pair<RecordId, RecordId>> forwarded;   // home, moved tuple
+        uint32_t pages = bp.page_count(segment_id_);
+        for (uint32_t page_no = 0; page_no < pages; ++page_no) {
+            if (!keep_page(page_no)) continue;
+            Frame *frame = bp.fetch_page(PageId{segment_id_, page_no});
+            const Page &page = frame->page;
+            uint32_t end = HeapPage::FIRST_RECORD + HeapPage::used_bytes(page);
+            uint32_t offset = HeapPage::FIRST_RECORD;
+            while (offset + HeapPage::RECORD_HEADER <= end) {
+                uint32_t hdr = HeapPage::record_header(page, offset);
+                uint32_t len = hdr & HeapPage::LEN_MASK;
+                if (len == 0 || offset + HeapPage::RECORD_HEADER + len > end) break;
+                RecordId id{page_no, offset};
+                if ((hdr & (HeapPage::FORWARD | HeapPage::DELETED)) == HeapPage::FORWARD) {
+                    RecordId to;
+                    std::memcpy(&to, page.data + offset + HeapPage::RECORD_HEADER, sizeof(RecordId));
+                    forwarded.emplace_back(id, to);
+                } else if (const char *tuple = HeapPage::tuple_at(page, offset, hdr);
+                           tuple && !(hdr & HeapPage::MOVED)) {
+                    const char *body_end = page.data + offset + HeapPage::RECORD_HEADER + len;
+                    uint32_t n = static_cast<uint32_t>(body_end - tuple);
+                    if (txn_ && (hdr & HeapPage::VERSIONED))
+                        tuple = VisibleTuple(*txn_, segment_id_, id, page, offset, hdr, n, copy);
+                    if (tuple) fn(id, tuple, n);
+                }
+                offset += HeapPage::RECORD_HEADER + len;
+            }
+            bp.unpin_page(frame, false);
+
+            for (const auto &[id, to] : forwarded)
+                if (ReadAt(bp, id, to, copy)) fn(id, copy.data(), static_cast<uint32_t>(copy.size()));
+            forwarded.clear();
+        }
+    }
+
+    uint32_t segment_id() const { return segment_id_; }
+
+    // The tuple of row `id` the transaction sees, given its record at `offset`
+    // of `page` (header `hdr`, tuple length in `len`): the stored tuple, an
+    // older version copied into `copy` (`len` updated), or nullptr when the
+    // row does not exist for the snapshot.
+    static const char *VisibleTuple(const Txn &txn, uint32_t segment_id, const RecordId &id, const Page &page,
+                                    uint32_t offset, uint32_t hdr, uint32_t &len, std::vector<char> &copy);
+
+    // ---- vacuum ----
+    PageUsage Usage(BufferPool &bp, uint32_t page_no);
+    // Slide the live records of a page together, dropping tombstones and the
+    // slack left by shrunken tuples. Rows whose id changed go to `moved`.
+    void CompactPage(BufferPool &bp, uint32_t page_no, std::vector<RecordMove> &moved);
+    // Move every live record of the page into lower pages; forwarded rows are
+    // brought back into one plain record. False if lower pages ran out of room.
+    bool EvacuatePage(BufferPool &bp, uint32_t page_no, std::vector<RecordMove> &moved);
+    // drop the pages from `pages` on (they must hold no live record)
+    void Truncate(BufferPool &bp, uint32_t pages);
+    // Remove the rows of the page deleted below `horizon` (seen deleted by
+    // every snapshot), and those an aborted transaction below it inserted,
+    // into `pruned`; returns how many deleted rows must stay
+    uint32_t PruneDeleted(BufferPool &bp, uint32_t page_no, TxnId horizon, const AbortedIds *aborted,
+                          std::vector<PrunedRow> &pruned);
+
 private:
     uint32_t segment_id_;
+    FreeSpaceMap *fsm_;
+    const Txn *txn_;
+
+    // Where the row's tuple is stored (after a FORWARD), with its header, row
+    // version and tuple bytes; false if `rid` is not a live row
+    bool Locate(BufferPool &bp, const RecordId &rid, RecordId &at, uint32_t &hdr, uint32_t &xmin, uint32_t &xmax,
+                std::vector<char> &tuple);
+    // store `body` (version + tuple, `flags` 0 or VERSIONED) as row `rid`; see Update
+    bool Rewrite(BufferPool &bp, RecordId &rid, const std::vector<char> &body, uint32_t flags, RecordId &stored_at);
+    // tombstone the record of row `rid` and its moved tuple
+    bool Erase(BufferPool &bp, const RecordId &rid);
+    // note in the transaction's undo list the version of `rid` it replaces,
+    // and in the log ahead of the change
+    void Remember(BufferPool &bp, const RecordId &rid, TxnId xmin, const std::vector<char> &tuple);
+
+    // write a record body with `flags` into a hole or the tail; returns its location
+    RecordId Place(BufferPool &bp, const std::vector<char> &body, uint32_t flags);
+    // same, but only into free space the map knows of on pages below `below`
+    bool Reuse(BufferPool &bp, const std::vector<char> &body, uint32_t flags, uint32_t below, RecordId &rid);
+    // mark a record dead and report its slot to the free space map
+    void Kill(Page &page, uint32_t page_no, uint32_t offset);
 };
 
 } // namespace storage
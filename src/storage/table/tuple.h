@@ -138,6 +138,24 @@ public:
         return Tuple(vals);
     }
 
+    // bytes taken by the serialized tuple at `ptr`
+    static uint32_t serialized_size(const char *ptr) {
+        const char *p = ptr;
+        uint16_t num_values;
+        std::memcpy(&num_values, p, sizeof(uint16_t));
+        p += sizeof(uint16_t);
+        for (int i = 0; i < num_values; i++) {
+            if (static_cast<ValueType>(*p++) == ValueType::INT) {
+                p += sizeof(int32_t);
+            } else {
+                uint16_t len;
+                std::memcpy(&len, p, sizeof(uint16_t));
+                p += sizeof(uint16_t) + len;
+            }
+        }
+        return static_cast<uint32_t>(p - ptr);
+    }
+
 private:
     std::vector<Value> values_;
 };
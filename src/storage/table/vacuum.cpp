@@ -0,0 +1,66 @@
+#include "src/storage/table/vacuum.h"
+
+#include <cmath>
+
+using namespace storage;
+
+size_t Vacuum::step(uint32_t segment_id, size_t budget, Changes &changes, bool &done) {
+    if (!active_ || segment_id != segment_id_) {
+        active_ = true;
+        segment_id_ = segment_id;
+        next_page_ = 0;
+        shrinking_ = false;
+        stats_ = Stats{};
+        stats_.pages = bp_.page_count(segment_id);
+    }
+    done = false;
+    TableHeap heap(segment_id, &fsm_);
+    size_t spent = 0;
+
+    // remove dead rows, measure, compact dense-enough garbage in place, publish free space
+    std::vector<RecordMove> &moved = changes.moved;
+    uint32_t pages = bp_.page_count(segment_id);
+    while (!shrinking_ && spent < budget && changes.empty()) {
+        if (next_page_ >= pages) {
+            shrinking_ = true;
+            break;
+        }
+        uint32_t page_no = next_page_++;
+        size_t before = changes.pruned.size();
+        stats_.kept += heap.PruneDeleted(bp_, page_no, horizon_, aborted_.get(), changes.pruned);
+        stats_.pruned += changes.pruned.size() - before;
+        PageUsage u = heap.Usage(bp_, page_no);
+        spent++;
+        stats_.used += u.used;
+        stats_.live += u.live;
+        if (u.dead_ratio() >= PAGE_DEAD_RATIO && u.used - u.live >= PAGE_DEAD_MIN_BYTES) {
+            heap.CompactPage(bp_, page_no, moved);
+            stats_.compacted++;
+            spent++;
+        } else {
+            fsm_.set(segment_id, page_no, u.largest_free);
+        }
+    }
+
+    // move the rows of trailing pages down and truncate the file
+    const double page_bytes = (PAGE_PAYLOAD_SIZE - HeapPage::FIRST_RECORD) * TAIL_FILL;
+    uint32_t needed = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(stats_.live / page_bytes)));
+    while (shrinking_ && spent < budget && changes.empty()) {
+        pages = bp_.page_count(segment_id);
+        if (pages <= needed) {
+            done = true;
+            break;
+        }
+        bool emptied = heap.EvacuatePage(bp_, pages - 1, moved);
+        spent += 2;
+        if (!emptied) {
+            done = true;
+            break;
+        }
+        heap.Truncate(bp_, pages - 1);
+        stats_.truncated++;
+    }
+
+    if (done) active_ = false;
+    return spent;
+}
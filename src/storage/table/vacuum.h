@@ -0,0 +1,79 @@
+#pragma once
+
+#include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/table/free_space_map.h"
+#include "src/storage/table/table_heap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace storage {
+
+// Space reclamation for one table heap at a time, run in small steps.
+// A pass first removes the rows every snapshot sees deleted (deleted below
+// the horizon) or never sees (inserted by an aborted transaction) and measures every page: pages whose dead share (tombstones and the
+// slack of shrunken tuples) reaches PAGE_DEAD_RATIO are compacted in place, the
+// free space of the others is reported to the FreeSpaceMap. It then
+// empties sparse pages at the end of the segment into the space below them and
+// cuts them off the file, until the live data fills the pages at TAIL_FILL.
+class Vacuum {
+public:
+    static constexpr double PAGE_DEAD_RATIO = 0.2;
+    static constexpr uint32_t PAGE_DEAD_MIN_BYTES = 256;
+    static constexpr double TAIL_FILL = 0.9;
+
+    struct Stats {
+        uint32_t pages = 0;       // at the start of the pass
+        uint64_t used = 0;        // record bytes before the pass
+        uint64_t live = 0;
+        uint32_t compacted = 0;
+        uint32_t truncated = 0;   // pages cut off the end
+        uint64_t pruned = 0;      // deleted rows removed
+        uint64_t kept = 0;        // deleted rows some snapshot may still see
+    };
+
+    // Rows a step moved or removed; both must reach the indexes before the next step
+    struct Changes {
+        std::vector<RecordMove> moved;
+        std::vector<PrunedRow> pruned;
+
+        bool empty() const { return moved.empty() && pruned.empty(); }
+        void clear() {
+            moved.clear();
+            pruned.clear();
+        }
+    };
+
+    Vacuum(BufferPool &bp, FreeSpaceMap &fsm) : bp_(bp), fsm_(fsm) {}
+
+    // deleted rows are removed once their deleter is below `horizon`, rows
+    // of aborted transactions once those are
+    void set_horizon(TxnId horizon, std::shared_ptr<const AbortedIds> aborted) {
+        horizon_ = horizon;
+        aborted_ = std::move(aborted);
+    }
+
+    // Continue the pass over `segment_id` (a different segment starts a new
+    // pass), touching about `budget` pages. Returns early once rows changed id
+    // or went away, listed in `changes`.
+    // `done` is set when the pass is over; stats() then describes it.
+    size_t step(uint32_t segment_id, size_t budget, Changes &changes, bool &done);
+
+    const Stats &stats() const { return stats_; }
+
+private:
+    BufferPool &bp_;
+    FreeSpaceMap &fsm_;
+    TxnId horizon_ = 0;
+    std::shared_ptr<const AbortedIds> aborted_;
+
+    bool active_ = false;
+    uint32_t segment_id_ = 0;
+    uint32_t next_page_ = 0;   // scan phase cursor
+    bool shrinking_ = false;
+    Stats stats_;
+};
+
+} // namespace storage
@@ -0,0 +1,79 @@
+#include "src/storage/table/zone_map.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace storage;
+
+ZoneMap::ZoneMap(uint32_t segment_id, std::vector<size_t> columns)
+    : segment_id_(segment_id), columns_(std::move(columns)) {
+    entry_size_ = static_cast<uint32_t>(sizeof(uint32_t) + columns_.size() * sizeof(ColumnZone));
+    entries_per_page_ = static_cast<uint32_t>(PAGE_PAYLOAD_SIZE / entry_size_);
+}
+
+int ZoneMap::slot_of(size_t column) const {
+    for (size_t i = 0; i < columns_.size(); ++i)
+        if (columns_[i] == column) return static_cast<int>(i);
+    return -1;
+}
+
+void ZoneMap::Update(BufferPool &bp, uint32_t heap_page, const std::vector<Value> &row) {
+    if (columns_.empty()) return;
+
+    PageId pid{segment_id_, heap_page / entries_per_page_};
+    while (bp.page_count(segment_id_) <= pid.page_number) bp.allocate_page(segment_id_);
+
+    Frame *f = bp.fetch_page(pid, true);
+    char *entry = f->page.data + entry_offset(heap_page);
+
+    uint32_t rows = 0;
+    std::memcpy(&rows, entry, sizeof(uint32_t));
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        char *zp = entry + sizeof(uint32_t) + i * sizeof(ColumnZone);
+        ColumnZone z;
+        std::memcpy(&z, zp, sizeof(z));
+        if (rows == 0) z = ColumnZone{INT32_MAX, INT32_MIN, 0};
+
+        size_t col = columns_[i];
+        if (col < row.size() && row[col].type() == ValueType::INT) {
+            int32_t v = row[col].as_int();
+            if (v < z.min) z.min = v;
+            if (v > z.max) z.max = v;
+        } else {
+            z.null_count++;
+        }
+        std::memcpy(zp, &z, sizeof(z));
+    }
+    rows++;
+    std::memcpy(entry, &rows, sizeof(uint32_t));
+    bp.unpin_page(f, true);
+}
+
+bool ZoneMap::MayMatch(BufferPool &bp, uint32_t heap_page, const std::vector<IntRange> &ranges) {
+    if (columns_.empty() || ranges.empty()) return true;
+
+    Frame *f = nullptr;
+    try {
+        f = bp.fetch_page(PageId{segment_id_, heap_page / entries_per_page_});
+    } catch (const std::out_of_range &) {
+        return true; // page predates the zone map
+    }
+    const char *entry = f->page.data + entry_offset(heap_page);
+
+    uint32_t rows = 0;
+    std::memcpy(&rows, entry, sizeof(uint32_t));
+    bool match = true;
+    if (rows != 0) {
+        for (const auto &r : ranges) {
+            ColumnZone z;
+            std::memcpy(&z, entry + sizeof(uint32_t) + r.slot * sizeof(ColumnZone), sizeof(z));
+            // rows without an INT value never satisfy a comparison
+            if (z.null_count == rows || z.max < r.lo || z.min > r.hi) {
+                match = false;
+                break;
+            }
+        }
+    }
+    bp.unpin_page(f, false);
+    return match;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/table/tuple.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace storage {
+
+// Per-heap-page summary of the INT columns of a table, kept in a side segment.
+// Each heap page gets one fixed-size entry:
+//   [rows u32] then per tracked column [min i32][max i32][nulls u32]
+// Entries are only ever widened (deleted and updated rows leave their old
+// bounds behind), so a page whose entry cannot satisfy a range predicate can
+// be skipped without being read.
+class ZoneMap {
+public:
+    struct ColumnZone {
+        int32_t min;
+        int32_t max;
+        uint32_t null_count;
+    };
+
+    // inclusive bound on one tracked column; `slot` indexes the tracked columns
+    struct IntRange {
+        size_t slot;
+        int64_t lo;
+        int64_t hi;
+    };
+
+    // columns = positions (in the row) of the INT columns to track
+    ZoneMap(uint32_t segment_id, std::vector<size_t> columns);
+
+    bool empty() const { return columns_.empty(); }
+    // slot of a row column in this map, or -1 if not tracked
+    int slot_of(size_t column) const;
+
+    void Update(BufferPool &bp, uint32_t heap_page, const std::vector<Value> &row);
+    // false only if no row on the page can fall inside every range
+    bool MayMatch(BufferPool &bp, uint32_t heap_page, const std::vector<IntRange> &ranges);
+
+private:
+    uint32_t segment_id_;
+    std::vector<size_t> columns_;
+    uint32_t entry_size_;
+    uint32_t entries_per_page_;
+
+    uint32_t entry_offset(uint32_t heap_page) const {
+        return (heap_page % entries_per_page_) * entry_size_;
+    }
+};
+
+} // namespace storage
@@ -0,0 +1,202 @@
+#include "src/storage/wal/recovery.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+using namespace storage;
+
+static uint64_t page_key(uint32_t segment_id, uint32_t page_number) {
+    return (static_cast<uint64_t>(segment_id) << 32) | page_number;
+}
+
+Recovery::Stats Recovery::run(unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    Stats st;
+
+    wal_.scan(wal_.base_lsn(), [&](Lsn lsn, const WalRecord &rec) {
+        TxnId xid;
+        RowUndo row;
+        if (rec.type == WalType::COMMIT) {
+            if (rec.payload.size() >= sizeof(xid)) {
+                std::memcpy(&xid, rec.payload.data(), sizeof(xid));
+                committed_.insert(xid);
+            }
+        } else if (rec.type == WalType::UNDO) {
+            if (RowUndo::from_log(rec, xid, row)) undo_.emplace_back(xid, std::move(row));
+        } else {
+            entries_.push_back(Entry{lsn, rec.type, rec.segment_id, rec.page_number, rec.payload});
+            segments_.insert(rec.segment_id);
+        }
+    });
+    // the committed ones keep their changes
+    undo_.erase(std::remove_if(undo_.begin(), undo_.end(),
+                               [&](const std::pair<TxnId, RowUndo> &u) { return committed_.count(u.first) > 0; }),
+                undo_.end());
+    std::vector<uint32_t> todo = settle_truncations();
+    st.records = todo.size();
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, todo.size() / PREFETCH_PAGES)));
+    st.threads = threads;
+
+    // a page always goes to the same worker, so its records stay in log order
+    std::vector<std::vector<uint32_t>> parts(threads);
+    for (uint32_t i : todo) {
+        const Entry &e = entries_[i];
+        uint64_t h = page_key(e.segment_id, e.page_number) * 0x9E3779B97F4A7C15ull;
+        parts[(h >> 32) % threads].push_back(i);
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> done(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (unsigned w = 1; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            try {
+                done[w] = redo(parts[w]);
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        });
+    }
+    try {
+        done[0] = redo(parts[0]);
+    } catch (...) {
+        errors[0] = std::current_exception();
+    }
+    for (auto &t : workers) t.join();
+    for (auto &e : errors)
+        if (e) std::rethrow_exception(e);
+    for (const auto &d : done) {
+        st.applied += d.first;
+        st.pages += d.second;
+    }
+
+    // the replayed pages are durable; the log goes with the checkpoint after the undo
+    sm_.sync();
+    entries_.clear();
+
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return st;
+}
+
+std::vector<uint32_t> Recovery::settle_truncations() {
+    // walking backwards, cut[seg] is the smallest size the segment is cut to
+    // later in the log: records of pages at or above it are lost anyway
+    std::unordered_map<uint32_t, uint32_t> cut;
+    std::unordered_map<uint32_t, uint32_t> need;   // pages the kept records reach
+    std::vector<uint32_t> todo;
+    for (size_t i = entries_.size(); i-- > 0;) {
+        const Entry &e = entries_[i];
+        auto it = cut.find(e.segment_id);
+        if (e.type == WalType::TRUNCATE) {
+            if (it == cut.end()) cut.emplace(e.segment_id, e.page_number);
+            else it->second = std::min(it->second, e.page_number);
+            continue;
+        }
+        if (it != cut.end() && e.page_number >= it->second) continue;
+        uint32_t &n = need[e.segment_id];
+        n = std::max(n, e.page_number + 1);
+        todo.push_back(static_cast<uint32_t>(i));
+    }
+    std::reverse(todo.begin(), todo.end());
+
+    // A page kept above its segment's smallest size was allocated again after
+    // that TRUNCATE, so its records start with PAGE_INIT: cut the file, then
+    // grow it back to what the records reach.
+    for (const auto &kv : cut)
+        if (sm_.page_count(kv.first) > kv.second) sm_.truncate(kv.first, kv.second);
+    for (const auto &kv : need) sm_.extend(kv.first, kv.second);
+    return todo;
+}
+
+std::pair<uint64_t, uint64_t> Recovery::redo(const std::vector<uint32_t> &mine) {
+    // records per page in log order, pages in file order
+    std::unordered_map<uint64_t, std::vector<uint32_t>> by_page;
+    std::vector<uint64_t> pages;
+    for (uint32_t i : mine) {
+        const Entry &e = entries_[i];
+        auto &list = by_page[page_key(e.segment_id, e.page_number)];
+        if (list.empty()) pages.push_back(page_key(e.segment_id, e.page_number));
+        list.push_back(i);
+    }
+    std::sort(pages.begin(), pages.end());
+
+    uint64_t applied = 0;
+    std::vector<Page> buf(PREFETCH_PAGES);
+    std::vector<bool> changed(PREFETCH_PAGES);
+    for (size_t b = 0; b < pages.size(); b += PREFETCH_PAGES) {
+        size_t n = std::min<size_t>(PREFETCH_PAGES, pages.size() - b);
+        // the batch as runs of consecutive pages: [i, j) are read with one call
+        for (size_t i = 0, j; i < n; i = j) {
+            for (j = i + 1; j < n && pages[b + j] == pages[b + j - 1] + 1; ++j) {}
+            sm_.read_pages(static_cast<uint32_t>(pages[b + i] >> 32), static_cast<uint32_t>(pages[b + i]),
+                           static_cast<uint32_t>(j - i), &buf[i]);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            changed[i] = false;
+            // records starting with the whole page rebuild it whatever the
+            // disk holds: a torn write may have left any LSN there
+            const std::vector<uint32_t> &records = by_page[pages[b + i]];
+            WalType first = entries_[records.front()].type;
+            bool whole = first == WalType::PAGE_IMAGE || first == WalType::PAGE_INIT;
+            for (uint32_t r : records) {
+                const Entry &e = entries_[r];
+                if (!whole && e.lsn <= buf[i].lsn()) continue;
+                apply(buf[i], e);
+                changed[i] = true;
+                applied++;
+            }
+        }
+
+        for (size_t i = 0, j; i < n; i = j) {
+            if (!changed[i]) {
+                j = i + 1;
+                continue;
+            }
+            for (j = i + 1; j < n && changed[j] && pages[b + j] == pages[b + j - 1] + 1; ++j) {}
+            sm_.write_pages(&buf[i], static_cast<uint32_t>(j - i));
+        }
+    }
+    return {applied, pages.size()};
+}
+
+void Recovery::apply(Page &page, const Entry &e) {
+    PageId pid{e.segment_id, e.page_number};
+    const std::string &p = e.payload;
+    switch (e.type) {
+    case WalType::PAGE_INIT: {
+        uint16_t type = static_cast<uint16_t>(PageType::TABLE_HEAP);
+        if (p.size() >= sizeof(type)) std::memcpy(&type, p.data(), sizeof(type));
+        page.reset(pid, static_cast<PageType>(type));
+        break;
+    }
+    case WalType::PAGE_IMAGE:
+        if (p.size() != sizeof(Page)) throw std::runtime_error("bad page image in the log");
+        std::memcpy(&page, p.data(), sizeof(Page));
+        break;
+    case WalType::PAGE_DELTA: {
+        char *dst = reinterpret_cast<char *>(&page);
+        for (size_t at = 0; at < p.size();) {
+            uint16_t run[2];
+            if (p.size() - at < sizeof(run)) throw std::runtime_error("bad page delta in the log");
+            std::memcpy(run, p.data() + at, sizeof(run));
+            at += sizeof(run);
+            if (run[1] > p.size() - at || size_t(run[0]) + run[1] > PAGE_SIZE)
+                throw std::runtime_error("bad page delta in the log");
+            std::memcpy(dst + run[0], p.data() + at, run[1]);
+            at += run[1];
+        }
+        break;
+    }
+    default:
+        return;
+    }
+    page.set_lsn(e.lsn);
+}
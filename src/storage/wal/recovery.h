@@ -0,0 +1,83 @@
+#pragma once
+
+#include "src/storage/mvcc/transaction.h"
+#include "src/storage/segment/segment_manager.h"
+#include "src/storage/table/table_heap.h"
+#include "src/storage/wal/wal.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace storage {
+
+// Redo pass run at startup, before the buffer pool caches any page. Every
+// record since the last checkpoint is replayed onto the segment files when it
+// is newer than the page it describes (record LSN > page LSN), which repeats
+// history up to the crash, statements cut short included. A page whose first
+// record is PAGE_IMAGE or PAGE_INIT (every page changed since the checkpoint,
+// see BufferPool) is rebuilt from that record without trusting the disk copy,
+// which a crash in the middle of writing it may have torn. It also collects
+// what undoing those takes: the ids with a COMMIT record, and the UNDO
+// records of the other ids, whose updated and deleted rows the engine puts
+// back (their inserts stay invisible, as ids that aborted) before a
+// checkpoint empties the log.
+//
+// Records of one page must be applied in log order, records of different
+// pages are independent: the pages are hashed across worker threads, each
+// reading its pages in batches of PREFETCH_PAGES (runs of consecutive pages
+// with one read) and writing back the ones it changed. TRUNCATE records are
+// settled up front: records of pages a later TRUNCATE cuts off are dropped,
+// every truncated segment is cut to its smallest size and grown again to the
+// pages the remaining records need (those start with PAGE_INIT).
+class Recovery {
+public:
+    static constexpr uint32_t PREFETCH_PAGES = 64;
+
+    struct Stats {
+        uint64_t records = 0;   // page records since the checkpoint (minus truncated pages)
+        uint64_t applied = 0;   // replayed (the rest were already on disk)
+        uint64_t pages = 0;     // distinct pages read
+        unsigned threads = 0;
+        double seconds = 0;
+    };
+
+    Recovery(SegmentManager &sm, Wal &wal) : sm_(sm), wal_(wal) {}
+
+    // Replay the log with `threads` workers (0 = one per core) and make the
+    // segment files durable. Throws on a record that does not fit its page.
+    Stats run(unsigned threads);
+
+    // after run(): the ids that committed since the checkpoint, and the rows
+    // to put back for the others, in log order
+    const std::unordered_set<TxnId> &committed() const { return committed_; }
+    const std::vector<std::pair<TxnId, RowUndo>> &undo() const { return undo_; }
+    // the segments with page records since the checkpoint
+    const std::unordered_set<uint32_t> &segments() const { return segments_; }
+
+private:
+    struct Entry {
+        Lsn lsn;
+        WalType type;
+        uint32_t segment_id;
+        uint32_t page_number;
+        std::string payload;
+    };
+
+    SegmentManager &sm_;
+    Wal &wal_;
+    std::vector<Entry> entries_;
+    std::unordered_set<TxnId> committed_;
+    std::vector<std::pair<TxnId, RowUndo>> undo_;
+    std::unordered_set<uint32_t> segments_;
+
+    // apply the TRUNCATE records; returns the page records left to replay
+    std::vector<uint32_t> settle_truncations();
+    // replay the entries listed (in log order) in `mine`; returns (applied, pages)
+    std::pair<uint64_t, uint64_t> redo(const std::vector<uint32_t> &mine);
+    static void apply(Page &page, const Entry &e);
+};
+
+} // namespace storage
@@ -0,0 +1,237 @@
+#include "src/storage/wal/wal.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace storage;
+
+static constexpr uint32_t WAL_MAGIC = 0x4C415742;   // "BWAL"
+static constexpr uint32_t WAL_VERSION = 1;
+static constexpr size_t FILE_HEADER = 16;
+static constexpr size_t RECORD_HEADER = 17;
+static constexpr size_t READ_CHUNK = 1 << 20;
+
+static uint32_t checksum(const char *p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void write_all(int fd, const char *p, size_t n, off_t at) {
+    while (n > 0) {
+        ssize_t w = ::pwrite(fd, p, n, at);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("wal write failed: ") + std::strerror(errno));
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+        at += w;
+    }
+}
+
+static void write_header(int fd, Lsn base) {
+    char hdr[FILE_HEADER];
+    std::memcpy(hdr, &WAL_MAGIC, 4);
+    std::memcpy(hdr + 4, &WAL_VERSION, 4);
+    std::memcpy(hdr + 8, &base, 8);
+    write_all(fd, hdr, sizeof(hdr), 0);
+}
+
+Wal::Wal(const std::string &dir) : path_(dir + "/wal.log") {
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) throw std::runtime_error("cannot open " + path_ + ": " + std::strerror(errno));
+
+    char hdr[FILE_HEADER];
+    if (::pread(fd_, hdr, sizeof(hdr), 0) != static_cast<ssize_t>(sizeof(hdr))) {
+        // new log: LSNs start at the file offset of the first record
+        base_ = FILE_HEADER;
+        write_header(fd_, base_);
+        if (::ftruncate(fd_, FILE_HEADER) != 0 || ::fsync(fd_) != 0)
+            throw std::runtime_error("cannot initialize " + path_);
+    } else {
+        uint32_t magic, version;
+        std::memcpy(&magic, hdr, 4);
+        std::memcpy(&version, hdr + 4, 4);
+        std::memcpy(&base_, hdr + 8, 8);
+        if (magic != WAL_MAGIC || version != WAL_VERSION) throw std::runtime_error("bad log header in " + path_);
+    }
+
+    // the log ends at the last intact record
+    Lsn end = scan_file(base_, nullptr);
+    if (::ftruncate(fd_, static_cast<off_t>(FILE_HEADER + (end - base_))) != 0)
+        throw std::runtime_error("cannot truncate " + path_);
+    buffer_lsn_ = flushed_ = end;
+}
+
+Wal::~Wal() {
+    try {
+        flush(end_lsn());
+    } catch (...) {
+    }
+    if (fd_ >= 0) ::close(fd_);
+}
+
+Lsn Wal::append(const WalRecord &rec) {
+    uint32_t len = static_cast<uint32_t>(RECORD_HEADER + rec.payload.size());
+    char hdr[RECORD_HEADER];
+    std::memcpy(hdr, &len, 4);
+    hdr[8] = static_cast<char>(rec.type);
+    std::memcpy(hdr + 9, &rec.segment_id, 4);
+    std::memcpy(hdr + 13, &rec.page_number, 4);
+    uint32_t sum = checksum(hdr + 8, RECORD_HEADER - 8);
+    for (char c : rec.payload) sum = (sum ^ static_cast<unsigned char>(c)) * 16777619u;
+    std::memcpy(hdr + 4, &sum, 4);
+
+    std::lock_guard<std::mutex> lg(mu_);
+    buffer_.append(hdr, sizeof(hdr));
+    buffer_.append(rec.payload);
+    return buffer_lsn_ + buffer_.size();
+}
+
+void Wal::flush(Lsn lsn) {
+    std::unique_lock<std::mutex> lk(mu_);
+    while (flushed_ < lsn) {
+        // records of a failed batch are gone: nothing later can be durable
+        if (failed_) throw std::runtime_error("wal flush failed: " + path_);
+        if (flushing_) {
+            flushed_cv_.wait(lk);
+            continue;
+        }
+        // lead this group: take everything appended so far
+        flushing_ = true;
+        std::string batch;
+        batch.swap(buffer_);
+        Lsn start = buffer_lsn_;
+        buffer_lsn_ += batch.size();
+        lk.unlock();
+
+        bool ok = true;
+        try {
+            write_all(fd_, batch.data(), batch.size(), static_cast<off_t>(FILE_HEADER + (start - base_)));
+            ok = ::fdatasync(fd_) == 0;
+        } catch (...) {
+            ok = false;
+        }
+
+        lk.lock();
+        flushing_ = false;
+        failed_ = !ok;
+        flushed_cv_.notify_all();
+        if (!ok) throw std::runtime_error("wal flush failed: " + path_);
+        flushed_ = start + batch.size();
+        syncs_++;
+    }
+}
+
+Lsn Wal::base_lsn() {
+    std::lock_guard<std::mutex> lg(mu_);
+    return base_;
+}
+
+Lsn Wal::end_lsn() {
+    std::lock_guard<std::mutex> lg(mu_);
+    return buffer_lsn_ + buffer_.size();
+}
+
+Lsn Wal::flushed_lsn() {
+    std::lock_guard<std::mutex> lg(mu_);
+    return flushed_;
+}
+
+uint64_t Wal::sync_count() {
+    std::lock_guard<std::mutex> lg(mu_);
+    return syncs_;
+}
+
+void Wal::scan(Lsn from, const std::function<void(Lsn, const WalRecord &)> &fn) {
+    scan_file(std::max(from, base_), fn);
+}
+
+void Wal::reset() {
+    Lsn end = end_lsn();
+    flush(end);
+
+    std::lock_guard<std::mutex> lg(mu_);
+    // a flush that started meanwhile would write into the old file
+    if (flushing_ || !buffer_.empty()) throw std::runtime_error("wal reset while appending: " + path_);
+    std::string tmp = path_ + ".tmp";
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("cannot create " + tmp + ": " + std::strerror(errno));
+    try {
+        write_header(fd, end);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (::fsync(fd) != 0 || ::rename(tmp.c_str(), path_.c_str()) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot replace " + path_ + ": " + std::strerror(errno));
+    }
+    // make the rename itself durable
+    std::string dir = path_.substr(0, path_.find_last_of('/'));
+    int dfd = ::open(dir.c_str(), O_RDONLY);
+    if (dfd >= 0) {
+        ::fsync(dfd);
+        ::close(dfd);
+    }
+    ::close(fd_);
+    fd_ = fd;
+    base_ = buffer_lsn_ = flushed_ = end;
+}
+
+// Walk the records from `from` (a record boundary) to the first torn or
+// missing one; returns the LSN where the intact log ends.
+Lsn Wal::scan_file(Lsn from, const std::function<void(Lsn, const WalRecord &)> &fn) {
+    std::vector<char> buf;
+    size_t pos = 0;   // read position in buf
+    off_t file_at = static_cast<off_t>(FILE_HEADER + (from - base_));
+    Lsn lsn = from;
+    WalRecord rec;
+
+    // make sure `need` bytes are buffered at pos; false at end of file
+    auto fill = [&](size_t need) {
+        if (buf.size() - pos >= need) return true;
+        buf.erase(buf.begin(), buf.begin() + static_cast<std::ptrdiff_t>(pos));
+        pos = 0;
+        while (buf.size() < need) {
+            size_t have = buf.size();
+            buf.resize(have + std::max(need - have, READ_CHUNK));
+            ssize_t r = ::pread(fd_, buf.data() + have, buf.size() - have, file_at);
+            if (r < 0 && errno == EINTR) r = 0;
+            buf.resize(have + static_cast<size_t>(std::max<ssize_t>(r, 0)));
+            if (r <= 0) return false;
+            file_at += r;
+        }
+        return true;
+    };
+
+    while (fill(RECORD_HEADER)) {
+        const char *p = buf.data() + pos;
+        uint32_t len, sum;
+        std::memcpy(&len, p, 4);
+        std::memcpy(&sum, p + 4, 4);
+        if (len < RECORD_HEADER || !fill(len)) break;
+        p = buf.data() + pos;
+        if (checksum(p + 8, len - 8) != sum) break;
+
+        lsn += len;
+        if (fn) {
+            rec.type = static_cast<WalType>(p[8]);
+            std::memcpy(&rec.segment_id, p + 9, 4);
+            std::memcpy(&rec.page_number, p + 13, 4);
+            rec.payload.assign(p + RECORD_HEADER, len - RECORD_HEADER);
+            fn(lsn, rec);
+        }
+        pos += len;
+    }
+    return lsn;
+}
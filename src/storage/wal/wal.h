@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace storage {
+
+using Lsn = uint64_t;
+
+enum class WalType : uint8_t {
+    PAGE_DELTA = 1,   // payload: runs of [offset u16][len u16][bytes] over the whole Page
+    PAGE_IMAGE = 2,   // payload: the whole Page
+    PAGE_INIT = 3,    // page (re)allocated: payload [page type u16]
+    TRUNCATE = 4,     // segment cut down to `page_number` pages
+    COMMIT = 5,       // payload: [xid u32]
+    UNDO = 6          // a row as it was before transaction xid changed it: [offset u32][xid u32][xmin u32][tuple]
+};
+
+struct WalRecord {
+    WalType type = WalType::COMMIT;
+    uint32_t segment_id = 0;
+    uint32_t page_number = 0;
+    std::string payload;
+};
+
+// Append-only redo log, <dir>/wal.log. The file starts with a header
+// [magic u32][version u32][base lsn u64] followed by records back to back:
+//   [len u32][checksum u32][type u8][segment u32][page u32][payload]
+// len covers the whole record, the checksum (FNV-1a) everything after it.
+// An LSN is the log position just past a record, so "durable up to L" covers
+// every record with LSN <= L; pages carry the LSN of their last change.
+// A checkpoint empties the log once every page it covers is on disk; the
+// header's base LSN is where the next one starts, so LSNs keep growing.
+//
+// append() only buffers. flush() is group commit: the first caller that finds
+// unwritten records writes everything buffered so far with one write and one
+// fdatasync; callers arriving meanwhile wait and are covered by the same sync.
+class Wal {
+public:
+    // opens or creates the log; a torn record at the end is cut off
+    explicit Wal(const std::string &dir);
+    ~Wal();
+    Wal(const Wal &) = delete;
+    Wal &operator=(const Wal &) = delete;
+
+    Lsn append(const WalRecord &rec);
+    // return once every record with LSN <= lsn is on disk
+    void flush(Lsn lsn);
+
+    Lsn base_lsn();
+    Lsn end_lsn();
+    Lsn flushed_lsn();
+    uint64_t sync_count();
+
+    // Visit the durable records with LSN > from, in log order
+    void scan(Lsn from, const std::function<void(Lsn, const WalRecord &)> &fn);
+
+    // Drop every record: the log restarts empty at end_lsn(). Only for a
+    // checkpoint, after the pages the records describe reached disk; the new
+    // file replaces the old one atomically (rename).
+    void reset();
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    Lsn base_ = 0;            // LSN of the first byte after the file header
+
+    std::mutex mu_;
+    std::condition_variable flushed_cv_;
+    std::string buffer_;      // appended, not yet written
+    Lsn buffer_lsn_ = 0;      // LSN of buffer_[0]
+    Lsn flushed_ = 0;
+    bool flushing_ = false;
+    bool failed_ = false;
+    uint64_t syncs_ = 0;
+
+    Lsn scan_file(Lsn from, const std::function<void(Lsn, const WalRecord &)> &fn);
+};
+
+} // namespace storage
@@ -0,0 +1,75 @@
+// EXPLAIN and ANALYZE: a table never analyzed uses any index that applies;
+// once ANALYZE has counted its values, an index on a column with few
+// distinct values loses to a sequential scan while a selective one keeps
+// its index. EXPLAIN ANALYZE reports what the chosen scan did.
+#include "tests/test_util.h"
+
+#include <string>
+
+// every line of an EXPLAIN, one plan node per line
+static std::string plan(Engine &engine, Session &session, const std::string &sql) {
+    test::Rows out;
+    engine.execute_sql(session, "EXPLAIN " + sql, out);
+    std::string text;
+    for (const auto &row : out.rows) text += row + "\n";
+    return text.empty() ? out.status_line : text;
+}
+
+static bool contains(const std::string &text, const std::string &part) {
+    if (text.find(part) != std::string::npos) return true;
+    std::cerr << "expected \"" << part << "\" in:\n" << text << std::endl;
+    return false;
+}
+
+int main() {
+    std::string dir = test::scratch_dir("explain");
+    Engine engine(test::config(dir));
+    std::string err;
+    if (!engine.init(err)) {
+        std::cerr << "init: " << err << std::endl;
+        return 1;
+    }
+    auto s = engine.open_session();
+    CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, k INT, s TEXT)")));
+    CHECK(test::ok(test::run(engine, *s, "CREATE INDEX t_id ON t (id) USING HASH")));
+    CHECK(test::ok(test::run(engine, *s, "CREATE INDEX t_k ON t (k) USING HASH")));
+    for (int from = 0; from < 20000; from += 2000) {
+        std::string sql = "INSERT INTO t VALUES ";
+        for (int i = from; i < from + 2000; ++i)
+            sql += (i == from ? "(" : ",(") + std::to_string(i) + ", " + std::to_string(i % 2) + ", 'row')";
+        CHECK(test::ok(test::run(engine, *s, sql)));
+    }
+
+    // no statistics yet: both predicates probe their index
+    CHECK(contains(plan(engine, *s, "SELECT COUNT(*) FROM t WHERE k = 1"), "Index Scan on t using t_k"));
+    CHECK(contains(plan(engine, *s, "SELECT s FROM t WHERE id = 42"), "Index Scan on t using t_id"));
+    // nothing to probe with
+    CHECK(contains(plan(engine, *s, "SELECT COUNT(*) FROM t WHERE k + 0 = 1"), "Seq Scan on t"));
+
+    CHECK(test::run(engine, *s, "ANALYZE t").rfind("OK: analyzed t (20000 rows, ", 0) == 0);
+
+    // k = 1 is half the table: reading every page beats 10000 random probes
+    std::string half = plan(engine, *s, "SELECT COUNT(*) FROM t WHERE k = 1");
+    CHECK(contains(half, "Seq Scan on t"));
+    CHECK(half.find("Index Scan") == std::string::npos);
+    // id = 42 is one row: still the index, with an estimate from the statistics
+    std::string one = plan(engine, *s, "SELECT s FROM t WHERE id = 42");
+    CHECK(contains(one, "Index Scan on t using t_id (est. rows=1"));
+
+    // the plans give the same answers either way
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE k = 1"), "10000");
+    CHECK_EQ(test::run(engine, *s, "SELECT id FROM t WHERE id = 42"), "42");
+
+    // EXPLAIN ANALYZE runs the query and counts what each node returned
+    std::string analyzed = plan(engine, *s, "ANALYZE SELECT id FROM t WHERE id = 42");
+    CHECK(contains(analyzed, "Index Scan on t using t_id"));
+    CHECK(contains(analyzed, "(rows=1, time="));
+    CHECK(contains(analyzed, "Execution time: "));
+
+    // EXPLAIN is for queries only
+    CHECK(test::run(engine, *s, "EXPLAIN DELETE FROM t").rfind("ERR", 0) == 0);
+
+    engine.shutdown();
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,148 @@
+// WHERE selection kernels: every kernel level this CPU runs (AVX2, SSE4.1)
+// must select exactly the rows the scalar kernels select, for each INT
+// predicate, at every tail length the vector loops leave over, and with
+// INT32_MIN / INT32_MAX both in the data and as constants.
+#include "tests/test_util.h"
+#include "src/execution/filter_kernels.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using Kernel = std::function<void(const int32_t *, size_t, uint8_t *)>;
+
+// the mask of `kernel` at `level`
+static std::vector<uint8_t> run_at(const char *level, const Kernel &kernel, const std::vector<int32_t> &v, size_t n) {
+    CHECK(set_filter_kernel_level(level));
+    // a guard byte past the end: kernels must not write beyond n
+    std::vector<uint8_t> mask(n + 1, 0xAB);
+    kernel(v.data(), n, mask.data());
+    CHECK(mask[n] == 0xAB);
+    mask.pop_back();
+    return mask;
+}
+
+static int compared = 0;
+
+static void same_as_scalar(const std::string &what, const Kernel &kernel, const std::vector<int32_t> &v,
+                           const std::function<bool(int32_t)> &expect) {
+    // every length up to 3 vector blocks of 32, then the whole input
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 100 && n <= v.size(); ++n) lengths.push_back(n);
+    lengths.push_back(v.size());
+    for (size_t n : lengths) {
+        std::vector<uint8_t> want = run_at("scalar", kernel, v, n);
+        for (size_t i = 0; i < n; ++i) {
+            if (want[i] != expect(v[i])) {
+                test::fail(__FILE__, __LINE__, "scalar " + what + " wrong for " + std::to_string(v[i]));
+                return;
+            }
+        }
+        for (const char *level : filter_kernel_levels()) {
+            if (run_at(level, kernel, v, n) != want) {
+                test::fail(__FILE__, __LINE__, std::string(level) + " " + what + " differs from scalar at n=" +
+                                                   std::to_string(n));
+                return;
+            }
+            compared++;
+        }
+    }
+}
+
+int main() {
+    std::vector<const char *> levels = filter_kernel_levels();
+    CHECK(!levels.empty() && std::string(levels.back()) == "scalar");
+    CHECK(!set_filter_kernel_level("avx512"));
+    std::cout << "kernel levels:";
+    for (const char *l : levels) std::cout << " " << l;
+    std::cout << std::endl;
+
+    // small values (many hits), the extremes, and their neighbours
+    std::mt19937 rng(31);
+    std::vector<int32_t> v(1000);
+    const int32_t edges[] = {INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX - 1, INT32_MAX};
+    for (size_t i = 0; i < v.size(); ++i) {
+        switch (rng() % 4) {
+        case 0: v[i] = edges[rng() % 7]; break;
+        case 1: v[i] = static_cast<int32_t>(rng()); break;
+        default: v[i] = static_cast<int32_t>(rng() % 21) - 10; break;
+        }
+    }
+
+    const int32_t constants[] = {INT32_MIN, INT32_MIN + 1, -10, -1, 0, 3, INT32_MAX - 1, INT32_MAX};
+    const sql::CompareOp ops[] = {sql::CompareOp::EQ, sql::CompareOp::NE, sql::CompareOp::LT,
+                                  sql::CompareOp::LE, sql::CompareOp::GT, sql::CompareOp::GE};
+    const char *names[] = {"=", "<>", "<", "<=", ">", ">="};
+    for (int32_t k : constants) {
+        for (int o = 0; o < 6; ++o) {
+            sql::CompareOp op = ops[o];
+            same_as_scalar(std::string("x ") + names[o] + " " + std::to_string(k),
+                           [&](const int32_t *p, size_t n, uint8_t *m) { filter_i32_compare(p, n, op, k, m); }, v,
+                           [&](int32_t x) {
+                               switch (op) {
+                               case sql::CompareOp::EQ: return x == k;
+                               case sql::CompareOp::NE: return x != k;
+                               case sql::CompareOp::LT: return x < k;
+                               case sql::CompareOp::LE: return x <= k;
+                               case sql::CompareOp::GT: return x > k;
+                               case sql::CompareOp::GE: return x >= k;
+                               }
+                               return false;
+                           });
+        }
+    }
+
+    const std::pair<int32_t, int32_t> ranges[] = {{INT32_MIN, INT32_MAX}, {INT32_MIN, 0}, {0, INT32_MAX},
+                                                  {-3, 3},                {5, 5},           {3, -3},
+                                                  {INT32_MAX, INT32_MAX}, {INT32_MIN, INT32_MIN}};
+    for (auto [lo, hi] : ranges) {
+        same_as_scalar("x BETWEEN " + std::to_string(lo) + " AND " + std::to_string(hi),
+                       [&](const int32_t *p, size_t n, uint8_t *m) { filter_i32_between(p, n, lo, hi, m); }, v,
+                       [&](int32_t x) { return x >= lo && x <= hi; });
+    }
+
+    // IN lists of every vectorized size, and longer ones (binary search)
+    std::vector<int32_t> pool = {INT32_MIN, -10, -7, -3, -1, 0, 2, 4, 5, 9, 10, 77, INT32_MAX};
+    for (size_t size = 0; size <= pool.size(); ++size) {
+        std::vector<int32_t> set(pool.begin(), pool.begin() + size);
+        if (size % 2) set.back() = INT32_MAX;
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+        same_as_scalar("x IN (" + std::to_string(set.size()) + " values)",
+                       [&](const int32_t *p, size_t n, uint8_t *m) { filter_i32_in(p, n, set.data(), set.size(), m); },
+                       v, [&](int32_t x) { return std::binary_search(set.begin(), set.end(), x); });
+    }
+    CHECK(compared > 0);
+    CHECK(set_filter_kernel_level("auto"));
+    CHECK_EQ(filter_kernel_level(), levels.front());
+
+    // the config key picks the level; one the CPU cannot run stops the engine
+    std::string dir = test::scratch_dir("filter_kernel");
+    Config cfg = test::config(dir);
+    cfg.filter_kernels = "no-such-level";
+    {
+        Engine engine(cfg);
+        std::string err;
+        CHECK(!engine.init(err));
+        CHECK(err.find("no-such-level") != std::string::npos);
+    }
+    cfg.filter_kernels = "scalar";
+    {
+        Engine engine(cfg);
+        std::string err;
+        CHECK(engine.init(err));
+        CHECK_EQ(filter_kernel_level(), "scalar");
+        auto s = engine.open_session();
+        CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (v INT)")));
+        CHECK(test::ok(test::run(engine, *s, "INSERT INTO t VALUES (-2147483648), (0), (2147483647), (5)")));
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE v > 0"), "2");
+        engine.shutdown();
+    }
+    set_filter_kernel_level("auto");
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
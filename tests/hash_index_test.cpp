@@ -0,0 +1,197 @@
+// Extendible hash index: spread keys splitting buckets, one key repeated
+// thousands of times (an overflow chain instead of directory doubling),
+// splits all the way to MAX_GLOBAL_DEPTH, Remove, lookups after reopening
+// the segment, and index probes agreeing with the heap after a crash.
+#include "tests/test_util.h"
+#include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/index/hash_index.h"
+#include "src/storage/segment/segment_manager.h"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using storage::HashIndex;
+using storage::RecordId;
+
+static constexpr uint32_t SEGMENT = 1;
+static constexpr int SPREAD = 20000;
+static constexpr int DUPS = 3000;   // many bucket pages' worth of one key
+
+static RecordId rid_of(int i) { return RecordId{static_cast<uint32_t>(i / 100), static_cast<uint32_t>(i % 100)}; }
+
+static bool has(const std::vector<RecordId> &rids, const RecordId &rid) {
+    return std::any_of(rids.begin(), rids.end(),
+                       [&](const RecordId &r) { return r.page_number == rid.page_number && r.offset == rid.offset; });
+}
+
+static uint64_t key(int i) { return HashIndex::HashValue(storage::Value(static_cast<int32_t>(i))); }
+
+// what spread() leaves: the even keys
+static void check_spread(HashIndex &idx) {
+    size_t found = 0;
+    for (int i = 0; i < SPREAD; ++i) {
+        std::vector<RecordId> rids = idx.Lookup(key(i));
+        if (has(rids, rid_of(i)) == (i % 2 == 0)) found++;
+    }
+    CHECK_EQ(std::to_string(found), std::to_string(SPREAD));
+    CHECK(idx.Lookup(key(-1)).empty());
+}
+
+static void spread(HashIndex &idx) {
+    for (int i = 0; i < SPREAD; ++i) idx.Insert(key(i), rid_of(i));
+    CHECK(idx.global_depth() > 0);
+    for (int i = 1; i < SPREAD; i += 2) CHECK(idx.Remove(key(i), rid_of(i)));
+    CHECK(!idx.Remove(key(1), rid_of(1)));
+    CHECK(!idx.Remove(key(0), rid_of(1)));
+    check_spread(idx);
+}
+
+// what duplicates() leaves: the last DUPS - 1000 entries of one key, and one other key
+static void check_duplicates(HashIndex &idx) {
+    CHECK(idx.global_depth() <= 1);
+    std::vector<RecordId> rids = idx.Lookup(key(-1));
+    CHECK_EQ(std::to_string(rids.size()), std::to_string(DUPS - 1000));
+    CHECK(has(rids, rid_of(100000 + DUPS - 1)) && !has(rids, rid_of(100000)));
+    CHECK(has(idx.Lookup(key(-2)), rid_of(99)));
+}
+
+// One key over and over: a split would leave every entry on one side, so the
+// bucket chains overflow pages and the directory does not double.
+static void duplicates(HashIndex &idx) {
+    for (int i = 0; i < DUPS; ++i) idx.Insert(key(-1), rid_of(100000 + i));
+    CHECK(idx.global_depth() == 0);
+    CHECK_EQ(std::to_string(idx.Lookup(key(-1)).size()), std::to_string(DUPS));
+    // another key splits the chain at most once, not a doubling per entry
+    idx.Insert(key(-2), rid_of(99));
+    // remove the first 1000 entries, from every page of the chain
+    for (int i = 0; i < 1000; ++i) CHECK(idx.Remove(key(-1), rid_of(100000 + i)));
+    CHECK(!idx.Remove(key(-1), rid_of(100000)));
+    check_duplicates(idx);
+}
+
+// Hashes that split bucket 0 once per bit: a full bucket of hash 0, then
+// hash 1 << d for d = 0, 1, ... Each is the only entry on its side of the
+// split at depth d, so the directory doubles up to MAX_GLOBAL_DEPTH (19);
+// past it the bucket chains.
+static void deepest(HashIndex &idx) {
+    for (int i = 0; i < 1000; ++i) idx.Insert(0, rid_of(i));
+    CHECK(idx.global_depth() == 0);
+    for (uint32_t d = 0; d < 19; ++d) {
+        idx.Insert(1ull << d, rid_of(1000 + d));
+        CHECK_EQ(std::to_string(idx.global_depth()), std::to_string(d + 1));
+    }
+    idx.Insert(1ull << 19, rid_of(1019));
+    idx.Insert(1ull << 20, rid_of(1020));
+    CHECK(idx.global_depth() == 19);
+    for (int i = 1000; i < 1100; ++i) idx.Insert(0, rid_of(i));
+    CHECK(idx.global_depth() == 19);
+}
+
+static void check_deepest(HashIndex &idx) {
+    CHECK(idx.global_depth() == 19);
+    CHECK_EQ(std::to_string(idx.Lookup(0).size()), "1100");
+    for (uint32_t d = 0; d <= 20; ++d) {
+        std::vector<RecordId> rids = idx.Lookup(1ull << d);
+        CHECK(rids.size() == 1 && has(rids, rid_of(1000 + d)));
+    }
+}
+
+// the child: commit an indexed table, tell the parent, then insert until killed
+[[noreturn]] static void writer(const std::string &dir, int ready_fd) {
+    Config cfg = test::config(dir);
+    cfg.checkpoint_wal_bytes = 1 << 20;
+    Engine engine(cfg);
+    std::string err;
+    if (!engine.init(err)) _exit(2);
+    auto s = engine.open_session();
+    if (!test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, k INT)"))) _exit(3);
+    if (!test::ok(test::run(engine, *s, "CREATE INDEX t_k ON t (k) USING HASH"))) _exit(3);
+    char c = 1;
+    if (::write(ready_fd, &c, 1) != 1) _exit(4);
+    // k = 1 on the even rows (and row 1), the rest spread: chains and splits in every statement
+    for (int from = 0;; from += 2000) {
+        std::string sql = "INSERT INTO t VALUES ";
+        for (int i = from; i < from + 2000; ++i)
+            sql += (i == from ? "(" : ",(") + std::to_string(i) + ", " + std::to_string(i % 2 ? i : 1) + ")";
+        test::run(engine, *s, sql);
+    }
+}
+
+static void crash(const std::string &dir) {
+    int ready[2];
+    if (::pipe(ready) != 0) {
+        test::fail(__FILE__, __LINE__, "pipe");
+        return;
+    }
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(ready[0]);
+        writer(dir, ready[1]);
+    }
+    ::close(ready[1]);
+    char c;
+    bool started = ::read(ready[0], &c, 1) == 1;
+    ::close(ready[0]);
+    if (started) std::this_thread::sleep_for(std::chrono::milliseconds(800));
+    ::kill(pid, SIGKILL);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    CHECK(started);
+
+    Engine engine(test::config(dir));
+    std::string err;
+    if (!engine.init(err)) {
+        test::fail(__FILE__, __LINE__, "recovery: " + err);
+        return;
+    }
+    auto s = engine.open_session();
+    std::string rows = test::run(engine, *s, "SELECT COUNT(*) FROM t");
+    CHECK(rows != "0" && std::stol(rows) % 2000 == 0);
+    // the probe for the repeated key, and for spread keys, finds what a scan finds
+    for (int k : {1, 3, 1001, 1999}) {
+        std::string probe = test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE k = " + std::to_string(k));
+        std::string scan = test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE k + 0 = " + std::to_string(k));
+        CHECK_EQ(probe, scan);
+    }
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE k = 1"), std::to_string(std::stol(rows) / 2 + 1));
+    engine.shutdown();
+}
+
+int main() {
+    std::string dir = test::scratch_dir("hash_index");
+    std::filesystem::create_directories(dir);
+    {
+        // a small pool: directory and bucket pages are evicted and read back
+        storage::SegmentManager sm(dir);
+        storage::BufferPool bp(64, sm);
+        HashIndex idx(bp, SEGMENT);
+        spread(idx);
+        HashIndex dups(bp, SEGMENT + 2);
+        duplicates(dups);
+        HashIndex deep(bp, SEGMENT + 1);
+        deepest(deep);
+        check_deepest(deep);
+        bp.flush_all();
+    }
+    {
+        storage::SegmentManager sm(dir);
+        storage::BufferPool bp(64, sm);
+        HashIndex idx(bp, SEGMENT);
+        check_spread(idx);
+        HashIndex dups(bp, SEGMENT + 2);
+        check_duplicates(dups);
+        HashIndex deep(bp, SEGMENT + 1);
+        check_deepest(deep);
+    }
+    std::filesystem::remove_all(dir);
+
+    crash(dir);
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,75 @@
+// UPDATE and DELETE on the heap: rows that still fit are rewritten in place,
+// rows that grew out of their page leave a forwarding record, deleted rows
+// disappear from scans and index lookups, and all of it survives a restart.
+#include "tests/test_util.h"
+
+#include <string>
+
+static std::string values(int from, int to, const std::string &text) {
+    std::string sql;
+    for (int i = from; i < to; ++i) {
+        if (!sql.empty()) sql += ",";
+        sql += "(" + std::to_string(i) + ", " + std::to_string(i % 10) + ", '" + text + "')";
+    }
+    return sql;
+}
+
+int main() {
+    std::string dir = test::scratch_dir("heap_update");
+    const std::string longer(300, 'z');
+    {
+        Engine engine(test::config(dir));
+        std::string err;
+        if (!engine.init(err)) {
+            std::cerr << "init: " << err << std::endl;
+            return 1;
+        }
+        auto s = engine.open_session();
+        CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, v INT, s TEXT)")));
+        CHECK(test::ok(test::run(engine, *s, "CREATE INDEX t_id ON t (id) USING HASH")));
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES " + values(0, 1000, "short")), "OK: 1000 rows inserted");
+
+        // same size: in place
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET v = v + 100 WHERE id < 500"), "OK: 500 rows updated");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(v) FROM t"), "1000,54500");
+
+        // grown past the free space of their pages: forwarded
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET s = '" + longer + "' WHERE id < 200"), "OK: 200 rows updated");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(id) FROM t"), "1000,499500");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE s = '" + longer + "'"), "200");
+        CHECK_EQ(test::run(engine, *s, "SELECT v, s FROM t WHERE id = 7"), "107," + longer);
+
+        // a forwarded row updated again, shrinking and growing
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET s = 'back' WHERE id < 100"), "OK: 100 rows updated");
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET s = '" + longer + longer + "' WHERE id < 50"),
+                 "OK: 50 rows updated");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE s = 'back'"), "50");
+        CHECK_EQ(test::run(engine, *s, "SELECT s FROM t WHERE id = 150"), longer);
+
+        // tombstones, forwarded rows among them
+        CHECK_EQ(test::run(engine, *s, "DELETE FROM t WHERE v = 103 OR id >= 900"), "OK: 150 rows deleted");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE id = 3"), "0");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE id = 950"), "0");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t"), "850");
+        CHECK_EQ(test::run(engine, *s, "DELETE FROM t WHERE id = 3"), "OK: 0 rows deleted");
+        engine.shutdown();
+    }
+    {
+        Engine engine(test::config(dir));
+        std::string err;
+        if (!engine.init(err)) {
+            std::cerr << "reopen: " << err << std::endl;
+            return 1;
+        }
+        auto s = engine.open_session();
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t"), "850");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE s = '" + longer + "'"), "90");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE s = 'back'"), "45");
+        CHECK_EQ(test::run(engine, *s, "SELECT v, s FROM t WHERE id = 57"), "107,back");
+        CHECK_EQ(test::run(engine, *s, "SELECT s FROM t WHERE id = 7"), longer + longer);
+        CHECK_EQ(test::run(engine, *s, "SELECT v FROM t WHERE id = 700"), "0");
+        engine.shutdown();
+    }
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,80 @@
+// INSERT: how the parser reads column lists and multi-row VALUES, and which
+// column lists the executor accepts. A list must name every column of the
+// table exactly once (there are no defaults), in any order.
+#include "tests/test_util.h"
+#include "src/sql/parser.h"
+
+#include <string>
+
+static void parse_insert() {
+    sql::Statement stmt;
+    std::string err;
+    CHECK(sql::parse("INSERT INTO t (b, a) VALUES (1, 'x'), (2, 'y');", stmt, err));
+    const sql::InsertStmt *ins = stmt.as<sql::InsertStmt>();
+    CHECK(ins != nullptr);
+    if (ins) {
+        CHECK_EQ(ins->table, "t");
+        CHECK(ins->columns.size() == 2);
+        if (ins->columns.size() == 2) {
+            CHECK_EQ(ins->columns[0], "b");
+            CHECK_EQ(ins->columns[1], "a");
+        }
+        CHECK(ins->rows.size() == 2);
+        for (const auto &row : ins->rows) CHECK(row.size() == 2);
+    }
+
+    sql::Statement plain;
+    CHECK(sql::parse("insert into t values (1, 2, 3)", plain, err));
+    const sql::InsertStmt *all = plain.as<sql::InsertStmt>();
+    CHECK(all != nullptr && all->columns.empty() && all->rows.size() == 1 && all->rows[0].size() == 3);
+
+    sql::Statement bad;
+    CHECK(!sql::parse("INSERT INTO t (a, ) VALUES (1)", bad, err));
+    CHECK(!sql::parse("INSERT INTO t VALUES", bad, err));
+    CHECK(!sql::parse("INSERT t VALUES (1)", bad, err));
+}
+
+int main() {
+    parse_insert();
+
+    std::string dir = test::scratch_dir("insert");
+    Engine engine(test::config(dir));
+    std::string err;
+    if (!engine.init(err)) {
+        std::cerr << "init: " << err << std::endl;
+        return 1;
+    }
+    auto s = engine.open_session();
+    CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, v INT, s TEXT)")));
+
+    // a column list in another order puts each value in its column
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t (s, id, v) VALUES ('one', 1, 10), ('two', 2, 20)"),
+             "OK: 2 rows inserted");
+    CHECK_EQ(test::run(engine, *s, "SELECT id, v, s FROM t WHERE id = 2"), "2,20,two");
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (3, 30, 'three')"), "OK: 1 row inserted");
+
+    // a column named twice, or one left out, is refused and stores nothing
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t (id, id, s) VALUES (4, 4, 'four')"),
+             "ERR: column name given twice: id");
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t (id, v, v) VALUES (4, 40, 41)"), "ERR: column name given twice: v");
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t (id, s) VALUES (4, 'four')"),
+             "ERR: column list must name every column: v is missing");
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t (id, v, s, nope) VALUES (4, 40, 'four', 1)"),
+             "ERR: unknown column nope");
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t (id, v, s) VALUES (4, 40)"),
+             "ERR: column count mismatch: expected 3");
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (4, 40, 'four'), (5, 50)"),
+             "ERR: column count mismatch: expected 3");
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(v) FROM t"), "3,60");
+
+    // the same checks hold for a prepared INSERT
+    CHECK_EQ(test::run(engine, *s, "PREPARE dup AS INSERT INTO t (v, v, s) VALUES (?, ?, ?)"),
+             "ERR: column name given twice: v");
+    CHECK(test::ok(test::run(engine, *s, "PREPARE ins AS INSERT INTO t (v, s, id) VALUES (?, ?, ?)")));
+    CHECK_EQ(test::run(engine, *s, "EXECUTE ins (60, 'six', 6)"), "OK: 1 row inserted");
+    CHECK_EQ(test::run(engine, *s, "SELECT id, v, s FROM t WHERE id = 6"), "6,60,six");
+
+    engine.shutdown();
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,138 @@
+// Lock manager: mode compatibility, raising a held lock, deadlock detection,
+// the wait timeout and waking waiters; then sessions updating the same rows
+// in parallel on one engine without losing an update.
+#include "tests/test_util.h"
+#include "src/storage/mvcc/lock_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using storage::LockManager;
+using storage::LockMode;
+using storage::LockTarget;
+
+static LockTarget row(uint32_t n) { return LockTarget::of_row(1, storage::RecordId{0, n}); }
+
+static void modes() {
+    LockManager lm(std::chrono::milliseconds(50));
+    LockTarget table = LockTarget::table(1);
+    CHECK(lm.try_lock(1, table, LockMode::IS));
+    CHECK(lm.try_lock(2, table, LockMode::IX));
+    CHECK(lm.try_lock(3, table, LockMode::IS));
+    CHECK(!lm.try_lock(4, table, LockMode::S));   // IX held
+    CHECK(!lm.try_lock(4, table, LockMode::X));
+    lm.release_all(2);
+    CHECK(lm.try_lock(4, table, LockMode::S));
+    CHECK(!lm.try_lock(5, table, LockMode::IX));  // S held
+    CHECK(!lm.try_lock(5, table, LockMode::SIX));
+    lm.release_all(1);
+    lm.release_all(3);
+    lm.release_all(4);
+
+    // a holder raises its own lock; others then conflict with the stronger mode
+    CHECK(lm.try_lock(1, row(1), LockMode::S));
+    CHECK(lm.try_lock(2, row(1), LockMode::S));
+    CHECK(!lm.try_lock(1, row(1), LockMode::X));  // 2 still reads it
+    lm.release_all(2);
+    CHECK(lm.try_lock(1, row(1), LockMode::X));
+    CHECK(!lm.try_lock(2, row(1), LockMode::S));
+    lm.release_all(1);
+    CHECK(lm.try_lock(2, row(1), LockMode::S));
+    lm.release_all(2);
+}
+
+static void waits() {
+    LockManager lm(std::chrono::milliseconds(2000));
+    std::string err;
+    CHECK(lm.lock(1, row(1), LockMode::X, err));
+    CHECK(lm.lock(2, row(2), LockMode::X, err));
+
+    // 1 waits for 2, then 2 asking for 1's row would close the cycle
+    auto first = std::async(std::launch::async, [&] {
+        std::string e;
+        return lm.lock(1, row(2), LockMode::X, e);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto started = std::chrono::steady_clock::now();
+    CHECK(!lm.lock(2, row(1), LockMode::X, err));
+    CHECK(err.find("deadlock") != std::string::npos);
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::milliseconds(1000));
+    // the refused one gives up its locks and the waiter goes on
+    lm.release_all(2);
+    CHECK(first.get());
+    lm.release_all(1);
+
+    // a wait no cycle explains ends at the timeout
+    LockManager quick(std::chrono::milliseconds(100));
+    CHECK(quick.lock(1, row(1), LockMode::X, err));
+    started = std::chrono::steady_clock::now();
+    CHECK(!quick.lock(2, row(1), LockMode::S, err));
+    CHECK(err.find("timed out") != std::string::npos);
+    CHECK(std::chrono::steady_clock::now() - started >= std::chrono::milliseconds(100));
+    quick.release_all(1);
+    CHECK(quick.lock(2, row(1), LockMode::S, err));
+    CHECK(quick.lock(3, row(1), LockMode::S, err));
+}
+
+static void sessions(const std::string &dir) {
+    Config cfg = test::config(dir);
+    cfg.worker_threads = 4;
+    cfg.lock_timeout_ms = 2000;
+    Engine engine(cfg);
+    std::string err;
+    if (!engine.init(err)) {
+        test::fail(__FILE__, __LINE__, "init: " + err);
+        return;
+    }
+    auto s = engine.open_session();
+    CHECK(test::ok(test::run(engine, *s, "CREATE TABLE acct (id INT, bal INT)")));
+    CHECK(test::ok(test::run(engine, *s, "CREATE INDEX acct_id ON acct (id) USING HASH")));
+    std::string rows;
+    for (int i = 0; i < 50; ++i) rows += (i ? ",(" : "(") + std::to_string(i) + ", 1000)";
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO acct VALUES " + rows), "OK: 50 rows inserted");
+
+    // increments of a few hot rows, and transfers between them, from 6 sessions
+    std::atomic<long> added{0}, failed{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 6; ++t) {
+        threads.emplace_back([&, t] {
+            auto w = engine.open_session();
+            std::mt19937 rng(t);
+            for (int i = 0; i < 150; ++i) {
+                std::string a = std::to_string(rng() % 50), b = std::to_string(rng() % 50);
+                if (i % 2 == 0) {
+                    std::string st = test::run(engine, *w, "UPDATE acct SET bal = bal + 1 WHERE id = " + a);
+                    (st == "OK: 1 row updated" ? added : failed)++;
+                    continue;
+                }
+                test::run(engine, *w, "BEGIN");
+                test::run(engine, *w, "UPDATE acct SET bal = bal - 5 WHERE id = " + a);
+                test::run(engine, *w, "UPDATE acct SET bal = bal + 5 WHERE id = " + b);
+                std::string st = test::run(engine, *w, "COMMIT");
+                // a deadlock between two transfers aborts one of them, whole
+                if (!test::ok(st) && st.find("deadlock") == std::string::npos &&
+                    st.find("timed out") == std::string::npos)
+                    failed++;
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    CHECK_EQ(std::to_string(failed.load()), "0");
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(bal) FROM acct"),
+             "50," + std::to_string(50000 + added.load()));
+    engine.shutdown();
+}
+
+int main() {
+    std::string dir = test::scratch_dir("lock_manager");
+    modes();
+    waits();
+    sessions(dir);
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,133 @@
+// MVCC: which transactions a snapshot sees, aborted ids staying invisible
+// across a restart, and a long query reading its snapshot while a writer
+// updates the same rows without waiting for it.
+#include "tests/test_util.h"
+#include "src/storage/mvcc/transaction.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using storage::Snapshot;
+using storage::TransactionManager;
+using storage::TxnId;
+
+static void visibility(const std::string &dir) {
+    TxnId done, aborted, running;
+    {
+        TransactionManager txns(dir);
+        done = txns.begin();
+        aborted = txns.begin();
+        running = txns.begin();
+        txns.end(done);
+        txns.abort(aborted);
+        txns.end(aborted);
+
+        Snapshot s = txns.snapshot(running);
+        CHECK(s.sees(0));
+        CHECK(s.sees(done));
+        CHECK(!s.sees(aborted));
+        CHECK(s.sees(running));
+
+        // a transaction still running, and one that starts later, are not seen
+        TxnId late = txns.begin();
+        Snapshot other = txns.snapshot(late);
+        CHECK(!other.sees(running));
+        CHECK(!s.sees(late));
+        // nor once it commits: the snapshot was taken before
+        txns.end(late);
+        CHECK(!s.sees(late));
+
+        // the oldest snapshot holds the horizon back
+        CHECK(txns.horizon() <= running);
+        txns.release(s);
+        txns.release(other);
+        txns.end(running);
+        txns.settle();
+    }
+    // the aborted id stays aborted in the next run
+    TransactionManager txns(dir);
+    TxnId next = txns.begin();
+    CHECK(next > running);
+    Snapshot s = txns.snapshot(next);
+    CHECK(s.sees(done));
+    CHECK(!s.sees(aborted));
+    CHECK(s.sees(running));
+    txns.release(s);
+    txns.end(next);
+}
+
+// a query sink that stops at its first batch until told to go on
+struct PausedReader : test::Rows {
+    std::mutex mu;
+    std::condition_variable cv;
+    bool started = false;
+    bool resume = false;
+    long sum = 0;
+
+    bool batch(const Batch &b) override {
+        {
+            std::unique_lock<std::mutex> lk(mu);
+            started = true;
+            cv.notify_all();
+            cv.wait_for(lk, std::chrono::seconds(10), [&] { return resume; });
+        }
+        for (size_t r = 0; r < b.size; ++r) sum += std::stol(b.columns[0].value_string(r));
+        return true;
+    }
+};
+
+static void reader_and_writer(const std::string &dir) {
+    Engine engine(test::config(dir));
+    std::string err;
+    if (!engine.init(err)) {
+        test::fail(__FILE__, __LINE__, "init: " + err);
+        return;
+    }
+    auto s = engine.open_session();
+    CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, v INT)")));
+    std::string rows;
+    for (int i = 0; i < 20000; ++i) rows += (i ? ",(" : "(") + std::to_string(i) + ", 1)";
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES " + rows), "OK: 20000 rows inserted");
+
+    PausedReader reader;
+    std::promise<void> finished;
+    CHECK(engine.submit(engine.open_session(), "SELECT v FROM t", reader, [&] { finished.set_value(); }));
+    {
+        std::unique_lock<std::mutex> lk(reader.mu);
+        reader.cv.wait_for(lk, std::chrono::seconds(10), [&] { return reader.started; });
+    }
+    CHECK(reader.started);
+
+    // the writer does not wait for the reader
+    auto writer = std::async(std::launch::async, [&] {
+        auto w = engine.open_session();
+        return test::run(engine, *w, "UPDATE t SET v = v + 1");
+    });
+    bool wrote = writer.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+    CHECK(wrote);
+    {
+        std::lock_guard<std::mutex> lg(reader.mu);
+        reader.resume = true;
+        reader.cv.notify_all();
+    }
+    CHECK_EQ(writer.get(), "OK: 20000 rows updated");
+    finished.get_future().wait();
+
+    // the reader saw the rows as of its snapshot, later statements the update
+    CHECK_EQ(std::to_string(reader.sum), "20000");
+    CHECK_EQ(test::run(engine, *s, "SELECT SUM(v) FROM t"), "40000");
+    engine.shutdown();
+}
+
+int main() {
+    std::string dir = test::scratch_dir("mvcc");
+    std::filesystem::create_directories(dir + "/txns");
+    visibility(dir + "/txns");
+    reader_and_writer(dir + "/engine");
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,138 @@
+// Plan cache and prepared statements: SQL that differs only in spacing, case
+// of keywords or a trailing ';' shares one entry, the least recently used
+// entry goes first, a plan bound before DDL is not reused, and a prepared
+// SELECT planned again after CREATE INDEX probes the new index. EXECUTE
+// checks its argument count and the types the statement needs.
+#include "tests/test_util.h"
+#include "src/execution/plan_cache.h"
+
+#include <memory>
+#include <string>
+
+static std::shared_ptr<const Plan> plan_at(uint64_t catalog_version) {
+    auto plan = std::make_shared<Plan>();
+    plan->catalog_version = catalog_version;
+    return plan;
+}
+
+static void cache() {
+    const std::string a = PlanCache::normalize("select id from t where k = 1;");
+    CHECK_EQ(a, PlanCache::normalize("  SELECT   id\nFROM t WHERE k=1"));
+    CHECK(a != PlanCache::normalize("SELECT id FROM t WHERE k = 2"));
+    // string literals keep their case
+    CHECK(PlanCache::normalize("SELECT id FROM t WHERE s = 'X'") !=
+          PlanCache::normalize("SELECT id FROM t WHERE s = 'x'"));
+    CHECK_EQ(PlanCache::normalize("SELECT 'unterminated"), "");
+
+    PlanCache pc(2);
+    auto pa = plan_at(1), pb = plan_at(1), pd = plan_at(1);
+    CHECK(pc.get(a, 1) == nullptr);
+    pc.put(a, pa);
+    pc.put("B", pb);
+    CHECK(pc.get(a, 1) == pa);   // a is now the most recently used
+    CHECK(pc.get("B", 1) == pb);
+    CHECK(pc.get(a, 1) == pa);
+    CHECK_EQ(std::to_string(pc.hits()), "3");
+    CHECK_EQ(std::to_string(pc.misses()), "1");
+
+    // a third entry evicts the least recently used one (B)
+    pc.put("D", pd);
+    CHECK(pc.get("B", 1) == nullptr);
+    CHECK(pc.get(a, 1) == pa);
+    CHECK(pc.get("D", 1) == pd);
+
+    // after DDL (a newer catalog version) the old plan is dropped, not returned
+    CHECK(pc.get(a, 2) == nullptr);
+    CHECK(pc.get(a, 1) == nullptr);
+    auto fresh = plan_at(2);
+    pc.put(a, fresh);
+    CHECK(pc.get(a, 2) == fresh);
+
+    // statements that do not lex, and a zero capacity, are never cached
+    pc.put("", pa);
+    CHECK(pc.get("", 1) == nullptr);
+    PlanCache none(0);
+    none.put(a, pa);
+    CHECK(none.get(a, 1) == nullptr);
+}
+
+// every line of an EXPLAIN
+static std::string plan(Engine &engine, Session &session, const std::string &sql) {
+    test::Rows out;
+    engine.execute_sql(session, "EXPLAIN " + sql, out);
+    std::string text;
+    for (const auto &row : out.rows) text += row + "\n";
+    return text.empty() ? out.status_line : text;
+}
+
+static std::string all_rows(Engine &engine, Session &session, const std::string &sql) {
+    test::Rows out;
+    engine.execute_sql(session, sql, out);
+    std::string text;
+    for (const auto &row : out.rows) text += row + ";";
+    return text.empty() ? out.status_line : text;
+}
+
+int main() {
+    cache();
+
+    std::string dir = test::scratch_dir("plan_cache");
+    Engine engine(test::config(dir));
+    std::string err;
+    if (!engine.init(err)) {
+        std::cerr << "init: " << err << std::endl;
+        return 1;
+    }
+    auto s = engine.open_session();
+    auto other = engine.open_session();
+    CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, k INT, s TEXT)")));
+    std::string sql = "INSERT INTO t VALUES ";
+    for (int i = 0; i < 5000; ++i)
+        sql += (i ? ",(" : "(") + std::to_string(i) + ", " + std::to_string(i % 1000) + ", 's" + std::to_string(i) +
+               "')";
+    CHECK(test::ok(test::run(engine, *s, sql)));
+
+    CHECK_EQ(test::run(engine, *s, "PREPARE q AS SELECT id, s FROM t WHERE k = ? ORDER BY id"),
+             "OK: prepared q (1 parameters)");
+    CHECK_EQ(test::run(engine, *s, "PREPARE q AS SELECT id FROM t"), "ERR: prepared statement already exists: q");
+    CHECK(plan(engine, *s, "EXECUTE q (7)").find("Seq Scan on t") != std::string::npos);
+    CHECK_EQ(all_rows(engine, *s, "EXECUTE q (7)"), "7,s7;1007,s1007;2007,s2007;3007,s3007;4007,s4007;");
+
+    // an index created by another session between two EXECUTEs: the next one is
+    // planned again and probes it, with the same answer
+    CHECK(test::ok(test::run(engine, *other, "CREATE INDEX t_k ON t (k) USING HASH")));
+    CHECK(plan(engine, *s, "EXECUTE q (7)").find("Index Scan on t using t_k") != std::string::npos);
+    CHECK_EQ(all_rows(engine, *s, "EXECUTE q (7)"), "7,s7;1007,s1007;2007,s2007;3007,s3007;4007,s4007;");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE q (999)"), "999,s999");
+    // plain SQL cached before the index is planned again too
+    CHECK(plan(engine, *s, "SELECT id FROM t WHERE k = 7").find("Index Scan") != std::string::npos);
+
+    // arity: too few, too many, and parameters outside PREPARE
+    CHECK_EQ(test::run(engine, *s, "EXECUTE q ()"), "ERR: expected 1 parameters, got 0");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE q (1, 2)"), "ERR: expected 1 parameters, got 2");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE nope (1)"), "ERR: unknown prepared statement nope");
+    CHECK_EQ(test::run(engine, *s, "SELECT id FROM t WHERE k = ?"),
+             "ERR: '?' parameters are only allowed in PREPARE");
+    CHECK_EQ(plan(engine, *s, "EXECUTE q ()"), "ERR: expected 1 parameters, got 0");
+
+    // types: a value the column cannot hold, and TEXT in arithmetic; an INT
+    // column is never equal to a TEXT value
+    CHECK_EQ(test::run(engine, *s, "PREPARE ins AS INSERT INTO t VALUES (?, ?, ?)"),
+             "OK: prepared ins (3 parameters)");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE ins ('x', 1, 'y')"), "ERR: invalid INT value for column id");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE ins (5000, 'y', 'y')"), "ERR: invalid INT value for column k");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE ins (5000, 1, 'new')"), "OK: 1 row inserted");
+    CHECK(test::ok(test::run(engine, *s, "PREPARE add AS SELECT k + ? FROM t WHERE id = 5000")));
+    CHECK_EQ(test::run(engine, *s, "EXECUTE add ('x')"), "ERR: arithmetic on non-INT value");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE add (41)"), "42");
+    CHECK_EQ(all_rows(engine, *s, "EXECUTE q ('7')"), "");   // no rows
+
+    // prepared statements belong to their session
+    CHECK_EQ(test::run(engine, *other, "EXECUTE q (7)"), "ERR: unknown prepared statement q");
+    CHECK_EQ(test::run(engine, *s, "DEALLOCATE q"), "OK: deallocated q");
+    CHECK_EQ(test::run(engine, *s, "EXECUTE q (7)"), "ERR: unknown prepared statement q");
+
+    engine.shutdown();
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,136 @@
+// The binary protocol: typed, columnar query results, 'P' requests running a
+// statement once per parameter set, and requests whose counts do not match
+// their bytes (or go over the limits) refused without harm to the connection.
+#include "tests/test_util.h"
+#include "tests/wire_client.h"
+#include "src/server/server.h"
+
+#include <string>
+
+// a 'P' request header: the statement, then `count` parameters x `sets`
+static std::string execute(const std::string &sql, uint16_t count, uint32_t sets) {
+    std::string body(1, static_cast<char>(protocol::Request::EXECUTE));
+    protocol::put_u32(body, static_cast<uint32_t>(sql.size()));
+    body += sql;
+    protocol::put_u16(body, count);
+    protocol::put_u32(body, sets);
+    return body;
+}
+
+static void put_int(std::string &body, int32_t v) {
+    body += static_cast<char>(protocol::Type::INT32);
+    protocol::put_u32(body, static_cast<uint32_t>(v));
+}
+
+static void put_text(std::string &body, const std::string &v) {
+    body += static_cast<char>(protocol::Type::TEXT);
+    protocol::put_u32(body, static_cast<uint32_t>(v.size()));
+    body += v;
+}
+
+// the value of a one-row, one-column INT64 result (COUNT(*)), or -1
+static long long single_count(const test::Reply &r) {
+    if (r.frames.size() != 2 || r.frames[1].first != static_cast<char>(protocol::Reply::BATCH)) return -1;
+    protocol::Reader batch(r.frames[1].second.data(), r.frames[1].second.size());
+    if (batch.u32() != 1) return -1;
+    uint64_t v = batch.u64();
+    return batch.ok ? static_cast<long long>(v) : -1;
+}
+
+static std::string query(const std::string &sql) {
+    return std::string(1, static_cast<char>(protocol::Request::QUERY)) + sql;
+}
+
+int main() {
+    std::string dir = test::scratch_dir("protocol");
+    Config cfg = test::config(dir + "/data");
+    cfg.listen_port = 0;
+    cfg.socket_path = dir + "/boltd.sock";
+    std::filesystem::create_directories(dir);
+    Engine engine(cfg);
+    std::string err;
+    if (!engine.init(err)) {
+        std::cerr << "init: " << err << std::endl;
+        return 1;
+    }
+    Server server(engine, cfg);
+    if (!server.start(err)) {
+        std::cerr << "start: " << err << std::endl;
+        return 1;
+    }
+
+    test::WireClient c(cfg.socket_path);
+    CHECK(c.hello());
+    CHECK(c.send_frame(query("CREATE TABLE t (id INT, name TEXT)")));
+    CHECK_EQ(c.reply().status, "OK: table created: t");
+
+    // one frame, 1000 executions, a reply each
+    std::string insert = execute("INSERT INTO t VALUES (?, ?)", 2, 1000);
+    for (int i = 0; i < 1000; ++i) {
+        put_int(insert, i);
+        put_text(insert, "n" + std::to_string(i));
+    }
+    CHECK(c.send_frame(insert));
+    size_t inserted = 0;
+    for (int i = 0; i < 1000; ++i) inserted += c.reply().status == "OK: 1 row inserted";
+    CHECK(inserted == 1000);
+
+    // columns, then batches of typed values
+    CHECK(c.send_frame(query("SELECT id, name FROM t WHERE id < 3")));
+    test::Reply r = c.reply();
+    CHECK(test::ok(r.status));
+    CHECK(!r.frames.empty() && r.frames[0].first == static_cast<char>(protocol::Reply::COLUMNS));
+    uint32_t rows = 0;
+    for (const auto &f : r.frames) {
+        if (f.first != static_cast<char>(protocol::Reply::BATCH)) continue;
+        protocol::Reader batch(f.second.data(), f.second.size());
+        rows += batch.u32();
+    }
+    CHECK(rows == 3);
+
+    // a lookup with a parameter
+    std::string lookup = execute("SELECT COUNT(*) FROM t WHERE name = ?", 1, 2);
+    put_text(lookup, "n42");
+    put_text(lookup, "missing");
+    CHECK(c.send_frame(lookup));
+    CHECK(single_count(c.reply()) == 1);
+    CHECK(single_count(c.reply()) == 0);
+
+    // counts the bytes cannot hold, too many sets, bad values: refused, in turn
+    CHECK(c.send_frame(execute("INSERT INTO t VALUES (?, ?)", 2, 4000000000u)));
+    CHECK_EQ(c.reply().status, "ERR: malformed request");
+    std::string too_many = execute("INSERT INTO t VALUES (?)", 1, 4097);
+    for (int i = 0; i < 4097; ++i) put_int(too_many, i);
+    CHECK(c.send_frame(too_many));
+    CHECK_EQ(c.reply().status, "ERR: more than 4096 parameter sets in one request");
+    std::string wide = execute("INSERT INTO t VALUES (?, ?)", 2, 1);
+    wide += static_cast<char>(protocol::Type::INT64);
+    protocol::put_u64(wide, 1ull << 40);
+    put_text(wide, "wide");
+    CHECK(c.send_frame(wide));
+    CHECK_EQ(c.reply().status, "ERR: parameter 1 is out of INT range");
+    std::string trailing = execute("INSERT INTO t VALUES (?, ?)", 2, 1);
+    put_int(trailing, 1);
+    put_text(trailing, "x");
+    trailing += "junk";
+    CHECK(c.send_frame(trailing));
+    CHECK_EQ(c.reply().status, "ERR: malformed request");
+    CHECK(c.send_frame("X"));
+    CHECK_EQ(c.reply().status, "ERR: unknown request type");
+
+    // and the connection still works, with none of them applied
+    CHECK(c.send_frame(query("SELECT COUNT(*) FROM t")));
+    CHECK(single_count(c.reply()) == 1000);
+
+    // a frame over MAX_FRAME ends the connection after its error
+    std::string huge;
+    protocol::put_u32(huge, protocol::MAX_FRAME + 1);
+    CHECK(c.send_raw(huge));
+    CHECK(c.reply().status.rfind("ERR: request of", 0) == 0);
+    CHECK(c.reply().status.empty());
+
+    server.stop();
+    engine.shutdown();
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,182 @@
+// Crash recovery: a child process keeps rewriting a table (updates, an insert
+// and a delete, all of it through the WAL) and is killed with SIGKILL part way
+// through a statement. Reopening the data directory must redo what committed,
+// undo the statement cut short, and leave the hash index agreeing with the
+// heap. Runs a few rounds with the kill landing at different times. Then a
+// torn page write: the first change of a page after a checkpoint is logged
+// whole, so redo rebuilds a page whose write stopped half way.
+#include "tests/test_util.h"
+#include "src/storage/buffer/buffer_pool.h"
+#include "src/storage/wal/recovery.h"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int ROWS = 20000;
+static constexpr int EXTRA = 3000;
+// SUM(v) of the original rows (v = id % 7), and after v = v + 100
+static constexpr long BASE_SUM = 59997;
+static constexpr long RAISED_SUM = BASE_SUM + 100L * ROWS;
+
+static std::string values(int from, int to, int v) {
+    std::string sql;
+    for (int i = from; i < to; ++i) {
+        if (!sql.empty()) sql += ",";
+        sql += "(" + std::to_string(i) + ", " + std::to_string(v < 0 ? i % 7 : v) + ", 'row')";
+    }
+    return sql;
+}
+
+static Config crash_config(const std::string &dir) {
+    Config cfg = test::config(dir);
+    cfg.checkpoint_wal_bytes = 1 << 20;
+    return cfg;
+}
+
+// the child: commit a marker, tell the parent, then write until killed
+[[noreturn]] static void writer(const std::string &dir, int ready_fd, int round) {
+    Engine engine(crash_config(dir));
+    std::string err;
+    if (!engine.init(err)) _exit(2);
+    auto s = engine.open_session();
+    std::string marker = "UPDATE t SET s = 'round" + std::to_string(round) + "' WHERE id < 100";
+    if (test::run(engine, *s, marker) != "OK: 100 rows updated") _exit(3);
+    char c = 1;
+    if (::write(ready_fd, &c, 1) != 1) _exit(4);
+    const std::string insert = "INSERT INTO t VALUES " + values(100000, 100000 + EXTRA, 7);
+    for (;;) {
+        test::run(engine, *s, "UPDATE t SET v = v + 100 WHERE id < 100000");
+        test::run(engine, *s, insert);
+        test::run(engine, *s, "UPDATE t SET v = v - 100 WHERE id < 100000");
+        test::run(engine, *s, "DELETE FROM t WHERE id >= 100000");
+    }
+}
+
+static void check_recovered(const std::string &dir, int round) {
+    Engine engine(crash_config(dir));
+    std::string err;
+    if (!engine.init(err)) {
+        test::fail(__FILE__, __LINE__, "recovery: " + err);
+        return;
+    }
+    auto s = engine.open_session();
+    // the marker committed before the kill
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE s = 'round" + std::to_string(round) + "'"), "100");
+    // every statement is there whole or not at all
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE id < 100000"), std::to_string(ROWS));
+    std::string extra = test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE id >= 100000");
+    CHECK(extra == "0" || extra == std::to_string(EXTRA));
+    std::string sum = test::run(engine, *s, "SELECT SUM(v) FROM t WHERE id < 100000");
+    CHECK(sum == std::to_string(BASE_SUM) || sum == std::to_string(RAISED_SUM));
+    // index probes find what a scan finds
+    for (int v : {3, 7, 103, 107}) {
+        std::string probe = test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE v = " + std::to_string(v));
+        std::string scan = test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE v + 0 = " + std::to_string(v));
+        CHECK_EQ(probe, scan);
+    }
+    engine.shutdown();
+}
+
+// Write a page through the pool with the log attached: a checkpoint, two
+// changes, the page written out, then its disk copy torn (the first sector
+// new, the rest as before the changes) as a crash during the write leaves it.
+static void torn_write(const std::string &dir) {
+    using namespace storage;
+    std::filesystem::create_directories(dir);
+    Page before, after;
+    {
+        SegmentManager sm(dir);
+        Wal wal(dir);
+        BufferPool bp(8, sm);
+        bp.attach_wal(&wal);
+        PageId pid = bp.allocate_page(1);
+        Frame *f = bp.fetch_page(pid, true);
+        std::memset(f->page.data, 'a', sizeof(f->page.data));
+        bp.unpin_page(f, true);
+        bp.log_changes();
+        bp.checkpoint();
+        before = sm.read_page(pid);
+
+        for (char c : {'b', 'c'}) {
+            f = bp.fetch_page(pid, true);
+            for (size_t i = 0; i < sizeof(f->page.data); i += 64) f->page.data[i] = c;
+            bp.unpin_page(f, true);
+            bp.log_changes();
+        }
+        f = bp.fetch_page(pid);
+        bp.flush_page(f);
+        after = f->page;
+        bp.unpin_page(f, false);
+
+        // the first record since the checkpoint is the whole page, the next a delta
+        std::vector<WalType> types;
+        wal.scan(wal.base_lsn(), [&](Lsn, const WalRecord &rec) { types.push_back(rec.type); });
+        CHECK(types.size() == 2 && types[0] == WalType::PAGE_IMAGE && types[1] == WalType::PAGE_DELTA);
+
+        Page torn = before;
+        std::memcpy(&torn, &after, 512);
+        sm.write_page(torn);
+        sm.sync();
+    }
+    // the pool goes without a checkpoint, as in a crash
+    SegmentManager sm(dir);
+    Wal wal(dir);
+    Recovery recovery(sm, wal);
+    Recovery::Stats st = recovery.run(1);
+    CHECK(st.applied == 2);
+    Page redone = sm.read_page(PageId{1, 0});
+    CHECK(std::memcmp(&redone, &after, sizeof(Page)) == 0);
+    std::filesystem::remove_all(dir);
+}
+
+int main() {
+    std::string dir = test::scratch_dir("recovery");
+    {
+        Engine engine(crash_config(dir));
+        std::string err;
+        if (!engine.init(err)) {
+            std::cerr << "init: " << err << std::endl;
+            return 1;
+        }
+        auto s = engine.open_session();
+        CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, v INT, s TEXT)")));
+        CHECK(test::ok(test::run(engine, *s, "CREATE INDEX t_v ON t (v) USING HASH")));
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES " + values(0, ROWS, -1)), "OK: 20000 rows inserted");
+        engine.shutdown();
+    }
+
+    int round = 0;
+    for (int delay_ms : {50, 300, 700, 1200}) {
+        round++;
+        int ready[2];
+        if (::pipe(ready) != 0) return 1;
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(ready[0]);
+            writer(dir, ready[1], round);
+        }
+        ::close(ready[1]);
+        char c;
+        bool started = ::read(ready[0], &c, 1) == 1;
+        ::close(ready[0]);
+        if (started) std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        ::kill(pid, SIGKILL);
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        CHECK(started);
+        CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+        check_recovered(dir, round);
+    }
+
+    std::filesystem::remove_all(dir);
+
+    torn_write(dir);
+    return test::finish();
+}
@@ -0,0 +1,120 @@
+// The daemon's network front end over its Unix socket: text statements and
+// their replies, pipelined requests answered in order, many connections at
+// once, and a client that stops reading a large result without holding up
+// other clients' writes or the checkpoints they trigger.
+#include "tests/test_util.h"
+#include "tests/wire_client.h"
+#include "src/server/server.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static size_t count_lines(const test::Reply &r) {
+    size_t n = 0;
+    for (const auto &f : r.frames)
+        if (f.first == static_cast<char>(protocol::Reply::ROWS))
+            for (char c : f.second) n += c == '\n';
+    return n;
+}
+
+int main() {
+    std::string dir = test::scratch_dir("server");
+    Config cfg = test::config(dir + "/data");
+    cfg.listen_port = 0;
+    cfg.socket_path = dir + "/boltd.sock";
+    cfg.worker_threads = 4;
+    cfg.checkpoint_wal_bytes = 64 * 1024;
+    std::filesystem::create_directories(dir);
+    Engine engine(cfg);
+    std::string err;
+    if (!engine.init(err)) {
+        std::cerr << "init: " << err << std::endl;
+        return 1;
+    }
+    engine.start_background();
+    Server server(engine, cfg);
+    if (!server.start(err)) {
+        std::cerr << "start: " << err << std::endl;
+        return 1;
+    }
+
+    {
+        test::WireClient c(cfg.socket_path);
+        CHECK(c.connected());
+        CHECK_EQ(c.query("CREATE TABLE t (id INT, s TEXT)").status, "OK: table created: t");
+        CHECK_EQ(c.query("INSERT INTO t VALUES (1, 'one'), (2, 'two')").status, "OK: 2 rows inserted");
+        test::Reply r = c.query("SELECT id, s FROM t WHERE id = 2");
+        CHECK(test::ok(r.status));
+        CHECK(r.frames.size() == 1 && r.frames[0].second == "id=2, s=two\n");
+        CHECK(c.query("SELECT FROM").status.rfind("ERR", 0) == 0);
+
+        // pipelined: every request sent first, the replies come back in order
+        std::string batch;
+        for (int i = 0; i < 300; ++i)
+            protocol::put_frame(batch, "INSERT INTO t VALUES (" + std::to_string(100 + i) + ", 'p')");
+        protocol::put_frame(batch, "SELECT COUNT(*) FROM t");
+        CHECK(c.send_raw(batch));
+        size_t inserted = 0;
+        for (int i = 0; i < 300; ++i) inserted += c.reply().status == "OK: 1 row inserted";
+        CHECK(inserted == 300);
+        r = c.reply();
+        CHECK(r.frames.size() == 1 && r.frames[0].second == "COUNT(*)=302\n");
+    }
+
+    {
+        // many connections, each with a statement in flight
+        std::vector<std::unique_ptr<test::WireClient>> clients;
+        for (int i = 0; i < 64; ++i) {
+            clients.push_back(std::make_unique<test::WireClient>(cfg.socket_path));
+            CHECK(clients.back()->send_frame("SELECT COUNT(*) FROM t WHERE id = 2"));
+        }
+        size_t answered = 0;
+        for (auto &c : clients) {
+            test::Reply r = c->reply();
+            answered += r.frames.size() == 1 && r.frames[0].second == "COUNT(*)=1\n";
+        }
+        CHECK(answered == 64);
+        CHECK(server.connections() >= 64);
+    }
+
+    {
+        // a big result nobody reads: its query pauses, the other client goes on
+        test::WireClient setup(cfg.socket_path);
+        CHECK(test::ok(setup.query("CREATE TABLE big (id INT, s TEXT)").status));
+        const std::string text(200, 'b');
+        for (int part = 0; part < 10; ++part) {
+            std::string sql = "INSERT INTO big VALUES ";
+            for (int i = 0; i < 2000; ++i)
+                sql += (i ? ",(" : "(") + std::to_string(part * 2000 + i) + ", '" + text + "')";
+            CHECK(test::ok(setup.query(sql).status));
+        }
+
+        test::WireClient slow(cfg.socket_path);
+        CHECK(slow.send_frame("SELECT id, s FROM big"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto writes = std::async(std::launch::async, [&] {
+            test::WireClient w(cfg.socket_path);
+            size_t ok = 0;
+            for (int i = 0; i < 400; ++i) {
+                std::string sql = "INSERT INTO t VALUES (" + std::to_string(1000 + i) + ", '" + text + "')";
+                ok += test::ok(w.query(sql).status);
+            }
+            return ok;
+        });
+        CHECK(writes.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        CHECK(writes.get() == 400);
+        // then the slow client reads everything
+        test::Reply r = slow.reply();
+        CHECK(test::ok(r.status));
+        CHECK(count_lines(r) == 20000);
+    }
+
+    server.stop();
+    engine.shutdown();
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
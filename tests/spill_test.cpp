@@ -0,0 +1,103 @@
+// Operators that spill: the same queries against an engine with the default
+// memory limits and one whose limits are a few rows, so that GROUP BY spills
+// partial groups (AggSpill), inner and LEFT joins partition both inputs
+// (grace hash join) and ORDER BY writes sorted runs and k-way merges them.
+// Every answer must match the in-memory one row for row.
+#include "tests/test_util.h"
+
+#include <string>
+#include <vector>
+
+static constexpr int ROWS = 6000;
+
+// every row of the answer, in order
+static std::vector<std::string> all_rows(Engine &engine, Session &session, const std::string &sql) {
+    test::Rows out;
+    engine.execute_sql(session, sql, out);
+    if (out.rows.empty()) out.rows.push_back(out.status_line);
+    return out.rows;
+}
+
+static void load(Engine &engine, Session &s) {
+    CHECK(test::ok(test::run(engine, s, "CREATE TABLE a (id INT, g INT, s TEXT, v INT)")));
+    CHECK(test::ok(test::run(engine, s, "CREATE TABLE b (id INT, w INT)")));
+    for (int from = 0; from < ROWS; from += 1000) {
+        std::string sql = "INSERT INTO a VALUES ";
+        for (int i = from; i < from + 1000; ++i) {
+            // 1500 groups; s repeats so ORDER BY g, s has ties
+            sql += (i == from ? "(" : ",(") + std::to_string(i) + ", " + std::to_string(i * 7 % 1500) + ", 's" +
+                   std::to_string(i % 3) + "', " + std::to_string(i % 2 ? -i : i * 3) + ")";
+        }
+        CHECK(test::ok(test::run(engine, s, sql)));
+    }
+    // b: every third id of a twice, and ids a does not have
+    std::string sql = "INSERT INTO b VALUES ";
+    for (int i = 0; i < ROWS + 600; i += 3)
+        sql += (i == 0 ? "(" : ",(") + std::to_string(i) + ", " + std::to_string(i % 11) + "), (" +
+               std::to_string(i) + ", " + std::to_string(100 + i % 5) + ")";
+    CHECK(test::ok(test::run(engine, s, sql)));
+}
+
+int main() {
+    const std::vector<std::string> queries = {
+        // GROUP BY: every aggregate over many more groups than fit
+        "SELECT g, COUNT(*), SUM(v), MIN(v), MAX(s), AVG(v) FROM a GROUP BY g ORDER BY g",
+        "SELECT s, g, COUNT(*), SUM(v) FROM a WHERE v > 0 GROUP BY s, g ORDER BY s, g",
+        "SELECT COUNT(*), SUM(v), MIN(g), MAX(g) FROM a",
+        // joins: matches with duplicates, build rows without a match, and probe rows without one
+        "SELECT a.id, a.s, b.w FROM a JOIN b ON a.id = b.id ORDER BY a.id, b.w",
+        "SELECT a.id, b.id, b.w FROM a LEFT JOIN b ON a.id = b.id ORDER BY a.id, b.w",
+        "SELECT COUNT(*), SUM(b.w) FROM a LEFT JOIN b ON a.id = b.id WHERE a.g < 700",
+        // multi-key ORDER BY with ties: ties keep scan order, in runs and across the merge
+        "SELECT g, s, id FROM a ORDER BY g DESC, s",
+        "SELECT s, v, id FROM a ORDER BY s, v",
+        "SELECT id, s FROM a ORDER BY s DESC LIMIT 100000",
+    };
+
+    std::vector<std::vector<std::string>> in_memory;
+    std::string dir = test::scratch_dir("spill");
+    {
+        Engine engine(test::config(dir));
+        std::string err;
+        if (!engine.init(err)) {
+            std::cerr << "init: " << err << std::endl;
+            return 1;
+        }
+        auto s = engine.open_session();
+        load(engine, *s);
+        for (const auto &q : queries) in_memory.push_back(all_rows(engine, *s, q));
+        engine.shutdown();
+    }
+    std::filesystem::remove_all(dir);
+
+    Config cfg = test::config(dir);
+    cfg.agg_max_groups = 16;
+    cfg.join_max_build_rows = 64;
+    cfg.sort_memory_bytes = 4096;
+    Engine engine(cfg);
+    std::string err;
+    if (!engine.init(err)) {
+        std::cerr << "init: " << err << std::endl;
+        return 1;
+    }
+    auto s = engine.open_session();
+    load(engine, *s);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        std::vector<std::string> spilled = all_rows(engine, *s, queries[i]);
+        CHECK(in_memory[i].size() > 1 || i == 2 || i == 5);
+        if (spilled == in_memory[i]) continue;
+        size_t at = 0;
+        while (at < spilled.size() && at < in_memory[i].size() && spilled[at] == in_memory[i][at]) at++;
+        test::fail(__FILE__, __LINE__,
+                   queries[i] + ": spilled answer has " + std::to_string(spilled.size()) + " rows, in memory " +
+                       std::to_string(in_memory[i].size()) + ", first difference at row " + std::to_string(at));
+    }
+    CHECK_EQ(in_memory[0].front().substr(0, 2), "0,");
+    CHECK_EQ(std::to_string(in_memory[0].size()), "1500");
+    // a LEFT JOIN keeps the rows of a without a match (two rows of b per third id)
+    CHECK_EQ(std::to_string(in_memory[4].size()), std::to_string(ROWS / 3 * 2 + (ROWS - ROWS / 3)));
+
+    engine.shutdown();
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// Helpers shared by the test programs: checks that count failures instead of
+// aborting, a result sink that keeps the rows as text, and a scratch data
+// directory per test. A test's main() ends with `return test::finish();`.
+#include "src/engine/engine.h"
+#include "src/execution/result_sink.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace test {
+
+inline int &failures() {
+    static int n = 0;
+    return n;
+}
+
+inline void fail(const char *file, int line, const std::string &what) {
+    std::cerr << file << ":" << line << ": FAILED: " << what << std::endl;
+    failures()++;
+}
+
+#define CHECK(cond)                                                                                          \
+    do {                                                                                                     \
+        if (!(cond)) test::fail(__FILE__, __LINE__, #cond);                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                           \
+    do {                                                                                                     \
+        const std::string a_ = (actual), e_ = (expected);                                                    \
+        if (a_ != e_) test::fail(__FILE__, __LINE__, #actual " is \"" + a_ + "\", expected \"" + e_ + "\""); \
+    } while (0)
+
+inline int finish() {
+    if (failures() > 0) {
+        std::cerr << failures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
+
+// rows as "v1,v2,..." lines, and the status line
+struct Rows : ResultSink {
+    std::vector<std::string> rows;
+    std::string status_line;
+
+    void columns(const std::vector<std::string> &, const std::vector<ColumnType> &) override {}
+    bool batch(const Batch &b) override {
+        for (size_t r = 0; r < b.size; ++r) {
+            std::string line;
+            for (size_t c = 0; c < b.columns.size(); ++c) {
+                if (c) line += ",";
+                line += b.columns[c].value_string(r);
+            }
+            rows.push_back(line);
+        }
+        return true;
+    }
+    void status(const std::string &msg) override { status_line = msg; }
+};
+
+// the first row of a query, or the status line of anything else
+inline std::string run(Engine &engine, Session &session, const std::string &sql) {
+    Rows out;
+    engine.execute_sql(session, sql, out);
+    return out.rows.empty() ? out.status_line : out.rows[0];
+}
+
+inline bool ok(const std::string &status) { return status.rfind("OK", 0) == 0; }
+
+// an empty directory for the test's data, under the system temp directory
+inline std::string scratch_dir(const std::string &name) {
+    std::filesystem::path dir =
+        std::filesystem::temp_directory_path() / ("boltd_" + name + "_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir);
+    return dir.string();
+}
+
+// an engine config for tests: no background vacuum, short lock waits
+inline Config config(const std::string &data_dir) {
+    Config cfg;
+    cfg.data_dir = data_dir;
+    cfg.ask_mode = false;
+    cfg.vacuum_pages_per_sec = 0;
+    cfg.lock_timeout_ms = 1000;
+    cfg.worker_threads = 2;
+    cfg.recovery_threads = 2;
+    return cfg;
+}
+
+} // namespace test
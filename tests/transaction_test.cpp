@@ -0,0 +1,95 @@
+// BEGIN / COMMIT / ROLLBACK: writes inside a block are queued and only
+// applied at COMMIT, ROLLBACK forgets them, a write that fails at COMMIT
+// leaves nothing of the block behind, and a committed block is still there
+// after a restart.
+#include "tests/test_util.h"
+
+#include <string>
+
+int main() {
+    std::string dir = test::scratch_dir("transaction");
+    {
+        Engine engine(test::config(dir));
+        std::string err;
+        if (!engine.init(err)) {
+            std::cerr << "init: " << err << std::endl;
+            return 1;
+        }
+        auto s = engine.open_session();
+        auto other = engine.open_session();
+        CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, v INT)")));
+        CHECK(test::ok(test::run(engine, *s, "CREATE INDEX t_id ON t (id) USING HASH")));
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (1, 10), (2, 20), (3, 30)"), "OK: 3 rows inserted");
+
+        // statements that only make sense in (or out of) a block
+        CHECK_EQ(test::run(engine, *s, "COMMIT"), "ERR: no transaction is open");
+        CHECK_EQ(test::run(engine, *s, "ROLLBACK"), "ERR: no transaction is open");
+        CHECK_EQ(test::run(engine, *s, "BEGIN"), "OK: transaction started");
+        CHECK_EQ(test::run(engine, *s, "BEGIN"), "ERR: a transaction is already open");
+        CHECK_EQ(test::run(engine, *s, "CREATE TABLE u (a INT)"), "ERR: CREATE cannot run inside a transaction");
+
+        // queued, not applied: neither the block nor another session sees them
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (4, 40)"), "OK: 1 row queued");
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (5, 50), (6, 60)"), "OK: 2 rows queued");
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET v = v + 1 WHERE id <= 4"), "OK: update queued");
+        CHECK_EQ(test::run(engine, *s, "DELETE FROM t WHERE id = 2"), "OK: delete queued");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(v) FROM t"), "3,60");
+        CHECK_EQ(test::run(engine, *other, "SELECT COUNT(*), SUM(v) FROM t"), "3,60");
+
+        // a write whose values cannot be built fails at once; the block stays open
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (7, 'seven')"), "ERR: invalid INT value for column v");
+
+        // applied in order: the update sees the rows inserted before it
+        CHECK_EQ(test::run(engine, *s, "COMMIT"), "OK: committed: 3 inserted, 4 updated, 1 deleted");
+        CHECK_EQ(test::run(engine, *other, "SELECT COUNT(*), SUM(v) FROM t"), "5,193");
+        CHECK_EQ(test::run(engine, *other, "SELECT v FROM t WHERE id = 4"), "41");
+        CHECK_EQ(test::run(engine, *other, "SELECT COUNT(*) FROM t WHERE id = 2"), "0");
+        CHECK_EQ(test::run(engine, *s, "COMMIT"), "ERR: no transaction is open");
+
+        // ROLLBACK drops the queue
+        CHECK_EQ(test::run(engine, *s, "BEGIN"), "OK: transaction started");
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (8, 80)"), "OK: 1 row queued");
+        CHECK_EQ(test::run(engine, *s, "DELETE FROM t"), "OK: delete queued");
+        CHECK_EQ(test::run(engine, *s, "ROLLBACK"), "OK: transaction rolled back");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(v) FROM t"), "5,193");
+
+        // a write that fails at COMMIT undoes the block's writes before it
+        CHECK_EQ(test::run(engine, *s, "BEGIN"), "OK: transaction started");
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (9, 90), (10, 100)"), "OK: 2 rows queued");
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET v = 0 WHERE id = 1"), "OK: update queued");
+        CHECK_EQ(test::run(engine, *s, "DELETE FROM t WHERE id = 3"), "OK: delete queued");
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET v = 10 / (id - 5)"), "OK: update queued");
+        std::string failed = test::run(engine, *s, "COMMIT");
+        CHECK(failed.rfind("ERR: commit stopped at write 4 of 4", 0) == 0);
+        CHECK(failed.find("nothing was applied") != std::string::npos);
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(v) FROM t"), "5,193");
+        CHECK_EQ(test::run(engine, *s, "SELECT v FROM t WHERE id = 1"), "11");
+        CHECK_EQ(test::run(engine, *s, "SELECT v FROM t WHERE id = 3"), "31");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE id = 9"), "0");
+        // the block is over either way
+        CHECK_EQ(test::run(engine, *s, "ROLLBACK"), "ERR: no transaction is open");
+
+        // one more committed block, the last thing before the restart
+        CHECK_EQ(test::run(engine, *s, "BEGIN"), "OK: transaction started");
+        CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES (11, 110)"), "OK: 1 row queued");
+        CHECK_EQ(test::run(engine, *s, "UPDATE t SET v = v * 2 WHERE id = 5"), "OK: update queued");
+        CHECK_EQ(test::run(engine, *s, "COMMIT"), "OK: committed: 1 inserted, 1 updated, 0 deleted");
+        engine.shutdown();
+    }
+    {
+        Engine engine(test::config(dir));
+        std::string err;
+        if (!engine.init(err)) {
+            std::cerr << "reopen: " << err << std::endl;
+            return 1;
+        }
+        auto s = engine.open_session();
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(v) FROM t"), "6,353");
+        CHECK_EQ(test::run(engine, *s, "SELECT v FROM t WHERE id = 11"), "110");
+        CHECK_EQ(test::run(engine, *s, "SELECT v FROM t WHERE id = 5"), "100");
+        CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*) FROM t WHERE id = 9"), "0");
+        engine.shutdown();
+    }
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
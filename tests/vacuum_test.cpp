@@ -0,0 +1,64 @@
+// Background vacuum: once the rows deleted from a table are dead to every
+// snapshot, the compactor reclaims their space: rows move out of sparse tail
+// pages, which are cut off the segment, and scans read only live data.
+#include "tests/test_util.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+static std::string values(int from, int to) {
+    std::string sql;
+    for (int i = from; i < to; ++i) {
+        if (!sql.empty()) sql += ",";
+        sql += "(" + std::to_string(i) + ", 'row-" + std::to_string(i) + "-padding-padding-padding')";
+    }
+    return sql;
+}
+
+// the page count of ANALYZE's "OK: analyzed t (N rows, P pages)"
+static long pages(Engine &engine, Session &s) {
+    std::string st = test::run(engine, s, "ANALYZE t");
+    size_t comma = st.rfind(", ");
+    return comma == std::string::npos ? -1 : std::stol(st.substr(comma + 2));
+}
+
+int main() {
+    std::string dir = test::scratch_dir("vacuum");
+    Config cfg = test::config(dir);
+    cfg.vacuum_pages_per_sec = 100000;
+    Engine engine(cfg);
+    std::string err;
+    if (!engine.init(err)) {
+        std::cerr << "init: " << err << std::endl;
+        return 1;
+    }
+    auto s = engine.open_session();
+    CHECK(test::ok(test::run(engine, *s, "CREATE TABLE t (id INT, s TEXT)")));
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES " + values(0, 4000)), "OK: 4000 rows inserted");
+    long full = pages(engine, *s);
+    CHECK(full > 20);
+
+    // the head and the tail of the table go; the rows left sit in between
+    CHECK_EQ(test::run(engine, *s, "DELETE FROM t WHERE id < 1000 OR id >= 1500"), "OK: 3500 rows deleted");
+    CHECK(pages(engine, *s) == full);
+
+    engine.start_background();
+    long now = full;
+    for (int i = 0; i < 200 && now > full / 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        now = pages(engine, *s);
+    }
+    CHECK(now <= full / 4);
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), MIN(id), MAX(id), SUM(id) FROM t"), "500,1000,1499,624750");
+    CHECK_EQ(test::run(engine, *s, "SELECT s FROM t WHERE id = 1234"), "row-1234-padding-padding-padding");
+
+    // new rows fill the compacted segment instead of the pages cut off
+    CHECK_EQ(test::run(engine, *s, "INSERT INTO t VALUES " + values(0, 500)), "OK: 500 rows inserted");
+    CHECK(pages(engine, *s) <= 2 * now + 1);
+    CHECK_EQ(test::run(engine, *s, "SELECT COUNT(*), SUM(id) FROM t"), "1000,749500");
+
+    engine.shutdown();
+    std::filesystem::remove_all(dir);
+    return test::finish();
+}
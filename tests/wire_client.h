@@ -0,0 +1,101 @@
+#pragma once
+
+// A blocking client of the daemon's wire protocol (src/server/protocol.h) for
+// the server tests: connects to the Unix socket, writes raw frames and reads
+// the reply frames of one statement at a time.
+#include "src/server/protocol.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace test {
+
+struct Reply {
+    std::vector<std::pair<char, std::string>> frames;   // before the status line
+    std::string status;                                 // "" if the connection failed
+};
+
+class WireClient {
+public:
+    explicit WireClient(const std::string &socket_path) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ >= 0 && ::connect(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        // a reply that never comes fails the test instead of hanging it
+        timeval tv{10, 0};
+        if (fd_ >= 0) ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    ~WireClient() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+    WireClient(const WireClient &) = delete;
+    WireClient &operator=(const WireClient &) = delete;
+
+    bool connected() const { return fd_ >= 0; }
+
+    bool send_raw(const std::string &bytes) {
+        size_t done = 0;
+        while (done < bytes.size()) {
+            ssize_t n = ::send(fd_, bytes.data() + done, bytes.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+    bool send_frame(const std::string &body) {
+        std::string out;
+        protocol::put_frame(out, body);
+        return send_raw(out);
+    }
+    bool hello() { return send_raw(std::string(protocol::BINARY_HELLO, sizeof(protocol::BINARY_HELLO))); }
+
+    // the frames of the next statement's reply, up to its 'Z'
+    Reply reply() {
+        Reply out;
+        for (;;) {
+            char header[4];
+            if (!read_all(header, sizeof(header))) return out;
+            uint32_t len = protocol::get_u32(header);
+            if (len == 0 || len > protocol::MAX_FRAME) return out;
+            std::string frame(len, '\0');
+            if (!read_all(&frame[0], len)) return out;
+            if (frame[0] == static_cast<char>(protocol::Reply::DONE)) {
+                out.status = frame.substr(1);
+                return out;
+            }
+            out.frames.emplace_back(frame[0], frame.substr(1));
+        }
+    }
+
+    // send one text-protocol statement and wait for its reply
+    Reply query(const std::string &sql) {
+        if (!send_frame(sql)) return Reply{};
+        return reply();
+    }
+
+private:
+    int fd_ = -1;
+
+    bool read_all(char *buf, size_t len) {
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = ::recv(fd_, buf + done, len - done, 0);
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+};
+
+} // namespace test